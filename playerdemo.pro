@@ -6,6 +6,10 @@ TEMPLATE = app
 TARGET = playerdemo
 DESTDIR = bin
 QT += core gui widgets
+# Qt 画面输出使用 QOpenGLWidget，Qt 6 中在单独的模块
+greaterThan(QT_MAJOR_VERSION, 5): QT += opengl openglwidgets
+# VideoState 含按缓存行对齐的成员，需要 C++17 的对齐 new
+CONFIG += c++17
 #CONFIG += debug
 #DEFINES += _UNICODE WIN64 QT_WIDGETS_LIB
 
@@ -13,7 +17,8 @@ INCLUDEPATH += src
 DLL_IMPORT_TYPE = msvc
 
 win32 {
-LIBS += -L$$PWD/lib/SDL2 \
+LIBS += -lws2_32 \
+    -L$$PWD/lib/SDL2 \
     -L$$PWD/lib/ffmpeg/lib \
     -lSDL2 \
     -lavcodec \
@@ -68,7 +73,29 @@ HEADERS += src/customthread.h \
     src/title.h \
     src/playlist.h \
     src/show.h \
-    src/ctrlbar.h
+    src/ctrlbar.h \
+    src/logctl.h \
+    src/decoderpool.h \
+    src/mirrorout.h \
+    src/colorlut.h \
+    src/audiomixer.h \
+    src/playlistimport.h \
+    src/playlistindex.h \
+    src/resampler.h \
+    src/seekstress.h \
+    src/soaktest.h \
+    src/renderbackend.h \
+    src/sdlrender.h \
+    src/qtrender.h \
+    src/renderbench.h \
+    src/osd.h \
+    src/framepool.h \
+    src/clocksync.h \
+    src/mediavalidate.h \
+    src/proxycache.h \
+    src/ioscheduler.h \
+    src/layoutbench.h \
+    src/perfcounter.h
 
 SOURCES += src/main.cpp \
     src/about.cpp \
@@ -82,7 +109,28 @@ SOURCES += src/main.cpp \
     src/medialist.cpp \
     src/playlist.cpp \
     src/show.cpp \
-    src/title.cpp
+    src/title.cpp \
+    src/logctl.cpp \
+    src/decoderpool.cpp \
+    src/mirrorout.cpp \
+    src/colorlut.cpp \
+    src/audiomixer.cpp \
+    src/playlistimport.cpp \
+    src/playlistindex.cpp \
+    src/resampler.cpp \
+    src/seekstress.cpp \
+    src/soaktest.cpp \
+    src/sdlrender.cpp \
+    src/qtrender.cpp \
+    src/renderbench.cpp \
+    src/osd.cpp \
+    src/framepool.cpp \
+    src/clocksync.cpp \
+    src/mediavalidate.cpp \
+    src/proxycache.cpp \
+    src/ioscheduler.cpp \
+    src/layoutbench.cpp \
+    src/perfcounter.cpp
 
 FORMS += src/mainwid.ui \
     src/ctrlbar.ui \
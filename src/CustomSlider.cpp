@@ -21,6 +21,7 @@ void CustomSlider::mousePressEvent(QMouseEvent *ev)
 
     emit SigCustomSliderValueChanged();
     mIsPressed = true;
+    emit SigCustomSliderPressed(true);
 }
 
 void CustomSlider::mouseReleaseEvent(QMouseEvent *ev)
@@ -29,6 +30,7 @@ void CustomSlider::mouseReleaseEvent(QMouseEvent *ev)
 
     //emit SigCustomSliderValueChanged();
     mIsPressed = false;
+    emit SigCustomSliderPressed(false);
 }
 
 void CustomSlider::mouseMoveEvent(QMouseEvent *ev)
@@ -16,6 +16,7 @@ protected:
     void mouseMoveEvent(QMouseEvent *ev);
 signals:
     void SigCustomSliderValueChanged();//自定义的鼠标单击信号，用于捕获并处理
+    void SigCustomSliderPressed(bool bPressed);//开始、结束拖动
 
 private:
     bool mIsPressed = false;
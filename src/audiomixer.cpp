@@ -0,0 +1,599 @@
+﻿/*
+ * @file 	audiomixer.cpp
+ * @date 	2026/10/18 18:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	多音轨混音
+ * @note
+ */
+
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+#include "audiomixer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MIX_SSE2 1
+#endif
+
+#pragma execution_character_set("utf-8")
+
+//混入的音轨
+struct MixTrack {
+    int stream_index;
+
+    PacketQueue queue;
+    Decoder dec;
+
+    //转为输出格式（只在该音轨解码线程使用）
+    struct SwrContext *swr;
+    AVChannelLayout swr_layout;
+    int swr_format;
+    int swr_rate;
+    std::vector<float> convert_buf;
+
+    //以下由 mutex 保护
+    std::mutex mutex;
+    std::condition_variable cond;
+    AVAudioFifo *fifo;              //< 已转换的交错 float 样本
+    double fifo_pts;                //< FIFO 首个样本的时间戳（秒），NAN 表示未知
+    int fifo_serial;                //< FIFO 中样本对应的队列序号
+    int64_t underruns;              //< 数据不足、缺的部分按静音混入的帧数
+    std::vector<float> gains;       //< 各声道增益，按 4 个声道的倍数重复，便于按 4 个样本一组相乘
+};
+
+//dst += src * gains，gains 以 pattern_len（4 的倍数）为周期重复
+static void mix_add(float *dst, const float *src, int count, const float *gains, int pattern_len)
+{
+    int i = 0;
+    int g = 0;
+
+#ifdef AUDIO_MIX_SSE2
+    for (; i + 4 <= count; i += 4) {
+        __m128 s = _mm_loadu_ps(src + i);
+        __m128 d = _mm_loadu_ps(dst + i);
+        d = _mm_add_ps(d, _mm_mul_ps(s, _mm_loadu_ps(gains + g)));
+        _mm_storeu_ps(dst + i, d);
+        g += 4;
+        if (g == pattern_len)
+            g = 0;
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] += src[i] * gains[g];
+        if (++g == pattern_len)
+            g = 0;
+    }
+}
+
+//声道在左侧为 -1，右侧为 1，居中或低音为 0
+static int channel_side(enum AVChannel ch)
+{
+    switch (ch) {
+    case AV_CHAN_FRONT_LEFT:
+    case AV_CHAN_BACK_LEFT:
+    case AV_CHAN_FRONT_LEFT_OF_CENTER:
+    case AV_CHAN_SIDE_LEFT:
+    case AV_CHAN_TOP_FRONT_LEFT:
+    case AV_CHAN_TOP_BACK_LEFT:
+    case AV_CHAN_STEREO_LEFT:
+    case AV_CHAN_WIDE_LEFT:
+    case AV_CHAN_SURROUND_DIRECT_LEFT:
+        return -1;
+    case AV_CHAN_FRONT_RIGHT:
+    case AV_CHAN_BACK_RIGHT:
+    case AV_CHAN_FRONT_RIGHT_OF_CENTER:
+    case AV_CHAN_SIDE_RIGHT:
+    case AV_CHAN_TOP_FRONT_RIGHT:
+    case AV_CHAN_TOP_BACK_RIGHT:
+    case AV_CHAN_STEREO_RIGHT:
+    case AV_CHAN_WIDE_RIGHT:
+    case AV_CHAN_SURROUND_DIRECT_RIGHT:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+AudioMixer::AudioMixer() :
+    m_nSampleRate(0),
+    m_nResamplePreset(RESAMPLE_PRESET_BALANCED),
+    m_pMainSwr(nullptr),
+    m_nMainFormat(-1),
+    m_nMainRate(0)
+{
+    memset(&m_stLayout, 0, sizeof(m_stLayout));
+    memset(&m_stMainLayout, 0, sizeof(m_stMainLayout));
+}
+
+AudioMixer::~AudioMixer()
+{
+    Close();
+}
+
+void AudioMixer::Open(const AVChannelLayout *ch_layout, int nSampleRate, int nResamplePreset)
+{
+    Close();
+
+    av_channel_layout_uninit(&m_stLayout);
+    if (av_channel_layout_copy(&m_stLayout, ch_layout) < 0)
+        return;
+    m_nSampleRate = nSampleRate;
+    m_nResamplePreset = nResamplePreset;
+}
+
+void AudioMixer::Close()
+{
+    std::vector<std::shared_ptr<MixTrack>> vecTracks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        vecTracks.swap(m_vecTracks);
+    }
+    for (auto &t : vecTracks)
+        StopTrack(t.get());
+
+    swr_free(&m_pMainSwr);
+    av_channel_layout_uninit(&m_stMainLayout);
+    m_nMainFormat = -1;
+    m_nMainRate = 0;
+}
+
+int AudioMixer::AddTrack(AVFormatContext *ic, int nStreamIndex, SDL_cond *empty_queue_cond)
+{
+    AVStream *st;
+    const AVCodec *codec;
+    AVCodecContext *avctx;
+    AVDictionary *opts = NULL;
+    int ret;
+
+    if (nStreamIndex < 0 || nStreamIndex >= (int)ic->nb_streams ||
+        ic->streams[nStreamIndex]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+        return AVERROR(EINVAL);
+    if (m_nSampleRate <= 0 || m_stLayout.nb_channels <= 0)
+        return AVERROR(EINVAL);
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        for (auto &t : m_vecTracks) {
+            if (t->stream_index == nStreamIndex)
+                return 0;
+        }
+        if (m_vecTracks.size() >= AUDIO_MIX_MAX_TRACKS)
+            return AVERROR(ENOSPC);
+    }
+
+    st = ic->streams[nStreamIndex];
+    avctx = avcodec_alloc_context3(NULL);
+    if (!avctx)
+        return AVERROR(ENOMEM);
+    ret = avcodec_parameters_to_context(avctx, st->codecpar);
+    if (ret < 0)
+        goto fail;
+    avctx->pkt_timebase = st->time_base;
+
+    codec = avcodec_find_decoder(avctx->codec_id);
+    if (!codec) {
+        av_log(NULL, AV_LOG_WARNING, "No decoder could be found for codec %s\n", avcodec_get_name(avctx->codec_id));
+        ret = AVERROR(EINVAL);
+        goto fail;
+    }
+    av_dict_set(&opts, "threads", "auto", 0);
+    ret = avcodec_open2(avctx, codec, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+        goto fail;
+
+    {
+        std::shared_ptr<MixTrack> t = std::make_shared<MixTrack>();
+        int nb_channels = m_stLayout.nb_channels;
+
+        t->stream_index = nStreamIndex;
+        t->swr = nullptr;
+        memset(&t->swr_layout, 0, sizeof(t->swr_layout));
+        t->swr_format = -1;
+        t->swr_rate = 0;
+        t->fifo_pts = NAN;
+        t->underruns = 0;
+        t->fifo = av_audio_fifo_alloc(AV_SAMPLE_FMT_FLT, nb_channels,
+            (int)lrint(m_nSampleRate * AUDIO_MIX_FIFO_SECONDS));
+        if (!t->fifo) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        if ((ret = packet_queue_init(&t->queue)) < 0) {
+            av_audio_fifo_free(t->fifo);
+            goto fail;
+        }
+        if ((ret = decoder_init(&t->dec, avctx, &t->queue, empty_queue_cond)) < 0) {
+            packet_queue_destroy(&t->queue);
+            av_audio_fifo_free(t->fifo);
+            goto fail;
+        }
+        if ((ic->iformat->flags & (AVFMT_NOBINSEARCH | AVFMT_NOGENSEARCH | AVFMT_NO_BYTE_SEEK)) && !ic->iformat->read_seek) {
+            t->dec.start_pts = st->start_time;
+            t->dec.start_pts_tb = st->time_base;
+        }
+        t->gains.assign(nb_channels * 4, 1.0f);
+
+        packet_queue_start(&t->queue);
+        t->fifo_serial = t->queue.serial;
+        t->dec.decode_thread = std::thread(&AudioMixer::TrackThread, this, t.get());
+
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        m_vecTracks.push_back(t);
+    }
+
+    av_log(NULL, AV_LOG_INFO, "mixing audio stream %d (%s)\n", nStreamIndex, codec->name);
+    return 0;
+
+fail:
+    avcodec_free_context(&avctx);
+    av_log(NULL, AV_LOG_ERROR, "Cannot open audio stream %d for mixing\n", nStreamIndex);
+    return ret;
+}
+
+void AudioMixer::RemoveTrack(int nStreamIndex)
+{
+    std::shared_ptr<MixTrack> t;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        for (auto it = m_vecTracks.begin(); it != m_vecTracks.end(); ++it) {
+            if ((*it)->stream_index == nStreamIndex) {
+                t = *it;
+                m_vecTracks.erase(it);
+                break;
+            }
+        }
+    }
+    if (t)
+        StopTrack(t.get());
+}
+
+bool AudioMixer::HasTrack(int nStreamIndex)
+{
+    std::lock_guard<std::mutex> lock(m_mutexTracks);
+    for (auto &t : m_vecTracks) {
+        if (t->stream_index == nStreamIndex)
+            return true;
+    }
+    return false;
+}
+
+bool AudioMixer::IsActive()
+{
+    std::lock_guard<std::mutex> lock(m_mutexTracks);
+    return !m_vecTracks.empty();
+}
+
+void AudioMixer::SetTrackMix(int nStreamIndex, double dGain, double dPan)
+{
+    std::shared_ptr<MixTrack> t;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        for (auto &track : m_vecTracks) {
+            if (track->stream_index == nStreamIndex)
+                t = track;
+        }
+    }
+    if (!t)
+        return;
+
+    //等功率声像，居中时左右声道增益均为 1
+    double angle = (av_clipd(dPan, -1.0, 1.0) + 1.0) * M_PI / 4;
+    double left = cos(angle) * M_SQRT2;
+    double right = sin(angle) * M_SQRT2;
+    int nb_channels = m_stLayout.nb_channels;
+
+    std::lock_guard<std::mutex> lock(t->mutex);
+    for (int i = 0; i < nb_channels; i++) {
+        int side = channel_side(av_channel_layout_channel_from_index(&m_stLayout, i));
+        double g = FFMAX(dGain, 0.0) * (side < 0 ? left : side > 0 ? right : 1.0);
+        for (int j = i; j < nb_channels * 4; j += nb_channels)
+            t->gains[j] = (float)g;
+    }
+}
+
+bool AudioMixer::PutPacket(AVPacket *pkt)
+{
+    std::lock_guard<std::mutex> lock(m_mutexTracks);
+    for (auto &t : m_vecTracks) {
+        if (t->stream_index == pkt->stream_index) {
+            packet_queue_put(&t->queue, pkt);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AudioMixer::PutNullPackets(AVPacket *pkt)
+{
+    std::lock_guard<std::mutex> lock(m_mutexTracks);
+    for (auto &t : m_vecTracks)
+        packet_queue_put_nullpacket(&t->queue, pkt, t->stream_index);
+}
+
+void AudioMixer::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_mutexTracks);
+    for (auto &t : m_vecTracks) {
+        packet_queue_flush(&t->queue);
+        //唤醒等待 FIFO 空间的解码线程，旧序号的帧直接丢弃
+        std::lock_guard<std::mutex> lockTrack(t->mutex);
+        t->cond.notify_all();
+    }
+}
+
+int AudioMixer::Mix(AVFrame *frame, double dPts)
+{
+    std::vector<std::shared_ptr<MixTrack>> vecTracks;
+    AVFrame *out;
+    int nb_samples;
+    int ret;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTracks);
+        vecTracks = m_vecTracks;
+    }
+    if (vecTracks.empty() || frame->sample_rate != m_nSampleRate)
+        return 0;
+
+    //主音轨转为交错 float、输出声道布局，采样率不变
+    if (!m_pMainSwr ||
+        frame->format != m_nMainFormat ||
+        frame->sample_rate != m_nMainRate ||
+        av_channel_layout_compare(&frame->ch_layout, &m_stMainLayout)) {
+        swr_free(&m_pMainSwr);
+        swr_alloc_set_opts2(&m_pMainSwr,
+            &m_stLayout, AV_SAMPLE_FMT_FLT, m_nSampleRate,
+            &frame->ch_layout, (AVSampleFormat)frame->format, frame->sample_rate,
+            0, NULL);
+        if (!m_pMainSwr || swr_init(m_pMainSwr) < 0) {
+            av_log(NULL, AV_LOG_ERROR, "Cannot create the mixer converter for %d Hz %s %d channels\n",
+                frame->sample_rate, av_get_sample_fmt_name((AVSampleFormat)frame->format), frame->ch_layout.nb_channels);
+            swr_free(&m_pMainSwr);
+            return -1;
+        }
+        av_channel_layout_uninit(&m_stMainLayout);
+        av_channel_layout_copy(&m_stMainLayout, &frame->ch_layout);
+        m_nMainFormat = frame->format;
+        m_nMainRate = frame->sample_rate;
+    }
+
+    out = av_frame_alloc();
+    if (!out)
+        return AVERROR(ENOMEM);
+    out->format = AV_SAMPLE_FMT_FLT;
+    out->sample_rate = m_nSampleRate;
+    out->nb_samples = frame->nb_samples;
+    if ((ret = av_channel_layout_copy(&out->ch_layout, &m_stLayout)) < 0 ||
+        (ret = av_frame_get_buffer(out, 0)) < 0) {
+        av_frame_free(&out);
+        return ret;
+    }
+    nb_samples = swr_convert(m_pMainSwr, out->data, out->nb_samples,
+        (const uint8_t **)frame->extended_data, frame->nb_samples);
+    if (nb_samples < 0) {
+        av_frame_free(&out);
+        return nb_samples;
+    }
+    out->nb_samples = nb_samples;
+
+    for (auto &t : vecTracks)
+        MixTrackInto(t.get(), (float *)out->data[0], nb_samples, dPts);
+
+    av_frame_copy_props(out, frame);
+    av_frame_unref(frame);
+    av_frame_move_ref(frame, out);
+    av_frame_free(&out);
+    return 1;
+}
+
+//把音轨中与 [pts, pts + nb_samples) 对应的样本混入 out。
+//不等待音轨解码，只混入已缓冲的部分，缺的部分相当于静音，晚到的样本在下一帧按时间戳丢弃
+int AudioMixer::MixTrackInto(MixTrack *t, float *out, int nb_samples, double pts)
+{
+    int nb_channels = m_stLayout.nb_channels;
+    int offset = 0;
+    int count;
+    std::vector<float> gains;
+
+    {
+        std::unique_lock<std::mutex> lock(t->mutex);
+        for (;;) {
+            int size;
+
+            if (!t->fifo)
+                return 0;
+
+            //seek 后 FIFO 中是旧序号的样本
+            if (t->fifo_serial != t->queue.serial) {
+                av_audio_fifo_reset(t->fifo);
+                t->fifo_serial = t->queue.serial;
+                t->fifo_pts = NAN;
+                t->cond.notify_all();
+            }
+
+            size = av_audio_fifo_size(t->fifo);
+            offset = 0;
+            if (size > 0 && !isnan(pts) && !isnan(t->fifo_pts)) {
+                double diff = t->fifo_pts - pts;
+                if (diff < -AUDIO_MIX_SYNC_THRESHOLD) {
+                    //音轨落后，丢掉已经过去的样本
+                    int drop = FFMIN(size, (int)lrint(-diff * m_nSampleRate));
+                    av_audio_fifo_drain(t->fifo, drop);
+                    t->fifo_pts += (double)drop / m_nSampleRate;
+                    t->cond.notify_all();
+                    continue;
+                }
+                if (diff > AUDIO_MIX_SYNC_THRESHOLD) {
+                    //音轨在本帧之后才开始
+                    offset = (int)lrint(diff * m_nSampleRate);
+                    if (offset >= nb_samples)
+                        return 0;
+                }
+            }
+            break;
+        }
+
+        count = FFMIN(av_audio_fifo_size(t->fifo), nb_samples - offset);
+        if (count < nb_samples - offset && !t->queue.abort_request && t->dec.finished != t->queue.serial) {
+            if (t->underruns++ == 0)
+                av_log(NULL, AV_LOG_VERBOSE, "Mix track %d underrun: %d of %d samples buffered, rest mixed as silence\n",
+                    t->stream_index, FFMAX(count, 0), nb_samples - offset);
+        }
+        if (count <= 0)
+            return 0;
+        if (m_vecTrackBuf.size() < (size_t)count * nb_channels)
+            m_vecTrackBuf.resize((size_t)count * nb_channels);
+        void *data = m_vecTrackBuf.data();
+        count = av_audio_fifo_read(t->fifo, &data, count);
+        if (count <= 0)
+            return 0;
+        if (!isnan(t->fifo_pts))
+            t->fifo_pts += (double)count / m_nSampleRate;
+        gains = t->gains;
+        t->cond.notify_all();
+    }
+
+    mix_add(out + offset * nb_channels, m_vecTrackBuf.data(), count * nb_channels, gains.data(), (int)gains.size());
+    return count;
+}
+
+//混入音轨的解码线程
+void AudioMixer::TrackThread(MixTrack *t)
+{
+    AVFrame *frame = av_frame_alloc();
+    int got_frame;
+
+    if (!frame)
+        return;
+
+    for (;;) {
+        if ((got_frame = decoder_decode_frame(&t->dec, frame, NULL)) < 0)
+            break;
+        if (got_frame) {
+            QueueTrackFrame(t, frame);
+            av_frame_unref(frame);
+        }
+        else {
+            //解码结束，唤醒等待数据的混音
+            std::lock_guard<std::mutex> lock(t->mutex);
+            t->cond.notify_all();
+        }
+    }
+
+    av_frame_free(&frame);
+}
+
+//转换为输出格式后放入 FIFO
+int AudioMixer::QueueTrackFrame(MixTrack *t, AVFrame *frame)
+{
+    int nb_channels = m_stLayout.nb_channels;
+    int max_samples = (int)lrint(m_nSampleRate * AUDIO_MIX_FIFO_SECONDS);
+    int serial = t->dec.pkt_serial;
+    int64_t delay;
+    int out_count;
+    int len;
+    double pts;
+    uint8_t *out;
+
+    if (serial != t->queue.serial)
+        return 0;
+
+    if (!t->swr ||
+        frame->format != t->swr_format ||
+        frame->sample_rate != t->swr_rate ||
+        av_channel_layout_compare(&frame->ch_layout, &t->swr_layout)) {
+        swr_free(&t->swr);
+        swr_alloc_set_opts2(&t->swr,
+            &m_stLayout, AV_SAMPLE_FMT_FLT, m_nSampleRate,
+            &frame->ch_layout, (AVSampleFormat)frame->format, frame->sample_rate,
+            0, NULL);
+        if (t->swr)
+            Resampler::ApplyPreset(t->swr, m_nResamplePreset);
+        if (!t->swr || swr_init(t->swr) < 0) {
+            av_log(NULL, AV_LOG_ERROR,
+                "Cannot create sample rate converter for mixing %d Hz %s %d channels to %d Hz %d channels!\n",
+                frame->sample_rate, av_get_sample_fmt_name((AVSampleFormat)frame->format), frame->ch_layout.nb_channels,
+                m_nSampleRate, nb_channels);
+            swr_free(&t->swr);
+            return -1;
+        }
+        av_channel_layout_uninit(&t->swr_layout);
+        av_channel_layout_copy(&t->swr_layout, &frame->ch_layout);
+        t->swr_format = frame->format;
+        t->swr_rate = frame->sample_rate;
+    }
+
+    //重采样器中缓存的样本使输出比输入晚
+    delay = swr_get_delay(t->swr, m_nSampleRate);
+    out_count = swr_get_out_samples(t->swr, frame->nb_samples);
+    if (out_count <= 0)
+        return 0;
+    if (t->convert_buf.size() < (size_t)out_count * nb_channels)
+        t->convert_buf.resize((size_t)out_count * nb_channels);
+    out = (uint8_t *)t->convert_buf.data();
+    len = swr_convert(t->swr, &out, out_count, (const uint8_t **)frame->extended_data, frame->nb_samples);
+    if (len <= 0)
+        return len;
+    pts = frame->pts == AV_NOPTS_VALUE ? NAN :
+        (double)frame->pts / frame->sample_rate - (double)delay / m_nSampleRate;
+
+    std::unique_lock<std::mutex> lock(t->mutex);
+    //FIFO 满时等待混音取走，seek 或停止时放弃
+    while (av_audio_fifo_size(t->fifo) > 0 && av_audio_fifo_size(t->fifo) + len > max_samples &&
+        !t->queue.abort_request && serial == t->queue.serial)
+        t->cond.wait_for(lock, std::chrono::milliseconds(10));
+    if (t->queue.abort_request || serial != t->queue.serial)
+        return 0;
+
+    if (t->fifo_serial != serial) {
+        av_audio_fifo_reset(t->fifo);
+        t->fifo_serial = serial;
+        t->fifo_pts = NAN;
+    }
+    if (av_audio_fifo_size(t->fifo) == 0) {
+        t->fifo_pts = pts;
+    }
+    else if (!isnan(pts) && !isnan(t->fifo_pts)) {
+        //音轨中间的空档（如评论音轨）补静音，保持时间连续
+        double gap = pts - (t->fifo_pts + (double)av_audio_fifo_size(t->fifo) / m_nSampleRate);
+        int silence = (int)lrint(gap * m_nSampleRate);
+        if (gap > AUDIO_MIX_SYNC_THRESHOLD && av_audio_fifo_size(t->fifo) + silence + len <= max_samples) {
+            std::vector<float> zeros((size_t)silence * nb_channels, 0.0f);
+            void *data = zeros.data();
+            av_audio_fifo_write(t->fifo, &data, silence);
+        }
+    }
+    av_audio_fifo_write(t->fifo, (void **)&out, len);
+    t->cond.notify_all();
+    return len;
+}
+
+void AudioMixer::StopTrack(MixTrack *t)
+{
+    if (t->underruns > 0)
+        av_log(NULL, AV_LOG_VERBOSE, "Mix track %d: %" PRId64 " frames not fully buffered\n", t->stream_index, t->underruns);
+
+    packet_queue_abort(&t->queue);
+    {
+        std::lock_guard<std::mutex> lock(t->mutex);
+        t->cond.notify_all();
+    }
+    if (t->dec.decode_thread.joinable())
+        t->dec.decode_thread.join();
+    packet_queue_flush(&t->queue);
+
+    decoder_destroy(&t->dec);
+    packet_queue_destroy(&t->queue);
+    swr_free(&t->swr);
+    av_channel_layout_uninit(&t->swr_layout);
+
+    //音频解码线程可能仍持有该音轨
+    std::lock_guard<std::mutex> lock(t->mutex);
+    av_audio_fifo_free(t->fifo);
+    t->fifo = nullptr;
+}
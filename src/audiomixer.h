@@ -0,0 +1,123 @@
+﻿/*
+ * @file 	audiomixer.h
+ * @date 	2026/10/18 18:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	多音轨混音
+ * @note	除主音轨外的音轨各自一个数据包队列和解码线程，解码后转为主音轨的采样率、输出声道布局的
+ *			交错 float 样本放入 FIFO。音频解码线程把主音轨的帧按时间戳与各音轨对齐，
+ *			乘上增益（含声像）后向量化累加，再送入 sampq，时钟和输出设备仍只跟随主音轨。
+ *			主音轨从不等待混入音轨，音轨数据不足时缺的部分为静音。
+ */
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+
+#include "globalhelper.h"
+#include "datactl.h"
+#include "resampler.h"
+
+#define AUDIO_MIX_MAX_TRACKS 8          //最多混入的音轨数
+#define AUDIO_MIX_FIFO_SECONDS 1.0      //每个音轨最多缓冲的时长（秒）
+#define AUDIO_MIX_SYNC_THRESHOLD 0.01   //混入音轨与主音轨时间戳相差超过该值（秒）时重新对齐
+
+typedef struct MixTrack MixTrack;
+
+class AudioMixer
+{
+public:
+    AudioMixer();
+    ~AudioMixer();
+
+    /**
+     * @brief	设置混音输出格式，打开主音轨后调用
+     *
+     * @param	ch_layout 输出声道布局
+     * @param	nSampleRate 主音轨采样率，混入音轨重采样到该采样率
+     * @param	nResamplePreset 混入音轨的重采样预设（ResamplePreset）
+     */
+    void Open(const AVChannelLayout *ch_layout, int nSampleRate, int nResamplePreset = RESAMPLE_PRESET_BALANCED);
+
+    /**
+     * @brief	关闭所有混入音轨并释放资源
+     */
+    void Close();
+
+    /**
+     * @brief	打开文件中的一个音轨参与混音
+     *
+     * @param	ic 文件
+     * @param	nStreamIndex 音频流序号
+     * @param	empty_queue_cond 队列为空时通知读取线程
+     * @return	0 成功 负值失败
+     */
+    int AddTrack(AVFormatContext *ic, int nStreamIndex, SDL_cond *empty_queue_cond);
+
+    /**
+     * @brief	停止混入该音轨
+     */
+    void RemoveTrack(int nStreamIndex);
+
+    bool HasTrack(int nStreamIndex);
+    bool IsActive();
+
+    /**
+     * @brief	设置音轨的增益和声像
+     *
+     * @param	nStreamIndex 音频流序号
+     * @param	dGain 线性增益，1 为原始音量
+     * @param	dPan 声像 -1（左）~ 1（右），0 居中
+     */
+    void SetTrackMix(int nStreamIndex, double dGain, double dPan);
+
+    /**
+     * @brief	读取线程调用，属于混入音轨的数据包放入其队列
+     *
+     * @return	true 已放入（数据包被取走）false 不属于混入音轨
+     */
+    bool PutPacket(AVPacket *pkt);
+
+    //读取结束时向各音轨放入空包，让解码器输出缓存的帧
+    void PutNullPackets(AVPacket *pkt);
+
+    //seek 后清空各音轨队列
+    void Flush();
+
+    /**
+     * @brief	音频解码线程调用，把主音轨的帧与混入音轨混合，混音结果替换原帧
+     *
+     * @param	frame 主音轨解码后的帧，成功时替换为交错 float 格式
+     * @param	dPts 帧的时间戳（秒），NAN 表示未知
+     * @return	1 已混音 0 没有需要混入的音轨 负值失败
+     */
+    int Mix(AVFrame *frame, double dPts);
+
+private:
+    int MixTrackInto(MixTrack *t, float *out, int nb_samples, double pts);
+    void TrackThread(MixTrack *t);
+    int QueueTrackFrame(MixTrack *t, AVFrame *frame);
+    void StopTrack(MixTrack *t);
+
+private:
+    std::mutex m_mutexTracks;
+    std::vector<std::shared_ptr<MixTrack>> m_vecTracks;
+
+    AVChannelLayout m_stLayout;             //< 输出声道布局
+    int m_nSampleRate;                      //< 输出采样率
+    int m_nResamplePreset;                  //< 混入音轨的重采样预设
+
+    //主音轨格式转换（只在音频解码线程使用）
+    struct SwrContext *m_pMainSwr;
+    AVChannelLayout m_stMainLayout;
+    int m_nMainFormat;
+    int m_nMainRate;
+    std::vector<float> m_vecTrackBuf;       //< 从音轨 FIFO 读出的样本
+};
+
+#endif // AUDIOMIXER_H
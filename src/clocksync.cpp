@@ -0,0 +1,566 @@
+﻿/*
+ * @file 	clocksync.cpp
+ * @date 	2026/10/19 09:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	多个播放器之间的时钟同步（UDP）
+ * @note
+ */
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include "clocksync.h"
+
+#pragma execution_character_set("utf-8")
+
+#if defined(_WIN32)
+typedef SOCKET socket_t;
+#define close_socket closesocket
+#else
+typedef int socket_t;
+#define close_socket close
+#endif
+
+#define SYNC_MAGIC 0x434e5953   //"SYNC"
+#define SYNC_VERSION 1
+#define SYNC_RECV_TIMEOUT_MS 20 //接收超时，线程按该间隔检查是否退出、发送请求
+
+enum SyncPacketType {
+    SYNC_PACKET_PING = 1,       //从机 -> 主机
+    SYNC_PACKET_CLOCK           //主机 -> 从机
+};
+
+//请求和回复使用同一结构，按本机字节序（各播放机均为小端）
+typedef struct SyncPacket {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    int64_t t1;             //从机发送时间（从机时间）
+    int64_t t2;             //主机接收时间（主机时间）
+    int64_t t3;             //主机发送时间（主机时间）
+    int64_t clock_time;     //时钟快照的时间（主机时间）
+    double pts;
+    double speed;
+    int32_t serial;
+    int32_t paused;
+    double skew_mean_ms;    //从机上一个统计周期的偏差，NAN 表示没有
+    double skew_max_ms;
+    double rtt_ms;
+} SyncPacket;
+
+ClockSync *ClockSync::m_pInstance = new ClockSync();
+
+ClockSync::ClockSync() :
+    m_nRole(SYNC_ROLE_OFF),
+    m_nSocket(-1),
+    m_bRunning(false),
+    m_nMasterIp(0),
+    m_nMasterPort(0)
+{
+    Stop();
+}
+
+ClockSync::~ClockSync()
+{
+    Stop();
+}
+
+ClockSync *ClockSync::GetInstance()
+{
+    return m_pInstance;
+}
+
+bool ClockSync::OpenSocket(int nPort)
+{
+    struct sockaddr_in addr;
+    socket_t fd;
+
+#if defined(_WIN32)
+    static bool bWsaInit = false;
+    if (!bWsaInit)
+    {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        {
+            av_log(NULL, AV_LOG_ERROR, "Sync: could not initialize sockets\n");
+            return false;
+        }
+        bWsaInit = true;
+    }
+#endif
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd == (socket_t)-1)
+    {
+        av_log(NULL, AV_LOG_ERROR, "Sync: could not create socket\n");
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)nPort);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        av_log(NULL, AV_LOG_ERROR, "Sync: could not bind UDP port %d\n", nPort);
+        close_socket(fd);
+        return false;
+    }
+
+#if defined(_WIN32)
+    DWORD timeout = SYNC_RECV_TIMEOUT_MS;
+#else
+    struct timeval timeout = { 0, SYNC_RECV_TIMEOUT_MS * 1000 };
+#endif
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+
+    m_nSocket = (intptr_t)fd;
+    return true;
+}
+
+void ClockSync::CloseSocket()
+{
+    if (m_nSocket != -1)
+    {
+        close_socket((socket_t)m_nSocket);
+        m_nSocket = -1;
+    }
+}
+
+bool ClockSync::StartMaster(int nPort)
+{
+    Stop();
+    if (!OpenSocket(nPort))
+    {
+        return false;
+    }
+
+    m_nRole = SYNC_ROLE_MASTER;
+    m_bRunning = true;
+    m_tThread = std::thread(&ClockSync::MasterThread, this);
+    av_log(NULL, AV_LOG_INFO, "Sync: master on UDP port %d\n", nPort);
+    return true;
+}
+
+bool ClockSync::StartFollower(const QString &strHost, int nPort)
+{
+    struct addrinfo hints, *res = NULL;
+
+    Stop();
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+#if defined(_WIN32)
+    //getaddrinfo 也需要先初始化
+    if (!OpenSocket(0))
+    {
+        return false;
+    }
+#endif
+    if (getaddrinfo(strHost.toUtf8().constData(), NULL, &hints, &res) != 0 || !res)
+    {
+        av_log(NULL, AV_LOG_ERROR, "Sync: could not resolve master %s\n", strHost.toUtf8().constData());
+        CloseSocket();
+        return false;
+    }
+    m_nMasterIp = ((struct sockaddr_in *)res->ai_addr)->sin_addr.s_addr;
+    m_nMasterPort = htons((uint16_t)nPort);
+    freeaddrinfo(res);
+
+    if (m_nSocket == -1 && !OpenSocket(0))
+    {
+        return false;
+    }
+
+    m_nRole = SYNC_ROLE_FOLLOWER;
+    m_bRunning = true;
+    m_tThread = std::thread(&ClockSync::FollowerThread, this);
+    av_log(NULL, AV_LOG_INFO, "Sync: following %s:%d\n", strHost.toUtf8().constData(), nPort);
+    return true;
+}
+
+void ClockSync::Stop()
+{
+    m_bRunning = false;
+    if (m_tThread.joinable())
+    {
+        m_tThread.join();
+    }
+    CloseSocket();
+    m_nRole = SYNC_ROLE_OFF;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stClock.pts = NAN;
+    m_stClock.time = 0;
+    m_stClock.speed = 1.0;
+    m_stClock.serial = 0;
+    m_stClock.paused = 0;
+    m_vecSamples.clear();
+    m_nLastRecv = 0;
+    m_dOffset = 0;
+    m_nRtt = 0;
+    m_dSkewSum = m_dSkewMax = 0;
+    m_nSkewCount = 0;
+    m_dReportMean = m_dReportMax = NAN;
+    m_vecSkewHist.clear();  //第一个样本时分配
+    m_nSkewTotal = 0;
+    m_dSkewTotalMax = 0;
+    m_mapFollowers.clear();
+    m_dSpreadMaxMs = 0;
+    m_nNextReport = av_gettime_relative() + (int64_t)(SYNC_REPORT_INTERVAL * 1000000);
+}
+
+int ClockSync::GetRole()
+{
+    return m_nRole;
+}
+
+void ClockSync::SetMasterClock(double dPts, double dSpeed, int nSerial, bool bPaused)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stClock.pts = dPts;
+    m_stClock.time = av_gettime_relative();
+    m_stClock.speed = dSpeed;
+    m_stClock.serial = nSerial;
+    m_stClock.paused = bPaused;
+}
+
+bool ClockSync::GetMasterClock(int64_t nNow, double *pPts, double *pSpeed, int *pSerial, bool *pPaused)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_nLastRecv || nNow - m_nLastRecv > SYNC_TIMEOUT * 1000000)
+    {
+        return false;
+    }
+
+    //换算到主机时间，再从快照按速度推算
+    double dElapsed = (nNow + m_dOffset - m_stClock.time) / 1000000.0;
+    *pPts = m_stClock.paused ? m_stClock.pts : m_stClock.pts + dElapsed * m_stClock.speed;
+    *pSpeed = m_stClock.speed;
+    *pSerial = m_stClock.serial;
+    *pPaused = m_stClock.paused;
+    return true;
+}
+
+void ClockSync::AddSkew(double dSkew)
+{
+    double dSkewMs = dSkew * 1000.0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dSkewSum += dSkewMs;
+    m_dSkewMax = std::max(m_dSkewMax, fabs(dSkewMs));
+    m_nSkewCount++;
+    if (m_vecSkewHist.empty())
+    {
+        m_vecSkewHist.assign(SYNC_SKEW_HIST_BINS, 0);
+    }
+    m_vecSkewHist[std::min((int)(fabs(dSkewMs) / SYNC_SKEW_HIST_BIN_MS), SYNC_SKEW_HIST_BINS - 1)]++;
+    m_nSkewTotal++;
+    m_dSkewTotalMax = std::max(m_dSkewTotalMax, fabs(dSkewMs));
+}
+
+double ClockSync::SkewPercentile(double dQuantile) const
+{
+    //与排序后取第 total * q 个样本相同
+    int64_t nRank = (int64_t)(m_nSkewTotal * dQuantile);
+    int64_t nCount = 0;
+
+    for (int i = 0; i < (int)m_vecSkewHist.size() - 1; i++)
+    {
+        nCount += m_vecSkewHist[i];
+        if (nCount > nRank)
+        {
+            return std::min((i + 1) * SYNC_SKEW_HIST_BIN_MS, m_dSkewTotalMax);
+        }
+    }
+    return m_dSkewTotalMax;
+}
+
+void ClockSync::MasterThread()
+{
+    SyncPacket pkt;
+    struct sockaddr_in addr;
+    socklen_t addr_len;
+    char host[INET_ADDRSTRLEN];
+
+    while (m_bRunning)
+    {
+        addr_len = sizeof(addr);
+        int n = recvfrom((socket_t)m_nSocket, (char *)&pkt, sizeof(pkt), 0, (struct sockaddr *)&addr, &addr_len);
+        int64_t now = av_gettime_relative();
+        if (n == (int)sizeof(pkt) && pkt.magic == SYNC_MAGIC && pkt.version == SYNC_VERSION && pkt.type == SYNC_PACKET_PING)
+        {
+            inet_ntop(AF_INET, &addr.sin_addr, host, sizeof(host));
+            std::string key = std::string(host) + ":" + std::to_string(ntohs(addr.sin_port));
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                FollowerInfo &info = m_mapFollowers[key];
+                info.last_seen = now;
+                info.skew_mean_ms = pkt.skew_mean_ms;
+                info.skew_max_ms = pkt.skew_max_ms;
+                info.rtt_ms = pkt.rtt_ms;
+
+                pkt.clock_time = m_stClock.time;
+                pkt.pts = m_stClock.pts;
+                pkt.speed = m_stClock.speed;
+                pkt.serial = m_stClock.serial;
+                pkt.paused = m_stClock.paused;
+            }
+            pkt.type = SYNC_PACKET_CLOCK;
+            pkt.t2 = now;
+            pkt.t3 = av_gettime_relative();
+            sendto((socket_t)m_nSocket, (const char *)&pkt, sizeof(pkt), 0, (struct sockaddr *)&addr, addr_len);
+        }
+        UpdateReport(now);
+    }
+}
+
+void ClockSync::FollowerThread()
+{
+    SyncPacket pkt;
+    struct sockaddr_in addr;
+    struct sockaddr_in from;
+    socklen_t from_len;
+    int64_t next_ping = 0;
+    int64_t pending_t1 = 0;     //等待回复的请求的发送时间，0 表示没有
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = m_nMasterIp;
+    addr.sin_port = m_nMasterPort;
+
+    while (m_bRunning)
+    {
+        int64_t now = av_gettime_relative();
+        if (now >= next_ping)
+        {
+            memset(&pkt, 0, sizeof(pkt));
+            pkt.magic = SYNC_MAGIC;
+            pkt.version = SYNC_VERSION;
+            pkt.type = SYNC_PACKET_PING;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                pkt.skew_mean_ms = m_dReportMean;
+                pkt.skew_max_ms = m_dReportMax;
+                pkt.rtt_ms = m_nRtt / 1000.0;
+            }
+            pkt.t1 = av_gettime_relative();
+            pending_t1 = pkt.t1;
+            sendto((socket_t)m_nSocket, (const char *)&pkt, sizeof(pkt), 0, (struct sockaddr *)&addr, sizeof(addr));
+            next_ping = now + (int64_t)(SYNC_PING_INTERVAL * 1000000);
+        }
+
+        from_len = sizeof(from);
+        int n = recvfrom((socket_t)m_nSocket, (char *)&pkt, sizeof(pkt), 0, (struct sockaddr *)&from, &from_len);
+        int64_t t4 = av_gettime_relative();
+        //只接受主机对当前请求的回复：其他来源的包、重复或过期（上一次请求）的回复都丢弃
+        if (n == (int)sizeof(pkt) && pkt.magic == SYNC_MAGIC && pkt.version == SYNC_VERSION && pkt.type == SYNC_PACKET_CLOCK &&
+            from.sin_family == AF_INET && from.sin_addr.s_addr == m_nMasterIp && from.sin_port == m_nMasterPort &&
+            pending_t1 && pkt.t1 == pending_t1)
+        {
+            pending_t1 = 0;
+            OffsetSample sample;
+            sample.offset = ((pkt.t2 - pkt.t1) + (pkt.t3 - t4)) / 2;
+            sample.rtt = (t4 - pkt.t1) - (pkt.t3 - pkt.t2);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_vecSamples.push_back(sample);
+            if (m_vecSamples.size() > SYNC_FILTER_SAMPLES)
+            {
+                m_vecSamples.erase(m_vecSamples.begin());
+            }
+            //往返时间最短的一次排队最少，时间差最准
+            const OffsetSample &best = *std::min_element(m_vecSamples.begin(), m_vecSamples.end(),
+                [](const OffsetSample &a, const OffsetSample &b) { return a.rtt < b.rtt; });
+            if (m_nLastRecv)
+                m_dOffset += (best.offset - m_dOffset) * SYNC_OFFSET_SMOOTH;
+            else
+                m_dOffset = best.offset;
+            m_nRtt = best.rtt;
+
+            m_stClock.pts = pkt.pts;
+            m_stClock.time = pkt.clock_time;
+            m_stClock.speed = pkt.speed;
+            m_stClock.serial = pkt.serial;
+            m_stClock.paused = pkt.paused;
+            m_nLastRecv = t4;
+        }
+        UpdateReport(t4);
+    }
+}
+
+void ClockSync::UpdateReport(int64_t nNow)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (nNow < m_nNextReport)
+    {
+        return;
+    }
+    m_nNextReport = nNow + (int64_t)(SYNC_REPORT_INTERVAL * 1000000);
+
+    if (m_nRole == SYNC_ROLE_FOLLOWER)
+    {
+        if (!m_nLastRecv || nNow - m_nLastRecv > SYNC_TIMEOUT * 1000000)
+        {
+            av_log(NULL, AV_LOG_WARNING, "Sync: no clock from master\n");
+        }
+        else if (m_nSkewCount > 0)
+        {
+            m_dReportMean = m_dSkewSum / m_nSkewCount;
+            m_dReportMax = m_dSkewMax;
+            av_log(NULL, AV_LOG_INFO, "Sync: skew mean %+.1f ms max %.1f ms, clock offset %.3f ms, rtt %.3f ms\n",
+                m_dReportMean, m_dReportMax, m_dOffset / 1000.0, m_nRtt / 1000.0);
+        }
+        m_dSkewSum = m_dSkewMax = 0;
+        m_nSkewCount = 0;
+        return;
+    }
+
+    //主机自身偏差为 0，各实例间的偏差取各从机平均偏差的极差
+    double dMin = 0, dMax = 0;
+    int nActive = 0;
+    for (const auto &it : m_mapFollowers)
+    {
+        const FollowerInfo &info = it.second;
+        if (nNow - info.last_seen > SYNC_FOLLOWER_TIMEOUT * 1000000 || std::isnan(info.skew_mean_ms))
+        {
+            continue;
+        }
+        dMin = std::min(dMin, info.skew_mean_ms);
+        dMax = std::max(dMax, info.skew_mean_ms);
+        nActive++;
+    }
+    if (nActive == 0)
+    {
+        return;
+    }
+    m_dSpreadMaxMs = std::max(m_dSpreadMaxMs, dMax - dMin);
+    av_log(NULL, AV_LOG_INFO, "Sync: %d follower(s), inter-instance skew %.1f ms\n", nActive, dMax - dMin);
+    for (const auto &it : m_mapFollowers)
+    {
+        const FollowerInfo &info = it.second;
+        if (nNow - info.last_seen <= SYNC_FOLLOWER_TIMEOUT * 1000000 && !std::isnan(info.skew_mean_ms))
+        {
+            av_log(NULL, AV_LOG_INFO, "Sync:   %s skew mean %+.1f ms max %.1f ms, rtt %.3f ms\n",
+                it.first.c_str(), info.skew_mean_ms, info.skew_max_ms, info.rtt_ms);
+        }
+    }
+}
+
+bool ClockSync::Summary(FILE *fp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_nRole == SYNC_ROLE_MASTER)
+    {
+        fprintf(fp, "sync master: %d follower(s), max inter-instance skew %.1f ms\n",
+            (int)m_mapFollowers.size(), m_dSpreadMaxMs);
+        return !m_mapFollowers.empty();
+    }
+    if (m_nRole != SYNC_ROLE_FOLLOWER)
+    {
+        return true;
+    }
+
+    if (m_nSkewTotal == 0)
+    {
+        fprintf(fp, "sync follower: no clock from master: FAIL\n");
+        return false;
+    }
+    double p50 = SkewPercentile(0.5);
+    double p95 = SkewPercentile(0.95);
+    bool bPass = p95 <= SYNC_TEST_MAX_SKEW_MS;
+    fprintf(fp, "sync follower: %lld samples, skew p50 %.1f ms p95 %.1f ms max %.1f ms, rtt %.3f ms: %s\n",
+        (long long)m_nSkewTotal, p50, p95, m_dSkewTotalMax, m_nRtt / 1000.0, bPass ? "PASS" : "FAIL");
+    return bPass;
+}
+
+int ClockSync::RunTest(const QString &strProgram, const QString &strFile, int nFollowers, double dSeconds, int nPort, FILE *fp)
+{
+    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    std::vector<std::unique_ptr<QProcess>> vecProcs;
+    QString strPort = QString::number(nPort);
+    //主机一直运行到最后一个从机结束
+    double dMasterSeconds = dSeconds + nFollowers * SYNC_TEST_START_INTERVAL + SYNC_SEEK_HOLDOFF;
+    bool bPass = true;
+
+    //无人值守时静音运行
+    if (!env.contains("SDL_AUDIODRIVER"))
+    {
+        env.insert("SDL_AUDIODRIVER", "dummy");
+    }
+
+    fprintf(fp, "sync test: 1 master + %d follower(s) on 127.0.0.1:%d, %.0f s\n", nFollowers, nPort, dSeconds);
+    for (int i = 0; i <= nFollowers; i++)
+    {
+        QStringList listArgs;
+        listArgs << "--sync-play";
+        if (i == 0)
+        {
+            listArgs << "--master" << "--seconds" << QString::number(dMasterSeconds);
+        }
+        else
+        {
+            listArgs << "--follow" << "127.0.0.1" << "--seconds" << QString::number(dSeconds);
+        }
+        listArgs << "--port" << strPort << strFile;
+
+        //依次启动，后启动的从机需要 seek 追上主机
+        if (i > 0)
+        {
+            av_usleep((int64_t)(SYNC_TEST_START_INTERVAL * 1000000));
+        }
+        std::unique_ptr<QProcess> pProc(new QProcess());
+        pProc->setProcessEnvironment(env);
+        pProc->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        pProc->start(strProgram, listArgs);
+        if (!pProc->waitForStarted())
+        {
+            fprintf(fp, "sync test: could not start %s\n", strProgram.toUtf8().constData());
+            bPass = false;
+            break;
+        }
+        vecProcs.push_back(std::move(pProc));
+    }
+
+    //从机先结束，主机最后
+    for (size_t i = vecProcs.size(); i-- > 0;)
+    {
+        QProcess *pProc = vecProcs[i].get();
+        pProc->waitForFinished(-1);
+        QString strName = i == 0 ? QString("master") : QString("follower %1").arg(i);
+        for (const QString &strLine : QString::fromUtf8(pProc->readAllStandardOutput()).split('\n'))
+        {
+            if (strLine.trimmed().isEmpty())
+            {
+                continue;
+            }
+            fprintf(fp, "[%s] %s\n", strName.toUtf8().constData(), strLine.toUtf8().constData());
+        }
+        if (pProc->exitStatus() != QProcess::NormalExit || pProc->exitCode() != 0)
+        {
+            bPass = false;
+        }
+    }
+
+    fprintf(fp, "sync test: %s\n", bPass ? "PASS" : "FAIL");
+    return bPass ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+﻿/*
+ * @file 	clocksync.h
+ * @date 	2026/10/19 09:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	多个播放器之间的时钟同步（UDP）
+ * @note	拼接屏由多台电脑分别播放，画面需要逐帧对齐。一个播放器作为主机，其他播放器作为从机，
+ *			从机定期向主机发请求，主机回复当前时钟（pts、时间、速度、序号、暂停状态）。
+ *			从机按往返时间最短的几次估计两机的时间差，得到主机时钟在本机此刻的值，
+ *			外部时钟跟随该值（小偏差调速度，大偏差直接设置时钟由丢帧/重复帧追上，再大则 seek）。
+ *			主机不广播，按收到的请求回复，同一台机器上多个进程通过回环地址也能测试。
+ */
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "globalhelper.h"
+
+#define SYNC_DEFAULT_PORT 23450         //主机默认端口
+#define SYNC_PING_INTERVAL 0.1          //从机请求间隔（秒）
+#define SYNC_FILTER_SAMPLES 8           //取最近几次中往返时间最短的一次估计时间差
+#define SYNC_OFFSET_SMOOTH 0.25         //时间差估计的平滑系数
+#define SYNC_TIMEOUT 1.0                //超过该时间没有收到主机回复视为断开（秒）
+#define SYNC_FOLLOWER_TIMEOUT 3.0       //主机超过该时间没有收到从机请求，不再统计该从机（秒）
+#define SYNC_REPORT_INTERVAL 5.0        //输出偏差统计的间隔（秒）
+#define SYNC_SPEED_GAIN 0.5             //偏差 1 秒对应的时钟速度调整量
+#define SYNC_STEP_THRESHOLD 0.1         //超过该偏差直接设置时钟（秒）
+#define SYNC_SEEK_THRESHOLD 2.0         //超过该偏差 seek 到主机位置（秒）
+#define SYNC_SEEK_HOLDOFF 2.0           //seek 或直接设置时钟后等待的时间，期间不再 seek，也不统计偏差（秒）
+#define SYNC_TEST_MAX_SKEW_MS 20.0      //测试通过的偏差上限（95 分位，毫秒）
+#define SYNC_TEST_START_INTERVAL 1.0    //测试中各进程依次启动的间隔（秒）
+#define SYNC_SKEW_HIST_BIN_MS 0.1       //偏差直方图每格的宽度（毫秒）
+#define SYNC_SKEW_HIST_BINS 10000       //偏差直方图格数，最后一格计入 1 秒以上的偏差
+
+enum SyncRole {
+    SYNC_ROLE_OFF,
+    SYNC_ROLE_MASTER,       //发布本机时钟
+    SYNC_ROLE_FOLLOWER      //跟随主机时钟
+};
+
+class ClockSync
+{
+public:
+    ClockSync();
+    ~ClockSync();
+
+    static ClockSync* GetInstance();
+
+    /**
+     * @brief	作为主机，在端口上等待从机请求
+     *
+     * @param	nPort UDP 端口
+     * @return	true 成功 false 端口无法使用
+     */
+    bool StartMaster(int nPort);
+
+    /**
+     * @brief	作为从机，跟随主机时钟
+     *
+     * @param	strHost 主机地址
+     * @param	nPort 主机端口
+     * @return	true 成功 false 地址无效
+     */
+    bool StartFollower(const QString &strHost, int nPort);
+
+    void Stop();
+    int GetRole();
+
+    /**
+     * @brief	主机更新当前时钟，刷新线程每次刷新时调用
+     *
+     * @param	dPts 时钟值（秒），NAN 表示无效（seek 中）
+     * @param	dSpeed 时钟速度
+     * @param	nSerial 序号，seek 后改变
+     * @param	bPaused 是否暂停
+     */
+    void SetMasterClock(double dPts, double dSpeed, int nSerial, bool bPaused);
+
+    /**
+     * @brief	从机取主机时钟在本机某一时间的值
+     *
+     * @param	nNow 本机时间（av_gettime_relative，微秒）
+     * @return	false 还没有收到主机时钟或已断开
+     */
+    bool GetMasterClock(int64_t nNow, double *pPts, double *pSpeed, int *pSerial, bool *pPaused);
+
+    /**
+     * @brief	从机累加一次偏差
+     *
+     * @param	dSkew 本机时钟 - 主机时钟（秒）
+     */
+    void AddSkew(double dSkew);
+
+    /**
+     * @brief	输出整个运行期间的偏差统计
+     *
+     * @return	从机：偏差 95 分位不超过 SYNC_TEST_MAX_SKEW_MS 为 true；主机：有从机为 true
+     */
+    bool Summary(FILE *fp);
+
+    /**
+     * @brief	同一台机器上启动一个主机、若干从机进程（无界面），通过回环地址同步，输出偏差
+     *
+     * @param	strProgram 播放器程序
+     * @param	strFile 播放的文件
+     * @param	nFollowers 从机个数
+     * @param	dSeconds 每个从机的运行时长（秒）
+     * @param	nPort 端口
+     * @return	进程返回值，0 表示所有从机通过
+     */
+    static int RunTest(const QString &strProgram, const QString &strFile, int nFollowers, double dSeconds, int nPort, FILE *fp);
+
+private:
+    bool OpenSocket(int nPort);
+    void CloseSocket();
+    void MasterThread();
+    void FollowerThread();
+    void UpdateReport(int64_t nNow);
+    //偏差直方图的分位数（毫秒），取所在格的上边界，只在持有 m_mutex 时调用
+    double SkewPercentile(double dQuantile) const;
+
+private:
+    static ClockSync* m_pInstance; //< 单例指针
+
+    //主机时钟的一次快照
+    typedef struct MasterClock {
+        double pts;
+        int64_t time;       //取时钟值的时间（主机 av_gettime_relative，微秒）
+        double speed;
+        int serial;
+        int paused;
+    } MasterClock;
+
+    //一次请求的往返
+    typedef struct OffsetSample {
+        int64_t offset;     //主机时间 - 本机时间（微秒）
+        int64_t rtt;        //往返时间，不含主机处理时间（微秒）
+    } OffsetSample;
+
+    //主机记录的从机
+    typedef struct FollowerInfo {
+        int64_t last_seen;
+        double skew_mean_ms;    //最近一个统计周期的平均偏差（带符号）
+        double skew_max_ms;     //最近一个统计周期的最大偏差（绝对值）
+        double rtt_ms;
+    } FollowerInfo;
+
+    std::atomic<int> m_nRole;
+    intptr_t m_nSocket;
+    std::thread m_tThread;
+    std::atomic<bool> m_bRunning;
+    uint32_t m_nMasterIp;               //< 从机：主机地址（网络字节序）
+    uint16_t m_nMasterPort;             //< 从机：主机端口（网络字节序）
+
+    std::mutex m_mutex;
+    MasterClock m_stClock;              //< 主机：本机时钟；从机：收到的主机时钟
+    //从机
+    std::vector<OffsetSample> m_vecSamples;
+    int64_t m_nLastRecv;                //< 最近一次收到回复的本机时间，0 表示没有
+    double m_dOffset;                   //< 平滑后的时间差（微秒）
+    int64_t m_nRtt;                     //< 选中样本的往返时间（微秒）
+    double m_dSkewSum, m_dSkewMax;      //< 当前统计周期
+    int64_t m_nSkewCount;
+    double m_dReportMean, m_dReportMax; //< 上一个统计周期，随请求发给主机
+    //全部偏差绝对值的直方图，用于最终统计；界面跟随时长期运行，不保存每个样本
+    std::vector<int64_t> m_vecSkewHist;
+    int64_t m_nSkewTotal;
+    double m_dSkewTotalMax;
+    //主机
+    std::map<std::string, FollowerInfo> m_mapFollowers;
+    double m_dSpreadMaxMs;              //< 运行期间各实例间最大偏差
+    int64_t m_nNextReport;
+};
+
+#endif // CLOCKSYNC_H
@@ -0,0 +1,1100 @@
+﻿/*
+ * @file 	colorlut.cpp
+ * @date 	2026/10/18 14:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	颜色管理
+ * @note
+ */
+
+#include <new>
+#include <math.h>
+#include <ctype.h>
+
+#include <QFile>
+
+#include "colorlut.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLOR_LUT_SSE2 1
+#endif
+
+#pragma execution_character_set("utf-8")
+
+#define DISPLAY_TRC_SIZE 4096       //显示器传输曲线查找表大小（按线性值的平方根均匀取样）
+#define PQ_REFERENCE_WHITE 203.0    //HDR 参考白亮度 (cd/m2)，映射到显示器白
+#define HLG_NOMINAL_PEAK 1000.0     //HLG 标称峰值亮度 (cd/m2)
+#define TONEMAP_KNEE 0.8            //HDR 高光压缩起点
+
+struct LutTable {
+    int size;                       //< 每个轴的节点数
+    int depth;                      //< 输入位深
+    float *nodes;                   //< size^3 个节点，每个节点 B G R A，16 字节对齐
+    int offset[3][1 << 10];         //< Y U V 码值对应的节点偏移（已乘步长）
+    float frac[3][1 << 10];         //< Y U V 码值在节点间的位置
+};
+
+namespace {
+
+typedef double Mat3[3][3];
+
+const double D50_WHITE[3] = { 0.9642, 1.0, 0.8249 };
+
+typedef struct Primaries {
+    double xy[4][2]; //R G B W
+} Primaries;
+
+const Primaries PRIM_BT709    = { { { 0.640, 0.330 }, { 0.300, 0.600 }, { 0.150, 0.060 }, { 0.3127, 0.3290 } } };
+const Primaries PRIM_BT470M   = { { { 0.670, 0.330 }, { 0.210, 0.710 }, { 0.140, 0.080 }, { 0.3100, 0.3160 } } };
+const Primaries PRIM_BT470BG  = { { { 0.640, 0.330 }, { 0.290, 0.600 }, { 0.150, 0.060 }, { 0.3127, 0.3290 } } };
+const Primaries PRIM_SMPTE170 = { { { 0.630, 0.340 }, { 0.310, 0.595 }, { 0.155, 0.070 }, { 0.3127, 0.3290 } } };
+const Primaries PRIM_BT2020   = { { { 0.708, 0.292 }, { 0.170, 0.797 }, { 0.131, 0.046 }, { 0.3127, 0.3290 } } };
+const Primaries PRIM_DCI_P3   = { { { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 }, { 0.3140, 0.3510 } } };
+const Primaries PRIM_P3_D65   = { { { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 }, { 0.3127, 0.3290 } } };
+
+const Primaries *GetPrimaries(int prim)
+{
+    switch (prim) {
+    case AVCOL_PRI_BT470M:    return &PRIM_BT470M;
+    case AVCOL_PRI_BT470BG:   return &PRIM_BT470BG;
+    case AVCOL_PRI_SMPTE170M:
+    case AVCOL_PRI_SMPTE240M: return &PRIM_SMPTE170;
+    case AVCOL_PRI_BT2020:    return &PRIM_BT2020;
+    case AVCOL_PRI_SMPTE431:  return &PRIM_DCI_P3;
+    case AVCOL_PRI_SMPTE432:  return &PRIM_P3_D65;
+    default:                  return &PRIM_BT709;
+    }
+}
+
+void XyToXyz(const double xy[2], double xyz[3])
+{
+    xyz[0] = xy[0] / xy[1];
+    xyz[1] = 1.0;
+    xyz[2] = (1.0 - xy[0] - xy[1]) / xy[1];
+}
+
+void Mat3Mul(const Mat3 a, const Mat3 b, Mat3 out)
+{
+    Mat3 t;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            t[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+    memcpy(out, t, sizeof(t));
+}
+
+void Mat3Apply(const Mat3 m, const double in[3], double out[3])
+{
+    double t[3];
+    for (int i = 0; i < 3; i++)
+        t[i] = m[i][0] * in[0] + m[i][1] * in[1] + m[i][2] * in[2];
+    memcpy(out, t, sizeof(t));
+}
+
+bool Mat3Invert(const Mat3 m, Mat3 out)
+{
+    double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                 m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                 m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    Mat3 t;
+
+    if (fabs(det) < 1e-12)
+        return false;
+
+    t[0][0] =  (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det;
+    t[0][1] = -(m[0][1] * m[2][2] - m[0][2] * m[2][1]) / det;
+    t[0][2] =  (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det;
+    t[1][0] = -(m[1][0] * m[2][2] - m[1][2] * m[2][0]) / det;
+    t[1][1] =  (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+    t[1][2] = -(m[0][0] * m[1][2] - m[0][2] * m[1][0]) / det;
+    t[2][0] =  (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det;
+    t[2][1] = -(m[0][0] * m[2][1] - m[0][1] * m[2][0]) / det;
+    t[2][2] =  (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+    memcpy(out, t, sizeof(t));
+    return true;
+}
+
+//线性 RGB 转 XYZ
+void RgbToXyzMatrix(const Primaries *p, Mat3 out)
+{
+    Mat3 m, inv;
+    double w[3], s[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        double xyz[3];
+        XyToXyz(p->xy[c], xyz);
+        for (int i = 0; i < 3; i++)
+            m[i][c] = xyz[i];
+    }
+    XyToXyz(p->xy[3], w);
+    Mat3Invert(m, inv);
+    Mat3Apply(inv, w, s);
+    for (int i = 0; i < 3; i++)
+        for (int c = 0; c < 3; c++)
+            out[i][c] = m[i][c] * s[c];
+}
+
+//Bradford 白点适配
+void BradfordMatrix(const double src_white[3], const double dst_white[3], Mat3 out)
+{
+    const Mat3 bradford = {
+        {  0.8951,  0.2664, -0.1614 },
+        { -0.7502,  1.7135,  0.0367 },
+        {  0.0389, -0.0685,  1.0296 }
+    };
+    Mat3 inv, scale = { { 0 } };
+    double src[3], dst[3];
+
+    Mat3Apply(bradford, src_white, src);
+    Mat3Apply(bradford, dst_white, dst);
+    for (int i = 0; i < 3; i++)
+        scale[i][i] = dst[i] / src[i];
+    Mat3Invert(bradford, inv);
+    Mat3Mul(scale, bradford, out);
+    Mat3Mul(inv, out, out);
+}
+
+//源 RGB 转 XYZ(D50)
+void SourceToPcsMatrix(const Primaries *p, Mat3 out)
+{
+    Mat3 to_xyz, adapt;
+    double white[3];
+
+    RgbToXyzMatrix(p, to_xyz);
+    XyToXyz(p->xy[3], white);
+    BradfordMatrix(white, D50_WHITE, adapt);
+    Mat3Mul(adapt, to_xyz, out);
+}
+
+double PqToLinear(double v)
+{
+    const double m1 = 2610.0 / 16384.0;
+    const double m2 = 2523.0 / 4096.0 * 128.0;
+    const double c1 = 3424.0 / 4096.0;
+    const double c2 = 2413.0 / 4096.0 * 32.0;
+    const double c3 = 2392.0 / 4096.0 * 32.0;
+    double p = pow(v, 1.0 / m2);
+
+    return pow(FFMAX(p - c1, 0.0) / (c2 - c3 * p), 1.0 / m1) * 10000.0 / PQ_REFERENCE_WHITE;
+}
+
+double HlgToScene(double v)
+{
+    const double a = 0.17883277;
+    const double b = 0.28466892;
+    const double c = 0.55991073;
+
+    return v <= 0.5 ? v * v / 3.0 : (exp((v - c) / a) + b) / 12.0;
+}
+
+//源信号转线性光，1.0 为参考白（HLG 为场景光，之后再做 OOTF）
+//SDR 曲线对超出 [0,1] 的值做奇延拓，色域边缘附近的节点插值不会被截断拉偏
+double TrcToLinear(int trc, double v)
+{
+    if (trc == AVCOL_TRC_SMPTE2084 || trc == AVCOL_TRC_ARIB_STD_B67)
+        v = av_clipd(v, 0.0, 1.0);
+    else if (v < 0.0)
+        return -TrcToLinear(trc, -v);
+
+    switch (trc) {
+    case AVCOL_TRC_LINEAR:       return v;
+    case AVCOL_TRC_IEC61966_2_1: return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+    case AVCOL_TRC_GAMMA22:      return pow(v, 2.2);
+    case AVCOL_TRC_GAMMA28:      return pow(v, 2.8);
+    case AVCOL_TRC_SMPTE2084:    return PqToLinear(v);
+    case AVCOL_TRC_ARIB_STD_B67: return HlgToScene(v);
+    default:                     return pow(v, 2.4); //BT.1886
+    }
+}
+
+//高光压缩，膝点以下保持不变，以上平滑趋近显示器白
+double ToneMap(double l)
+{
+    double x;
+
+    if (l <= TONEMAP_KNEE)
+        return l;
+    x = (l - TONEMAP_KNEE) / (1.0 - TONEMAP_KNEE);
+    return TONEMAP_KNEE + (1.0 - TONEMAP_KNEE) * x / (1.0 + x);
+}
+
+int ResolveColorSpace(const AVFrame *frame)
+{
+    if (frame->colorspace == AVCOL_SPC_UNSPECIFIED)
+        return frame->height >= 720 ? AVCOL_SPC_BT709 : AVCOL_SPC_SMPTE170M;
+    return frame->colorspace;
+}
+
+void GetLumaCoefficients(const AVFrame *frame, double *kr, double *kb)
+{
+    switch (ResolveColorSpace(frame)) {
+    case AVCOL_SPC_BT709:      *kr = 0.2126; *kb = 0.0722; break;
+    case AVCOL_SPC_FCC:        *kr = 0.30;   *kb = 0.11;   break;
+    case AVCOL_SPC_SMPTE240M:  *kr = 0.212;  *kb = 0.087;  break;
+    case AVCOL_SPC_BT2020_NCL:
+    case AVCOL_SPC_BT2020_CL:  *kr = 0.2627; *kb = 0.0593; break;
+    default:                   *kr = 0.299;  *kb = 0.114;  break;
+    }
+}
+
+bool IsFullRange(const AVFrame *frame)
+{
+    return frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P;
+}
+
+//与原有显示路径一致、不需要转换的源
+bool IsReferenceSource(const AVFrame *frame)
+{
+    switch (frame->color_primaries) {
+    case AVCOL_PRI_BT709:
+    case AVCOL_PRI_UNSPECIFIED:
+        break;
+    default:
+        return false;
+    }
+
+    switch (frame->color_trc) {
+    case AVCOL_TRC_BT709:
+    case AVCOL_TRC_UNSPECIFIED:
+    case AVCOL_TRC_SMPTE170M:
+    case AVCOL_TRC_BT2020_10:
+    case AVCOL_TRC_BT2020_12:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//ICC 配置文件解析，只支持矩阵/曲线型（显示器配置通常如此）
+typedef struct IccCurve {
+    int type;                   //-1 查找表，0~4 参数曲线类型
+    double params[7];           //g a b c d e f
+    std::vector<double> table;
+} IccCurve;
+
+uint32_t ReadBe32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+uint16_t ReadBe16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+double ReadS15Fixed16(const uint8_t *p)
+{
+    return (int32_t)ReadBe32(p) / 65536.0;
+}
+
+bool FindIccTag(const QByteArray &baIcc, const char *sig, const uint8_t **data, uint32_t *size)
+{
+    const uint8_t *p = (const uint8_t *)baIcc.constData();
+    uint32_t count;
+
+    if (baIcc.size() < 132)
+        return false;
+    count = ReadBe32(p + 128);
+    if (count > (uint32_t)(baIcc.size() - 132) / 12)
+        return false;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint8_t *entry = p + 132 + i * 12;
+        uint32_t offset = ReadBe32(entry + 4);
+        uint32_t len = ReadBe32(entry + 8);
+        if (memcmp(entry, sig, 4))
+            continue;
+        if (offset > (uint32_t)baIcc.size() || len > (uint32_t)baIcc.size() - offset || len < 12)
+            return false;
+        *data = p + offset;
+        *size = len;
+        return true;
+    }
+    return false;
+}
+
+bool ParseIccXyz(const QByteArray &baIcc, const char *sig, double xyz[3])
+{
+    const uint8_t *p;
+    uint32_t size;
+
+    if (!FindIccTag(baIcc, sig, &p, &size) || size < 20 || memcmp(p, "XYZ ", 4))
+        return false;
+    for (int i = 0; i < 3; i++)
+        xyz[i] = ReadS15Fixed16(p + 8 + i * 4);
+    return true;
+}
+
+bool ParseIccCurve(const QByteArray &baIcc, const char *sig, IccCurve *curve)
+{
+    static const int para_count[5] = { 1, 3, 4, 5, 7 };
+    const uint8_t *p;
+    uint32_t size, n;
+
+    if (!FindIccTag(baIcc, sig, &p, &size))
+        return false;
+
+    memset(curve->params, 0, sizeof(curve->params));
+    curve->table.clear();
+
+    if (!memcmp(p, "curv", 4))
+    {
+        n = ReadBe32(p + 8);
+        if (n > (size - 12) / 2)
+            return false;
+        curve->type = 0;
+        if (n == 0)
+        {
+            curve->params[0] = 1.0;
+        }
+        else if (n == 1)
+        {
+            curve->params[0] = ReadBe16(p + 12) / 256.0;
+        }
+        else
+        {
+            curve->type = -1;
+            for (uint32_t i = 0; i < n; i++)
+                curve->table.push_back(ReadBe16(p + 12 + i * 2) / 65535.0);
+        }
+        return true;
+    }
+
+    if (!memcmp(p, "para", 4))
+    {
+        curve->type = ReadBe16(p + 8);
+        if (curve->type > 4 || size < 12 + 4 * (uint32_t)para_count[curve->type])
+            return false;
+        for (int i = 0; i < para_count[curve->type]; i++)
+            curve->params[i] = ReadS15Fixed16(p + 12 + i * 4);
+        //类型 1、2 的分段点为 -c/a，a 为 0 的曲线无效
+        if ((curve->type == 1 || curve->type == 2) && curve->params[1] == 0.0)
+            return false;
+        return true;
+    }
+
+    return false;
+}
+
+//显示器传输曲线：信号转线性
+double EvalIccCurve(const IccCurve &curve, double x)
+{
+    const double *q = curve.params;
+
+    switch (curve.type) {
+    case -1: {
+        double pos = x * (curve.table.size() - 1);
+        int i = FFMIN((int)pos, (int)curve.table.size() - 2);
+        return curve.table[i] + (curve.table[i + 1] - curve.table[i]) * (pos - i);
+    }
+    case 0: return pow(x, q[0]);
+    case 1: return x >= -q[2] / q[1] ? pow(q[1] * x + q[2], q[0]) : 0.0;
+    case 2: return x >= -q[2] / q[1] ? pow(q[1] * x + q[2], q[0]) + q[3] : q[3];
+    case 3: return x >= q[4] ? pow(q[1] * x + q[2], q[0]) : q[3] * x;
+    case 4: return x >= q[4] ? pow(q[1] * x + q[2], q[0]) + q[5] : q[3] * x + q[6];
+    default: return x;
+    }
+}
+
+//线性转信号查找表，曲线单调，二分求逆
+void BuildInverseTrc(const IccCurve &curve, std::vector<float> &vecTrc)
+{
+    vecTrc.resize(DISPLAY_TRC_SIZE);
+    for (int i = 0; i < DISPLAY_TRC_SIZE; i++)
+    {
+        double s = (double)i / (DISPLAY_TRC_SIZE - 1);
+        double target = s * s;
+        double lo = 0.0, hi = 1.0;
+        for (int k = 0; k < 24; k++)
+        {
+            double mid = (lo + hi) / 2;
+            if (EvalIccCurve(curve, mid) < target)
+                lo = mid;
+            else
+                hi = mid;
+        }
+        vecTrc[i] = (float)((lo + hi) / 2);
+    }
+}
+
+void BuildReferenceTrc(std::vector<float> &vecTrc)
+{
+    IccCurve curve;
+    curve.type = 0;
+    memset(curve.params, 0, sizeof(curve.params));
+    curve.params[0] = 2.4;
+    BuildInverseTrc(curve, vecTrc);
+}
+
+void ReferenceDisplayMatrix(Mat3 out)
+{
+    Mat3 to_pcs;
+    SourceToPcsMatrix(&PRIM_BT709, to_pcs);
+    Mat3Invert(to_pcs, out);
+}
+
+void FreeLutTable(LutTable *table)
+{
+    if (table)
+    {
+        av_freep(&table->nodes);
+        delete table;
+    }
+}
+
+//四面体插值，结果为 B G R A 四个字节
+inline uint32_t LutBlend(const float *c0, const float *ca, const float *cb, const float *c1, float w0, float w1, float w2)
+{
+#ifdef COLOR_LUT_SSE2
+    __m128 v0 = _mm_load_ps(c0);
+    __m128 va = _mm_load_ps(ca);
+    __m128 vb = _mm_load_ps(cb);
+    __m128 v1 = _mm_load_ps(c1);
+    __m128 r = _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(va, v0), _mm_set1_ps(w0)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_sub_ps(vb, va), _mm_set1_ps(w1)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_sub_ps(v1, vb), _mm_set1_ps(w2)));
+    __m128i i = _mm_cvtps_epi32(r);
+    i = _mm_packs_epi32(i, i);
+    i = _mm_packus_epi16(i, i);
+    return (uint32_t)_mm_cvtsi128_si32(i);
+#else
+    uint32_t out = 0;
+    for (int c = 0; c < 4; c++)
+    {
+        float v = c0[c] + (ca[c] - c0[c]) * w0 + (cb[c] - ca[c]) * w1 + (c1[c] - cb[c]) * w2;
+        out |= (uint32_t)av_clip_uint8(lrintf(v)) << (c * 8);
+    }
+    return out;
+#endif
+}
+
+template <typename T>
+void ApplyRows(const LutJob &job, int y0, int y1)
+{
+    const LutTable *t = job.table;
+    const AVFrame *frame = job.frame;
+    const int sy = 4;
+    const int su = 4 * t->size;
+    const int sv = 4 * t->size * t->size;
+    const int mask = (1 << t->depth) - 1;
+
+    for (int y = y0; y < y1; y++)
+    {
+        const T *py = (const T *)(frame->data[0] + y * frame->linesize[0]);
+        const T *pu = (const T *)(frame->data[1] + (y >> 1) * frame->linesize[1]);
+        const T *pv = (const T *)(frame->data[2] + (y >> 1) * frame->linesize[2]);
+        uint32_t *out = (uint32_t *)(job.pixels + (y - job.y) * job.pitch) - job.x;
+
+        for (int x = job.x; x < job.x + job.w; x++)
+        {
+            int cy = py[x] & mask;
+            int cu = pu[x >> 1] & mask;
+            int cv = pv[x >> 1] & mask;
+            const float *c0 = t->nodes + t->offset[0][cy] + t->offset[1][cu] + t->offset[2][cv];
+            float fy = t->frac[0][cy];
+            float fu = t->frac[1][cu];
+            float fv = t->frac[2][cv];
+            int a, b;
+            float w0, w1, w2;
+
+            //按三个小数部分的大小选择四面体
+            if (fy >= fu)
+            {
+                if (fu >= fv)      { a = sy; b = sy + su; w0 = fy; w1 = fu; w2 = fv; }
+                else if (fy >= fv) { a = sy; b = sy + sv; w0 = fy; w1 = fv; w2 = fu; }
+                else               { a = sv; b = sy + sv; w0 = fv; w1 = fy; w2 = fu; }
+            }
+            else
+            {
+                if (fv >= fu)      { a = sv; b = su + sv; w0 = fv; w1 = fu; w2 = fy; }
+                else if (fv >= fy) { a = su; b = su + sv; w0 = fu; w1 = fv; w2 = fy; }
+                else               { a = su; b = sy + su; w0 = fu; w1 = fy; w2 = fv; }
+            }
+
+            out[x] = LutBlend(c0, c0 + a, c0 + b, c0 + sy + su + sv, w0, w1, w2);
+        }
+    }
+}
+
+}
+
+ColorLut::ColorLut() :
+    m_bEnabled(true),
+    m_bHasProfile(false),
+    m_nCubeSize(0),
+    m_nConfigSerial(0),
+    m_bRunning(false),
+    m_nNextSlice(0),
+    m_nDoneSlices(0)
+{
+    memset(&m_stJob, 0, sizeof(m_stJob));
+    ReferenceDisplayMatrix(m_dDisplayFromXyz);
+    for (int c = 0; c < 3; c++)
+    {
+        BuildReferenceTrc(m_vecDisplayTrc[c]);
+    }
+}
+
+ColorLut::~ColorLut()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexJob);
+        m_bRunning = false;
+    }
+    m_condJob.notify_all();
+    for (std::thread &worker : m_vecWorkers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+void ColorLut::SetEnabled(bool bEnabled)
+{
+    m_bEnabled = bEnabled;
+}
+
+bool ColorLut::SetDisplayProfile(const QString &strIccFile)
+{
+    std::lock_guard<std::mutex> lock(m_mutexConfig);
+    QByteArray baIcc;
+    double xyz[3][3];
+    IccCurve curves[3];
+    Mat3 to_pcs;
+    static const char *colorant_tags[3] = { "rXYZ", "gXYZ", "bXYZ" };
+    static const char *trc_tags[3] = { "rTRC", "gTRC", "bTRC" };
+
+    m_nConfigSerial++;
+    m_bHasProfile = false;
+    ReferenceDisplayMatrix(m_dDisplayFromXyz);
+    for (int c = 0; c < 3; c++)
+    {
+        BuildReferenceTrc(m_vecDisplayTrc[c]);
+    }
+
+    if (strIccFile.isEmpty())
+    {
+        return true;
+    }
+
+    QFile fileIcc(strIccFile);
+    if (!fileIcc.open(QIODevice::ReadOnly))
+    {
+        av_log(NULL, AV_LOG_WARNING, "Cannot open display profile %s\n", strIccFile.toLocal8Bit().constData());
+        return false;
+    }
+    baIcc = fileIcc.readAll();
+    fileIcc.close();
+
+    //文件头：'acsp' 标识，RGB 设备，XYZ 连接空间
+    if (baIcc.size() < 132 || memcmp(baIcc.constData() + 36, "acsp", 4) ||
+        memcmp(baIcc.constData() + 16, "RGB ", 4) || memcmp(baIcc.constData() + 20, "XYZ ", 4))
+    {
+        av_log(NULL, AV_LOG_WARNING, "Unsupported display profile %s\n", strIccFile.toLocal8Bit().constData());
+        return false;
+    }
+
+    for (int c = 0; c < 3; c++)
+    {
+        if (!ParseIccXyz(baIcc, colorant_tags[c], xyz[c]) || !ParseIccCurve(baIcc, trc_tags[c], &curves[c]))
+        {
+            av_log(NULL, AV_LOG_WARNING, "Display profile %s is not a matrix/TRC profile, using BT.709 reference display\n",
+                strIccFile.toLocal8Bit().constData());
+            return false;
+        }
+    }
+
+    //ICC 的着色剂已适配到 D50
+    for (int i = 0; i < 3; i++)
+        for (int c = 0; c < 3; c++)
+            to_pcs[i][c] = xyz[c][i];
+    if (!Mat3Invert(to_pcs, m_dDisplayFromXyz))
+    {
+        ReferenceDisplayMatrix(m_dDisplayFromXyz);
+        return false;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        BuildInverseTrc(curves[c], m_vecDisplayTrc[c]);
+    }
+    m_bHasProfile = true;
+
+    av_log(NULL, AV_LOG_INFO, "Display profile %s loaded\n", strIccFile.toLocal8Bit().constData());
+
+    return true;
+}
+
+bool ColorLut::SetLutFile(const QString &strCubeFile)
+{
+    std::lock_guard<std::mutex> lock(m_mutexConfig);
+    std::vector<float> vecCube;
+    int nSize = 0;
+    bool bValid = true;
+    double dMin[3] = { 0.0, 0.0, 0.0 };
+    double dMax[3] = { 1.0, 1.0, 1.0 };
+
+    m_nConfigSerial++;
+    m_nCubeSize = 0;
+    m_vecCube.clear();
+
+    if (strCubeFile.isEmpty())
+    {
+        return true;
+    }
+
+    QFile fileCube(strCubeFile);
+    if (!fileCube.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        av_log(NULL, AV_LOG_WARNING, "Cannot open LUT file %s\n", strCubeFile.toLocal8Bit().constData());
+        return false;
+    }
+
+    while (!fileCube.atEnd())
+    {
+        QByteArray baLine = fileCube.readLine().simplified();
+        QList<QByteArray> listFields;
+
+        if (baLine.isEmpty() || baLine.startsWith('#') || baLine.startsWith("TITLE"))
+            continue;
+
+        listFields = baLine.split(' ');
+        if (listFields[0] == "LUT_3D_SIZE")
+        {
+            //只能出现一次，且在数据之前
+            if (nSize || listFields.size() != 2 || !vecCube.empty())
+            {
+                bValid = false;
+                break;
+            }
+            nSize = listFields[1].toInt();
+            if (nSize < 2 || nSize > 256)
+            {
+                bValid = false;
+                break;
+            }
+            vecCube.reserve((size_t)nSize * nSize * nSize * 3);
+        }
+        else if (listFields[0] == "DOMAIN_MIN" && listFields.size() == 4)
+        {
+            for (int i = 0; i < 3; i++)
+                dMin[i] = listFields[i + 1].toDouble();
+        }
+        else if (listFields[0] == "DOMAIN_MAX" && listFields.size() == 4)
+        {
+            for (int i = 0; i < 3; i++)
+                dMax[i] = listFields[i + 1].toDouble();
+        }
+        else if (listFields[0] == "LUT_1D_SIZE")
+        {
+            av_log(NULL, AV_LOG_WARNING, "1D LUT is not supported: %s\n", strCubeFile.toLocal8Bit().constData());
+            return false;
+        }
+        else if (isalpha((unsigned char)listFields[0][0]))
+        {
+            //其他关键字（LUT_3D_INPUT_RANGE 等）忽略
+        }
+        else
+        {
+            //数据在 LUT_3D_SIZE 之前、多于 size³ 行、不是 3 个数时无效
+            if (listFields.size() != 3 || !nSize || vecCube.size() >= (size_t)nSize * nSize * nSize * 3)
+            {
+                bValid = false;
+                break;
+            }
+            for (int i = 0; i < 3; i++)
+            {
+                bool bOk = false;
+                vecCube.push_back(listFields[i].toFloat(&bOk));
+                bValid = bValid && bOk;
+            }
+            if (!bValid)
+                break;
+        }
+    }
+    fileCube.close();
+
+    if (!bValid || nSize < 2 || vecCube.size() != (size_t)nSize * nSize * nSize * 3 ||
+        dMax[0] <= dMin[0] || dMax[1] <= dMin[1] || dMax[2] <= dMin[2])
+    {
+        av_log(NULL, AV_LOG_WARNING, "Invalid LUT file %s: LUT_3D_SIZE %d, %d entries\n",
+            strCubeFile.toLocal8Bit().constData(), nSize, (int)(vecCube.size() / 3));
+        return false;
+    }
+
+    m_nCubeSize = nSize;
+    m_vecCube.swap(vecCube);
+    memcpy(m_dCubeMin, dMin, sizeof(dMin));
+    memcpy(m_dCubeMax, dMax, sizeof(dMax));
+
+    av_log(NULL, AV_LOG_INFO, "LUT file %s loaded, size %d\n", strCubeFile.toLocal8Bit().constData(), nSize);
+
+    return true;
+}
+
+bool ColorLut::IsNeeded(const AVFrame *frame)
+{
+    if (!m_bEnabled)
+    {
+        return false;
+    }
+
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P && frame->format != AV_PIX_FMT_YUV420P10)
+    {
+        return false;
+    }
+
+    if (frame->linesize[0] < 0 || frame->linesize[1] < 0 || frame->linesize[2] < 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutexConfig);
+    if (m_bHasProfile || m_nCubeSize > 0)
+    {
+        return true;
+    }
+
+    return !IsReferenceSource(frame);
+}
+
+void ColorLut::EncodeDisplay(const double xyz_d50[3], float out[3])
+{
+    double rgb[3];
+
+    Mat3Apply(m_dDisplayFromXyz, xyz_d50, rgb);
+    for (int c = 0; c < 3; c++)
+    {
+        const std::vector<float> &trc = m_vecDisplayTrc[c];
+        double lin = fabs(rgb[c]);
+        double v;
+
+        //超出显示器范围的部分线性外推，最终输出时再裁剪
+        if (lin > 1.0)
+        {
+            double last = (double)(DISPLAY_TRC_SIZE - 2) / (DISPLAY_TRC_SIZE - 1);
+            double slope = (trc[DISPLAY_TRC_SIZE - 1] - trc[DISPLAY_TRC_SIZE - 2]) / (1.0 - last * last);
+            v = trc[DISPLAY_TRC_SIZE - 1] + (lin - 1.0) * slope;
+        }
+        else
+        {
+            double pos = sqrt(lin) * (DISPLAY_TRC_SIZE - 1);
+            int i = FFMIN((int)pos, DISPLAY_TRC_SIZE - 2);
+            v = trc[i] + (trc[i + 1] - trc[i]) * (pos - i);
+        }
+        out[c] = (float)(rgb[c] < 0.0 ? -v : v);
+    }
+}
+
+void ColorLut::SampleCube(const double rgb[3], float out[3])
+{
+    const int n = m_nCubeSize;
+    int idx[3];
+    double f[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        double pos = (rgb[c] - m_dCubeMin[c]) / (m_dCubeMax[c] - m_dCubeMin[c]);
+        pos = av_clipd(pos, 0.0, 1.0) * (n - 1);
+        idx[c] = FFMIN((int)pos, n - 2);
+        f[c] = pos - idx[c];
+    }
+
+    //.cube 中 R 变化最快
+    for (int c = 0; c < 3; c++)
+    {
+        double v = 0.0;
+        for (int k = 0; k < 8; k++)
+        {
+            int dr = k & 1, dg = (k >> 1) & 1, db = (k >> 2) & 1;
+            double w = (dr ? f[0] : 1 - f[0]) * (dg ? f[1] : 1 - f[1]) * (db ? f[2] : 1 - f[2]);
+            size_t node = ((size_t)(idx[2] + db) * n + (idx[1] + dg)) * n + (idx[0] + dr);
+            v += w * m_vecCube[node * 3 + c];
+        }
+        out[c] = (float)v;
+    }
+}
+
+LutTable *ColorLut::BuildTable(const AVFrame *frame)
+{
+    const Primaries *prim = GetPrimaries(frame->color_primaries);
+    const int n = COLOR_LUT_SIZE;
+    const int trc = frame->color_trc;
+    const bool hdr = trc == AVCOL_TRC_SMPTE2084 || trc == AVCOL_TRC_ARIB_STD_B67;
+    LutTable *table;
+    Mat3 to_pcs, to_xyz;
+    double kr, kb;
+    int depth, max_code;
+    bool full_range = IsFullRange(frame);
+
+    table = new (std::nothrow) LutTable();
+    if (!table)
+    {
+        return nullptr;
+    }
+    table->size = n;
+    table->depth = depth = frame->format == AV_PIX_FMT_YUV420P10 ? 10 : 8;
+    table->nodes = (float *)av_malloc(sizeof(float) * 4 * n * n * n);
+    if (!table->nodes)
+    {
+        FreeLutTable(table);
+        return nullptr;
+    }
+    max_code = (1 << depth) - 1;
+
+    GetLumaCoefficients(frame, &kr, &kb);
+    SourceToPcsMatrix(prim, to_pcs);
+    RgbToXyzMatrix(prim, to_xyz);
+
+    for (int iv = 0; iv < n; iv++)
+    {
+        for (int iu = 0; iu < n; iu++)
+        {
+            for (int iy = 0; iy < n; iy++)
+            {
+                double code[3] = { (double)iy * max_code / (n - 1), (double)iu * max_code / (n - 1), (double)iv * max_code / (n - 1) };
+                double yy, cb, cr, rgb[3];
+                float out[3];
+                float *node = table->nodes + 4 * ((iv * n + iu) * n + iy);
+
+                if (full_range)
+                {
+                    yy = code[0] / max_code;
+                    cb = (code[1] - (1 << (depth - 1))) / max_code;
+                    cr = (code[2] - (1 << (depth - 1))) / max_code;
+                }
+                else
+                {
+                    double s = 1 << (depth - 8);
+                    yy = (code[0] - 16 * s) / (219 * s);
+                    cb = (code[1] - 128 * s) / (224 * s);
+                    cr = (code[2] - 128 * s) / (224 * s);
+                }
+
+                rgb[0] = yy + 2 * (1 - kr) * cr;
+                rgb[2] = yy + 2 * (1 - kb) * cb;
+                rgb[1] = (yy - kr * rgb[0] - kb * rgb[2]) / (1 - kr - kb);
+
+                if (m_nCubeSize > 0)
+                {
+                    SampleCube(rgb, out);
+                }
+                else
+                {
+                    double lin[3], xyz[3];
+
+                    for (int c = 0; c < 3; c++)
+                        lin[c] = TrcToLinear(trc, rgb[c]);
+
+                    if (trc == AVCOL_TRC_ARIB_STD_B67)
+                    {
+                        //HLG OOTF，按标称峰值亮度换算为显示光
+                        double ys = to_xyz[1][0] * lin[0] + to_xyz[1][1] * lin[1] + to_xyz[1][2] * lin[2];
+                        double scale = HLG_NOMINAL_PEAK * pow(FFMAX(ys, 1e-6), 0.2) / PQ_REFERENCE_WHITE;
+                        for (int c = 0; c < 3; c++)
+                            lin[c] *= scale;
+                    }
+
+                    if (hdr)
+                    {
+                        //按最大分量压缩高光，保持色相
+                        double peak = FFMAX3(lin[0], lin[1], lin[2]);
+                        if (peak > TONEMAP_KNEE)
+                        {
+                            double ratio = ToneMap(peak) / peak;
+                            for (int c = 0; c < 3; c++)
+                                lin[c] *= ratio;
+                        }
+                    }
+
+                    Mat3Apply(to_pcs, lin, xyz);
+                    EncodeDisplay(xyz, out);
+                }
+
+                //节点值不截断，输出像素时再饱和到 0~255
+                node[0] = out[2] * 255.0f;
+                node[1] = out[1] * 255.0f;
+                node[2] = out[0] * 255.0f;
+                node[3] = 255.0f;
+            }
+        }
+    }
+
+    for (int code = 0; code <= max_code; code++)
+    {
+        double pos = (double)code * (n - 1) / max_code;
+        int i = FFMIN((int)pos, n - 2);
+        float f = (float)(pos - i);
+
+        table->offset[0][code] = 4 * i;
+        table->offset[1][code] = 4 * i * n;
+        table->offset[2][code] = 4 * i * n * n;
+        for (int c = 0; c < 3; c++)
+            table->frac[c][code] = f;
+    }
+
+    return table;
+}
+
+std::shared_ptr<LutTable> ColorLut::GetTable(const AVFrame *frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutexConfig);
+    uint64_t key;
+    int64_t start;
+
+    key = ((uint64_t)m_nConfigSerial << 40) |
+        ((uint64_t)(frame->color_trc & 0xff) << 32) |
+        ((uint64_t)(frame->color_primaries & 0xff) << 24) |
+        ((uint64_t)(ResolveColorSpace(frame) & 0xff) << 16) |
+        ((uint64_t)IsFullRange(frame) << 8) |
+        (uint64_t)(frame->format == AV_PIX_FMT_YUV420P10);
+
+    auto it = m_mapTables.find(key);
+    if (it != m_mapTables.end())
+    {
+        for (auto itOrder = m_vecTableOrder.begin(); itOrder != m_vecTableOrder.end(); ++itOrder)
+        {
+            if (*itOrder == key)
+            {
+                m_vecTableOrder.erase(itOrder);
+                break;
+            }
+        }
+        m_vecTableOrder.push_back(key);
+        return it->second;
+    }
+
+    start = av_gettime_relative();
+    std::shared_ptr<LutTable> table(BuildTable(frame), &FreeLutTable);
+    if (!table)
+    {
+        return nullptr;
+    }
+    av_log(NULL, AV_LOG_VERBOSE, "Color LUT for %s/%s/%s built in %.1f ms\n",
+        av_color_primaries_name(frame->color_primaries),
+        av_color_transfer_name(frame->color_trc),
+        av_color_space_name(frame->colorspace),
+        (av_gettime_relative() - start) / 1000.0);
+
+    if (m_vecTableOrder.size() >= COLOR_LUT_CACHE_SIZE)
+    {
+        m_mapTables.erase(m_vecTableOrder.front());
+        m_vecTableOrder.erase(m_vecTableOrder.begin());
+    }
+    m_mapTables[key] = table;
+    m_vecTableOrder.push_back(key);
+
+    return table;
+}
+
+int ColorLut::Apply(const AVFrame *frame, uint8_t *pixels, int pitch, const SDL_Rect *roi)
+{
+    std::shared_ptr<LutTable> table = GetTable(frame);
+    LutJob job;
+    int nThreads;
+
+    if (!table)
+    {
+        return -1;
+    }
+
+    //同一时间只处理一帧
+    std::lock_guard<std::mutex> lockApply(m_mutexApply);
+
+    if (!m_bRunning)
+    {
+        int nWorkers = FFMIN((int)std::thread::hardware_concurrency() - 1, COLOR_LUT_MAX_WORKERS);
+        m_bRunning = true;
+        for (int i = 0; i < nWorkers; i++)
+        {
+            m_vecWorkers.push_back(std::thread(&ColorLut::WorkerThread, this));
+        }
+    }
+    nThreads = (int)m_vecWorkers.size() + 1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexJob);
+        m_stJob.table = table.get();
+        m_stJob.frame = frame;
+        m_stJob.pixels = pixels;
+        m_stJob.pitch = pitch;
+        m_stJob.x = roi ? roi->x : 0;
+        m_stJob.y = roi ? roi->y : 0;
+        m_stJob.w = roi ? roi->w : frame->width;
+        m_stJob.h = roi ? roi->h : frame->height;
+        //每片行数取偶数，色度行不跨片
+        m_stJob.rows_per_slice = FFALIGN((m_stJob.h + nThreads * 4 - 1) / (nThreads * 4), 2);
+        m_stJob.slices = (m_stJob.h + m_stJob.rows_per_slice - 1) / m_stJob.rows_per_slice;
+        m_stJob.serial++;
+        m_nDoneSlices = 0;
+        m_nNextSlice = (uint64_t)m_stJob.serial << 32;
+        job = m_stJob;
+    }
+    m_condJob.notify_all();
+
+    RunSlices(job);
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutexJob);
+        m_condDone.wait(lock, [&] { return m_nDoneSlices.load() >= job.slices; });
+    }
+
+    return 0;
+}
+
+void ColorLut::RunSlices(const LutJob &job)
+{
+    for (;;)
+    {
+        uint64_t nNext = m_nNextSlice.load();
+        int nSlice, y0, y1;
+
+        //只领取本任务的分片，上一帧残留的线程不会多领
+        do
+        {
+            if ((uint32_t)(nNext >> 32) != job.serial || (int)(uint32_t)nNext >= job.slices)
+                return;
+        } while (!m_nNextSlice.compare_exchange_weak(nNext, nNext + 1));
+
+        nSlice = (int)(uint32_t)nNext;
+        y0 = job.y + nSlice * job.rows_per_slice;
+        y1 = FFMIN(y0 + job.rows_per_slice, job.y + job.h);
+
+        if (job.table->depth > 8)
+            ApplyRows<uint16_t>(job, y0, y1);
+        else
+            ApplyRows<uint8_t>(job, y0, y1);
+
+        if (m_nDoneSlices.fetch_add(1) + 1 == job.slices)
+        {
+            std::lock_guard<std::mutex> lock(m_mutexJob);
+            m_condDone.notify_all();
+        }
+    }
+}
+
+void ColorLut::WorkerThread()
+{
+    uint32_t nSerial = 0;
+    LutJob job;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutexJob);
+            m_condJob.wait(lock, [&] { return !m_bRunning || m_stJob.serial != nSerial; });
+            if (!m_bRunning)
+            {
+                return;
+            }
+            nSerial = m_stJob.serial;
+            job = m_stJob;
+        }
+        RunSlices(job);
+    }
+}
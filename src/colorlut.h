@@ -0,0 +1,130 @@
+﻿/*
+ * @file 	colorlut.h
+ * @date 	2026/10/18 14:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	颜色管理
+ * @note	按源的矩阵系数、色域、传输特性和显示器 ICC 配置（或 .cube 文件）生成 3D LUT。
+ *			LUT 直接以 YUV 码值为索引，YUV 转 RGB、色域转换、传输曲线一次查表完成，
+ *			四面体插值，按行分片在工作线程上并行，每个 (源, 显示) 组合的 LUT 只生成一次。
+ *			由视频解码线程在入队前转换为 BGRA 帧，刷新线程（主画面和镜像输出）只上传。
+ */
+#ifndef COLORLUT_H
+#define COLORLUT_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <condition_variable>
+
+#include <QString>
+
+#include "globalhelper.h"
+
+#define COLOR_LUT_SIZE 33       //LUT 每个轴的节点数
+#define COLOR_LUT_CACHE_SIZE 8  //最多缓存的 LUT 个数
+#define COLOR_LUT_MAX_WORKERS 8 //最多工作线程数
+
+typedef struct LutTable LutTable;
+
+//一帧的转换任务，按行分片
+typedef struct LutJob {
+    const LutTable *table;
+    const AVFrame *frame;
+    uint8_t *pixels;        //对应 (x, y) 处
+    int pitch;
+    int x, y, w, h;         //转换区域，y 为偶数
+    int rows_per_slice;
+    int slices;
+    uint32_t serial;
+} LutJob;
+
+class ColorLut
+{
+public:
+    ColorLut();
+    ~ColorLut();
+
+    void SetEnabled(bool bEnabled);
+
+    /**
+     * @brief	设置显示器 ICC 配置文件（矩阵/曲线型），为空表示 BT.709 参考显示器
+     *
+     * @param	strIccFile ICC 文件路径
+     * @return	true 成功 false 失败（继续使用参考显示器）
+     */
+    bool SetDisplayProfile(const QString &strIccFile);
+
+    /**
+     * @brief	载入 .cube 3D LUT，代替源到显示的颜色转换，为空表示不使用
+     *
+     * @param	strCubeFile .cube 文件路径
+     * @return	true 成功 false 失败
+     */
+    bool SetLutFile(const QString &strCubeFile);
+
+    /**
+     * @brief	该帧是否需要走颜色管理
+     */
+    bool IsNeeded(const AVFrame *frame);
+
+    /**
+     * @brief	颜色管理并转换为 BGRA（SDL_PIXELFORMAT_ARGB8888）
+     *
+     * @param	frame 视频帧
+     * @param	pixels 目标像素
+     * @param	pitch 目标行跨度
+     * @param	roi 只转换该区域（x、y 为偶数），pixels 指向区域左上角，为空表示整帧
+     * @return	0 成功 负值失败
+     */
+    int Apply(const AVFrame *frame, uint8_t *pixels, int pitch, const SDL_Rect *roi = nullptr);
+
+private:
+    //按帧的颜色参数取出（或生成）LUT
+    std::shared_ptr<LutTable> GetTable(const AVFrame *frame);
+    LutTable *BuildTable(const AVFrame *frame);
+
+    //显示器：线性 XYZ(D50) 转显示信号
+    void EncodeDisplay(const double xyz_d50[3], float out[3]);
+    //源 RGB 信号直接经 .cube 映射
+    void SampleCube(const double rgb[3], float out[3]);
+
+    void WorkerThread();
+    void RunSlices(const LutJob &job);
+
+private:
+    bool m_bEnabled;
+
+    std::mutex m_mutexConfig;
+    //显示器
+    bool m_bHasProfile;
+    double m_dDisplayFromXyz[3][3];              //< XYZ(D50) 转显示器线性 RGB
+    std::vector<float> m_vecDisplayTrc[3];       //< 显示器传输曲线（线性->信号）查找表
+    //.cube
+    int m_nCubeSize;
+    double m_dCubeMin[3];
+    double m_dCubeMax[3];
+    std::vector<float> m_vecCube;
+    uint32_t m_nConfigSerial;                    //< 配置变化后使缓存失效
+
+    std::map<uint64_t, std::shared_ptr<LutTable>> m_mapTables; //< LUT 缓存
+    std::vector<uint64_t> m_vecTableOrder;                     //< 按使用顺序，最久未用的在前
+
+    //工作线程
+    std::mutex m_mutexApply;
+    std::mutex m_mutexJob;
+    std::condition_variable m_condJob;
+    std::condition_variable m_condDone;
+    std::vector<std::thread> m_vecWorkers;
+    bool m_bRunning;
+    LutJob m_stJob; //< 当前任务
+    std::atomic<uint64_t> m_nNextSlice; //< 高 32 位任务序号，低 32 位下一个分片
+    std::atomic<int> m_nDoneSlices;
+};
+
+#endif // COLORLUT_H
@@ -74,6 +74,7 @@ bool CtrlBar::ConnectSignalSlots()
 
     connect(ui->PlaylistCtrlBtn, &QPushButton::clicked, this, &CtrlBar::SigShowOrHidePlaylist);
     connect(ui->PlaySlider, &CustomSlider::SigCustomSliderValueChanged, this, &CtrlBar::OnPlaySliderValueChanged);
+    connect(ui->PlaySlider, &CustomSlider::SigCustomSliderPressed, this, &CtrlBar::SigScrubbing);
     connect(ui->VolumeSlider, &CustomSlider::SigCustomSliderValueChanged, this, &CtrlBar::OnVolumeSliderValueChanged);
     connect(ui->BackwardBtn, &QPushButton::clicked, this, &CtrlBar::SigBackwardPlay);
     connect(ui->ForwardBtn, &QPushButton::clicked, this, &CtrlBar::SigForwardPlay);
@@ -28,6 +28,7 @@
 #include <math.h>
 #include <limits.h>
 #include <signal.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <assert.h>
 
@@ -85,8 +86,8 @@ typedef struct MyAVPacketList {
     int serial;
 } MyAVPacketList;
 
-//数据包队列
-typedef struct PacketQueue {
+//数据包队列（读取线程写入、解码线程读取，独占缓存行）
+typedef struct alignas(CACHE_LINE_SIZE) PacketQueue {
     AVFifo* pkt_list;
     int nb_packets;
     int size;
@@ -111,8 +112,8 @@ typedef struct AudioParams {
     int bytes_per_sec;
 } AudioParams;
 
-//时钟
-typedef struct Clock {
+//时钟（各时钟由不同线程更新，独占缓存行）
+typedef struct alignas(CACHE_LINE_SIZE) Clock {
     double pts;           /* clock base */
     double pts_drift;     /* clock base minus time at which we updated the clock */
     double last_updated;
@@ -137,20 +138,28 @@ typedef struct Frame {
     AVRational sar;
     int uploaded;
     int flip_v;
+    double rotation;      /* 显示时顺时针旋转角度，来自显示矩阵 */
+    int flip_h;           /* 显示时水平镜像，来自显示矩阵 */
 } Frame;
 
 //帧队列
 typedef struct FrameQueue {
     Frame queue[FRAME_QUEUE_SIZE];
-    int rindex;
-    int windex;
-    int size;
     int max_size;
     int keep_last;
-    int rindex_shown;
     SDL_mutex* mutex;
     SDL_cond* cond;
     PacketQueue* pktq;
+
+    /* 消费者（渲染线程/音频回调）写入 */
+    alignas(CACHE_LINE_SIZE) int rindex;
+    int rindex_shown;
+
+    /* 生产者（解码线程）写入 */
+    alignas(CACHE_LINE_SIZE) int windex;
+
+    /* 双方在 mutex 保护下修改 */
+    alignas(CACHE_LINE_SIZE) int size;
 } FrameQueue;
 
 enum {
@@ -159,8 +168,8 @@ enum {
     AV_SYNC_EXTERNAL_CLOCK, /* synchronize to an external clock */
 };
 
-//解码器，管理数据队列
-typedef struct Decoder {
+//解码器，管理数据队列（由各自解码线程写入，独占缓存行）
+typedef struct alignas(CACHE_LINE_SIZE) Decoder {
     AVPacket* pkt;
     PacketQueue* queue;
     AVCodecContext* avctx;
@@ -172,103 +181,197 @@ typedef struct Decoder {
     AVRational start_pts_tb;
     int64_t next_pts;
     AVRational next_pts_tb;
+    int64_t decode_errors;  /* 送入数据包或取出帧失败的次数 */
     std::thread decode_thread;
 } Decoder;
 
+//音频可视化数据，体积大，不放在 VideoState 中。当前没有波形、频谱显示，不分配；
+//以后加入显示时在显示处首次使用时分配，stream_component_close、stream_close 已处理释放
+typedef struct VisState {
+    int16_t sample_array[SAMPLE_ARRAY_SIZE];
+    int sample_array_index;
+    int last_i_start;
+    RDFTContext *rdft;
+    int rdft_bits;
+    FFTSample *rdft_data;
+    int xpos;
+    double last_vis_time;
+    SDL_Texture* vis_texture;
+} VisState;
+
+/* 视频纹理，帧超出渲染器最大纹理尺寸时拆成多块 */
+typedef struct VideoTile {
+    SDL_Texture *texture;
+    SDL_Rect rect;                      /* 在帧中的区域 */
+    struct SwsContext *convert_ctx;
+} VideoTile;
+
+typedef struct VideoTiles {
+    VideoTile *tiles;
+    int nb_tiles;
+    int cols, rows;
+    int width, height;                  /* 帧宽高 */
+    AVFrame *view;                      /* 指向某一块的帧引用，上传时复用 */
+} VideoTiles;
+
+/* 外部音频文件，独立的解复用和读取线程，数据包放入主音轨的 audioq */
+typedef struct ExtAudio {
+    AVFormatContext *ic;
+    int stream_index;
+    int64_t ts_offset;                  /* 加到外部文件时间戳上对齐主文件 (AV_TIME_BASE) */
+    std::thread read_tid;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    int abort_request;
+    int finished;                       /* 读取线程已退出 */
+    int seek_req;                       /* 1 请求 seek，2 已完成，等主读取线程清空队列 */
+    int64_t seek_min, seek_target, seek_max;
+    int seek_ret;
+    int eof;
+} ExtAudio;
+
 //视频状态，管理所有的视频信息及数据
+//按写入线程划分区域，每个区域从新的缓存行开始，避免多个线程反复争用同一缓存行
 typedef struct VideoState {
+    /* 打开后基本只读的数据 */
     std::thread read_tid; //读取线程
     AVInputFormat *iformat;
-    int abort_request; //停止读取标志
-    int force_refresh;
+    AVFormatContext *ic;
+    int realtime;
+    int av_sync_type;
+    int audio_stream;
+    AVStream *audio_st;
+    int video_stream;
+    AVStream *video_st;
+    int subtitle_stream;
+    AVStream *subtitle_st;
+    double max_frame_duration;      // maximum duration of a frame - above this, we consider the jump a timestamp discontinuity
+    int audio_hw_buf_size;
+    struct AudioParams audio_tgt;
+    SDL_cond *continue_read_thread;
+    int64_t open_time;              //打开时间，用于统计首帧耗时
+
+    /* 控制线程写入，其他线程读取 */
+    alignas(CACHE_LINE_SIZE) int abort_request; //停止读取标志
     int paused;
-    int last_paused;
-    int queue_attachments_req;
-    int seek_req;
+    int step;
+    int audio_volume;
+    double start_pos;   /* 切换原文件与代理时从该位置开始（秒），之前的帧丢弃，NAN 表示没有 */
+
+    /* 读取线程写入 */
+    alignas(CACHE_LINE_SIZE) int seek_req;
     int seek_flags;
     int64_t seek_pos;
     int64_t seek_rel;
     int read_pause_return;
-    AVFormatContext *ic;
-    int realtime;
-
-    Clock audclk;
-    Clock vidclk;
-    Clock extclk;
-
-    FrameQueue pictq;
-    FrameQueue subpq;
-    FrameQueue sampq;
-
-    Decoder auddec;
-    Decoder viddec;
-    Decoder subdec;
-
-    int audio_stream;
-
-    int av_sync_type;
+    int last_paused;
+    int queue_attachments_req;
+    int eof;
+    int last_video_stream, last_audio_stream, last_subtitle_stream;
+    ExtAudio *ext_audio;            //外部音频，主音轨来自该文件，读取线程打开主文件后设置
 
+    /* 音频回调写入 */
+    alignas(CACHE_LINE_SIZE) uint8_t *audio_buf;
+    uint8_t *audio_buf1;
+    unsigned int audio_buf_size; /* in bytes */
+    unsigned int audio_buf1_size;
+    int audio_buf_index; /* in bytes */
+    int audio_write_buf_size;
     double audio_clock;
     int audio_clock_serial;
     double audio_diff_cum; /* used for AV difference average computation */
     double audio_diff_avg_coef;
     double audio_diff_threshold;
     int audio_diff_avg_count;
-    AVStream *audio_st;
-    PacketQueue audioq;
-    int audio_hw_buf_size;
-    uint8_t *audio_buf;
-    uint8_t *audio_buf1;
-    unsigned int audio_buf_size; /* in bytes */
-    unsigned int audio_buf1_size;
-    int audio_buf_index; /* in bytes */
-    int audio_write_buf_size;
-    int audio_volume;
-
     struct AudioParams audio_src;
-
-    struct AudioParams audio_tgt;
     struct SwrContext *swr_ctx;
-    int frame_drops_early;
+    int swr_preset;     /* 创建 swr_ctx 时的重采样预设 */
+    int swr_no_soxr;    /* soxr 不支持变速补偿，本次播放改用 swr 引擎 */
+    int first_audio_played;
+
+    /* 渲染线程写入 */
+    alignas(CACHE_LINE_SIZE) double frame_timer;
+    int force_refresh;
+    int first_frame_shown;
     int frame_drops_late;
+    int width, height, xleft, ytop;
+    SDL_Rect vid_roi;       /* 已上传到画面输出的区域，宽为 0 表示整帧 */
+    struct SwsContext *sub_convert_ctx;
+    int64_t schedule_start; /* 定时播放的开始时间（av_gettime，微秒），0 表示立即开始 */
+    int schedule_pending;   /* 等待开始时间，只预加载，不显示画面、不启动音频设备 */
+    int64_t preroll_time;   /* 定时播放预加载完成的时间，0 表示未完成 */
+    int64_t sync_jump_time; /* 跟随其他播放器时最近一次 seek 或直接设置时钟的时间 */
+
+    /* 视频解码线程写入 */
+    alignas(CACHE_LINE_SIZE) int frame_drops_early;
+    int64_t frames_decoded;
+    double frame_last_returned_time;
+    double frame_last_filter_delay;
 
-    int16_t sample_array[SAMPLE_ARRAY_SIZE];
-    int sample_array_index;
-    int last_i_start;
-    RDFTContext *rdft;
-    int rdft_bits;
-    FFTSample *rdft_data;
-    int xpos;
-    double last_vis_time;
+    /* 音频解码线程写入 */
+    alignas(CACHE_LINE_SIZE) int audio_started;   //音频设备已开始播放
+    double audio_primed;                          //设备开始前已缓冲的音频时长
 
-    SDL_Texture* vis_texture;
-    SDL_Texture* sub_texture;
-    SDL_Texture* vid_texture;
+    /* 以下结构体自身按缓存行对齐 */
+    Clock audclk;
+    Clock vidclk;
+    Clock extclk;
 
-    int subtitle_stream;
-    AVStream *subtitle_st;
-    PacketQueue subtitleq;
+    FrameQueue pictq;
+    FrameQueue subpq;
+    FrameQueue sampq;
 
-    double frame_timer;
-    double frame_last_returned_time;
-    double frame_last_filter_delay;
-    int video_stream;
-    AVStream *video_st;
+    Decoder auddec;
+    Decoder viddec;
+    Decoder subdec;
+
+    PacketQueue audioq;
     PacketQueue videoq;
-    double max_frame_duration;      // maximum duration of a frame - above this, we consider the jump a timestamp discontinuity
-    struct SwsContext *img_convert_ctx;
-    struct SwsContext *sub_convert_ctx;
-    int eof;
+    PacketQueue subtitleq;
 
+    /* 冷数据 */
     char *filename;
-    int width, height, xleft, ytop;
-    int step;
-
-    int last_video_stream, last_audio_stream, last_subtitle_stream;
-
-    SDL_cond *continue_read_thread;
+    VisState *vis;
 } VideoState;
 
+/* 检查各区域从新的缓存行开始，后加的字段在其写入线程的区域内。
+ * VideoState 含 std::thread，不是标准布局，offsetof 在 GCC、Clang、MSVC 上可用，GCC 会警告，这里关闭 */
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+#define VS_REGION_START(field) \
+    static_assert(offsetof(VideoState, field) % CACHE_LINE_SIZE == 0, #field " must start a cache line")
+#define VS_IN_REGION(field, start, next) \
+    static_assert(offsetof(VideoState, field) >= offsetof(VideoState, start) && \
+                  offsetof(VideoState, field) + sizeof(((VideoState *)0)->field) <= offsetof(VideoState, next), \
+                  #field " must stay in the region starting at " #start)
+VS_REGION_START(abort_request);
+VS_REGION_START(seek_req);
+VS_REGION_START(audio_buf);
+VS_REGION_START(frame_timer);
+VS_REGION_START(frame_drops_early);
+VS_REGION_START(audio_started);
+VS_REGION_START(audclk);
+VS_IN_REGION(audio_volume, abort_request, seek_req);
+VS_IN_REGION(start_pos, abort_request, seek_req);
+VS_IN_REGION(ext_audio, seek_req, audio_buf);
+VS_IN_REGION(swr_preset, audio_buf, frame_timer);
+VS_IN_REGION(swr_no_soxr, audio_buf, frame_timer);
+VS_IN_REGION(first_audio_played, audio_buf, frame_timer);
+VS_IN_REGION(first_frame_shown, frame_timer, frame_drops_early);
+VS_IN_REGION(vid_roi, frame_timer, frame_drops_early);
+VS_IN_REGION(schedule_pending, frame_timer, frame_drops_early);
+VS_IN_REGION(preroll_time, frame_timer, frame_drops_early);
+VS_IN_REGION(sync_jump_time, frame_timer, frame_drops_early);
+VS_IN_REGION(frames_decoded, frame_drops_early, audio_started);
+VS_IN_REGION(audio_primed, audio_started, audclk);
+#undef VS_REGION_START
+#undef VS_IN_REGION
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
 
 
 
@@ -486,6 +589,8 @@ static int decoder_decode_frame(Decoder *d, AVFrame *frame, AVSubtitle *sub) {
                     }
                     break;
                 }
+                if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                    d->decode_errors++;
                 if (ret == AVERROR_EOF) {
                     d->finished = d->pkt_serial;
                     avcodec_flush_buffers(d->avctx);
@@ -533,11 +638,14 @@ static int decoder_decode_frame(Decoder *d, AVFrame *frame, AVSubtitle *sub) {
             av_packet_unref(d->pkt);
         }
         else {
-            if (avcodec_send_packet(d->avctx, d->pkt) == AVERROR(EAGAIN)) {
+            ret = avcodec_send_packet(d->avctx, d->pkt);
+            if (ret == AVERROR(EAGAIN)) {
                 av_log(d->avctx, AV_LOG_ERROR, "Receive_frame and send_packet both returned EAGAIN, which is an API violation.\n");
                 d->packet_pending = 1;
             }
             else {
+                if (ret < 0 && ret != AVERROR_EOF)
+                    d->decode_errors++;
                 av_packet_unref(d->pkt);
             }
         }
@@ -0,0 +1,177 @@
+﻿/*
+ * @file 	decoderpool.cpp
+ * @date 	2026/10/18 11:05
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	解码器复用池
+ * @note
+ */
+
+#include "decoderpool.h"
+
+DecoderPool::DecoderPool() :
+    m_bEnabled(true)
+{
+}
+
+DecoderPool::~DecoderPool()
+{
+    Clear();
+}
+
+AVCodecContext *DecoderPool::Acquire(const AVCodecParameters *par)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_bEnabled)
+    {
+        return nullptr;
+    }
+
+    //从最近归还的开始找
+    for (auto it = m_vecEntries.rbegin(); it != m_vecEntries.rend(); ++it)
+    {
+        if (IsSameParameters(it->par, par))
+        {
+            AVCodecContext *avctx = it->avctx;
+            avcodec_parameters_free(&it->par);
+            m_vecEntries.erase(std::next(it).base());
+            ApplyParameters(avctx, par);
+            return avctx;
+        }
+    }
+
+    return nullptr;
+}
+
+void DecoderPool::Release(AVCodecContext *avctx, const AVCodecParameters *par)
+{
+    PoolEntry entry;
+
+    if (!avctx)
+    {
+        return;
+    }
+
+    //字幕解码器开销很小，不做复用
+    if (!par || (avctx->codec_type != AVMEDIA_TYPE_VIDEO && avctx->codec_type != AVMEDIA_TYPE_AUDIO))
+    {
+        avcodec_free_context(&avctx);
+        return;
+    }
+
+    entry.avctx = avctx;
+    entry.par = avcodec_parameters_alloc();
+    if (!entry.par || avcodec_parameters_copy(entry.par, par) < 0)
+    {
+        avcodec_parameters_free(&entry.par);
+        avcodec_free_context(&avctx);
+        return;
+    }
+
+    //清空解码器内部缓存的帧，保留已初始化的解码线程
+    avcodec_flush_buffers(avctx);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_bEnabled)
+    {
+        avcodec_parameters_free(&entry.par);
+        avcodec_free_context(&avctx);
+        return;
+    }
+
+    if (m_vecEntries.size() >= DECODER_POOL_SIZE)
+    {
+        avcodec_free_context(&m_vecEntries.front().avctx);
+        avcodec_parameters_free(&m_vecEntries.front().par);
+        m_vecEntries.erase(m_vecEntries.begin());
+    }
+    m_vecEntries.push_back(entry);
+}
+
+void DecoderPool::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (PoolEntry &entry : m_vecEntries)
+    {
+        avcodec_free_context(&entry.avctx);
+        avcodec_parameters_free(&entry.par);
+    }
+    m_vecEntries.clear();
+}
+
+void DecoderPool::SetEnabled(bool bEnabled)
+{
+    if (!bEnabled)
+    {
+        Clear();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bEnabled = bEnabled;
+}
+
+bool DecoderPool::IsSameParameters(const AVCodecParameters *a, const AVCodecParameters *b)
+{
+    if (a->codec_type != b->codec_type ||
+        a->codec_id != b->codec_id ||
+        a->codec_tag != b->codec_tag ||
+        a->profile != b->profile ||
+        a->level != b->level ||
+        a->bits_per_coded_sample != b->bits_per_coded_sample ||
+        a->bits_per_raw_sample != b->bits_per_raw_sample ||
+        a->extradata_size != b->extradata_size)
+        return false;
+
+    if (a->extradata_size > 0 && memcmp(a->extradata, b->extradata, a->extradata_size))
+        return false;
+
+    switch (a->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        return a->format == b->format &&
+            a->width == b->width &&
+            a->height == b->height &&
+            a->field_order == b->field_order &&
+            a->video_delay == b->video_delay;
+    case AVMEDIA_TYPE_AUDIO:
+        return a->format == b->format &&
+            a->sample_rate == b->sample_rate &&
+            a->block_align == b->block_align &&
+            a->frame_size == b->frame_size &&
+            a->initial_padding == b->initial_padding &&
+            a->trailing_padding == b->trailing_padding &&
+            a->seek_preroll == b->seek_preroll &&
+            !av_channel_layout_compare(&a->ch_layout, &b->ch_layout);
+    default:
+        return false;
+    }
+}
+
+void DecoderPool::ApplyParameters(AVCodecContext *avctx, const AVCodecParameters *par)
+{
+    //与 avcodec_parameters_to_context 相同的字段；extradata 等已由 IsSameParameters 保证一致，不重新设置
+    avctx->bit_rate = par->bit_rate;
+
+    switch (par->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        avctx->sample_aspect_ratio = par->sample_aspect_ratio;
+        avctx->color_range = par->color_range;
+        avctx->color_primaries = par->color_primaries;
+        avctx->color_trc = par->color_trc;
+        avctx->colorspace = par->color_space;
+        avctx->chroma_sample_location = par->chroma_location;
+        avctx->has_b_frames = par->video_delay;
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        avctx->initial_padding = par->initial_padding;
+        avctx->trailing_padding = par->trailing_padding;
+        avctx->seek_preroll = par->seek_preroll;
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,69 @@
+﻿/*
+ * @file 	decoderpool.h
+ * @date 	2026/10/18 11:05
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	解码器复用池
+ * @note	关闭流时把已打开的解码器清空缓存后保留下来，下一个文件的编码参数相同时直接复用，
+ *			省去 avcodec_open2 的初始化和解码线程池的创建。
+ */
+#ifndef DECODERPOOL_H
+#define DECODERPOOL_H
+
+#include <mutex>
+#include <vector>
+
+#include "globalhelper.h"
+
+#define DECODER_POOL_SIZE 4 //最多保留的解码器个数
+
+class DecoderPool
+{
+public:
+    DecoderPool();
+    ~DecoderPool();
+
+    /**
+     * @brief	取出一个与编码参数匹配的已打开解码器，颜色、宽高比等描述字段已按 par 重新设置，
+     *			pkt_timebase 由调用方设置
+     *
+     * @param	par 流的编码参数
+     * @return	解码器，没有可复用的返回 nullptr
+     */
+    AVCodecContext* Acquire(const AVCodecParameters *par);
+
+    /**
+     * @brief	归还解码器，清空内部缓存后留待复用，无法复用时直接释放
+     *
+     * @param	avctx 解码器（调用后由复用池接管）
+     * @param	par 该解码器打开时对应的编码参数
+     */
+    void Release(AVCodecContext *avctx, const AVCodecParameters *par);
+
+    /**
+     * @brief	释放池中所有解码器
+     */
+    void Clear();
+
+    void SetEnabled(bool bEnabled);
+
+private:
+    //编码参数是否一致，一致的解码器可以直接复用
+    static bool IsSameParameters(const AVCodecParameters *a, const AVCodecParameters *b);
+    //把不影响解码器初始化的描述字段设置到已打开的解码器，避免沿用上一个文件的值
+    static void ApplyParameters(AVCodecContext *avctx, const AVCodecParameters *par);
+
+private:
+    typedef struct PoolEntry {
+        AVCodecContext *avctx;
+        AVCodecParameters *par;
+    } PoolEntry;
+
+    bool m_bEnabled;
+    std::mutex m_mutex;
+    std::vector<PoolEntry> m_vecEntries; //按归还时间排序，最早归还的在前
+};
+
+#endif // DECODERPOOL_H
@@ -0,0 +1,547 @@
+﻿/*
+ * @file 	framepool.cpp
+ * @date 	2026/10/18 23:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	视频帧缓冲池
+ * @note
+ */
+
+#include "framepool.h"
+#include "perfcounter.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#pragma execution_character_set("utf-8")
+
+#define PAGE_FLAG_HUGE 1 //释放回调的 opaque 中记录大小，最低位标记大页
+
+static std::atomic<int64_t> s_nRequests(0);
+static std::atomic<int64_t> s_nAllocations(0);
+static std::atomic<int64_t> s_nBytes(0);
+static std::atomic<int64_t> s_nHugeBytes(0);
+
+static size_t page_size()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+#endif
+}
+
+//逐页写入，分配时完成缺页
+static void prefault(uint8_t *ptr, size_t size)
+{
+    size_t step = page_size();
+    for (size_t off = 0; off < size; off += step)
+        ptr[off] = 0;
+}
+
+#if defined(_WIN32)
+//大页需要“锁定内存页”权限，没有时只试一次
+static bool enable_lock_memory_privilege()
+{
+    static int enabled = -1;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (enabled < 0) {
+        HANDLE token;
+        TOKEN_PRIVILEGES tp;
+        enabled = 0;
+        if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+            tp.PrivilegeCount = 1;
+            tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+            if (LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &tp.Privileges[0].Luid) &&
+                AdjustTokenPrivileges(token, FALSE, &tp, 0, NULL, NULL) && GetLastError() == ERROR_SUCCESS)
+                enabled = 1;
+            CloseHandle(token);
+        }
+        if (!enabled)
+            av_log(NULL, AV_LOG_VERBOSE, "frame pool: no lock memory privilege, using regular pages\n");
+    }
+    return enabled == 1;
+}
+#endif
+
+/**
+ * 分配页对齐的内存并预先写入
+ *
+ * @param size 请求的大小，返回实际分配的大小
+ * @param huge 优先使用大页，返回是否得到大页
+ */
+static uint8_t *alloc_pages(size_t *size, bool *huge)
+{
+    uint8_t *ptr = NULL;
+
+#if defined(_WIN32)
+    if (*huge) {
+        size_t large = GetLargePageMinimum();
+        if (large && enable_lock_memory_privilege()) {
+            size_t len = FFALIGN(*size, large);
+            //大页分配即锁定在物理内存中，不需要预先写入
+            ptr = (uint8_t *)VirtualAlloc(NULL, len, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (ptr) {
+                *size = len;
+                return ptr;
+            }
+        }
+    }
+    *huge = false;
+    *size = FFALIGN(*size, page_size());
+    ptr = (uint8_t *)VirtualAlloc(NULL, *size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!ptr)
+        return NULL;
+#elif defined(__linux__)
+    if (*huge) {
+        size_t len = FFALIGN(*size, FRAME_POOL_HUGE_PAGE_SIZE);
+
+        //预留了大页（/proc/sys/vm/nr_hugepages）时直接使用
+        ptr = (uint8_t *)mmap(NULL, len, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (ptr != MAP_FAILED) {
+            *size = len;
+            return ptr;
+        }
+
+        //透明大页：多映射一个大页，起始地址按大页对齐后去掉首尾
+        uint8_t *base = (uint8_t *)mmap(NULL, len + FRAME_POOL_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED)
+            return NULL;
+        ptr = (uint8_t *)FFALIGN((uintptr_t)base, (uintptr_t)FRAME_POOL_HUGE_PAGE_SIZE);
+        if (ptr > base)
+            munmap(base, ptr - base);
+        if (ptr + len < base + len + FRAME_POOL_HUGE_PAGE_SIZE)
+            munmap(ptr + len, base + len + FRAME_POOL_HUGE_PAGE_SIZE - (ptr + len));
+        *size = len;
+        //透明大页关闭（never）时失败，仍按普通页使用
+        *huge = madvise(ptr, len, MADV_HUGEPAGE) == 0;
+        prefault(ptr, len);
+        return ptr;
+    }
+
+    *size = FFALIGN(*size, page_size());
+    ptr = (uint8_t *)mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    //透明大页为 always 时也不合并，与大页方式对比
+    madvise(ptr, *size, MADV_NOHUGEPAGE);
+#else
+    *huge = false;
+    *size = FFALIGN(*size, page_size());
+    ptr = (uint8_t *)mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+#endif
+
+    prefault(ptr, *size);
+    return ptr;
+}
+
+static void free_pages(uint8_t *ptr, size_t size)
+{
+#if defined(_WIN32)
+    Q_UNUSED(size);
+    VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+FramePool *FramePool::m_pInstance = new FramePool();
+
+FramePool::FramePool() :
+    m_nUseCounter(0)
+{
+    m_nMode = FRAME_POOL_HUGE_PAGES;
+}
+
+FramePool::~FramePool()
+{
+    Trim();
+}
+
+FramePool *FramePool::GetInstance()
+{
+    return m_pInstance;
+}
+
+void FramePool::SetMode(int nMode)
+{
+    if (nMode < 0 || nMode >= FRAME_POOL_MODE_NB)
+    {
+        return;
+    }
+
+    //已分配的缓冲区大小相同也不再混用
+    if (m_nMode.exchange(nMode) != nMode)
+    {
+        Trim();
+    }
+}
+
+int FramePool::GetMode()
+{
+    return m_nMode;
+}
+
+void FramePool::Attach(AVCodecContext *avctx)
+{
+    if (avctx->codec_type != AVMEDIA_TYPE_VIDEO)
+    {
+        return;
+    }
+
+    avctx->opaque = this;
+    avctx->get_buffer2 = GetBuffer2;
+}
+
+AVBufferRef *FramePool::GetBuffer(size_t nSize)
+{
+    AVBufferPool *pool = NULL;
+    int nMode = m_nMode;
+
+    if (nMode == FRAME_POOL_OFF || nSize == 0)
+    {
+        return NULL;
+    }
+
+    bool bHuge = nMode == FRAME_POOL_HUGE_PAGES && nSize >= FRAME_POOL_HUGE_MIN_SIZE;
+    nSize = FFALIGN(nSize, bHuge ? FRAME_POOL_HUGE_PAGE_SIZE : FRAME_POOL_SIZE_ALIGN);
+    s_nRequests++;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (SizePool &entry : m_vecPools)
+    {
+        if (entry.size == nSize && entry.huge == bHuge)
+        {
+            entry.last_use = ++m_nUseCounter;
+            pool = entry.pool;
+            break;
+        }
+    }
+
+    if (!pool)
+    {
+        //分辨率变化后旧大小的池不再使用，使用中的缓冲区归还后由 FFmpeg 释放
+        if (m_vecPools.size() >= FRAME_POOL_MAX_SIZES)
+        {
+            auto oldest = m_vecPools.begin();
+            for (auto it = m_vecPools.begin(); it != m_vecPools.end(); ++it)
+            {
+                if (it->last_use < oldest->last_use)
+                {
+                    oldest = it;
+                }
+            }
+            av_buffer_pool_uninit(&oldest->pool);
+            m_vecPools.erase(oldest);
+        }
+
+        SizePool entry;
+        entry.size = nSize;
+        entry.huge = bHuge;
+        entry.pool = av_buffer_pool_init2(nSize, bHuge ? (void *)this : NULL, PoolAlloc, NULL);
+        entry.last_use = ++m_nUseCounter;
+        if (!entry.pool)
+        {
+            return NULL;
+        }
+        m_vecPools.push_back(entry);
+        pool = entry.pool;
+    }
+
+    //在锁内取，池不会同时被 Trim 释放
+    return av_buffer_pool_get(pool);
+}
+
+int FramePool::GetFrameBuffer(AVFrame *frame)
+{
+    int linesize[4];
+    int ret;
+
+    if ((ret = av_image_fill_linesizes(linesize, (AVPixelFormat)frame->format, FFALIGN(frame->width, 32))) < 0)
+    {
+        return ret;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        linesize[i] = FFALIGN(linesize[i], 64);
+    }
+    return AllocPlanes(frame, frame->height, linesize);
+}
+
+void FramePool::Trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (SizePool &entry : m_vecPools)
+    {
+        av_buffer_pool_uninit(&entry.pool);
+    }
+    m_vecPools.clear();
+}
+
+void FramePool::GetStats(FramePoolStats *stats)
+{
+    stats->requests = s_nRequests;
+    stats->allocations = s_nAllocations;
+    stats->bytes = s_nBytes;
+    stats->huge_bytes = s_nHugeBytes;
+}
+
+int FramePool::GetBuffer2(AVCodecContext *avctx, AVFrame *frame, int flags)
+{
+    FramePool *pPool = (FramePool *)avctx->opaque;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+
+    //硬件解码、不支持外部分配的解码器仍用默认方式
+    if (!pPool || pPool->GetMode() == FRAME_POOL_OFF || !desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL) ||
+        avctx->hw_frames_ctx || !(avctx->codec->capabilities & AV_CODEC_CAP_DR1) ||
+        pPool->GetVideoBuffer(avctx, frame) < 0)
+    {
+        return avcodec_default_get_buffer2(avctx, frame, flags);
+    }
+    return 0;
+}
+
+//与 avcodec_default_get_buffer2 相同的对齐方式
+int FramePool::GetVideoBuffer(AVCodecContext *avctx, AVFrame *frame)
+{
+    int w = frame->width;
+    int h = frame->height;
+    int linesize_align[AV_NUM_DATA_POINTERS];
+    int linesize[4];
+    int unaligned;
+    int ret;
+
+    avcodec_align_dimensions2(avctx, &w, &h, linesize_align);
+    do {
+        if ((ret = av_image_fill_linesizes(linesize, (AVPixelFormat)frame->format, w)) < 0)
+            return ret;
+        //宽度不满足行对齐时加上最低位，直到各平面都对齐
+        w += w & ~(w - 1);
+        unaligned = 0;
+        for (int i = 0; i < 4; i++)
+            unaligned |= linesize[i] % linesize_align[i];
+    } while (unaligned);
+
+    return AllocPlanes(frame, h, linesize);
+}
+
+//全部平面放在一个缓冲区中，各平面后留余量
+int FramePool::AllocPlanes(AVFrame *frame, int nHeight, const int linesize[4])
+{
+    ptrdiff_t linesizes[4];
+    size_t sizes[4];
+    size_t nTotal = 0;
+    int ret;
+
+    for (int i = 0; i < 4; i++)
+        linesizes[i] = linesize[i];
+    if ((ret = av_image_fill_plane_sizes(sizes, (AVPixelFormat)frame->format, nHeight, linesizes)) < 0)
+        return ret;
+    for (int i = 0; i < 4; i++)
+        nTotal += sizes[i] ? FFALIGN(sizes[i] + FRAME_POOL_PLANE_PADDING, 64) : 0;
+
+    AVBufferRef *buf = GetBuffer(nTotal);
+    if (!buf)
+        return AVERROR(ENOMEM);
+
+    memset(frame->data, 0, sizeof(frame->data));
+    memset(frame->linesize, 0, sizeof(frame->linesize));
+    uint8_t *ptr = buf->data;
+    for (int i = 0; i < 4 && sizes[i]; i++) {
+        frame->data[i] = ptr;
+        frame->linesize[i] = linesize[i];
+        ptr += FFALIGN(sizes[i] + FRAME_POOL_PLANE_PADDING, 64);
+    }
+    frame->buf[0] = buf;
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+AVBufferRef *FramePool::PoolAlloc(void *opaque, size_t nSize)
+{
+    bool bHuge = opaque != NULL;
+    size_t nMapped = nSize;
+
+    uint8_t *ptr = alloc_pages(&nMapped, &bHuge);
+    if (!ptr)
+    {
+        return NULL;
+    }
+
+    AVBufferRef *buf = av_buffer_create(ptr, nSize, PoolFree, (void *)(nMapped | (bHuge ? PAGE_FLAG_HUGE : 0)), 0);
+    if (!buf)
+    {
+        free_pages(ptr, nMapped);
+        return NULL;
+    }
+
+    s_nAllocations++;
+    s_nBytes += nMapped;
+    if (bHuge)
+    {
+        s_nHugeBytes += nMapped;
+    }
+    return buf;
+}
+
+//不引用 FramePool，池去掉后缓冲区才归还时也能释放
+void FramePool::PoolFree(void *opaque, uint8_t *data)
+{
+    uintptr_t nValue = (uintptr_t)opaque;
+    size_t nMapped = nValue & ~(uintptr_t)PAGE_FLAG_HUGE;
+
+    free_pages(data, nMapped);
+    s_nBytes -= nMapped;
+    if (nValue & PAGE_FLAG_HUGE)
+    {
+        s_nHugeBytes -= nMapped;
+    }
+}
+
+/* 基准测试 */
+
+static int64_t page_fault_count()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return -1;
+    return pmc.PageFaultCount;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) < 0)
+        return -1;
+    return usage.ru_minflt + usage.ru_majflt;
+#endif
+}
+
+int FramePool::RunBench(int nFrames, int nWidth, int nHeight, FILE *fp)
+{
+    static const char *names[FRAME_POOL_MODE_NB] = { "av_frame_get_buffer", "pool, regular pages", "pool, huge pages" };
+
+    fprintf(fp, "frame pool benchmark: %d frames of %dx%d yuv420p, %d held, flush every %d frames\n",
+        nFrames, nWidth, nHeight, FRAME_POOL_BENCH_QUEUE, FRAME_POOL_BENCH_SEEK_INTERVAL);
+    fprintf(fp, "%-22s %10s %14s %12s %14s %10s\n", "allocator", "ms/frame", "page faults", "faults/frame", "dTLB miss/frame", "huge MB");
+
+    for (int nMode = 0; nMode < FRAME_POOL_MODE_NB; nMode++)
+    {
+        fprintf(fp, "%-22s ", names[nMode]);
+        if (RunBenchMode(nMode, nFrames, nWidth, nHeight, fp) < 0)
+        {
+            fprintf(fp, "failed\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//模拟解码：分配帧，写满各平面，再按 16x16 块从持有的其他帧随机读取（运动补偿）
+int FramePool::RunBenchMode(int nMode, int nFrames, int nWidth, int nHeight, FILE *fp)
+{
+    FramePool stPool;
+    AVFrame *frames[FRAME_POOL_BENCH_QUEUE] = { NULL };
+    FramePoolStats stats;
+    uint32_t nRand = 1;
+    uint64_t nSum = 0;
+    int nBlocks = (nWidth / 16) * (nHeight / 16) / 4;
+    int ret = 0;
+
+    stPool.SetMode(nMode);
+    for (int i = 0; i < FRAME_POOL_BENCH_QUEUE; i++)
+    {
+        if (!(frames[i] = av_frame_alloc()))
+        {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+    }
+
+    {
+        int fd = PerfCounter::Open(PERF_COUNTER_DTLB_READ_MISS);
+        int64_t nFaults = page_fault_count();
+        int64_t nStart = av_gettime_relative();
+        PerfCounter::Start(fd);
+
+        for (int n = 0; n < nFrames; n++)
+        {
+            if (n % FRAME_POOL_BENCH_SEEK_INTERVAL == 0)
+            {
+                for (int i = 0; i < FRAME_POOL_BENCH_QUEUE; i++)
+                    av_frame_unref(frames[i]);
+            }
+
+            AVFrame *frame = frames[n % FRAME_POOL_BENCH_QUEUE];
+            av_frame_unref(frame);
+            frame->format = AV_PIX_FMT_YUV420P;
+            frame->width = nWidth;
+            frame->height = nHeight;
+            ret = nMode == FRAME_POOL_OFF ? av_frame_get_buffer(frame, 0) : stPool.GetFrameBuffer(frame);
+            if (ret < 0)
+                break;
+
+            for (int p = 0; p < 3; p++)
+            {
+                int w = p ? AV_CEIL_RSHIFT(nWidth, 1) : nWidth;
+                int h = p ? AV_CEIL_RSHIFT(nHeight, 1) : nHeight;
+                for (int y = 0; y < h; y++)
+                    memset(frame->data[p] + y * frame->linesize[p], (n + y) & 0xff, w);
+            }
+
+            for (int b = 0; b < nBlocks; b++)
+            {
+                nRand = nRand * 1664525 + 1013904223;
+                AVFrame *ref = frames[(nRand >> 8) % FRAME_POOL_BENCH_QUEUE];
+                if (!ref->data[0])
+                    continue;
+                nRand = nRand * 1664525 + 1013904223;
+                int x = (nRand >> 8) % (nWidth - 15);
+                nRand = nRand * 1664525 + 1013904223;
+                int y = (nRand >> 8) % (nHeight - 15);
+                for (int r = 0; r < 16; r++)
+                    nSum += ref->data[0][(y + r) * ref->linesize[0] + x];
+            }
+        }
+
+        int64_t nElapsed = av_gettime_relative() - nStart;
+        int64_t nTlbMisses = PerfCounter::Stop(fd);
+        nFaults = page_fault_count() - nFaults;
+        PerfCounter::Close(fd);
+        FramePool::GetStats(&stats);
+
+        if (ret >= 0)
+        {
+            char szTlb[32] = "n/a";
+            if (nTlbMisses >= 0)
+                snprintf(szTlb, sizeof(szTlb), "%.0f", (double)nTlbMisses / nFrames);
+            fprintf(fp, "%10.2f %14" PRId64 " %12.1f %14s %10.1f\n", nElapsed / 1000.0 / nFrames, nFaults,
+                (double)nFaults / nFrames, szTlb, stats.huge_bytes / (1024.0 * 1024.0));
+        }
+    }
+
+end:
+    //校验和只为防止读取被优化掉
+    av_log(NULL, AV_LOG_DEBUG, "frame pool benchmark checksum %" PRIu64 "\n", nSum);
+    for (int i = 0; i < FRAME_POOL_BENCH_QUEUE; i++)
+        av_frame_free(&frames[i]);
+    stPool.Trim();
+    return ret;
+}
@@ -0,0 +1,124 @@
+﻿/*
+ * @file 	framepool.h
+ * @date 	2026/10/18 23:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	视频帧缓冲池
+ * @note	4K/8K 的一帧有几十 MB，解码器默认每个参考帧单独分配，大块内存由 malloc 直接 mmap，
+ *			释放即归还系统，seek 后重新分配时逐页缺页。这里按大小建 AVBufferPool，
+ *			缓冲区用大页（Linux 先试 hugetlbfs，再用透明大页；Windows 需要锁定内存页权限）
+ *			分配并在分配时预先写入，归还后留在池中，seek 后直接复用，不再缺页。
+ *			接管视频解码器的 get_buffer2，也为画面格式转换提供缓冲区。
+ */
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "globalhelper.h"
+
+#define FRAME_POOL_HUGE_PAGE_SIZE (2 * 1024 * 1024) //大页大小
+#define FRAME_POOL_HUGE_MIN_SIZE (1024 * 1024)      //小于该大小的缓冲区用普通页，避免按大页取整浪费
+#define FRAME_POOL_SIZE_ALIGN (64 * 1024)           //缓冲区大小取整，相近的大小共用一个池
+#define FRAME_POOL_PLANE_PADDING 128                //每个平面后的余量，与解码器默认分配一致（16 + 对齐）
+#define FRAME_POOL_MAX_SIZES 6                      //最多保留的不同大小的池
+#define FRAME_POOL_BENCH_QUEUE 8                    //基准测试同时持有的帧数（参考帧 + 显示队列）
+#define FRAME_POOL_BENCH_SEEK_INTERVAL 30           //基准测试每隔多少帧模拟一次 seek（释放全部帧）
+
+enum FramePoolMode {
+    FRAME_POOL_OFF,         //解码器默认分配
+    FRAME_POOL_PAGES,       //缓冲池，普通页
+    FRAME_POOL_HUGE_PAGES,  //缓冲池，大页
+    FRAME_POOL_MODE_NB
+};
+
+//缓冲池统计，所有池合计
+typedef struct FramePoolStats {
+    int64_t requests;       //取缓冲区次数
+    int64_t allocations;    //新分配次数（池中没有空闲）
+    int64_t bytes;          //已分配（含池中空闲）的字节数
+    int64_t huge_bytes;     //其中大页的字节数
+} FramePoolStats;
+
+class FramePool
+{
+public:
+    FramePool();
+    ~FramePool();
+
+    static FramePool* GetInstance();
+
+    void SetMode(int nMode);
+    int GetMode();
+
+    /**
+     * @brief	视频解码器使用缓冲池分配输出帧，打开解码器之前调用
+     */
+    void Attach(AVCodecContext *avctx);
+
+    /**
+     * @brief	取一个缓冲区，起始地址按页对齐，线程安全
+     *
+     * @param	nSize 字节数
+     * @return	缓冲区，失败返回 NULL
+     */
+    AVBufferRef *GetBuffer(size_t nSize);
+
+    /**
+     * @brief	按帧的 format、width、height 从池中分配数据，代替 av_frame_get_buffer
+     *
+     * @return	0 成功 负值失败
+     */
+    int GetFrameBuffer(AVFrame *frame);
+
+    /**
+     * @brief	释放池中空闲的缓冲区，使用中的缓冲区归还时释放
+     */
+    void Trim();
+
+    static void GetStats(FramePoolStats *stats);
+
+    /**
+     * @brief	基准测试，比较默认分配与各缓冲池方式的缺页数、TLB 未命中数和耗时
+     *
+     * @param	nFrames 每种方式分配的帧数
+     * @param	nWidth 帧宽
+     * @param	nHeight 帧高
+     * @param	fp 结果输出
+     * @return	进程返回值
+     */
+    static int RunBench(int nFrames, int nWidth, int nHeight, FILE *fp);
+
+private:
+    static int GetBuffer2(AVCodecContext *avctx, AVFrame *frame, int flags);
+    int GetVideoBuffer(AVCodecContext *avctx, AVFrame *frame);
+    int AllocPlanes(AVFrame *frame, int nHeight, const int linesize[4]);
+
+    static AVBufferRef *PoolAlloc(void *opaque, size_t nSize);
+    static void PoolFree(void *opaque, uint8_t *data);
+
+    static int RunBenchMode(int nMode, int nFrames, int nWidth, int nHeight, FILE *fp);
+
+private:
+    static FramePool* m_pInstance; //< 单例指针
+
+    //一种大小的池
+    typedef struct SizePool {
+        size_t size;
+        bool huge;
+        AVBufferPool *pool;
+        int64_t last_use;
+    } SizePool;
+
+    std::mutex m_mutex;
+    std::vector<SizePool> m_vecPools;
+    int64_t m_nUseCounter;          //< 最近使用顺序，超出个数时去掉最久未用的池
+    std::atomic<int> m_nMode;       //< FramePoolMode
+};
+
+#endif // FRAMEPOOL_H
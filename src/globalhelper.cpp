@@ -87,6 +87,64 @@ void GlobalHelper::GetPlayVolume(double& nVolume)
     nVolume = settings.value("volume/size", nVolume).toDouble();
 }
 
+void GlobalHelper::SaveColorConfig(const QString& strDisplayProfile, const QString& strLutFile)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    settings.setValue("color/display_profile", strDisplayProfile);
+    settings.setValue("color/lut_file", strLutFile);
+}
+
+void GlobalHelper::GetColorConfig(QString& strDisplayProfile, QString& strLutFile)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    strDisplayProfile = settings.value("color/display_profile").toString();
+    strLutFile = settings.value("color/lut_file").toString();
+}
+
+void GlobalHelper::SaveResamplePreset(int nPreset)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    settings.setValue("audio/resample_preset", nPreset);
+}
+
+void GlobalHelper::GetResamplePreset(int& nPreset)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    nPreset = settings.value("audio/resample_preset", nPreset).toInt();
+}
+
+void GlobalHelper::SaveRenderBackend(int nBackend)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    settings.setValue("video/render_backend", nBackend);
+}
+
+void GlobalHelper::GetRenderBackend(int& nBackend)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    nBackend = settings.value("video/render_backend", nBackend).toInt();
+}
+
+void GlobalHelper::SaveDecoderPool(bool bEnabled)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    settings.setValue("video/decoder_pool", bEnabled);
+}
+
+void GlobalHelper::GetDecoderPool(bool& bEnabled)
+{
+    QString strPlayerConfigFileName = PLAYER_CONFIG_BASEDIR + QDir::separator() + PLAYER_CONFIG;
+    QSettings settings(strPlayerConfigFileName, QSettings::IniFormat);
+    bEnabled = settings.value("video/decoder_pool", bEnabled).toBool();
+}
+
 QString GlobalHelper::GetAppVersion()
 {
     return APP_VERSION;
@@ -53,6 +53,18 @@ public:
     static void GetPlaylist(QStringList& playList);
     static void SavePlayVolume(double& nVolume);
     static void GetPlayVolume(double& nVolume);
+    //颜色管理：显示器 ICC 配置文件、.cube 文件，为空表示不使用
+    static void SaveColorConfig(const QString& strDisplayProfile, const QString& strLutFile);
+    static void GetColorConfig(QString& strDisplayProfile, QString& strLutFile);
+    //重采样预设（ResamplePreset）
+    static void SaveResamplePreset(int nPreset);
+    static void GetResamplePreset(int& nPreset);
+    //画面输出方式（RenderBackendType）
+    static void SaveRenderBackend(int nBackend);
+    static void GetRenderBackend(int& nBackend);
+    //解码器复用
+    static void SaveDecoderPool(bool bEnabled);
+    static void GetDecoderPool(bool& bEnabled);
 
     static QString GetAppVersion();
 };
@@ -75,6 +87,7 @@ extern "C"{
 #include "libavutil/parseutils.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/time.h"
+#include "libavutil/display.h"
 #include "libavutil/bprint.h"
 #include "libavformat/avformat.h"
 #include "libavcodec/avcodec.h"
@@ -84,6 +97,7 @@ extern "C"{
 #include "libavutil/opt.h"
 #include "libavcodec/avfft.h"
 #include "libswresample/swresample.h"
+#include "libavutil/audio_fifo.h"
 
 #include "SDL2/SDL.h"
 }
@@ -93,6 +107,9 @@ extern "C"{
 
 #define MAX_SLIDER_VALUE 65536
 
+/* 缓存行大小，不同线程写入的数据按缓存行隔开，避免伪共享 */
+#define CACHE_LINE_SIZE 64
+
 
 
 #endif // GLOBALHELPER_H
@@ -0,0 +1,367 @@
+﻿/*
+ * @file 	ioscheduler.cpp
+ * @date 	2026/10/19 16:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	读取调度：播放读取优先，后台读取限速
+ * @note
+ */
+
+#include <chrono>
+
+#include "ioscheduler.h"
+
+#pragma execution_character_set("utf-8")
+
+#define IO_WAIT_SLICE_US 20000      //等待时按该间隔检查中断回调（微秒）
+#define IO_MIN_RATE_SCALE 0.1       //缓冲刚超过 IO_BUFFER_LOW 时的速率比例
+#define IO_BURST_TIME 0.1           //令牌桶最多积累该时长的读取量（秒）
+
+//日志中的类别名
+static const char *const s_pszClassNames[IO_CLASS_NB] = { "playback", "probe", "proxy" };
+//界面显示的类别名
+static const char *const s_pszClassTitles[IO_CLASS_NB] = { "播放", "元数据探测", "代理转码" };
+
+//后台读取的文件
+typedef struct IoReader {
+    AVIOContext *inner;         //实际读取文件
+    int io_class;
+    AVIOInterruptCB interrupt;  //打开时 AVFormatContext 中的中断回调
+} IoReader;
+
+IoScheduler *IoScheduler::m_pInstance = new IoScheduler();
+
+IoScheduler::IoScheduler() :
+    m_nPlaybackReads(0),
+    m_nPlaybackStreams(0),
+    m_dBuffer(0),
+    m_bSatisfied(false),
+    m_bStarved(false),
+    m_nStarvedCount(0),
+    m_dTokens(0),
+    m_nTokenTime(0),
+    m_nWindowStart(0),
+    m_nNextReport(0),
+    m_nReportBackground(0)
+{
+    memset(m_arrStats, 0, sizeof(m_arrStats));
+    memset(m_arrWindowBytes, 0, sizeof(m_arrWindowBytes));
+}
+
+IoScheduler::~IoScheduler()
+{
+
+}
+
+IoScheduler *IoScheduler::GetInstance()
+{
+    return m_pInstance;
+}
+
+void IoScheduler::PlaybackStart()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_nPlaybackStreams++;
+    m_dBuffer = 0;
+    m_bSatisfied = false;
+    m_bStarved = false;
+}
+
+void IoScheduler::PlaybackStop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_nPlaybackStreams--;
+        m_bStarved = false;
+    }
+    m_cond.notify_all();
+}
+
+void IoScheduler::PlaybackReadBegin()
+{
+    m_nPlaybackReads++;
+}
+
+void IoScheduler::PlaybackReadEnd(int64_t nBytes)
+{
+    m_nPlaybackReads--;
+    if (nBytes > 0)
+    {
+        Account(IO_CLASS_PLAYBACK, nBytes);
+    }
+    m_cond.notify_all();
+}
+
+void IoScheduler::SetPlaybackBuffer(double dSeconds, bool bSatisfied)
+{
+    bool bRecovered = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dBuffer = dSeconds;
+        m_bSatisfied = bSatisfied;
+        if (!m_bStarved && !bSatisfied && dSeconds < IO_BUFFER_LOW)
+        {
+            m_bStarved = true;
+            m_nStarvedCount++;
+        }
+        else if (m_bStarved && (bSatisfied || dSeconds >= IO_BUFFER_HIGH))
+        {
+            m_bStarved = false;
+            bRecovered = true;
+        }
+    }
+
+    if (bRecovered)
+    {
+        m_cond.notify_all();
+    }
+}
+
+bool IoScheduler::BackgroundWait(int nClass, int nBytes, const AVIOInterruptCB *cb)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    int64_t nWaitStart = 0;
+    bool bResult = true;
+
+    for (;;)
+    {
+        int64_t nNow = av_gettime_relative();
+        int64_t nWait = IO_WAIT_SLICE_US;
+
+        if (cb->callback && cb->callback(cb->opaque))
+        {
+            bResult = false;
+            break;
+        }
+        //没有播放时不限速
+        if (m_nPlaybackStreams <= 0)
+        {
+            break;
+        }
+
+        //播放正在读取或缓冲不足时让出
+        if (m_nPlaybackReads == 0 && !m_bStarved)
+        {
+            //缓冲越接近耗尽速率越低
+            double dRate = IO_BACKGROUND_RATE;
+            if (!m_bSatisfied)
+            {
+                dRate *= av_clipd((m_dBuffer - IO_BUFFER_LOW) / (IO_BUFFER_HIGH - IO_BUFFER_LOW), IO_MIN_RATE_SCALE, 1.0);
+            }
+
+            m_dTokens += dRate * (nNow - m_nTokenTime) / 1000000.0;
+            m_dTokens = FFMIN(m_dTokens, FFMAX(dRate * IO_BURST_TIME, (double)nBytes));
+            m_nTokenTime = nNow;
+            if (m_dTokens >= nBytes)
+            {
+                m_dTokens -= nBytes;
+                break;
+            }
+            nWait = FFMIN(nWait, (int64_t)((nBytes - m_dTokens) / dRate * 1000000.0) + 1);
+        }
+
+        if (!nWaitStart)
+        {
+            nWaitStart = nNow;
+        }
+        m_cond.wait_for(lock, std::chrono::microseconds(nWait));
+    }
+
+    if (nWaitStart)
+    {
+        m_arrStats[nClass].waits++;
+        m_arrStats[nClass].wait_seconds += (av_gettime_relative() - nWaitStart) / 1000000.0;
+    }
+    return bResult;
+}
+
+void IoScheduler::Account(int nClass, int64_t nBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t nNow = av_gettime_relative();
+    int64_t nBackground = 0;
+
+    m_arrStats[nClass].bytes += nBytes;
+    UpdateRates(nNow);
+
+    if (nNow < m_nNextReport)
+    {
+        return;
+    }
+    m_nNextReport = nNow + (int64_t)(IO_REPORT_INTERVAL * 1000000);
+
+    //只在有后台读取时输出
+    for (int i = IO_CLASS_PLAYBACK + 1; i < IO_CLASS_NB; i++)
+    {
+        nBackground += m_arrStats[i].bytes;
+    }
+    if (nBackground == m_nReportBackground)
+    {
+        return;
+    }
+    m_nReportBackground = nBackground;
+
+    char szLine[512];
+    int nLen = snprintf(szLine, sizeof(szLine), "I/O:");
+    for (int i = 0; i < IO_CLASS_NB; i++)
+    {
+        nLen += snprintf(szLine + nLen, sizeof(szLine) - nLen, " %s %.1f MB/s (%.0f MB, waited %.1f s)%s",
+            s_pszClassNames[i], m_arrStats[i].rate / 1048576, m_arrStats[i].bytes / 1048576.0,
+            m_arrStats[i].wait_seconds, i + 1 < IO_CLASS_NB ? "," : "");
+    }
+    av_log(NULL, AV_LOG_INFO, "%s; playback buffer %.2f s, low %" PRId64 " times\n", szLine, m_dBuffer, m_nStarvedCount);
+}
+
+void IoScheduler::UpdateRates(int64_t nNow)
+{
+    double dElapsed = (nNow - m_nWindowStart) / 1000000.0;
+
+    if (dElapsed < IO_RATE_WINDOW)
+    {
+        return;
+    }
+    for (int i = 0; i < IO_CLASS_NB; i++)
+    {
+        m_arrStats[i].rate = (m_arrStats[i].bytes - m_arrWindowBytes[i]) / dElapsed;
+        m_arrWindowBytes[i] = m_arrStats[i].bytes;
+    }
+    m_nWindowStart = nNow;
+}
+
+void IoScheduler::GetStats(IoClassStats stats[IO_CLASS_NB])
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    UpdateRates(av_gettime_relative());
+    memcpy(stats, m_arrStats, sizeof(m_arrStats));
+}
+
+QString IoScheduler::Summary()
+{
+    IoClassStats stats[IO_CLASS_NB];
+    QString strSummary;
+    int64_t nStarvedCount;
+
+    GetStats(stats);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        nStarvedCount = m_nStarvedCount;
+    }
+
+    for (int i = 0; i < IO_CLASS_NB; i++)
+    {
+        strSummary += QString("%1：累计 %2 MB，当前 %3 MB/s").arg(s_pszClassTitles[i])
+            .arg(stats[i].bytes / 1048576.0, 0, 'f', 1).arg(stats[i].rate / 1048576, 0, 'f', 1);
+        if (i != IO_CLASS_PLAYBACK)
+        {
+            strSummary += QString("，让出 %1 次共 %2 秒").arg(stats[i].waits).arg(stats[i].wait_seconds, 0, 'f', 1);
+        }
+        strSummary += "\n";
+    }
+    strSummary += QString("播放缓冲低于 %1 秒：%2 次").arg(IO_BUFFER_LOW).arg(nStarvedCount);
+
+    return strSummary;
+}
+
+int IoScheduler::OpenInput(AVFormatContext **pic, const char *url, int nClass)
+{
+    AVFormatContext *ic = *pic;
+    AVIOContext *pb = NULL;
+    IoReader *reader;
+    uint8_t *buffer;
+    int ret;
+
+    if (!ic && !(ic = avformat_alloc_context()))
+        return AVERROR(ENOMEM);
+
+    reader = (IoReader *)av_mallocz(sizeof(IoReader));
+    if (!reader) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    reader->io_class = nClass;
+    reader->interrupt = ic->interrupt_callback;
+    if ((ret = avio_open2(&reader->inner, url, AVIO_FLAG_READ, &ic->interrupt_callback, NULL)) < 0) {
+        av_freep(&reader);
+        goto fail;
+    }
+
+    buffer = (uint8_t *)av_malloc(IO_BLOCK_SIZE);
+    if (buffer)
+        pb = avio_alloc_context(buffer, IO_BLOCK_SIZE, 0, reader, ReadPacket, NULL, Seek);
+    if (!pb) {
+        av_free(buffer);
+        avio_closep(&reader->inner);
+        av_freep(&reader);
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    pb->seekable = reader->inner->seekable;
+
+    //ic 设置了 pb 时 avformat_open_input 不打开、也不关闭文件，失败时释放 ic
+    ic->pb = pb;
+    if ((ret = avformat_open_input(&ic, url, NULL, NULL)) < 0) {
+        FreeReader(&pb);
+        *pic = NULL;
+        return ret;
+    }
+    *pic = ic;
+    return 0;
+
+fail:
+    avformat_free_context(ic);
+    *pic = NULL;
+    return ret;
+}
+
+void IoScheduler::CloseInput(AVFormatContext **pic)
+{
+    AVIOContext *pb = *pic ? (*pic)->pb : NULL;
+
+    avformat_close_input(pic);
+    if (pb && pb->read_packet == ReadPacket)
+        FreeReader(&pb);
+}
+
+int IoScheduler::ReadPacket(void *opaque, uint8_t *buf, int buf_size)
+{
+    IoReader *reader = (IoReader *)opaque;
+    int ret;
+
+    if (!GetInstance()->BackgroundWait(reader->io_class, buf_size, &reader->interrupt))
+        return AVERROR_EXIT;
+
+    ret = avio_read_partial(reader->inner, buf, buf_size);
+    if (ret == 0)
+        return AVERROR_EOF;
+    if (ret > 0)
+        GetInstance()->Account(reader->io_class, ret);
+    return ret;
+}
+
+int64_t IoScheduler::Seek(void *opaque, int64_t offset, int whence)
+{
+    IoReader *reader = (IoReader *)opaque;
+
+    if (whence == AVSEEK_SIZE)
+        return avio_size(reader->inner);
+    return avio_seek(reader->inner, offset, whence & ~AVSEEK_FORCE);
+}
+
+void IoScheduler::FreeReader(AVIOContext **ppb)
+{
+    AVIOContext *pb = *ppb;
+    IoReader *reader;
+
+    if (!pb)
+        return;
+    reader = (IoReader *)pb->opaque;
+    if (reader) {
+        avio_closep(&reader->inner);
+        av_freep(&reader);
+    }
+    av_freep(&pb->buffer);
+    avio_context_free(ppb);
+}
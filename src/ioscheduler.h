@@ -0,0 +1,125 @@
+﻿/*
+ * @file 	ioscheduler.h
+ * @date 	2026/10/19 16:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	读取调度：播放读取优先，后台读取限速
+ * @note	元数据探测、代理转码等后台任务与播放读取同一块机械硬盘或网络共享时，会抢占播放的读取。
+ *			播放读取线程不受限制，只报告正在读取和数据包队列的缓冲时长；后台任务通过 OpenInput 打开文件，
+ *			每次读取前等待：播放正在读取时让出，缓冲低于 IO_BUFFER_LOW 时暂停直到恢复到 IO_BUFFER_HIGH，
+ *			其间按缓冲时长限速（离耗尽越近越慢），缓冲已满或读到结尾时按 IO_BACKGROUND_RATE 限速，没有播放时不限速。
+ *			按类别统计读取量和速率。
+ */
+#ifndef IOSCHEDULER_H
+#define IOSCHEDULER_H
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include <QString>
+
+#include "globalhelper.h"
+
+#define IO_BUFFER_LOW 0.5                       //播放缓冲低于该值暂停后台读取（秒）
+#define IO_BUFFER_HIGH 1.0                      //播放缓冲达到该值后台读取恢复全速（秒）
+#define IO_BACKGROUND_RATE (8 * 1024 * 1024)    //播放时后台读取的总速率上限（字节/秒）
+#define IO_BLOCK_SIZE (64 * 1024)               //后台每次读取的最大字节数，限制单次占用磁盘的时间
+#define IO_RATE_WINDOW 2.0                      //计算当前速率的时间窗口（秒）
+#define IO_REPORT_INTERVAL 10.0                 //有后台读取时输出统计的间隔（秒）
+
+enum IoClass {
+    IO_CLASS_PLAYBACK,      //播放，不受限制
+    IO_CLASS_PROBE,         //播放列表元数据探测
+    IO_CLASS_PROXY,         //代理转码
+    IO_CLASS_NB
+};
+
+typedef struct IoClassStats {
+    int64_t bytes;          //累计读取字节数
+    double rate;            //最近的速率（字节/秒）
+    int64_t waits;          //等待次数（后台）
+    double wait_seconds;    //累计等待时间（后台，秒）
+} IoClassStats;
+
+class IoScheduler
+{
+public:
+    IoScheduler();
+    ~IoScheduler();
+
+    static IoScheduler* GetInstance();
+
+    //播放读取线程开始、结束
+    void PlaybackStart();
+    void PlaybackStop();
+
+    //播放读取前后调用，读取期间后台让出
+    void PlaybackReadBegin();
+    void PlaybackReadEnd(int64_t nBytes);
+
+    /**
+     * @brief	播放读取线程每次循环更新缓冲状态
+     *
+     * @param	dSeconds 音视频队列中较短的缓冲时长（秒）
+     * @param	bSatisfied 队列已满或已读到结尾，暂时不需要读取
+     */
+    void SetPlaybackBuffer(double dSeconds, bool bSatisfied);
+
+    /**
+     * @brief	打开文件用于后台读取，用法与 avformat_open_input 相同，所有读取经过调度。
+     *			预先分配的 ic 中设置的中断回调在等待时同样生效。必须用 CloseInput 关闭
+     *
+     * @param	nClass 读取类别（IoClass）
+     * @return	0 成功 负值失败（ic 已释放）
+     */
+    static int OpenInput(AVFormatContext **pic, const char *url, int nClass);
+    static void CloseInput(AVFormatContext **pic);
+
+    void GetStats(IoClassStats stats[IO_CLASS_NB]);
+
+    //各类别的读取统计，用于显示
+    QString Summary();
+
+private:
+    /**
+     * @brief	后台读取前等待
+     *
+     * @param	nBytes 将要读取的字节数
+     * @param	cb 中断回调
+     * @return	false 被中断
+     */
+    bool BackgroundWait(int nClass, int nBytes, const AVIOInterruptCB *cb);
+    void Account(int nClass, int64_t nBytes);
+    void UpdateRates(int64_t nNow);
+
+    static int ReadPacket(void *opaque, uint8_t *buf, int buf_size);
+    static int64_t Seek(void *opaque, int64_t offset, int whence);
+    static void FreeReader(AVIOContext **ppb);
+
+private:
+    static IoScheduler* m_pInstance; //< 单例指针
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::atomic<int> m_nPlaybackReads;  //< 正在进行的播放读取
+    int m_nPlaybackStreams;             //< 正在播放的读取线程数
+    double m_dBuffer;                   //< 播放缓冲时长（秒）
+    bool m_bSatisfied;                  //< 播放暂时不需要读取
+    bool m_bStarved;                    //< 缓冲低于 IO_BUFFER_LOW，尚未恢复到 IO_BUFFER_HIGH
+    int64_t m_nStarvedCount;            //< 进入低缓冲的次数
+
+    double m_dTokens;                   //< 后台可读取的字节数（令牌桶）
+    int64_t m_nTokenTime;               //< 上次补充令牌的时间（微秒）
+
+    IoClassStats m_arrStats[IO_CLASS_NB];
+    int64_t m_arrWindowBytes[IO_CLASS_NB];  //< 速率窗口开始时的累计字节数
+    int64_t m_nWindowStart;
+    int64_t m_nNextReport;
+    int64_t m_nReportBackground;        //< 上次输出统计时后台累计字节数
+};
+
+#endif // IOSCHEDULER_H
@@ -0,0 +1,147 @@
+﻿/*
+ * @file 	layoutbench.cpp
+ * @date 	2026/10/20 10:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	VideoState 布局基准测试
+ * @note
+ */
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "layoutbench.h"
+#include "datactl.h"
+#include "perfcounter.h"
+
+#pragma execution_character_set("utf-8")
+
+//人为构造的紧凑布局，不是拆分前 VideoState 的字段顺序：
+//把各线程常写的字段（包括后来加入的解码计数）放在一起，落在同一缓存行，作为伪共享的最坏情况
+typedef struct PackedState {
+    int abort_request;          //控制线程
+    int eof;                    //读取线程
+    int audio_buf_index;        //音频回调
+    int audio_write_buf_size;
+    double audio_clock;
+    double frame_timer;         //渲染线程
+    int force_refresh;
+    int64_t frames_decoded;     //视频解码线程
+    double audio_primed;        //音频解码线程
+} PackedState;
+
+//各线程访问的字段，指向 PackedState 或 VideoState
+typedef struct HotFields {
+    volatile int *abort_request;
+    volatile int *eof;
+    volatile int *audio_buf_index;
+    volatile int *audio_write_buf_size;
+    volatile double *audio_clock;
+    volatile double *frame_timer;
+    volatile int *force_refresh;
+    volatile int64_t *frames_decoded;
+    volatile double *audio_primed;
+} HotFields;
+
+//一个模拟线程：等所有线程就绪后同时开始，返回耗时（微秒），未命中数累加到 misses（有线程不支持计数时置为 -1）
+static void bench_thread(int nRole, const HotFields *f, int nIterations, std::atomic<int> *ready,
+                         std::atomic<int64_t> *elapsed, std::atomic<int64_t> *misses)
+{
+    int fd = PerfCounter::Open(PERF_COUNTER_L1D_READ_MISS);
+
+    ready->fetch_add(1);
+    while (ready->load() < LAYOUT_BENCH_THREADS)
+        std::this_thread::yield();
+
+    int64_t nStart = av_gettime_relative();
+    PerfCounter::Start(fd);
+    for (int i = 0; i < nIterations && !*f->abort_request; i++) {
+        switch (nRole) {
+        case 0:
+            *f->eof = i & 1;
+            break;
+        case 1:
+            *f->audio_buf_index = *f->audio_buf_index + 4;
+            *f->audio_write_buf_size = i;
+            *f->audio_clock = *f->audio_clock + 0.001;
+            break;
+        case 2:
+            *f->frame_timer = *f->frame_timer + 0.016;
+            *f->force_refresh = i & 1;
+            break;
+        case 3:
+            *f->frames_decoded = *f->frames_decoded + 1;
+            break;
+        default:
+            *f->audio_primed = *f->audio_primed + 0.02;
+            break;
+        }
+    }
+    int64_t nMisses = PerfCounter::Stop(fd);
+    PerfCounter::Close(fd);
+    int64_t nElapsed = av_gettime_relative() - nStart;
+
+    int64_t nPrev = elapsed->load();
+    while (nPrev < nElapsed && !elapsed->compare_exchange_weak(nPrev, nElapsed))
+        ;
+    if (nMisses < 0)
+        misses->store(-1);
+    else if (misses->load() >= 0)
+        misses->fetch_add(nMisses);
+}
+
+static void run_layout(const char *pszName, const HotFields *f, int nIterations, FILE *fp)
+{
+    std::thread threads[LAYOUT_BENCH_THREADS];
+    std::atomic<int> ready(0);
+    std::atomic<int64_t> elapsed(0);
+    std::atomic<int64_t> misses(0);
+
+    for (int i = 0; i < LAYOUT_BENCH_THREADS; i++)
+        threads[i] = std::thread(bench_thread, i, f, nIterations, &ready, &elapsed, &misses);
+    for (int i = 0; i < LAYOUT_BENCH_THREADS; i++)
+        threads[i].join();
+
+    char szMisses[32] = "n/a";
+    if (misses.load() >= 0)
+        snprintf(szMisses, sizeof(szMisses), "%.3f", (double)misses.load() / ((double)nIterations * LAYOUT_BENCH_THREADS));
+    fprintf(fp, "%-28s %12.2f %16s\n", pszName, elapsed.load() * 1000.0 / nIterations, szMisses);
+}
+
+int LayoutBench::Run(int nIterations, FILE *fp)
+{
+    PackedState *packed = new (std::nothrow) PackedState();
+    VideoState *is = new (std::nothrow) VideoState();
+    int ret = 0;
+
+    if (!packed || !is) {
+        fprintf(fp, "out of memory\n");
+        ret = 1;
+        goto end;
+    }
+
+    fprintf(fp, "VideoState layout benchmark: %d threads, %d iterations each, %d CPUs\n",
+        LAYOUT_BENCH_THREADS, nIterations, (int)std::thread::hardware_concurrency());
+    fprintf(fp, "synthetic packed: the same hot fields placed adjacent in one %d-byte struct (worst case),\n"
+        "not the field order of VideoState before the split\n", (int)sizeof(PackedState));
+    fprintf(fp, "%-28s %12s %16s\n", "layout", "ns/iter", "L1D miss/iter");
+
+    {
+        HotFields f = { &packed->abort_request, &packed->eof, &packed->audio_buf_index, &packed->audio_write_buf_size,
+            &packed->audio_clock, &packed->frame_timer, &packed->force_refresh, &packed->frames_decoded, &packed->audio_primed };
+        run_layout("synthetic packed", &f, nIterations, fp);
+    }
+    {
+        HotFields f = { &is->abort_request, &is->eof, &is->audio_buf_index, &is->audio_write_buf_size,
+            &is->audio_clock, &is->frame_timer, &is->force_refresh, &is->frames_decoded, &is->audio_primed };
+        run_layout("VideoState (per-thread)", &f, nIterations, fp);
+    }
+
+end:
+    delete packed;
+    delete is;
+    return ret;
+}
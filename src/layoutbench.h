@@ -0,0 +1,35 @@
+﻿/*
+ * @file 	layoutbench.h
+ * @date 	2026/10/20 10:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	VideoState 布局基准测试
+ * @note	用五个线程模拟读取线程、音频回调、渲染线程、视频解码线程、音频解码线程，
+ *			各自循环写入自己常写的字段并读取控制线程的 abort_request。
+ *			分别在人为构造的紧凑布局（同样的字段相邻，落在同一缓存行，伪共享的最坏情况，
+ *			不是拆分前 VideoState 的字段顺序）和当前 VideoState 上运行，
+ *			比较每次循环的耗时和 L1D 读未命中数（Linux perf 计数器，没有权限时显示 n/a）。
+ */
+#ifndef LAYOUTBENCH_H
+#define LAYOUTBENCH_H
+
+#include <cstdio>
+
+#define LAYOUT_BENCH_THREADS 5      //模拟的写入线程数
+
+class LayoutBench
+{
+public:
+    /**
+     * @brief	运行基准测试
+     *
+     * @param	nIterations 每个线程的循环次数
+     * @param	fp 结果输出
+     * @return	进程返回值
+     */
+    static int Run(int nIterations, FILE *fp);
+};
+
+#endif // LAYOUTBENCH_H
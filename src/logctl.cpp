@@ -0,0 +1,418 @@
+﻿/*
+ * @file 	logctl.cpp
+ * @date 	2026/10/18 10:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	异步日志
+ * @note
+ */
+
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+#include "logctl.h"
+
+#pragma execution_character_set("utf-8")
+
+namespace {
+
+//线程已退出（thread_local 已析构），之后的日志不再领取缓冲区
+thread_local bool t_ring_exited = false;
+
+//线程退出时标记缓冲区，由刷新线程写完后回收
+struct LogRingHolder {
+    LogRing *ring = nullptr;
+    ~LogRingHolder()
+    {
+        if (ring)
+            ring->state.store(LOG_RING_RETIRED, std::memory_order_release);
+        ring = nullptr;
+        t_ring_exited = true;
+    }
+};
+
+thread_local LogRingHolder t_ring_holder;
+
+//缓冲区不可用时 av_log_format_line2 使用的行首标志
+thread_local int t_print_prefix = 1;
+
+//LogRing::repeat 的打包与拆分
+inline uint64_t make_repeat(uint32_t seq, uint32_t count)
+{
+    return ((uint64_t)seq << 32) | count;
+}
+
+inline uint32_t repeat_seq(uint64_t repeat)
+{
+    return (uint32_t)(repeat >> 32);
+}
+
+inline uint32_t repeat_count(uint64_t repeat)
+{
+    return (uint32_t)repeat;
+}
+
+}
+
+LogCtl *LogCtl::m_pInstance = new LogCtl();
+
+LogCtl *LogCtl::GetInstance()
+{
+    return m_pInstance;
+}
+
+LogCtl::LogCtl() :
+    m_bInited(false),
+    m_bRunning(false),
+    m_arrRings(nullptr),
+    m_nNoRing(0)
+{
+}
+
+LogCtl::~LogCtl()
+{
+    UnInit();
+}
+
+bool LogCtl::Init()
+{
+    if (m_bInited == true)
+    {
+        return true;
+    }
+
+    //不在构造函数中分配，单例在静态初始化时创建，不用日志的进程不占这部分内存；
+    //再次 Init 时沿用，已领取缓冲区的线程可能还在
+    if (!m_arrRings)
+    {
+        //默认初始化，日志条目所在的内存页用到时才实际占用
+        m_arrRings = new (std::nothrow) LogRing[LOG_MAX_THREADS];
+        if (!m_arrRings)
+        {
+            return false;
+        }
+        for (int i = 0; i < LOG_MAX_THREADS; i++)
+        {
+            m_arrRings[i].head.store(0, std::memory_order_relaxed);
+            m_arrRings[i].tail.store(0, std::memory_order_relaxed);
+            m_arrRings[i].dropped.store(0, std::memory_order_relaxed);
+            m_arrRings[i].repeat.store(0, std::memory_order_relaxed);
+            m_arrRings[i].state.store(LOG_RING_FREE, std::memory_order_relaxed);
+            m_arrRings[i].repeat_seq = 0;
+            m_arrRings[i].repeat_since = 0;
+        }
+    }
+
+    m_bRunning = true;
+    m_tFlushThread = std::thread(&LogCtl::FlushThread, this);
+
+    av_log_set_callback(&LogCtl::AvLogCallback);
+    qInstallMessageHandler(&LogCtl::QtMessageHandler);
+
+    m_bInited = true;
+
+    return true;
+}
+
+void LogCtl::UnInit()
+{
+    if (m_bInited == false)
+    {
+        return;
+    }
+
+    av_log_set_callback(av_log_default_callback);
+    qInstallMessageHandler(nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexWake);
+        m_bRunning = false;
+    }
+    m_condWake.notify_one();
+    if (m_tFlushThread.joinable())
+    {
+        m_tFlushThread.join();
+    }
+
+    m_bInited = false;
+}
+
+void LogCtl::AvLogCallback(void *ptr, int level, const char *fmt, va_list vl)
+{
+    char line[LOG_LINE_SIZE];
+    LogRing *ring;
+
+    level &= 0xff;
+    if (level > av_log_get_level())
+        return;
+
+    ring = m_pInstance->CurrentRing();
+    av_log_format_line2(ptr, level, fmt, vl, line, sizeof(line), ring ? &ring->print_prefix : &t_print_prefix);
+
+    m_pInstance->Write(level, line);
+}
+
+void LogCtl::QtMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    Q_UNUSED(context);
+    int level;
+
+    switch (type)
+    {
+    case QtDebugMsg:
+        level = AV_LOG_DEBUG;
+        break;
+    case QtInfoMsg:
+        level = AV_LOG_INFO;
+        break;
+    case QtWarningMsg:
+        level = AV_LOG_WARNING;
+        break;
+    case QtCriticalMsg:
+        level = AV_LOG_ERROR;
+        break;
+    case QtFatalMsg:
+    default:
+        //程序即将终止，直接同步输出
+        fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+        fflush(stderr);
+        return;
+    }
+
+    QByteArray baMsg = msg.toLocal8Bit();
+    baMsg.append('\n');
+    m_pInstance->Write(level, baMsg.constData());
+}
+
+LogRing *LogCtl::CurrentRing()
+{
+    if (t_ring_holder.ring)
+    {
+        return t_ring_holder.ring;
+    }
+    if (t_ring_exited || !m_arrRings)
+    {
+        return nullptr;
+    }
+
+    //每个线程只在第一次写日志时领取一次，刷新线程写完已退出线程的日志后才会置为空闲
+    for (int i = 0; i < LOG_MAX_THREADS; i++)
+    {
+        LogRing *ring = &m_arrRings[i];
+        int state = LOG_RING_FREE;
+        if (ring->state.load(std::memory_order_relaxed) != LOG_RING_FREE ||
+            !ring->state.compare_exchange_strong(state, LOG_RING_IN_USE, std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        //以下字段只有所属线程访问，领取时重置
+        ring->print_prefix = 1;
+        ring->last_level = -1;
+        ring->repeat.store(make_repeat(ring->head.load(std::memory_order_relaxed), 0), std::memory_order_release);
+        ring->window_start = 0;
+        ring->window_count = 0;
+        t_ring_holder.ring = ring;
+        return ring;
+    }
+
+    return nullptr;
+}
+
+void LogCtl::Write(int level, const char *text)
+{
+    LogRing *ring = CurrentRing();
+    uint64_t repeat;
+    int64_t now;
+    int len;
+
+    if (!ring)
+    {
+        m_nNoRing.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    len = strnlen(text, LOG_LINE_SIZE - 1);
+    if (len == 0)
+    {
+        return;
+    }
+
+    //与上一条完全相同则只计数
+    if (ring->last_level == level && !strncmp(ring->last_text, text, LOG_LINE_SIZE))
+    {
+        ring->repeat.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    //刷新线程可能已经输出了一部分
+    repeat = ring->repeat.exchange(0, std::memory_order_acq_rel);
+    if (repeat_count(repeat) > 0)
+    {
+        PushRepeat(ring, repeat_count(repeat));
+    }
+    memcpy(ring->last_text, text, len);
+    ring->last_text[len] = 0;
+    ring->last_level = level;
+
+    //频率限制，超出部分只记录丢弃数
+    now = av_gettime_relative();
+    if (now - ring->window_start > 1000000)
+    {
+        ring->window_start = now;
+        ring->window_count = 0;
+    }
+    if (++ring->window_count > LOG_RATE_LIMIT_PER_SEC)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        //丢弃的日志不合并，之后相同的日志同样按频率限制计数
+        ring->last_level = -1;
+        return;
+    }
+
+    Push(ring, level, text, len);
+    //这条写出之后，刷新线程才能输出它的重复条数
+    ring->repeat.store(make_repeat(ring->head.load(std::memory_order_relaxed), 0), std::memory_order_release);
+}
+
+void LogCtl::Push(LogRing *ring, int level, const char *text, int len)
+{
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    LogEntry *entry;
+
+    if (head - tail >= LOG_RING_SIZE)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    entry = &ring->entries[head % LOG_RING_SIZE];
+    entry->level = level;
+    entry->len = len;
+    memcpy(entry->text, text, len);
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void LogCtl::PushRepeat(LogRing *ring, uint32_t count)
+{
+    char line[64];
+    int len = snprintf(line, sizeof(line), "    Last message repeated %u times\n", count);
+
+    Push(ring, ring->last_level, line, FFMIN(len, (int)sizeof(line) - 1));
+}
+
+bool LogCtl::FlushRepeat(LogRing *ring, uint32_t tail, bool bFinal)
+{
+    uint64_t repeat = ring->repeat.load(std::memory_order_acquire);
+    int64_t now = av_gettime_relative();
+
+    //没有重复，或者上一条还没写出（合并提示要在它之后）
+    if (repeat_count(repeat) == 0 || repeat_seq(repeat) != tail)
+    {
+        ring->repeat_since = 0;
+        return false;
+    }
+    if (ring->repeat_since == 0 || ring->repeat_seq != tail)
+    {
+        ring->repeat_seq = tail;
+        ring->repeat_since = now;
+    }
+    if (!bFinal && now - ring->repeat_since < LOG_REPEAT_FLUSH_MS * 1000LL)
+    {
+        return false;
+    }
+
+    //所属线程同时累加则带上新的条数重试，写了新日志则留给所属线程输出
+    while (!ring->repeat.compare_exchange_weak(repeat, make_repeat(tail, 0), std::memory_order_acq_rel))
+    {
+        if (repeat_count(repeat) == 0 || repeat_seq(repeat) != tail)
+        {
+            return false;
+        }
+    }
+    ring->repeat_since = 0;
+    fprintf(stderr, "    Last message repeated %u times\n", repeat_count(repeat));
+    return true;
+}
+
+void LogCtl::Flush(bool bFinal)
+{
+    bool bWritten = false;
+    uint32_t dropped;
+
+    if (!m_arrRings)
+    {
+        return;
+    }
+
+    //缓冲区固定，写入线程不加锁，这里写 stderr 时不会阻塞任何写日志的线程
+    for (int i = 0; i < LOG_MAX_THREADS; i++)
+    {
+        LogRing *ring = &m_arrRings[i];
+        int state = ring->state.load(std::memory_order_acquire);
+        if (state == LOG_RING_FREE)
+        {
+            continue;
+        }
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++)
+        {
+            LogEntry *entry = &ring->entries[tail % LOG_RING_SIZE];
+            fwrite(entry->text, 1, entry->len, stderr);
+            bWritten = true;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        //线程已退出，不会再有新日志
+        if (FlushRepeat(ring, tail, bFinal || state == LOG_RING_RETIRED))
+        {
+            bWritten = true;
+        }
+
+        dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped)
+        {
+            fprintf(stderr, "[log] %u messages dropped\n", dropped);
+            bWritten = true;
+        }
+
+        //退出前的日志已在 state 之前写入，上面已全部写出
+        if (state == LOG_RING_RETIRED)
+        {
+            ring->state.store(LOG_RING_FREE, std::memory_order_release);
+        }
+    }
+
+    dropped = m_nNoRing.exchange(0, std::memory_order_relaxed);
+    if (dropped)
+    {
+        fprintf(stderr, "[log] %u messages dropped, more than %d threads logging\n", dropped, LOG_MAX_THREADS);
+        bWritten = true;
+    }
+
+    if (bWritten)
+    {
+        fflush(stderr);
+    }
+}
+
+void LogCtl::FlushThread()
+{
+    while (m_bRunning)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutexWake);
+            m_condWake.wait_for(lock, std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MS), [this] { return !m_bRunning; });
+        }
+        Flush(false);
+    }
+
+    //UnInit 时写出所有未输出的重复条数
+    Flush(true);
+}
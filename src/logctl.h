@@ -0,0 +1,130 @@
+﻿/*
+ * @file 	logctl.h
+ * @date 	2026/10/18 10:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	异步日志
+ * @note	接管 av_log 与 qDebug 输出。各线程把日志格式化到自己的无锁环形缓冲区，
+ *			由后台线程统一写到 stderr，音频回调等实时线程不会因为写日志而阻塞。
+ *			缓冲区在 Init 时分配，线程第一次写日志时用原子操作领取一个，不加锁、不分配内存。
+ */
+#ifndef LOGCTL_H
+#define LOGCTL_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include <QtGlobal>
+#include <QString>
+
+#include "globalhelper.h"
+
+#define LOG_RING_SIZE 256           //每个线程缓冲的日志条数
+#define LOG_LINE_SIZE 512           //单条日志最大长度
+#define LOG_FLUSH_INTERVAL_MS 20    //后台线程刷新间隔
+#define LOG_RATE_LIMIT_PER_SEC 200  //单个线程每秒最多记录的日志条数
+#define LOG_MAX_THREADS 64          //预先分配的缓冲区个数，超出的线程日志丢弃并计数
+#define LOG_REPEAT_FLUSH_MS 1000    //重复日志之后没有新日志，超过这个时间由刷新线程输出合并提示
+
+//缓冲区状态
+enum LogRingState {
+    LOG_RING_FREE,      //未使用
+    LOG_RING_IN_USE,    //所属线程在写
+    LOG_RING_RETIRED    //所属线程已退出，刷新线程写完后置为未使用
+};
+
+//单条日志
+typedef struct LogEntry {
+    int level;
+    int len;
+    char text[LOG_LINE_SIZE];
+} LogEntry;
+
+//单线程日志环形缓冲区，写入方为所属线程，读取方为刷新线程
+typedef struct LogRing {
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> head;   //写入位置，所属线程更新
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> tail;   //读取位置，刷新线程更新
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> dropped; //缓冲区满或超出频率限制而丢弃的条数
+    std::atomic<int> state;                                //LogRingState
+    //未输出的重复条数（低 32 位）和上一条日志写入后的 head（高 32 位）；
+    //所属线程累加，刷新线程在上一条已写出且一段时间没有新日志时取走并输出合并提示
+    std::atomic<uint64_t> repeat;
+
+    /* 以下仅所属线程访问 */
+    int print_prefix;           //av_log_format_line2 的行首标志
+    char last_text[LOG_LINE_SIZE];
+    int last_level;
+    int64_t window_start;       //频率限制的统计窗口
+    int window_count;
+
+    /* 以下仅刷新线程访问 */
+    uint32_t repeat_seq;        //正在计时的重复日志对应的 head
+    int64_t repeat_since;       //开始计时的时间，0 表示没有等待输出的重复条数
+
+    LogEntry entries[LOG_RING_SIZE];
+} LogRing;
+
+class LogCtl
+{
+public:
+    static LogCtl* GetInstance();
+    ~LogCtl();
+
+    /**
+     * @brief	安装 av_log / Qt 日志处理函数并启动刷新线程
+     *
+     * @return	true 成功 false 失败
+     */
+    bool Init();
+
+    /**
+     * @brief	写出剩余日志，恢复默认处理函数并停止刷新线程
+     */
+    void UnInit();
+
+    /**
+     * @brief	记录一条已格式化的日志，只写当前线程的缓冲区，不加锁、不阻塞
+     *
+     * @param	level 日志级别（AV_LOG_*）
+     * @param	text 日志内容
+     */
+    void Write(int level, const char *text);
+
+private:
+    LogCtl();
+
+    static void AvLogCallback(void *ptr, int level, const char *fmt, va_list vl);
+    static void QtMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+
+    //获取当前线程的缓冲区，首次调用时领取，没有空闲缓冲区或线程正在退出时返回 nullptr
+    LogRing* CurrentRing();
+    //写入环形缓冲区，满则丢弃
+    void Push(LogRing *ring, int level, const char *text, int len);
+    //输出重复日志的合并提示
+    void PushRepeat(LogRing *ring, uint32_t count);
+    //写出所有缓冲区中的日志，回收已退出线程的缓冲区，只在刷新线程调用；
+    //bFinal 为 true 时不等超时，写出所有未输出的重复条数
+    void Flush(bool bFinal);
+    //输出上一条已写出、超时未输出的重复条数，返回是否有输出
+    bool FlushRepeat(LogRing *ring, uint32_t tail, bool bFinal);
+    void FlushThread();
+
+private:
+    static LogCtl* m_pInstance; //< 单例指针
+
+    bool m_bInited;
+    std::atomic<bool> m_bRunning;
+
+    LogRing *m_arrRings;                //LOG_MAX_THREADS 个，Init 时分配；线程退出时仍会访问，不释放
+    std::atomic<uint32_t> m_nNoRing;    //没有领到缓冲区的线程丢弃的条数
+
+    std::mutex m_mutexWake;
+    std::condition_variable m_condWake;
+    std::thread m_tFlushThread;
+};
+
+#endif // LOGCTL_H
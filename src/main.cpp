@@ -1,12 +1,437 @@
 ﻿#include "mainwid.h"
+#include "logctl.h"
+#include "videoctl.h"
+#include "resampler.h"
+#include "renderbench.h"
+#include "framepool.h"
+#include "layoutbench.h"
+#include "clocksync.h"
+#include "mediavalidate.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QThread>
 #include <QFontDatabase>
 #include <QDebug>
+#include <ctime>
 //#undef main
 
+//无界面 seek 压力测试：playerdemo --seek-stress [--seeks N] [--seed S] 文件...
+static int SeekStressMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList listFiles;
+    int nSeeks = 1000;
+    unsigned int nSeed = (unsigned int)time(nullptr);
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--seeks" && i + 1 < argc)
+        {
+            nSeeks = atoi(argv[++i]);
+        }
+        else if (strArg == "--seed" && i + 1 < argc)
+        {
+            nSeed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            listFiles << strArg;
+        }
+    }
+    if (listFiles.isEmpty() || nSeeks <= 0)
+    {
+        fprintf(stderr, "usage: %s --seek-stress [--seeks N] [--seed S] file...\n", argv[0]);
+        return 2;
+    }
+
+    return VideoCtl::RunSeekStress(listFiles, nSeeks, nSeed);
+}
+
+//无界面长时间运行测试：playerdemo --soak [--hours H] [--interval 秒] [--seed S] 文件...
+static int SoakMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList listFiles;
+    double dHours = 4.0;
+    int nIntervalSec = 60;
+    unsigned int nSeed = (unsigned int)time(nullptr);
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--hours" && i + 1 < argc)
+        {
+            dHours = atof(argv[++i]);
+        }
+        else if (strArg == "--interval" && i + 1 < argc)
+        {
+            nIntervalSec = atoi(argv[++i]);
+        }
+        else if (strArg == "--seed" && i + 1 < argc)
+        {
+            nSeed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            listFiles << strArg;
+        }
+    }
+    if (listFiles.isEmpty() || dHours <= 0 || nIntervalSec <= 0)
+    {
+        fprintf(stderr, "usage: %s --soak [--hours H] [--interval SEC] [--seed S] file...\n", argv[0]);
+        return 2;
+    }
+
+    return VideoCtl::RunSoak(listFiles, dHours, nIntervalSec, nSeed);
+}
+
+//解码器复用基准测试：playerdemo --decoder-pool-bench [--rounds N] 文件...
+static int DecoderPoolBenchMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList listFiles;
+    int nRounds = 5;
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--rounds" && i + 1 < argc)
+        {
+            nRounds = atoi(argv[++i]);
+        }
+        else
+        {
+            listFiles << strArg;
+        }
+    }
+    //第一轮只预热，至少两轮才有结果
+    if (listFiles.isEmpty() || nRounds < 2)
+    {
+        fprintf(stderr, "usage: %s --decoder-pool-bench [--rounds N] file...\n", argv[0]);
+        return 2;
+    }
+
+    return VideoCtl::RunDecoderPoolBench(listFiles, nRounds);
+}
+
+//重采样基准测试：playerdemo --resample-bench [--seconds N] [--float]
+static int ResampleBenchMain(int argc, char *argv[])
+{
+    double dSeconds = 10.0;
+    bool bFloat = false;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            dSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--float") == 0)
+        {
+            bFloat = true;
+        }
+        else
+        {
+            dSeconds = 0;
+            break;
+        }
+    }
+    if (dSeconds <= RESAMPLE_BENCH_SKIP_SECONDS)
+    {
+        fprintf(stderr, "usage: %s --resample-bench [--seconds N] [--float]\n", argv[0]);
+        return 2;
+    }
+
+    return Resampler::RunBench(dSeconds, bFloat, stdout);
+}
+
+//画面输出基准测试：playerdemo --render-bench [--frames N] [--width W --height H]
+static int RenderBenchMain(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    int nFrames = 600;
+    int nWidth = 1920;
+    int nHeight = 1080;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            nFrames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+        {
+            nWidth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+        {
+            nHeight = atoi(argv[++i]);
+        }
+        else
+        {
+            nFrames = 0;
+            break;
+        }
+    }
+    if (nFrames <= 0 || nWidth <= 0 || nHeight <= 0 || (nWidth & 1) || (nHeight & 1))
+    {
+        fprintf(stderr, "usage: %s --render-bench [--frames N] [--width W --height H]\n", argv[0]);
+        return 2;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO))
+    {
+        fprintf(stderr, "Could not initialize SDL - %s\n", SDL_GetError());
+        return 1;
+    }
+    int nRet = RenderBench::Run(nFrames, nWidth, nHeight, stdout);
+    SDL_Quit();
+    return nRet;
+}
+
+//帧缓冲池基准测试：playerdemo --framepool-bench [--frames N] [--width W --height H]
+static int FramePoolBenchMain(int argc, char *argv[])
+{
+    int nFrames = 300;
+    int nWidth = 3840;
+    int nHeight = 2160;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            nFrames = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+        {
+            nWidth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+        {
+            nHeight = atoi(argv[++i]);
+        }
+        else
+        {
+            nFrames = 0;
+            break;
+        }
+    }
+    if (nFrames <= 0 || nWidth < 16 || nHeight < 16)
+    {
+        fprintf(stderr, "usage: %s --framepool-bench [--frames N] [--width W --height H]\n", argv[0]);
+        return 2;
+    }
+
+    return FramePool::RunBench(nFrames, nWidth, nHeight, stdout);
+}
+
+//VideoState 布局基准测试：playerdemo --layout-bench [--iterations N]
+static int LayoutBenchMain(int argc, char *argv[])
+{
+    int nIterations = 50000000;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            nIterations = atoi(argv[++i]);
+        }
+        else
+        {
+            nIterations = 0;
+            break;
+        }
+    }
+    if (nIterations <= 0)
+    {
+        fprintf(stderr, "usage: %s --layout-bench [--iterations N]\n", argv[0]);
+        return 2;
+    }
+
+    return LayoutBench::Run(nIterations, stdout);
+}
+
+//无界面同步播放：playerdemo --sync-play (--master | --follow HOST) [--port P] [--seconds N] 文件
+static int SyncPlayMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QString strFile, strHost;
+    bool bMaster = false;
+    int nPort = SYNC_DEFAULT_PORT;
+    double dSeconds = 30.0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--master")
+        {
+            bMaster = true;
+        }
+        else if (strArg == "--follow" && i + 1 < argc)
+        {
+            strHost = QString::fromLocal8Bit(argv[++i]);
+        }
+        else if (strArg == "--port" && i + 1 < argc)
+        {
+            nPort = atoi(argv[++i]);
+        }
+        else if (strArg == "--seconds" && i + 1 < argc)
+        {
+            dSeconds = atof(argv[++i]);
+        }
+        else
+        {
+            strFile = strArg;
+        }
+    }
+    if (strFile.isEmpty() || bMaster == !strHost.isEmpty() || nPort <= 0 || nPort > 65535 || dSeconds <= 0)
+    {
+        fprintf(stderr, "usage: %s --sync-play (--master | --follow HOST) [--port P] [--seconds N] file\n", argv[0]);
+        return 2;
+    }
+
+    if (!(bMaster ? ClockSync::GetInstance()->StartMaster(nPort) : ClockSync::GetInstance()->StartFollower(strHost, nPort)))
+    {
+        return 1;
+    }
+    int nRet = VideoCtl::RunSyncPlay(strFile, dSeconds);
+    ClockSync::GetInstance()->Stop();
+    return nRet;
+}
+
+//同步播放测试，在本机启动一个主机和若干从机进程：playerdemo --sync-test [--followers N] [--seconds N] [--port P] 文件
+static int SyncTestMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QString strFile;
+    int nFollowers = 3;
+    int nPort = SYNC_DEFAULT_PORT;
+    double dSeconds = 30.0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--followers" && i + 1 < argc)
+        {
+            nFollowers = atoi(argv[++i]);
+        }
+        else if (strArg == "--seconds" && i + 1 < argc)
+        {
+            dSeconds = atof(argv[++i]);
+        }
+        else if (strArg == "--port" && i + 1 < argc)
+        {
+            nPort = atoi(argv[++i]);
+        }
+        else
+        {
+            strFile = strArg;
+        }
+    }
+    //偏差在 seek 追上后才统计
+    if (strFile.isEmpty() || nFollowers <= 0 || nPort <= 0 || nPort > 65535 || dSeconds <= SYNC_SEEK_HOLDOFF * 2)
+    {
+        fprintf(stderr, "usage: %s --sync-test [--followers N] [--seconds N] [--port P] file\n", argv[0]);
+        return 2;
+    }
+
+    return ClockSync::RunTest(QCoreApplication::applicationFilePath(), strFile, nFollowers, dSeconds, nPort, stdout);
+}
+
+//批量校验：playerdemo --validate [--jobs N] [--verbose] 文件、目录或播放列表...
+static int ValidateMain(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList listInputs;
+    int nJobs = QThread::idealThreadCount();
+    bool bVerbose = false;
+
+    for (int i = 2; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--jobs" && i + 1 < argc)
+        {
+            nJobs = atoi(argv[++i]);
+        }
+        else if (strArg == "--verbose")
+        {
+            bVerbose = true;
+        }
+        else
+        {
+            listInputs << strArg;
+        }
+    }
+    if (listInputs.isEmpty() || nJobs <= 0)
+    {
+        fprintf(stderr, "usage: %s --validate [--jobs N] [--verbose] file|dir|playlist...\n", argv[0]);
+        return 2;
+    }
+
+    //结果在标准输出，解码器的日志默认不输出
+    if (!bVerbose)
+    {
+        av_log_set_level(AV_LOG_FATAL);
+    }
+    return MediaValidate::Run(listInputs, nJobs, stdout);
+}
+
 int main(int argc, char *argv[])
 {
 //    qDebug() << "123";
+    //日志改为异步输出，避免解码、音频线程阻塞在 stderr 上
+    LogCtl::GetInstance()->Init();
+
+    if (argc > 1 && (strcmp(argv[1], "--seek-stress") == 0 || strcmp(argv[1], "--soak") == 0))
+    {
+        int nRet = strcmp(argv[1], "--soak") == 0 ? SoakMain(argc, argv) : SeekStressMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--decoder-pool-bench") == 0)
+    {
+        int nRet = DecoderPoolBenchMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--resample-bench") == 0)
+    {
+        int nRet = ResampleBenchMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--render-bench") == 0)
+    {
+        int nRet = RenderBenchMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--framepool-bench") == 0)
+    {
+        int nRet = FramePoolBenchMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--layout-bench") == 0)
+    {
+        int nRet = LayoutBenchMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && strcmp(argv[1], "--validate") == 0)
+    {
+        int nRet = ValidateMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+    if (argc > 1 && (strcmp(argv[1], "--sync-play") == 0 || strcmp(argv[1], "--sync-test") == 0))
+    {
+        int nRet = strcmp(argv[1], "--sync-test") == 0 ? SyncTestMain(argc, argv) : SyncPlayMain(argc, argv);
+        LogCtl::GetInstance()->UnInit();
+        return nRet;
+    }
+
     QApplication a(argc, argv);
     
     //使用第三方字库，用来作为UI图片 ://res/fa-solid-900.ttf
@@ -20,5 +445,47 @@ int main(int argc, char *argv[])
     }
     w.show();
 
-    return a.exec();
+    //拼接屏同步播放：playerdemo [--sync-master | --sync-follow HOST] [--sync-port P] [文件]
+    QString strSyncHost, strFile;
+    bool bSyncMaster = false;
+    int nSyncPort = SYNC_DEFAULT_PORT;
+    for (int i = 1; i < argc; i++)
+    {
+        QString strArg = QString::fromLocal8Bit(argv[i]);
+        if (strArg == "--sync-master")
+        {
+            bSyncMaster = true;
+        }
+        else if (strArg == "--sync-follow" && i + 1 < argc)
+        {
+            strSyncHost = QString::fromLocal8Bit(argv[++i]);
+        }
+        else if (strArg == "--sync-port" && i + 1 < argc)
+        {
+            nSyncPort = atoi(argv[++i]);
+        }
+        else if (!strArg.startsWith("-"))
+        {
+            strFile = strArg;
+        }
+    }
+    if (bSyncMaster)
+    {
+        ClockSync::GetInstance()->StartMaster(nSyncPort);
+    }
+    else if (!strSyncHost.isEmpty())
+    {
+        ClockSync::GetInstance()->StartFollower(strSyncHost, nSyncPort);
+    }
+    if (!strFile.isEmpty())
+    {
+        emit w.SigOpenFile(strFile);
+    }
+
+    int nRet = a.exec();
+    ClockSync::GetInstance()->Stop();
+
+    LogCtl::GetInstance()->UnInit();
+
+    return nRet;
 }
@@ -19,6 +19,9 @@
 #include <QScreen>
 #include <QRect>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QDateTime>
 #include <QJsonDocument>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -31,8 +34,6 @@
 #include "globalhelper.h"
 #include "videoctl.h"
 
-const int FULLSCREEN_MOUSE_DETECT_TIME = 500;
-
 MainWid::MainWid(QMainWindow *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWid),
@@ -79,9 +80,7 @@ MainWid::MainWid(QMainWindow *parent) :
     m_bPlaying = false;
 
     m_bFullScreenPlay = false;
-
-    m_stCtrlBarAnimationTimer.setInterval(2000);
-    m_stFullscreenMouseDetectTimer.setInterval(FULLSCREEN_MOUSE_DETECT_TIME);
+    m_bMaximizedBeforeFullScreen = false;
 
     
 }
@@ -116,10 +115,6 @@ bool MainWid::Init()
         return false;
     }
 
-
-    m_stCtrlbarAnimationShow = new QPropertyAnimation(ui->CtrlBarWid, "geometry");
-    m_stCtrlbarAnimationHide = new QPropertyAnimation(ui->CtrlBarWid, "geometry");
-
     if (m_stAboutWidget.Init() == false)
     {
         return false;
@@ -188,14 +183,19 @@ bool MainWid::ConnectSignalSlots()
     connect(ui->ShowWid, &Show::SigFullScreen, this, &MainWid::OnFullScreenPlay);
     connect(ui->ShowWid, &Show::SigPlayOrPause, VideoCtl::GetInstance(), &VideoCtl::OnPause);
     connect(ui->ShowWid, &Show::SigStop, VideoCtl::GetInstance(), &VideoCtl::OnStop);
+    connect(ui->ShowWid, &Show::SigPlaySeek, VideoCtl::GetInstance(), &VideoCtl::OnPlaySeek);
     connect(ui->ShowWid, &Show::SigShowMenu, this, &MainWid::OnShowMenu);
     connect(ui->ShowWid, &Show::SigSeekForward, VideoCtl::GetInstance(), &VideoCtl::OnSeekForward);
     connect(ui->ShowWid, &Show::SigSeekBack, VideoCtl::GetInstance(), &VideoCtl::OnSeekBack);
     connect(ui->ShowWid, &Show::SigAddVolume, VideoCtl::GetInstance(), &VideoCtl::OnAddVolume);
     connect(ui->ShowWid, &Show::SigSubVolume, VideoCtl::GetInstance(), &VideoCtl::OnSubVolume);
+    connect(ui->ShowWid, &Show::SigZoom, VideoCtl::GetInstance(), &VideoCtl::OnZoom);
+    connect(ui->ShowWid, &Show::SigPan, VideoCtl::GetInstance(), &VideoCtl::OnPan);
+    connect(ui->ShowWid, &Show::SigZoomReset, VideoCtl::GetInstance(), &VideoCtl::OnZoomReset);
 
     connect(ui->CtrlBarWid, &CtrlBar::SigShowOrHidePlaylist, this, &MainWid::OnShowOrHidePlaylist);
     connect(ui->CtrlBarWid, &CtrlBar::SigPlaySeek, VideoCtl::GetInstance(), &VideoCtl::OnPlaySeek);
+    connect(ui->CtrlBarWid, &CtrlBar::SigScrubbing, VideoCtl::GetInstance(), &VideoCtl::OnScrubbing);
     connect(ui->CtrlBarWid, &CtrlBar::SigPlayVolume, VideoCtl::GetInstance(), &VideoCtl::OnPlayVolume);
     connect(ui->CtrlBarWid, &CtrlBar::SigPlayOrPause, VideoCtl::GetInstance(), &VideoCtl::OnPause);
     connect(ui->CtrlBarWid, &CtrlBar::SigStop, VideoCtl::GetInstance(), &VideoCtl::OnStop);
@@ -222,12 +222,10 @@ bool MainWid::ConnectSignalSlots()
     connect(VideoCtl::GetInstance(), &VideoCtl::SigStopFinished, &m_stTitle, &Title::OnStopFinished, Qt::DirectConnection);
     connect(VideoCtl::GetInstance(), &VideoCtl::SigStartPlay, &m_stTitle, &Title::OnPlay, Qt::DirectConnection);
 
-    connect(&m_stCtrlBarAnimationTimer, &QTimer::timeout, this, &MainWid::OnCtrlBarAnimationTimeOut);
-
-    connect(&m_stFullscreenMouseDetectTimer, &QTimer::timeout, this, &MainWid::OnFullscreenMouseDetectTimeOut);
-
 
     connect(&m_stActFullscreen, &QAction::triggered, this, &MainWid::OnFullScreenPlay);
+
+    connect(&m_stMirrorWid, &MirrorWid::SigClosed, this, &MainWid::OnMirrorWidClosed);
     
 
 
@@ -314,142 +312,213 @@ void MainWid::OnFullScreenPlay()
     {
         m_bFullScreenPlay = true;
         m_stActFullscreen.setChecked(true);
-        //脱离父窗口后才能设置
-        ui->ShowWid->setWindowFlags(Qt::Window);
-        //多屏情况下，在当前屏幕全屏
-        QScreen *pStCurScreen = screen();
-        ui->ShowWid->windowHandle()->setScreen(pStCurScreen);
-        
-        ui->ShowWid->showFullScreen();
-
-
-        QRect stScreenRect = pStCurScreen->geometry();
-        int nCtrlBarHeight = ui->CtrlBarWid->height();
-        int nX = ui->ShowWid->x();
-        m_stCtrlBarAnimationShow = QRect(nX, stScreenRect.height() - nCtrlBarHeight, stScreenRect.width(), nCtrlBarHeight);
-        m_stCtrlBarAnimationHide = QRect(nX, stScreenRect.height(), stScreenRect.width(), nCtrlBarHeight);
-
-        m_stCtrlbarAnimationShow->setStartValue(m_stCtrlBarAnimationHide);
-        m_stCtrlbarAnimationShow->setEndValue(m_stCtrlBarAnimationShow);
-        m_stCtrlbarAnimationShow->setDuration(1000);
-
-        m_stCtrlbarAnimationHide->setStartValue(m_stCtrlBarAnimationShow);
-        m_stCtrlbarAnimationHide->setEndValue(m_stCtrlBarAnimationHide);
-        m_stCtrlbarAnimationHide->setDuration(1000);
-        
-        ui->CtrlBarWid->setWindowFlags(Qt::FramelessWindowHint | Qt::Window);
-        ui->CtrlBarWid->windowHandle()->setScreen(pStCurScreen);
-        ui->CtrlBarWid->raise();
-        ui->CtrlBarWid->setWindowOpacity(0.5);
-        ui->CtrlBarWid->showNormal();
-        ui->CtrlBarWid->windowHandle()->setScreen(pStCurScreen);
-        
-        m_stCtrlbarAnimationShow->start();
-        m_bFullscreenCtrlBarShow = true;
-        m_stFullscreenMouseDetectTimer.start();
+        VideoCtl::GetInstance()->MarkOutputTransition("fullscreen");
+
+        //显示控件不脱离父窗口（改变窗口标志会重建原生窗口，SDL 接管的窗口随之失效），
+        //主窗口全屏并隐藏其他面板，播放画面所在的原生子窗口只改变大小。
+        //控制面板也隐藏，由显示控件画在画面上的全屏控制条代替
+        m_bMaximizedBeforeFullScreen = isMaximized();
+        setUpdatesEnabled(false);
+        m_listHiddenForFullScreen.clear();
+        for (QWidget *pPanel : { (QWidget *)ui->TitleWid, (QWidget *)ui->PlaylistWid, (QWidget *)ui->CtrlBarWid, (QWidget *)ui->menubar, (QWidget *)ui->statusbar })
+        {
+            if (pPanel->isVisible())
+            {
+                m_listHiddenForFullScreen.append(pPanel);
+                pPanel->hide();
+            }
+        }
+        showFullScreen();
+        setUpdatesEnabled(true);
 
+        ui->ShowWid->SetFullScreen(true);
         this->setFocus();
     }
     else
     {
         m_bFullScreenPlay = false;
         m_stActFullscreen.setChecked(false);
+        VideoCtl::GetInstance()->MarkOutputTransition("windowed");
 
-        m_stCtrlbarAnimationShow->stop(); //快速切换时，动画还没结束导致控制面板消失
-        m_stCtrlbarAnimationHide->stop();
-        ui->CtrlBarWid->setWindowOpacity(1);
-        ui->CtrlBarWid->setWindowFlags(Qt::SubWindow);
-        
-        ui->ShowWid->setWindowFlags(Qt::SubWindow);
+        ui->ShowWid->SetFullScreen(false);
 
-        ui->CtrlBarWid->showNormal();
-        ui->ShowWid->showNormal();
+        setUpdatesEnabled(false);
+        for (QWidget *pPanel : m_listHiddenForFullScreen)
+        {
+            pPanel->show();
+        }
+        m_listHiddenForFullScreen.clear();
+        if (m_bMaximizedBeforeFullScreen)
+        {
+            showMaximized();
+        }
+        else
+        {
+            showNormal();
+        }
+        setUpdatesEnabled(true);
 
-        m_stFullscreenMouseDetectTimer.stop();
         this->setFocus();
     }
 }
 
-void MainWid::OnCtrlBarAnimationTimeOut()
+void MainWid::OnShowMenu()
+{
+    m_stMenu.exec(cursor().pos());
+}
+
+void MainWid::OnShowAbout()
 {
-    QApplication::setOverrideCursor(Qt::BlankCursor);
+    m_stAboutWidget.move(cursor().pos().x() - m_stAboutWidget.width()/2, cursor().pos().y() - m_stAboutWidget.height()/2);
+    m_stAboutWidget.show();
 }
 
-void MainWid::OnFullscreenMouseDetectTimeOut()
+void MainWid::OpenFile()
 {
-//     qDebug() << m_stCtrlBarAnimationShow;
-//     qDebug() << cursor().pos();
-//     qDebug() << ui->CtrlBarWid->geometry();
-    if (m_bFullScreenPlay)
+    QString strFileName = QFileDialog::getOpenFileName(this, "打开文件", QDir::homePath(),
+        "视频文件(*.mkv *.rmvb *.mp4 *.avi *.flv *.wmv *.3gp)");
+
+    emit SigOpenFile(strFileName);
+}
+
+void MainWid::OnLoadAudio()
+{
+    QString strFileName = QFileDialog::getOpenFileName(this, "载入音频", QDir::homePath(),
+        "音频文件(*.mp3 *.aac *.m4a *.ac3 *.eac3 *.dts *.flac *.wav *.ogg *.opus *.mka *.mp4)");
+    if (strFileName.isEmpty())
     {
-        if (m_stCtrlBarAnimationShow.contains(cursor().pos()))
-        {
-            //判断鼠标是否在控制面板上面
-            if (ui->CtrlBarWid->geometry().contains(cursor().pos()))
-            {
-                //继续显示
-                m_bFullscreenCtrlBarShow = true;
-            }
-            else
-            {
-                //需要显示
-                ui->CtrlBarWid->raise();
-                
-                m_stCtrlbarAnimationShow->start();
-                m_stCtrlbarAnimationHide->stop();
-                stCtrlBarHideTimer.stop();
-            }
-        }
-        else  
-        {
-            if (m_bFullscreenCtrlBarShow)
-            {
-                //需要隐藏
-                m_bFullscreenCtrlBarShow = false;
-                stCtrlBarHideTimer.singleShot(2000, this, &MainWid::OnCtrlBarHideTimeOut);
-            }
+        return;
+    }
 
-        }
+    VideoCtl::GetInstance()->LoadAudio(strFileName);
+}
 
+void MainWid::OnSchedulePlay()
+{
+    QString strFileName = QFileDialog::getOpenFileName(this, "定时播放", QDir::homePath(),
+        "视频文件(*.mkv *.rmvb *.mp4 *.avi *.flv *.wmv *.3gp)");
+    if (strFileName.isEmpty())
+    {
+        return;
+    }
+
+    bool bOk = false;
+    QString strTime = QInputDialog::getText(this, "定时播放", "开始时间（时:分:秒.毫秒）：", QLineEdit::Normal,
+        QTime::currentTime().addSecs(60).toString("HH:mm:ss.zzz"), &bOk);
+    if (!bOk)
+    {
+        return;
+    }
+    QTime tmStart = QTime::fromString(strTime.trimmed(), "HH:mm:ss.zzz");
+    if (!tmStart.isValid())
+    {
+        tmStart = QTime::fromString(strTime.trimmed(), "HH:mm:ss");
+    }
+    if (!tmStart.isValid())
+    {
+        QMessageBox::warning(this, "定时播放", "时间格式错误：" + strTime);
+        return;
     }
+
+    //已过的时间按明天处理
+    QDateTime dtStart(QDate::currentDate(), tmStart);
+    if (dtStart <= QDateTime::currentDateTime())
+    {
+        dtStart = dtStart.addDays(1);
+    }
+
+    m_stPlaylist.OnAddFile(strFileName);
+    ui->ShowWid->OnSchedulePlay(strFileName, dtStart);
 }
 
-void MainWid::OnCtrlBarHideTimeOut()
+void MainWid::OnShowIoStats()
 {
-    if (m_bFullScreenPlay)
+    QMessageBox::information(this, "读取统计", IoScheduler::GetInstance()->Summary());
+}
+
+void MainWid::OnShowSettingWid()
+{
+    m_stSettingWid.show();
+}
+
+void MainWid::OnMirrorOutput()
+{
+    if (m_stMirrorWid.isVisible())
     {
-        m_stCtrlbarAnimationHide->start();
+        m_stMirrorWid.close();
+        return;
     }
-    //setCursor(Qt::BlankCursor);
 
+    m_stMirrorWid.ShowOnScreen(windowHandle() ? windowHandle()->screen() : nullptr);
+    if (VideoCtl::GetInstance()->AddMirror(m_stMirrorWid.winId()) == false)
+    {
+        m_stMirrorWid.hide();
+    }
 }
 
-void MainWid::OnShowMenu()
+void MainWid::OnMirrorWidClosed()
 {
-    m_stMenu.exec(cursor().pos());
+    VideoCtl::GetInstance()->RemoveMirror(m_stMirrorWid.winId());
 }
 
-void MainWid::OnShowAbout()
+void MainWid::OnMixAudioTracks()
 {
-    m_stAboutWidget.move(cursor().pos().x() - m_stAboutWidget.width()/2, cursor().pos().y() - m_stAboutWidget.height()/2);
-    m_stAboutWidget.show();
+    VideoCtl::GetInstance()->OnToggleAudioMix();
 }
 
-void MainWid::OpenFile()
+void MainWid::OnResampleFast()
 {
-    QString strFileName = QFileDialog::getOpenFileName(this, "打开文件", QDir::homePath(),
-        "视频文件(*.mkv *.rmvb *.mp4 *.avi *.flv *.wmv *.3gp)");
+    SetResamplePreset(RESAMPLE_PRESET_FAST);
+}
 
-    emit SigOpenFile(strFileName);
+void MainWid::OnResampleBalanced()
+{
+    SetResamplePreset(RESAMPLE_PRESET_BALANCED);
 }
 
-void MainWid::OnShowSettingWid()
+void MainWid::OnResampleHigh()
 {
-    m_stSettingWid.show();
+    SetResamplePreset(RESAMPLE_PRESET_HIGH);
+}
+
+void MainWid::SetResamplePreset(int nPreset)
+{
+    VideoCtl::GetInstance()->SetResamplePreset(nPreset);
+    GlobalHelper::SaveResamplePreset(nPreset);
+}
+
+void MainWid::OnRenderSdl()
+{
+    SetRenderBackend(RENDER_BACKEND_SDL);
+}
+
+void MainWid::OnRenderQt()
+{
+    SetRenderBackend(RENDER_BACKEND_QT);
+}
+
+void MainWid::SetRenderBackend(int nBackend)
+{
+    VideoCtl::GetInstance()->SetRenderBackend(nBackend);
+    GlobalHelper::SaveRenderBackend(nBackend);
 }
 
 void MainWid::InitMenu()
 {
+    //菜单配置中的函数名与槽函数对应
+    map_act_["OpenFile"] = &MainWid::OpenFile;
+    map_act_["OnLoadAudio"] = &MainWid::OnLoadAudio;
+    map_act_["OnSchedulePlay"] = &MainWid::OnSchedulePlay;
+    map_act_["OnShowIoStats"] = &MainWid::OnShowIoStats;
+    map_act_["OnCloseBtnClicked"] = &MainWid::OnCloseBtnClicked;
+    map_act_["OnMirrorOutput"] = &MainWid::OnMirrorOutput;
+    map_act_["OnMixAudioTracks"] = &MainWid::OnMixAudioTracks;
+    map_act_["OnResampleFast"] = &MainWid::OnResampleFast;
+    map_act_["OnResampleBalanced"] = &MainWid::OnResampleBalanced;
+    map_act_["OnResampleHigh"] = &MainWid::OnResampleHigh;
+    map_act_["OnRenderSdl"] = &MainWid::OnRenderSdl;
+    map_act_["OnRenderQt"] = &MainWid::OnRenderQt;
+
     QString menu_json_file_name = ":/res/menu.json";
     QByteArray ba_json;
     QFile json_file(menu_json_file_name);
@@ -496,9 +565,11 @@ void MainWid::MenuJsonParser(QJsonObject& json_obj, QMenu* menu)
                 }
                 QAction* action = menu->addAction(key);
 
-                //TODO: 字符串与函数指针对应，连接信号
                 QString fun_str = value_info[0];
-
+                if (map_act_.contains(fun_str))
+                {
+                    connect(action, &QAction::triggered, this, map_act_[fun_str]);
+                }
 
             }
         }
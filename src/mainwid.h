@@ -16,13 +16,13 @@
 #include <QDragEnterEvent>
 #include <QMenu>
 #include <QAction>
-#include <QPropertyAnimation>
 #include <QTimer>
 #include <QMainWindow>
 
 #include "playlist.h"
 #include "title.h"
 #include "settingwid.h"
+#include "mirrorout.h"
 
 namespace Ui {
 class MainWid;
@@ -81,16 +81,36 @@ private:
     */
     void OnFullScreenPlay();
 
-    void OnCtrlBarAnimationTimeOut();
-    void OnFullscreenMouseDetectTimeOut();
-
-    void OnCtrlBarHideTimeOut();
     void OnShowMenu();
     void OnShowAbout();
     void OpenFile();
+    //载入外部音频
+    void OnLoadAudio();
+    //在指定时间开始播放
+    void OnSchedulePlay();
+    //显示各类读取的统计
+    void OnShowIoStats();
 
     void OnShowSettingWid();
 
+    //打开、关闭镜像输出窗口
+    void OnMirrorOutput();
+    void OnMirrorWidClosed();
+
+    //开启、关闭混入其他音轨
+    void OnMixAudioTracks();
+
+    //重采样预设
+    void OnResampleFast();
+    void OnResampleBalanced();
+    void OnResampleHigh();
+    void SetResamplePreset(int nPreset);
+
+    //画面输出方式，下一个文件开始生效
+    void OnRenderSdl();
+    void OnRenderQt();
+    void SetRenderBackend(int nBackend);
+
 
     //添加菜单
     void InitMenu();
@@ -121,16 +141,8 @@ private:
     const int m_nShadowWidth; ///< 阴影宽度
 
     bool m_bFullScreenPlay; ///< 全屏播放标志
-
-    QPropertyAnimation *m_stCtrlbarAnimationShow; //全屏时控制面板浮动显示
-    QPropertyAnimation *m_stCtrlbarAnimationHide; //全屏时控制面板浮动显示
-    QRect m_stCtrlBarAnimationShow;//控制面板显示区域
-    QRect m_stCtrlBarAnimationHide;//控制面板隐藏区域
-
-    QTimer m_stCtrlBarAnimationTimer;
-    QTimer m_stFullscreenMouseDetectTimer;//全屏时鼠标位置监测时钟
-    bool m_bFullscreenCtrlBarShow;
-    QTimer stCtrlBarHideTimer;
+    bool m_bMaximizedBeforeFullScreen; ///< 进入全屏前是否最大化
+    QList<QWidget*> m_listHiddenForFullScreen; ///< 全屏时隐藏的面板，退出全屏时恢复
 
     Playlist m_stPlaylist;
     Title m_stTitle;
@@ -140,6 +152,7 @@ private:
 
     About m_stAboutWidget;
     SettingWid m_stSettingWid;
+    MirrorWid m_stMirrorWid;
 
     QMenu m_stMenu;
     QAction m_stActFullscreen;
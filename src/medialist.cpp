@@ -9,6 +9,7 @@ MediaList::MediaList(QWidget *parent)
     : QListWidget(parent),
       m_stMenu(this),
       m_stActAdd(this),
+      m_stActImport(this),
       m_stActRemove(this),
       m_stActClearList(this)
 {
@@ -25,6 +26,8 @@ bool MediaList::Init()
 {
     m_stActAdd.setText("添加");
     m_stMenu.addAction(&m_stActAdd);
+    m_stActImport.setText("导入播放列表");
+    m_stMenu.addAction(&m_stActImport);
     m_stActRemove.setText("移除所选项");
     QMenu* stRemoveMenu = m_stMenu.addMenu("移除");
     stRemoveMenu->addAction(&m_stActRemove);
@@ -33,6 +36,7 @@ bool MediaList::Init()
 
 
     connect(&m_stActAdd, &QAction::triggered, this, &MediaList::AddFile);
+    connect(&m_stActImport, &QAction::triggered, this, &MediaList::ImportPlaylist);
     connect(&m_stActRemove, &QAction::triggered, this, &MediaList::RemoveFile);
     connect(&m_stActClearList, &QAction::triggered, this, &QListWidget::clear);
 
@@ -56,6 +60,18 @@ void MediaList::AddFile()
     }
 }
 
+void MediaList::ImportPlaylist()
+{
+    QString strFileName = QFileDialog::getOpenFileName(this, "导入播放列表", QDir::homePath(),
+        "播放列表(*.m3u *.m3u8 *.pls *.xspf)");
+    if (strFileName.isEmpty())
+    {
+        return;
+    }
+
+    emit SigImportPlaylist(strFileName);
+}
+
 void MediaList::RemoveFile()
 {
     takeItem(currentRow());
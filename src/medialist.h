@@ -16,15 +16,18 @@ protected:
     void contextMenuEvent(QContextMenuEvent* event);
 private:
     void AddFile(); //添加文件
+    void ImportPlaylist(); //导入播放列表
     void RemoveFile();
 signals:
     void SigAddFile(QString strFileName);   //添加文件信号
+    void SigImportPlaylist(QString strFileName);   //导入播放列表信号
 
 
 private:
     QMenu m_stMenu;
 
     QAction m_stActAdd;     //添加文件
+    QAction m_stActImport;  //导入播放列表
     QAction m_stActRemove;  //移除文件
     QAction m_stActClearList;//清空列表
 };
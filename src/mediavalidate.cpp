@@ -0,0 +1,459 @@
+﻿/*
+ * @file 	mediavalidate.cpp
+ * @date 	2026/10/19 11:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	批量校验媒体文件
+ * @note
+ */
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include "mediavalidate.h"
+#include "playlistimport.h"
+#include "datactl.h"
+
+#pragma execution_character_set("utf-8")
+
+//一路音视频流的校验状态
+typedef struct ValidateStream {
+    AVStream *st;
+    PacketQueue q;
+    Decoder d;
+    double frame_duration;      //视频一帧的时长（秒），未知为 0
+
+    /* 解封装线程写入 */
+    int64_t packets;
+    int64_t corrupt_packets;
+    int64_t missing_ts;         //没有 dts
+    int64_t non_monotonic_dts;  //dts 不递增
+    int64_t last_dts;
+
+    /* 解码线程写入 */
+    int64_t frames;
+    int64_t corrupt_frames;
+    int64_t missing_pts;
+    int64_t pts_backwards;      //视频 pts 不递增
+    int64_t discontinuities;    //音频 pts 与上一帧结尾不连续
+    int64_t pts_frames;         //有 pts 的帧数
+    double first_pts;
+    double last_pts;
+    double end_pts;             //最后一帧的结尾
+} ValidateStream;
+
+static const char *media_type_name(enum AVMediaType type)
+{
+    const char *name = av_get_media_type_string(type);
+    return name ? name : "unknown";
+}
+
+static QString error_string(int err)
+{
+    char buf[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+    av_strerror(err, buf, sizeof(buf));
+    return QString::fromUtf8(buf);
+}
+
+//解码线程：取出帧后只检查时间戳和错误标记
+static void validate_decode_thread(ValidateStream *vs)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return;
+
+    for (;;) {
+        double pts, end;
+        //返回 0 表示解码器已输出全部帧
+        if (decoder_decode_frame(&vs->d, frame, NULL) <= 0)
+            break;
+
+        vs->frames++;
+        if (frame->decode_error_flags || (frame->flags & AV_FRAME_FLAG_CORRUPT))
+            vs->corrupt_frames++;
+        if (frame->pts == AV_NOPTS_VALUE) {
+            vs->missing_pts++;
+            av_frame_unref(frame);
+            continue;
+        }
+
+        if (vs->d.avctx->codec_type == AVMEDIA_TYPE_AUDIO) {
+            //decoder_decode_frame 已换算到 1/采样率
+            pts = frame->pts / (double)frame->sample_rate;
+            end = pts + frame->nb_samples / (double)frame->sample_rate;
+            if (vs->pts_frames && fabs(pts - vs->end_pts) > VALIDATE_AUDIO_GAP)
+                vs->discontinuities++;
+        }
+        else {
+            pts = frame->pts * av_q2d(vs->st->time_base);
+            end = pts + vs->frame_duration;
+            if (vs->pts_frames && pts <= vs->last_pts)
+                vs->pts_backwards++;
+        }
+        if (!vs->pts_frames)
+            vs->first_pts = pts;
+        vs->last_pts = pts;
+        vs->end_pts = vs->pts_frames ? FFMAX(vs->end_pts, end) : end;
+        vs->pts_frames++;
+        av_frame_unref(frame);
+    }
+    av_frame_free(&frame);
+}
+
+QJsonObject MediaValidate::ValidateFile(const QString &strFile, int nDecoderThreads)
+{
+    QJsonObject objResult;
+    QJsonArray arrStreams;
+    AVFormatContext *ic = NULL;
+    AVPacket *pkt = NULL;
+    SDL_mutex *wait_mutex = NULL;
+    SDL_cond *continue_read = NULL;
+    std::vector<ValidateStream *> vecStreams;
+    std::vector<ValidateStream *> vecByIndex;
+    int64_t start_time = av_gettime_relative();
+    int64_t read_errors = 0, read_errors_in_row = 0;
+    int64_t errors = 0, warnings = 0;
+    int drained = 0;
+    QString strError;
+    int ret;
+
+    objResult["file"] = strFile;
+
+    ret = avformat_open_input(&ic, strFile.toUtf8().constData(), NULL, NULL);
+    if (ret < 0) {
+        strError = "open: " + error_string(ret);
+        goto done;
+    }
+    ret = avformat_find_stream_info(ic, NULL);
+    if (ret < 0) {
+        strError = "find stream info: " + error_string(ret);
+        goto done;
+    }
+    objResult["format"] = ic->iformat->name;
+    if (ic->duration != AV_NOPTS_VALUE)
+        objResult["duration"] = ic->duration / (double)AV_TIME_BASE;
+
+    pkt = av_packet_alloc();
+    wait_mutex = SDL_CreateMutex();
+    continue_read = SDL_CreateCond();
+    if (!pkt || !wait_mutex || !continue_read) {
+        strError = "out of memory";
+        goto done;
+    }
+
+    //打开所有音视频流的解码器，封面图片、字幕、数据流只检查数据包
+    vecByIndex.resize(ic->nb_streams, nullptr);
+    for (unsigned int i = 0; i < ic->nb_streams; i++) {
+        AVStream *st = ic->streams[i];
+        enum AVMediaType type = st->codecpar->codec_type;
+        const AVCodec *codec;
+        AVCodecContext *avctx;
+        ValidateStream *vs;
+
+        if ((type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO) || (st->disposition & AV_DISPOSITION_ATTACHED_PIC))
+            continue;
+
+        codec = avcodec_find_decoder(st->codecpar->codec_id);
+        if (!codec) {
+            strError = QString("stream %1: no decoder for %2").arg(i).arg(avcodec_get_name(st->codecpar->codec_id));
+            goto done;
+        }
+        avctx = avcodec_alloc_context3(codec);
+        if (!avctx) {
+            strError = "out of memory";
+            goto done;
+        }
+        avcodec_parameters_to_context(avctx, st->codecpar);
+        avctx->pkt_timebase = st->time_base;
+        avctx->thread_count = nDecoderThreads;
+        ret = avcodec_open2(avctx, codec, NULL);
+        if (ret < 0) {
+            avcodec_free_context(&avctx);
+            strError = QString("stream %1: could not open decoder: %2").arg(i).arg(error_string(ret));
+            goto done;
+        }
+
+        vs = new ValidateStream();
+        vs->st = st;
+        vs->last_dts = AV_NOPTS_VALUE;
+        if (type == AVMEDIA_TYPE_VIDEO) {
+            AVRational frame_rate = av_guess_frame_rate(ic, st, NULL);
+            vs->frame_duration = frame_rate.num && frame_rate.den ? av_q2d(av_inv_q(frame_rate)) : 0;
+        }
+        if (packet_queue_init(&vs->q) < 0) {
+            avcodec_free_context(&avctx);
+            delete vs;
+            strError = "out of memory";
+            goto done;
+        }
+        if (decoder_init(&vs->d, avctx, &vs->q, continue_read) < 0) {
+            avcodec_free_context(&avctx);
+            packet_queue_destroy(&vs->q);
+            delete vs;
+            strError = "out of memory";
+            goto done;
+        }
+        packet_queue_start(&vs->q);
+        vs->d.decode_thread = std::thread(validate_decode_thread, vs);
+        vecStreams.push_back(vs);
+        vecByIndex[i] = vs;
+    }
+    if (vecStreams.empty()) {
+        strError = "no audio or video stream";
+        goto done;
+    }
+
+    //与读取线程相同：队列满了等解码线程取走
+    for (;;) {
+        int queued = 0;
+        ValidateStream *vs;
+
+        for (ValidateStream *s : vecStreams)
+            queued += s->q.size;
+        if (queued > MAX_QUEUE_SIZE) {
+            SDL_LockMutex(wait_mutex);
+            SDL_CondWaitTimeout(continue_read, wait_mutex, VALIDATE_WAIT_MS);
+            SDL_UnlockMutex(wait_mutex);
+            continue;
+        }
+
+        ret = av_read_frame(ic, pkt);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF || avio_feof(ic->pb))
+                break;
+            read_errors++;
+            if ((ic->pb && ic->pb->error) || ++read_errors_in_row >= VALIDATE_MAX_READ_ERRORS) {
+                strError = "read: " + error_string(ret);
+                break;
+            }
+            continue;
+        }
+        read_errors_in_row = 0;
+
+        vs = vecByIndex[pkt->stream_index];
+        if (!vs) {
+            av_packet_unref(pkt);
+            continue;
+        }
+        vs->packets++;
+        if (pkt->flags & AV_PKT_FLAG_CORRUPT)
+            vs->corrupt_packets++;
+        if (pkt->dts == AV_NOPTS_VALUE) {
+            vs->missing_ts++;
+        }
+        else {
+            if (vs->last_dts != AV_NOPTS_VALUE && pkt->dts <= vs->last_dts)
+                vs->non_monotonic_dts++;
+            vs->last_dts = pkt->dts;
+        }
+        packet_queue_put(&vs->q, pkt);
+    }
+
+    //送入空包让解码器输出剩余的帧
+    for (ValidateStream *vs : vecStreams)
+        packet_queue_put_nullpacket(&vs->q, pkt, vs->st->index);
+    drained = 1;
+
+done:
+    {
+        double decoded_duration = 0;
+        int64_t video_frames = 0;
+        double elapsed;
+
+        for (ValidateStream *vs : vecStreams) {
+            QJsonObject objStream;
+            int64_t stream_errors, stream_warnings;
+
+            //没有读取就失败时解码线程还在等数据包
+            if (!drained)
+                packet_queue_abort(&vs->q);
+            if (vs->d.decode_thread.joinable())
+                vs->d.decode_thread.join();
+
+            stream_errors = vs->d.decode_errors + vs->corrupt_packets + vs->corrupt_frames + (vs->packets && !vs->frames);
+            stream_warnings = vs->missing_ts + vs->non_monotonic_dts + vs->missing_pts + vs->pts_backwards + vs->discontinuities;
+            errors += stream_errors;
+            warnings += stream_warnings;
+
+            objStream["index"] = vs->st->index;
+            objStream["type"] = media_type_name(vs->st->codecpar->codec_type);
+            objStream["codec"] = avcodec_get_name(vs->st->codecpar->codec_id);
+            objStream["packets"] = (qint64)vs->packets;
+            objStream["frames"] = (qint64)vs->frames;
+            objStream["decode_errors"] = (qint64)vs->d.decode_errors;
+            objStream["corrupt_packets"] = (qint64)vs->corrupt_packets;
+            objStream["corrupt_frames"] = (qint64)vs->corrupt_frames;
+            objStream["missing_dts"] = (qint64)vs->missing_ts;
+            objStream["non_monotonic_dts"] = (qint64)vs->non_monotonic_dts;
+            objStream["missing_pts"] = (qint64)vs->missing_pts;
+            objStream["pts_backwards"] = (qint64)vs->pts_backwards;
+            objStream["discontinuities"] = (qint64)vs->discontinuities;
+            if (vs->pts_frames) {
+                objStream["start"] = vs->first_pts;
+                objStream["duration"] = vs->end_pts - vs->first_pts;
+                decoded_duration = FFMAX(decoded_duration, vs->end_pts - vs->first_pts);
+            }
+            if (vs->st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+                video_frames += vs->frames;
+            arrStreams.append(objStream);
+
+            decoder_destroy(&vs->d);
+            packet_queue_destroy(&vs->q);
+            delete vs;
+        }
+
+        elapsed = (av_gettime_relative() - start_time) / 1000000.0;
+        if (!arrStreams.isEmpty()) {
+            objResult["decoded_duration"] = decoded_duration;
+            objResult["streams"] = arrStreams;
+            if (ic->duration != AV_NOPTS_VALUE &&
+                fabs(decoded_duration - ic->duration / (double)AV_TIME_BASE) > VALIDATE_DURATION_TOLERANCE) {
+                objResult["duration_mismatch"] = true;
+                warnings++;
+            }
+        }
+        objResult["read_errors"] = (qint64)read_errors;
+        objResult["decode_seconds"] = elapsed;
+        if (elapsed > 0) {
+            objResult["speed"] = decoded_duration / elapsed;
+            objResult["fps"] = video_frames / elapsed;
+        }
+        if (!strError.isEmpty())
+            objResult["error"] = strError;
+        errors += read_errors;
+        objResult["status"] = !strError.isEmpty() || errors ? "error" : warnings ? "warning" : "ok";
+    }
+
+    av_packet_free(&pkt);
+    if (continue_read)
+        SDL_DestroyCond(continue_read);
+    if (wait_mutex)
+        SDL_DestroyMutex(wait_mutex);
+    avformat_close_input(&ic);
+    return objResult;
+}
+
+bool MediaValidate::IsMediaFile(const QString &strFile)
+{
+    static const QStringList listSuffixes = {
+        "mkv", "mka", "webm", "mp4", "m4v", "m4a", "mov", "avi", "flv", "wmv", "wma", "asf", "rmvb", "rm",
+        "3gp", "ts", "m2ts", "mts", "mpg", "mpeg", "vob", "ogg", "ogv", "opus", "mp3", "aac", "ac3", "eac3",
+        "dts", "flac", "wav", "mxf", "y4m"
+    };
+    return listSuffixes.contains(QFileInfo(strFile).suffix().toLower());
+}
+
+QStringList MediaValidate::CollectFiles(const QStringList &listInputs)
+{
+    QStringList listFiles;
+
+    for (const QString &strInput : listInputs)
+    {
+        QFileInfo fileInfo(strInput);
+        if (fileInfo.isDir())
+        {
+            //按路径排序，结果与文件系统的遍历顺序无关
+            QStringList listDir;
+            QDirIterator it(strInput, QDir::Files, QDirIterator::Subdirectories);
+            while (it.hasNext())
+            {
+                QString strFile = it.next();
+                if (IsMediaFile(strFile))
+                {
+                    listDir << strFile;
+                }
+            }
+            listDir.sort();
+            listFiles << listDir;
+        }
+        else if (fileInfo.isFile() && PlaylistImport::IsPlaylistFile(strInput))
+        {
+            //复用播放列表导入线程，在本线程直接取走每一批
+            PlaylistImport import;
+            QObject::connect(&import, &PlaylistImport::SigBatch, &import, [&](QStringList listBatch, QStringList)
+            {
+                listFiles << listBatch;
+                import.BatchDone();
+            }, Qt::DirectConnection);
+            if (import.Start(strInput, listFiles))
+            {
+                import.wait();
+            }
+            else
+            {
+                fprintf(stderr, "%s: could not read playlist\n", strInput.toUtf8().constData());
+            }
+        }
+        else
+        {
+            listFiles << strInput;
+        }
+    }
+    return listFiles;
+}
+
+int MediaValidate::Run(const QStringList &listInputs, int nJobs, FILE *fp)
+{
+    QStringList listFiles = CollectFiles(listInputs);
+    std::atomic<int> nNext(0);
+    std::atomic<int> nErrors(0), nWarnings(0);
+    std::mutex mutexOutput;
+    std::vector<std::thread> vecWorkers;
+    int64_t nStartTime = av_gettime_relative();
+    int nCores = FFMAX((int)std::thread::hardware_concurrency(), 1);
+
+    nJobs = FFMAX(FFMIN(nJobs, (int)listFiles.size()), 1);
+    //每个文件一个工作线程，核数多于文件数时剩下的核给解码器
+    int nDecoderThreads = FFMAX(nCores / nJobs, 1);
+
+    for (int i = 0; i < nJobs; i++)
+    {
+        vecWorkers.emplace_back([&]()
+        {
+            int nIndex;
+            while ((nIndex = nNext++) < listFiles.size())
+            {
+                QJsonObject objResult = ValidateFile(listFiles[nIndex], nDecoderThreads);
+                QString strStatus = objResult["status"].toString();
+                if (strStatus == "error")
+                {
+                    nErrors++;
+                }
+                else if (strStatus == "warning")
+                {
+                    nWarnings++;
+                }
+                objResult["index"] = nIndex;
+
+                std::lock_guard<std::mutex> lock(mutexOutput);
+                fprintf(fp, "%s\n", QJsonDocument(objResult).toJson(QJsonDocument::Compact).constData());
+                fflush(fp);
+            }
+        });
+    }
+    for (std::thread &t : vecWorkers)
+    {
+        t.join();
+    }
+
+    QJsonObject objSummary;
+    objSummary["summary"] = true;
+    objSummary["files"] = (int)listFiles.size();
+    objSummary["errors"] = (int)nErrors;
+    objSummary["warnings"] = (int)nWarnings;
+    objSummary["jobs"] = nJobs;
+    objSummary["seconds"] = (av_gettime_relative() - nStartTime) / 1000000.0;
+    fprintf(fp, "%s\n", QJsonDocument(objSummary).toJson(QJsonDocument::Compact).constData());
+    fflush(fp);
+
+    return listFiles.isEmpty() || nErrors ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+﻿/*
+ * @file 	mediavalidate.h
+ * @date 	2026/10/19 11:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	批量校验媒体文件
+ * @note	无界面，不按播放速度，每个文件完整解封装并解码所有音视频流，多个文件在各核上并行（每个工作线程一个文件）。
+ *			解封装、数据包队列、解码与播放共用 datactl.h 中的实现，队列按 MAX_QUEUE_SIZE 限制，内存占用与文件大小无关。
+ *			每个文件输出一行 JSON：解码错误、时间戳问题、时长、解码速度。
+ */
+#ifndef MEDIAVALIDATE_H
+#define MEDIAVALIDATE_H
+
+#include <cstdio>
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include "globalhelper.h"
+
+#define VALIDATE_WAIT_MS 10                 //队列满时解封装等待解码的时间
+#define VALIDATE_MAX_READ_ERRORS 16         //连续读取失败超过该次数不再继续读取
+#define VALIDATE_AUDIO_GAP 0.01             //音频时间戳与上一帧结尾相差超过该值记为不连续（秒）
+#define VALIDATE_DURATION_TOLERANCE 1.0     //解码时长与封装时长相差超过该值记为不一致（秒）
+
+class MediaValidate
+{
+public:
+    /**
+     * @brief	展开输入：目录递归查找媒体文件，播放列表取出条目，其他按文件或地址处理
+     *
+     * @param	listInputs 输入
+     * @return	待校验的文件
+     */
+    static QStringList CollectFiles(const QStringList &listInputs);
+
+    /**
+     * @brief	校验一个文件
+     *
+     * @param	strFile 文件
+     * @param	nDecoderThreads 每个解码器的线程数
+     * @return	结果，status 为 ok、warning 或 error
+     */
+    static QJsonObject ValidateFile(const QString &strFile, int nDecoderThreads);
+
+    /**
+     * @brief	并行校验，每个文件完成后输出一行 JSON，最后输出一行汇总
+     *
+     * @param	listInputs 文件、目录或播放列表
+     * @param	nJobs 同时校验的文件数
+     * @param	fp 结果输出
+     * @return	进程返回值，0 表示没有 error
+     */
+    static int Run(const QStringList &listInputs, int nJobs, FILE *fp);
+
+    //按扩展名判断是否为媒体文件（用于目录查找）
+    static bool IsMediaFile(const QString &strFile);
+};
+
+#endif // MEDIAVALIDATE_H
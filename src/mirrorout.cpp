@@ -0,0 +1,187 @@
+﻿/*
+ * @file 	mirrorout.cpp
+ * @date 	2026/10/18 13:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	镜像输出
+ * @note
+ */
+
+#include <QGuiApplication>
+#include <QScreen>
+#include <QIcon>
+
+#include "mirrorout.h"
+#include "videoctl.h"
+
+#pragma execution_character_set("utf-8")
+
+MirrorOutput::MirrorOutput(WId wid) :
+    m_wid(wid),
+    m_stRender(true),
+    m_bUploaded(false),
+    m_pSubFrame(nullptr),
+    m_dSubPts(0),
+    m_pSubConvertCtx(nullptr)
+{
+    m_stRender.SetWindow(wid);
+}
+
+MirrorOutput::~MirrorOutput()
+{
+    Close();
+}
+
+WId MirrorOutput::GetWId() const
+{
+    return m_wid;
+}
+
+int MirrorOutput::Open()
+{
+    int w, h;
+
+    if (m_stRender.IsOpen())
+    {
+        return 0;
+    }
+
+    m_bUploaded = false;
+    m_pSubFrame = nullptr;
+    return m_stRender.Open(&w, &h);
+}
+
+void MirrorOutput::Close()
+{
+    m_stRender.Close();
+    sws_freeContext(m_pSubConvertCtx);
+    m_pSubConvertCtx = nullptr;
+    m_bUploaded = false;
+    m_pSubFrame = nullptr;
+}
+
+bool MirrorOutput::IsOpen() const
+{
+    return m_stRender.IsOpen();
+}
+
+Uint32 MirrorOutput::WindowID() const
+{
+    return m_stRender.WindowID();
+}
+
+void MirrorOutput::Display(Frame *vp, Frame *sp, bool bNewFrame)
+{
+    SDL_Rect rect;
+    int w, h;
+
+    if (!m_stRender.IsOpen() || !vp->frame->data[0])
+    {
+        return;
+    }
+
+    //镜像输出始终显示整帧，不跟随主画面的缩放
+    if (bNewFrame || !m_bUploaded)
+    {
+        if (m_stRender.UploadVideo(vp->frame, NULL) < 0)
+        {
+            return;
+        }
+        m_bUploaded = true;
+    }
+    if (sp && UploadSubtitle(sp, vp) < 0)
+    {
+        sp = NULL;
+    }
+
+    if (!m_stRender.BeginFrame())
+    {
+        return;
+    }
+    //窗口大小可能随时变化，每次按当前大小计算
+    m_stRender.Open(&w, &h);
+    VideoCtl::calculate_display_rect(&rect, 0, 0, w, h, vp->width, vp->height, vp->sar, vp->rotation);
+    m_stRender.RenderVideo(NULL, &rect, vp->rotation,
+        (vp->flip_v ? SDL_FLIP_VERTICAL : 0) | (vp->flip_h ? SDL_FLIP_HORIZONTAL : 0));
+    if (sp)
+    {
+        //字幕保持正向，铺在旋转后的画面区域上
+        SDL_RendererInfo info = { 0 };
+        SDL_Rect sub_src = { 0, 0, 0, 0 };
+        SDL_Rect sub_rect = VideoCtl::rotated_display_rect(rect, vp->rotation);
+        m_stRender.MaxTextureSize(&info.max_texture_width, &info.max_texture_height);
+        VideoCtl::fit_texture_size(&info, sp->width, sp->height, &sub_src.w, &sub_src.h);
+        m_stRender.RenderSubtitle(&sub_src, &sub_rect);
+    }
+    m_stRender.EndFrame();
+}
+
+int MirrorOutput::UploadSubtitle(Frame *sp, Frame *vp)
+{
+    SDL_RendererInfo info = { 0 };
+
+    if (m_pSubFrame == sp && m_dSubPts == sp->pts)
+    {
+        return 0;
+    }
+
+    m_stRender.MaxTextureSize(&info.max_texture_width, &info.max_texture_height);
+    if (VideoCtl::upload_subtitle(&m_stRender, &info, sp, vp, &m_pSubConvertCtx) < 0)
+    {
+        m_pSubFrame = nullptr;
+        return -1;
+    }
+    m_pSubFrame = sp;
+    m_dSubPts = sp->pts;
+    return 0;
+}
+
+MirrorWid::MirrorWid(QWidget *parent) :
+    QWidget(parent, Qt::Window)
+{
+    setWindowTitle("镜像输出");
+    setWindowIcon(QIcon("://res/player.png"));
+    //需要独立的原生窗口句柄供 SDL 使用
+    setAttribute(Qt::WA_NativeWindow);
+    setAttribute(Qt::WA_PaintOnScreen);
+    setAttribute(Qt::WA_NoSystemBackground);
+    resize(640, 360);
+}
+
+void MirrorWid::ShowOnScreen(QScreen *pMainScreen)
+{
+    for (QScreen *pScreen : QGuiApplication::screens())
+    {
+        if (pScreen != pMainScreen)
+        {
+            setGeometry(pScreen->geometry());
+            showFullScreen();
+            return;
+        }
+    }
+
+    showNormal();
+}
+
+QPaintEngine *MirrorWid::paintEngine() const
+{
+    return nullptr;
+}
+
+void MirrorWid::closeEvent(QCloseEvent *event)
+{
+    emit SigClosed();
+    QWidget::closeEvent(event);
+}
+
+void MirrorWid::keyReleaseEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_Escape)
+    {
+        close();
+        return;
+    }
+    QWidget::keyReleaseEvent(event);
+}
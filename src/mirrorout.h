@@ -0,0 +1,97 @@
+﻿/*
+ * @file 	mirrorout.h
+ * @date 	2026/10/18 13:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	镜像输出
+ * @note	把主窗口正在显示的画面和字幕同步显示到其他窗口（如副屏监看）。
+ *			帧数据按引用计数共享，不重复解码、不拷贝。SDL 窗口和渲染器只能在创建它们的线程上使用，
+ *			所以镜像输出在刷新线程上打开、绘制和关闭，主画面显示后依次显示，不等待垂直同步。
+ *			全屏控制条叠加层属于主窗口的操作界面，不镜像。
+ */
+#ifndef MIRROROUT_H
+#define MIRROROUT_H
+
+#include <QWidget>
+#include <QCloseEvent>
+#include <QKeyEvent>
+
+#include "globalhelper.h"
+#include "sdlrender.h"
+
+class MirrorOutput
+{
+public:
+    explicit MirrorOutput(WId wid);
+    ~MirrorOutput();
+
+    WId GetWId() const;
+
+    /* 以下只在刷新线程调用 */
+
+    /**
+     * @brief	打开输出窗口的 SDL 渲染器，已打开时直接返回
+     *
+     * @return	0 成功 负值失败
+     */
+    int Open();
+
+    //关闭输出，释放渲染器和纹理
+    void Close();
+
+    bool IsOpen() const;
+
+    //SDL 窗口 ID，用于区分镜像输出窗口的事件
+    Uint32 WindowID() const;
+
+    /**
+     * @brief	显示主画面当前的帧和字幕
+     *
+     * @param	vp 视频帧
+     * @param	sp 正在显示的字幕，没有时为空
+     * @param	bNewFrame 新帧需要上传，否则只重绘（窗口大小变化、字幕变化）
+     */
+    void Display(Frame *vp, Frame *sp, bool bNewFrame);
+
+private:
+    //上传字幕，与上次相同时不重复上传
+    int UploadSubtitle(Frame *sp, Frame *vp);
+
+private:
+    WId m_wid;  //< 输出窗口ID
+    SdlRender m_stRender;
+    bool m_bUploaded;           //< 已上传过视频帧
+    const Frame *m_pSubFrame;   //< 已上传的字幕（帧队列中的位置和时间戳一起判断）
+    double m_dSubPts;
+    struct SwsContext *m_pSubConvertCtx;
+};
+
+// 镜像输出窗口（监看窗口），有副屏时全屏显示在副屏上
+class MirrorWid : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MirrorWid(QWidget *parent = nullptr);
+
+    /**
+     * @brief	显示窗口，有副屏时全屏显示在主窗口以外的屏幕上
+     *
+     * @param	pMainScreen 主窗口所在屏幕
+     */
+    void ShowOnScreen(QScreen *pMainScreen);
+
+protected:
+    //画面由 SDL 直接绘制
+    QPaintEngine *paintEngine() const;
+    void closeEvent(QCloseEvent *event);
+    void keyReleaseEvent(QKeyEvent *event);
+
+signals:
+    //窗口即将关闭，需先移除镜像输出
+    void SigClosed();
+};
+
+#endif // MIRROROUT_H
@@ -0,0 +1,342 @@
+﻿/*
+ * @file 	osd.cpp
+ * @date 	2026/10/18 22:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	全屏控制条
+ * @note
+ */
+
+#include <QFont>
+#include <QLinearGradient>
+#include <QPainter>
+
+#include "osd.h"
+#include "videoctl.h"
+
+#pragma execution_character_set("utf-8")
+
+Osd::Osd(QObject *parent) :
+    QObject(parent),
+    m_bEnabled(false),
+    m_bShown(false),
+    m_nOutputW(0),
+    m_nOutputH(0),
+    m_dDpr(1.0),
+    m_nTotalSeconds(0),
+    m_nPlaySeconds(0),
+    m_bPaused(true),
+    m_nHoverItem(OSD_ITEM_NONE),
+    m_nHoverSeekX(0)
+{
+    m_stHideTimer.setSingleShot(true);
+    m_stHideTimer.setInterval(OSD_HIDE_DELAY_MS);
+    connect(&m_stHideTimer, &QTimer::timeout, this, &Osd::OnHideTimeOut);
+}
+
+Osd::~Osd()
+{
+}
+
+void Osd::SetEnabled(bool bEnabled)
+{
+    if (m_bEnabled == bEnabled)
+    {
+        return;
+    }
+
+    m_bEnabled = bEnabled;
+    m_nHoverItem = OSD_ITEM_NONE;
+    //进入全屏时先显示一次，鼠标不动则按时隐藏
+    SetShown(bEnabled);
+    if (bEnabled)
+    {
+        m_stHideTimer.start();
+    }
+    else
+    {
+        m_stHideTimer.stop();
+    }
+}
+
+bool Osd::IsEnabled() const
+{
+    return m_bEnabled;
+}
+
+bool Osd::IsShown() const
+{
+    return m_bShown;
+}
+
+void Osd::SetOutputSize(int nWidth, int nHeight, qreal dDpr)
+{
+    if (m_nOutputW == nWidth && m_nOutputH == nHeight && m_dDpr == dDpr)
+    {
+        return;
+    }
+
+    m_nOutputW = nWidth;
+    m_nOutputH = nHeight;
+    m_dDpr = dDpr;
+    Update();
+}
+
+void Osd::OnMouseMove(const QPoint &pos)
+{
+    if (!m_bEnabled)
+    {
+        return;
+    }
+
+    int nHover = HitTest(pos);
+    //悬停在进度条上时显示目标时间，位置变化要重画
+    bool bChanged = nHover != m_nHoverItem || (nHover == OSD_ITEM_SEEK && pos.x() != m_nHoverSeekX);
+    m_nHoverItem = nHover;
+    m_nHoverSeekX = pos.x();
+
+    if (!m_bShown)
+    {
+        SetShown(true);
+    }
+    else if (bChanged)
+    {
+        Update();
+    }
+
+    //鼠标在控制条上时不隐藏
+    if (nHover == OSD_ITEM_NONE)
+    {
+        m_stHideTimer.start();
+    }
+    else
+    {
+        m_stHideTimer.stop();
+    }
+}
+
+bool Osd::OnMousePress(const QPoint &pos)
+{
+    if (!m_bEnabled || !m_bShown)
+    {
+        return false;
+    }
+
+    switch (HitTest(pos))
+    {
+    case OSD_ITEM_SEEK:
+    {
+        QRectF rcSeek = ItemRect(OSD_ITEM_SEEK);
+        double dPercent = (pos.x() - rcSeek.left()) / rcSeek.width();
+        emit SigPlaySeek(qBound(0.0, dPercent, 1.0));
+        return true;
+    }
+    case OSD_ITEM_PLAY:
+        emit SigPlayOrPause();
+        return true;
+    case OSD_ITEM_STOP:
+        emit SigStop();
+        return true;
+    case OSD_ITEM_EXIT:
+        emit SigExitFullScreen();
+        return true;
+    default:
+        break;
+    }
+
+    //控制条空白处不穿透到画面（避免开始拖动）
+    return pos.y() >= m_nOutputH - OSD_HEIGHT;
+}
+
+void Osd::OnMouseLeave()
+{
+    if (m_nHoverItem != OSD_ITEM_NONE)
+    {
+        m_nHoverItem = OSD_ITEM_NONE;
+        Update();
+    }
+    if (m_bEnabled)
+    {
+        m_stHideTimer.start();
+    }
+}
+
+void Osd::OnVideoTotalSeconds(int nSeconds)
+{
+    m_nTotalSeconds = nSeconds;
+    Update();
+}
+
+void Osd::OnVideoPlaySeconds(int nSeconds)
+{
+    //每秒一次，只在秒数变化时重画
+    if (m_nPlaySeconds != nSeconds)
+    {
+        m_nPlaySeconds = nSeconds;
+        Update();
+    }
+}
+
+void Osd::OnPauseStat(bool bPaused)
+{
+    m_bPaused = bPaused;
+    Update();
+}
+
+void Osd::OnStopFinished()
+{
+    m_nPlaySeconds = 0;
+    m_nTotalSeconds = 0;
+    m_bPaused = true;
+    Update();
+}
+
+void Osd::SetShown(bool bShown)
+{
+    if (m_bShown != bShown)
+    {
+        m_bShown = bShown;
+        emit SigShownChanged(bShown);
+    }
+    Update();
+}
+
+void Osd::OnHideTimeOut()
+{
+    if (m_nHoverItem == OSD_ITEM_NONE)
+    {
+        SetShown(false);
+    }
+}
+
+void Osd::Update()
+{
+    VideoCtl *pVideoCtl = VideoCtl::GetInstance();
+    if (!pVideoCtl)
+    {
+        return;
+    }
+
+    if (!m_bEnabled || !m_bShown || m_nOutputW <= 0 || m_nOutputH < OSD_HEIGHT)
+    {
+        pVideoCtl->SetOverlay(QImage());
+        return;
+    }
+
+    //每次新建，刷新线程可能还持有上一张
+    QImage image(qRound(m_nOutputW * m_dDpr), qRound(OSD_HEIGHT * m_dDpr), QImage::Format_ARGB32);
+    if (image.isNull())
+    {
+        return;
+    }
+    image.setDevicePixelRatio(m_dDpr);
+    image.fill(Qt::transparent);
+    Paint(image);
+    pVideoCtl->SetOverlay(image);
+}
+
+void Osd::Paint(QImage &image)
+{
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setRenderHint(QPainter::TextAntialiasing, true);
+
+    //底部渐暗，保证浅色画面上也看得清
+    QLinearGradient gradient(0, 0, 0, OSD_HEIGHT);
+    gradient.setColorAt(0, QColor(0, 0, 0, 60));
+    gradient.setColorAt(1, QColor(0, 0, 0, 200));
+    painter.fillRect(QRectF(0, 0, m_nOutputW, OSD_HEIGHT), gradient);
+
+    //进度条
+    QRectF rcSeek = ItemRect(OSD_ITEM_SEEK);
+    double dBarH = m_nHoverItem == OSD_ITEM_SEEK ? 6 : 4;
+    QRectF rcBar(rcSeek.left(), rcSeek.center().y() - dBarH / 2, rcSeek.width(), dBarH);
+    double dPercent = m_nTotalSeconds > 0 ? qBound(0.0, (double)m_nPlaySeconds / m_nTotalSeconds, 1.0) : 0;
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(255, 255, 255, 80));
+    painter.drawRoundedRect(rcBar, dBarH / 2, dBarH / 2);
+    painter.setBrush(QColor(0x1e, 0x90, 0xff));
+    painter.drawRoundedRect(QRectF(rcBar.left(), rcBar.top(), rcBar.width() * dPercent, dBarH), dBarH / 2, dBarH / 2);
+    painter.drawEllipse(QPointF(rcBar.left() + rcBar.width() * dPercent, rcBar.center().y()), dBarH + 1, dBarH + 1);
+
+    //按钮
+    QFont fontIcon;
+    fontIcon.setFamily("FontAwesome");
+    fontIcon.setPixelSize(18);
+    painter.setFont(fontIcon);
+    struct { int nItem; QChar icon; } buttons[] = {
+        { OSD_ITEM_PLAY, QChar(m_bPaused ? 0xf04b : 0xf04c) },
+        { OSD_ITEM_STOP, QChar(0xf04d) },
+        { OSD_ITEM_EXIT, QChar(0xf066) },
+    };
+    for (const auto &button : buttons)
+    {
+        painter.setPen(m_nHoverItem == button.nItem ? QColor(0x1e, 0x90, 0xff) : QColor(255, 255, 255, 230));
+        painter.drawText(ItemRect(button.nItem), Qt::AlignCenter, QString(button.icon));
+    }
+
+    //时间，悬停在进度条上时显示目标时间
+    QFont fontText;
+    fontText.setPixelSize(14);
+    painter.setFont(fontText);
+    painter.setPen(QColor(255, 255, 255, 230));
+    QRectF rcStop = ItemRect(OSD_ITEM_STOP);
+    QRectF rcExit = ItemRect(OSD_ITEM_EXIT);
+    QRectF rcTime(rcStop.right() + OSD_MARGIN, rcStop.top(), rcExit.left() - rcStop.right() - 2 * OSD_MARGIN, rcStop.height());
+    QString strTime = FormatTime(m_nPlaySeconds) + " / " + FormatTime(m_nTotalSeconds);
+    if (m_nHoverItem == OSD_ITEM_SEEK && m_nTotalSeconds > 0)
+    {
+        double dTarget = qBound(0.0, (m_nHoverSeekX - rcSeek.left()) / rcSeek.width(), 1.0);
+        strTime += "  →  " + FormatTime((int)(dTarget * m_nTotalSeconds));
+    }
+    painter.drawText(rcTime, Qt::AlignLeft | Qt::AlignVCenter, strTime);
+}
+
+QRectF Osd::ItemRect(int nItem) const
+{
+    const double dButton = 36;
+    const double dRowTop = OSD_SEEK_BAND + (OSD_HEIGHT - OSD_SEEK_BAND - dButton) / 2;
+
+    switch (nItem)
+    {
+    case OSD_ITEM_SEEK:
+        return QRectF(OSD_MARGIN, 0, qMax(m_nOutputW - 2 * OSD_MARGIN, 1), OSD_SEEK_BAND);
+    case OSD_ITEM_PLAY:
+        return QRectF(OSD_MARGIN, dRowTop, dButton, dButton);
+    case OSD_ITEM_STOP:
+        return QRectF(OSD_MARGIN + dButton, dRowTop, dButton, dButton);
+    case OSD_ITEM_EXIT:
+        return QRectF(m_nOutputW - OSD_MARGIN - dButton, dRowTop, dButton, dButton);
+    default:
+        return QRectF();
+    }
+}
+
+int Osd::HitTest(const QPoint &pos) const
+{
+    //换算到控制条坐标
+    QPointF pt(pos.x(), pos.y() - (m_nOutputH - OSD_HEIGHT));
+    if (!m_bShown || pt.y() < 0)
+    {
+        return OSD_ITEM_NONE;
+    }
+
+    for (int nItem = OSD_ITEM_SEEK; nItem <= OSD_ITEM_EXIT; nItem++)
+    {
+        if (ItemRect(nItem).contains(pt))
+        {
+            return nItem;
+        }
+    }
+    return OSD_ITEM_NONE;
+}
+
+QString Osd::FormatTime(int nSeconds)
+{
+    nSeconds = qMax(nSeconds, 0);
+    return QString("%1:%2:%3").arg(nSeconds / 3600, 2, 10, QChar('0'))
+        .arg((nSeconds % 3600) / 60, 2, 10, QChar('0'))
+        .arg(nSeconds % 60, 2, 10, QChar('0'));
+}
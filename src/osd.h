@@ -0,0 +1,107 @@
+﻿/*
+ * @file 	osd.h
+ * @date 	2026/10/18 22:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	全屏控制条
+ * @note	全屏时代替浮动的控制面板窗口。控制条（进度条、时间、按钮）在界面线程上画到一张带透明度的
+ *			QImage，只在内容变化时（秒数、悬停、暂停状态、大小）重画，交给刷新线程作为叠加层纹理
+ *			与画面一起输出，不需要合成器混合半透明窗口。显示和隐藏由鼠标事件驱动，不轮询光标位置。
+ */
+#ifndef OSD_H
+#define OSD_H
+
+#include <QObject>
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+#include <QTimer>
+
+#define OSD_HEIGHT 64               //控制条高度（逻辑像素）
+#define OSD_MARGIN 16               //左右边距
+#define OSD_SEEK_BAND 20            //顶部进度条的点击区域高度
+#define OSD_HIDE_DELAY_MS 2000      //鼠标静止后隐藏的延时（毫秒）
+
+class Osd : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Osd(QObject *parent = nullptr);
+    ~Osd();
+
+    //全屏时开启，关闭时移除叠加层
+    void SetEnabled(bool bEnabled);
+    bool IsEnabled() const;
+    bool IsShown() const;
+
+    /**
+     * @brief	画面输出区域大小变化
+     *
+     * @param	nWidth 宽（逻辑像素）
+     * @param	nHeight 高
+     * @param	dDpr 设备像素比
+     */
+    void SetOutputSize(int nWidth, int nHeight, qreal dDpr);
+
+    //鼠标事件，坐标相对画面输出区域
+    void OnMouseMove(const QPoint &pos);
+    /**
+     * @return	true 点在控制条上，事件已处理
+     */
+    bool OnMousePress(const QPoint &pos);
+    void OnMouseLeave();
+
+    void OnVideoTotalSeconds(int nSeconds);
+    void OnVideoPlaySeconds(int nSeconds);
+    void OnPauseStat(bool bPaused);
+    void OnStopFinished();
+
+signals:
+    void SigPlaySeek(double dPercent);
+    void SigPlayOrPause();
+    void SigStop();
+    void SigExitFullScreen();
+    void SigShownChanged(bool bShown);  ///< 显示、隐藏（隐藏时可以隐藏光标）
+
+private:
+    enum OsdItem {
+        OSD_ITEM_NONE,
+        OSD_ITEM_SEEK,
+        OSD_ITEM_PLAY,
+        OSD_ITEM_STOP,
+        OSD_ITEM_EXIT
+    };
+
+    void SetShown(bool bShown);
+    void OnHideTimeOut();
+
+    //重画控制条并交给刷新线程，隐藏时移除叠加层
+    void Update();
+    void Paint(QImage &image);
+
+    //控制条上各元素的位置（相对控制条，逻辑像素）
+    QRectF ItemRect(int nItem) const;
+    int HitTest(const QPoint &pos) const;
+    static QString FormatTime(int nSeconds);
+
+private:
+    bool m_bEnabled;
+    bool m_bShown;
+
+    int m_nOutputW;
+    int m_nOutputH;
+    qreal m_dDpr;
+
+    int m_nTotalSeconds;
+    int m_nPlaySeconds;
+    bool m_bPaused;
+    int m_nHoverItem;               //< 鼠标所在的元素（OsdItem）
+    int m_nHoverSeekX;              //< 鼠标在进度条上时的位置，用于显示目标时间
+
+    QTimer m_stHideTimer;
+};
+
+#endif // OSD_H
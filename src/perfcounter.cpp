@@ -0,0 +1,80 @@
+﻿/*
+ * @file 	perfcounter.cpp
+ * @date 	2026/10/21 09:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	基准测试用的硬件性能计数器
+ * @note
+ */
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfcounter.h"
+
+#pragma execution_character_set("utf-8")
+
+int PerfCounter::Open(PerfCounterType eType)
+{
+#if defined(__linux__)
+    struct perf_event_attr attr;
+    uint64_t cache = eType == PERF_COUNTER_DTLB_READ_MISS ? PERF_COUNT_HW_CACHE_DTLB : PERF_COUNT_HW_CACHE_L1D;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)eType;
+    return -1;
+#endif
+}
+
+void PerfCounter::Start(int fd)
+{
+#if defined(__linux__)
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+int64_t PerfCounter::Stop(int fd)
+{
+#if defined(__linux__)
+    uint64_t count = 0;
+    if (fd < 0)
+        return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &count, sizeof(count)) != sizeof(count))
+        return -1;
+    return (int64_t)count;
+#else
+    (void)fd;
+    return -1;
+#endif
+}
+
+void PerfCounter::Close(int fd)
+{
+#if defined(__linux__)
+    if (fd >= 0)
+        close(fd);
+#else
+    (void)fd;
+#endif
+}
@@ -0,0 +1,36 @@
+﻿/*
+ * @file 	perfcounter.h
+ * @date 	2026/10/21 09:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	基准测试用的硬件性能计数器
+ * @note	只有 Linux 支持（perf_event_open），只统计调用线程的用户态事件；
+ *			其他平台或没有权限（perf_event_paranoid）时 Open 返回 -1，Stop 返回 -1。
+ */
+#ifndef PERFCOUNTER_H
+#define PERFCOUNTER_H
+
+#include <cstdint>
+
+//计数的事件
+enum PerfCounterType {
+    PERF_COUNTER_L1D_READ_MISS,     //L1D 读未命中
+    PERF_COUNTER_DTLB_READ_MISS,    //数据 TLB 读未命中
+};
+
+class PerfCounter
+{
+public:
+    //打开当前线程的计数器，返回 fd，失败返回 -1
+    static int Open(PerfCounterType eType);
+    //清零并开始计数
+    static void Start(int fd);
+    //停止计数，返回计数值，失败返回 -1；不关闭 fd
+    static int64_t Stop(int fd);
+    //关闭计数器，fd 为 -1 时什么都不做
+    static void Close(int fd);
+};
+
+#endif // PERFCOUNTER_H
@@ -10,7 +10,9 @@
 
 Playlist::Playlist(QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::Playlist)
+    ui(new Ui::Playlist),
+    m_pImportProgress(nullptr),
+    m_nSearchId(0)
 {
     ui->setupUi(this);
 	
@@ -18,6 +20,9 @@ Playlist::Playlist(QWidget *parent) :
 
 Playlist::~Playlist()
 {
+    m_stImport.Cancel();
+    m_stImport.wait();
+
     QStringList strListPlayList;
     for (int i = 0; i < ui->List->count(); i++)
     {
@@ -58,6 +63,7 @@ bool Playlist::InitUi()
     //GlobalHelper::SetIcon(ui->HideOrShowBtn, 12, QChar(0xf104));
 
     ui->List->clear();
+    ui->SearchList->hide();
 
     QStringList strListPlaylist;
     GlobalHelper::GetPlaylist(strListPlaylist);
@@ -65,9 +71,18 @@ bool Playlist::InitUi()
     for (QString strVideoFile : strListPlaylist)
     {
         QFileInfo fileInfo(strVideoFile);
-        if (fileInfo.exists())
+        //导入的网络地址没有对应的本地文件
+        if (strVideoFile.indexOf("://") > 1)
+        {
+            QListWidgetItem *pItem = new QListWidgetItem();
+            pItem->setData(Qt::UserRole, QVariant(strVideoFile));
+            pItem->setText(strVideoFile);
+            pItem->setToolTip(strVideoFile);
+            ui->List->addItem(pItem);
+        }
+        else if (fileInfo.exists())
         {
-            QListWidgetItem *pItem = new QListWidgetItem(ui->List);
+            QListWidgetItem *pItem = new QListWidgetItem();
             pItem->setData(Qt::UserRole, QVariant(fileInfo.filePath()));  // 用户数据
             pItem->setText(QString("%1").arg(fileInfo.fileName()));  // 显示文本
             pItem->setToolTip(fileInfo.filePath());
@@ -92,6 +107,30 @@ bool Playlist::ConnectSignalSlots()
 
     bRet = connect(ui->List, &MediaList::SigAddFile, this, &Playlist::OnAddFile);
     listRet.append(bRet);
+    bRet = connect(ui->List, &MediaList::SigImportPlaylist, this, &Playlist::OnImportPlaylist);
+    listRet.append(bRet);
+    bRet = connect(&m_stImport, &PlaylistImport::SigBatch, this, &Playlist::OnImportBatch);
+    listRet.append(bRet);
+    bRet = connect(&m_stImport, &PlaylistImport::SigProgress, this, &Playlist::OnImportProgress);
+    listRet.append(bRet);
+    bRet = connect(&m_stImport, &PlaylistImport::SigFinished, this, &Playlist::OnImportFinished);
+    listRet.append(bRet);
+    bRet = connect(ui->List->model(), &QAbstractItemModel::rowsInserted, this, &Playlist::OnListRowsInserted);
+    listRet.append(bRet);
+    bRet = connect(ui->List->model(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &Playlist::OnListRowsAboutToBeRemoved);
+    listRet.append(bRet);
+    bRet = connect(ui->List->model(), &QAbstractItemModel::modelAboutToBeReset, this, &Playlist::OnListAboutToBeReset);
+    listRet.append(bRet);
+    bRet = connect(ui->SearchEdit, &QLineEdit::textChanged, this, &Playlist::OnSearchTextChanged);
+    listRet.append(bRet);
+    bRet = connect(&m_stIndex, &PlaylistIndex::SigResults, this, &Playlist::OnSearchResults);
+    listRet.append(bRet);
+
+    //InitUi 中载入的条目
+    if (ui->List->count() > 0)
+    {
+        OnListRowsInserted(QModelIndex(), 0, ui->List->count() - 1);
+    }
 
 	for (bool bReturn : listRet)
 	{
@@ -141,7 +180,7 @@ void Playlist::OnAddFile(QString strFileName)
     QListWidgetItem *pItem = nullptr;
 	if (listItem.isEmpty())
 	{
-        pItem = new QListWidgetItem(ui->List);
+        pItem = new QListWidgetItem();
         pItem->setData(Qt::UserRole, QVariant(fileInfo.filePath()));  // 用户数据
         pItem->setText(fileInfo.fileName());  // 显示文本
         pItem->setToolTip(fileInfo.filePath());
@@ -172,7 +211,7 @@ void Playlist::OnAddFileAndPlay(QString strFileName)
     QListWidgetItem *pItem = nullptr;
     if (listItem.isEmpty())
     {
-        pItem = new QListWidgetItem(ui->List);
+        pItem = new QListWidgetItem();
         pItem->setData(Qt::UserRole, QVariant(fileInfo.filePath()));  // 用户数据
         pItem->setText(fileInfo.fileName());  // 显示文本
         pItem->setToolTip(fileInfo.filePath());
@@ -185,6 +224,177 @@ void Playlist::OnAddFileAndPlay(QString strFileName)
     on_List_itemDoubleClicked(pItem);
 }
 
+void Playlist::OnImportPlaylist(QString strFileName)
+{
+    if (m_stImport.isRunning())
+    {
+        return;
+    }
+
+    QStringList listExisting;
+    for (int i = 0; i < ui->List->count(); i++)
+    {
+        listExisting.append(ui->List->item(i)->data(Qt::UserRole).toString());
+    }
+    if (m_stImport.Start(strFileName, listExisting) == false)
+    {
+        return;
+    }
+
+    if (m_pImportProgress == nullptr)
+    {
+        m_pImportProgress = new QProgressDialog(this);
+        m_pImportProgress->setWindowTitle("导入播放列表");
+        m_pImportProgress->setCancelButtonText("取消");
+        m_pImportProgress->setRange(0, 1000);
+        m_pImportProgress->setMinimumDuration(500);
+        m_pImportProgress->setWindowModality(Qt::NonModal);
+        m_pImportProgress->setAutoClose(false);
+        m_pImportProgress->setAutoReset(false);
+        connect(m_pImportProgress, &QProgressDialog::canceled, &m_stImport, &PlaylistImport::Cancel);
+    }
+    m_pImportProgress->setLabelText(QFileInfo(strFileName).fileName());
+    m_pImportProgress->setValue(0);
+}
+
+void Playlist::OnImportBatch(QStringList listFiles, QStringList listTitles)
+{
+    ui->List->setUpdatesEnabled(false);
+    for (int i = 0; i < listFiles.size(); i++)
+    {
+        const QString &strFile = listFiles.at(i);
+        QString strTitle = listTitles.at(i);
+        if (strTitle.isEmpty())
+        {
+            strTitle = strFile.indexOf("://") > 1 ? strFile : QFileInfo(strFile).fileName();
+        }
+
+        QListWidgetItem *pItem = new QListWidgetItem(strTitle);
+        pItem->setData(Qt::UserRole, QVariant(strFile));
+        pItem->setToolTip(strFile);
+        ui->List->addItem(pItem);
+    }
+    ui->List->setUpdatesEnabled(true);
+
+    m_stImport.BatchDone();
+}
+
+void Playlist::OnImportProgress(int nPermille)
+{
+    if (m_pImportProgress)
+    {
+        m_pImportProgress->setValue(nPermille);
+    }
+}
+
+void Playlist::OnImportFinished(int nAdded, int nDuplicates, bool bCanceled)
+{
+    qDebug() << "playlist import" << (bCanceled ? "canceled" : "finished") << "added" << nAdded << "duplicates" << nDuplicates;
+
+    if (m_pImportProgress)
+    {
+        m_pImportProgress->reset();
+    }
+    if (ui->List->currentRow() < 0 && ui->List->count() > 0)
+    {
+        ui->List->setCurrentRow(0);
+    }
+}
+
+void Playlist::OnListRowsInserted(const QModelIndex &parent, int nFirst, int nLast)
+{
+    Q_UNUSED(parent);
+
+    for (int i = nFirst; i <= nLast; i++)
+    {
+        QListWidgetItem *pItem = ui->List->item(i);
+        m_stIndex.Add(pItem->data(Qt::UserRole).toString(), pItem->text());
+    }
+}
+
+void Playlist::OnListRowsAboutToBeRemoved(const QModelIndex &parent, int nFirst, int nLast)
+{
+    Q_UNUSED(parent);
+
+    for (int i = nFirst; i <= nLast; i++)
+    {
+        m_stIndex.Remove(ui->List->item(i)->data(Qt::UserRole).toString());
+    }
+}
+
+void Playlist::OnListAboutToBeReset()
+{
+    m_stIndex.Clear();
+}
+
+void Playlist::OnSearchTextChanged(const QString &strText)
+{
+    m_nSearchId = m_stIndex.Search(strText);
+
+    if (strText.trimmed().isEmpty())
+    {
+        m_listSearchFiles.clear();
+        ui->SearchList->clear();
+        ui->SearchList->hide();
+        ui->List->show();
+    }
+}
+
+void Playlist::OnSearchResults(quint64 nSearchId, QStringList listFiles, QStringList listDisplays, int nTotal)
+{
+    //输入过程中已提交了新的查询，或搜索框已清空
+    if (nSearchId != m_nSearchId || ui->SearchEdit->text().trimmed().isEmpty())
+    {
+        return;
+    }
+
+    ui->List->hide();
+    ui->SearchList->show();
+    //后台探测到元数据后会重新查询，结果不变时不刷新，保留滚动位置
+    if (listFiles == m_listSearchFiles && ui->SearchList->count() > 0)
+    {
+        return;
+    }
+    m_listSearchFiles = listFiles;
+
+    ui->SearchList->setUpdatesEnabled(false);
+    ui->SearchList->clear();
+    for (int i = 0; i < listFiles.size(); i++)
+    {
+        QListWidgetItem *pItem = new QListWidgetItem(listDisplays.at(i));
+        pItem->setData(Qt::UserRole, QVariant(listFiles.at(i)));
+        pItem->setToolTip(listFiles.at(i));
+        ui->SearchList->addItem(pItem);
+    }
+    if (nTotal > listFiles.size() || nTotal == 0)
+    {
+        QListWidgetItem *pItem = new QListWidgetItem(nTotal == 0 ? QString("无匹配项") :
+            QString("共 %1 项，请输入更多关键字").arg(nTotal));
+        pItem->setFlags(Qt::NoItemFlags);
+        ui->SearchList->addItem(pItem);
+    }
+    ui->SearchList->setUpdatesEnabled(true);
+}
+
+void Playlist::on_SearchList_itemDoubleClicked(QListWidgetItem *item)
+{
+    QString strFile = item->data(Qt::UserRole).toString();
+    if (strFile.isEmpty())
+    {
+        return;
+    }
+
+    for (int i = 0; i < ui->List->count(); i++)
+    {
+        if (ui->List->item(i)->data(Qt::UserRole).toString() == strFile)
+        {
+            on_List_itemDoubleClicked(ui->List->item(i));
+            ui->List->scrollToItem(ui->List->item(i));
+            return;
+        }
+    }
+}
+
 void Playlist::OnBackwardPlay()
 {
     if (m_nCurrentPlayListIndex == 0)
@@ -229,6 +439,11 @@ void Playlist::dropEvent(QDropEvent *event)
     {
         QString strFileName = url.toLocalFile();
 
+        if (PlaylistImport::IsPlaylistFile(strFileName))
+        {
+            OnImportPlaylist(strFileName);
+            continue;
+        }
         OnAddFile(strFileName);
     }
 }
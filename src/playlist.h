@@ -16,6 +16,10 @@
 #include <QDropEvent>
 #include <QDragEnterEvent>
 #include <QMimeData>
+#include <QProgressDialog>
+
+#include "playlistimport.h"
+#include "playlistindex.h"
 
 namespace Ui {
 class Playlist;
@@ -49,6 +53,13 @@ public:
     void OnAddFile(QString strFileName);
     void OnAddFileAndPlay(QString strFileName);
 
+    /**
+     * @brief	导入播放列表文件（M3U/M3U8/PLS/XSPF），后台解析，分批插入
+     *
+     * @param	strFileName 播放列表文件完整路径
+     */
+    void OnImportPlaylist(QString strFileName);
+
     void OnBackwardPlay();
     void OnForwardPlay();
 
@@ -85,10 +96,30 @@ private slots:
 
 	void on_List_itemDoubleClicked(QListWidgetItem *item);
 
+    void OnImportBatch(QStringList listFiles, QStringList listTitles);
+    void OnImportProgress(int nPermille);
+    void OnImportFinished(int nAdded, int nDuplicates, bool bCanceled);
+
+    //列表增删时同步搜索索引
+    void OnListRowsInserted(const QModelIndex &parent, int nFirst, int nLast);
+    void OnListRowsAboutToBeRemoved(const QModelIndex &parent, int nFirst, int nLast);
+    void OnListAboutToBeReset();
+
+    void OnSearchTextChanged(const QString &strText);
+    void OnSearchResults(quint64 nSearchId, QStringList listFiles, QStringList listDisplays, int nTotal);
+    void on_SearchList_itemDoubleClicked(QListWidgetItem *item);
+
 private:
     Ui::Playlist *ui;
 
     int m_nCurrentPlayListIndex;
+
+    PlaylistImport m_stImport;              //< 播放列表导入
+    QProgressDialog *m_pImportProgress;     //< 导入进度，可取消
+
+    PlaylistIndex m_stIndex;                //< 搜索索引
+    quint64 m_nSearchId;                    //< 最新查询序号，旧查询的结果丢弃
+    QStringList m_listSearchFiles;          //< 当前显示的搜索结果
 };
 
 #endif // PLAYLIST_H
@@ -0,0 +1,369 @@
+﻿/*
+ * @file 	playlistimport.cpp
+ * @date 	2026/10/18 19:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	播放列表导入
+ * @note
+ */
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+#include "playlistimport.h"
+
+#pragma execution_character_set("utf-8")
+
+PlaylistImport::PlaylistImport() :
+    m_bUtf8(true),
+    m_semPending(PLAYLIST_IMPORT_MAX_PENDING),
+    m_nAdded(0),
+    m_nDuplicates(0),
+    m_nPermille(0)
+{
+    m_bRunning = false;
+}
+
+PlaylistImport::~PlaylistImport()
+{
+    Cancel();
+    wait();
+}
+
+bool PlaylistImport::Start(const QString &strFile, const QStringList &listExisting)
+{
+    if (isRunning())
+    {
+        return false;
+    }
+
+    QFileInfo fileInfo(strFile);
+    if (!fileInfo.isReadable())
+    {
+        return false;
+    }
+
+    m_strFile = fileInfo.absoluteFilePath();
+    m_stBaseDir = fileInfo.absoluteDir();
+    m_bUtf8 = !strFile.endsWith(".m3u", Qt::CaseInsensitive);
+
+    m_setKeys.clear();
+    for (const QString &strExisting : listExisting)
+    {
+        m_setKeys.insert(CanonicalKey(strExisting));
+    }
+    m_listFiles.clear();
+    m_listTitles.clear();
+    m_semPending.acquire(m_semPending.available());
+    m_semPending.release(PLAYLIST_IMPORT_MAX_PENDING);
+    m_nAdded = 0;
+    m_nDuplicates = 0;
+    m_nPermille = 0;
+
+    return StartThread();
+}
+
+void PlaylistImport::Cancel()
+{
+    StopThread();
+}
+
+void PlaylistImport::BatchDone()
+{
+    m_semPending.release();
+}
+
+bool PlaylistImport::IsPlaylistFile(const QString &strFile)
+{
+    return strFile.endsWith(".m3u", Qt::CaseInsensitive) ||
+        strFile.endsWith(".m3u8", Qt::CaseInsensitive) ||
+        strFile.endsWith(".pls", Qt::CaseInsensitive) ||
+        strFile.endsWith(".xspf", Qt::CaseInsensitive);
+}
+
+QString PlaylistImport::CanonicalKey(const QString &strLocation)
+{
+    //带协议的网络地址（排除 Windows 盘符）
+    int nScheme = strLocation.indexOf("://");
+    if (nScheme > 1)
+    {
+        QUrl url(strLocation);
+        if (url.isLocalFile())
+        {
+            return CanonicalKey(url.toLocalFile());
+        }
+        return url.adjusted(QUrl::NormalizePathSegments | QUrl::StripTrailingSlash).toString();
+    }
+
+    //不访问磁盘，避免每个条目一次文件系统查询
+    QString strKey = QDir::cleanPath(QFileInfo(strLocation).absoluteFilePath());
+#ifdef Q_OS_WIN
+    strKey = strKey.toLower();
+#endif
+    return strKey;
+}
+
+void PlaylistImport::run()
+{
+    QFile file(m_strFile);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        emit SigFinished(0, 0, false);
+        return;
+    }
+
+    if (m_strFile.endsWith(".pls", Qt::CaseInsensitive))
+    {
+        ParsePls(file);
+    }
+    else if (m_strFile.endsWith(".xspf", Qt::CaseInsensitive))
+    {
+        ParseXspf(file);
+    }
+    else
+    {
+        ParseM3u(file);
+    }
+    FlushBatch();
+
+    if (m_bRunning)
+    {
+        emit SigProgress(1000);
+    }
+    emit SigFinished(m_nAdded, m_nDuplicates, !m_bRunning);
+    m_bRunning = false;
+}
+
+//#EXTM3U 扩展格式中 #EXTINF:时长,标题 在条目之前，其他 # 开头的行忽略
+void PlaylistImport::ParseM3u(QFile &file)
+{
+    QString strTitle;
+
+    while (m_bRunning && !file.atEnd())
+    {
+        QString strLine = ReadLine(file).trimmed();
+        if (strLine.isEmpty())
+        {
+            continue;
+        }
+
+        if (strLine.startsWith('#'))
+        {
+            if (strLine.startsWith("#EXTINF:", Qt::CaseInsensitive))
+            {
+                //IPTV 列表的属性值（tvg-name="..."）中可能有逗号，取引号外的第一个逗号
+                bool bQuoted = false;
+                int nComma = -1;
+                for (int i = 8; i < strLine.size(); i++)
+                {
+                    if (strLine.at(i) == '"')
+                    {
+                        bQuoted = !bQuoted;
+                    }
+                    else if (strLine.at(i) == ',' && !bQuoted)
+                    {
+                        nComma = i;
+                        break;
+                    }
+                }
+                strTitle = nComma >= 0 ? strLine.mid(nComma + 1).trimmed() : QString();
+            }
+            continue;
+        }
+
+        AddEntry(strLine, strTitle);
+        strTitle.clear();
+        ReportProgress(file);
+    }
+}
+
+//[playlist] 下 FileN=、TitleN=，同一序号的 Title 通常紧随 File
+void PlaylistImport::ParsePls(QFile &file)
+{
+    QString strLocation;
+    QString strTitle;
+    QString strIndex;
+
+    while (m_bRunning && !file.atEnd())
+    {
+        QString strLine = ReadLine(file).trimmed();
+        int nEqual = strLine.indexOf('=');
+        if (nEqual <= 0)
+        {
+            continue;
+        }
+
+        QString strKey = strLine.left(nEqual).trimmed();
+        QString strValue = strLine.mid(nEqual + 1).trimmed();
+        if (strKey.startsWith("File", Qt::CaseInsensitive))
+        {
+            if (!strLocation.isEmpty())
+            {
+                AddEntry(strLocation, strTitle);
+                ReportProgress(file);
+            }
+            strLocation = strValue;
+            strTitle.clear();
+            strIndex = strKey.mid(4);
+        }
+        else if (strKey.startsWith("Title", Qt::CaseInsensitive) && strKey.mid(5) == strIndex)
+        {
+            strTitle = strValue;
+        }
+    }
+
+    if (m_bRunning && !strLocation.isEmpty())
+    {
+        AddEntry(strLocation, strTitle);
+    }
+}
+
+//<trackList><track><location>URI</location><title>标题</title></track></trackList>
+void PlaylistImport::ParseXspf(QFile &file)
+{
+    QXmlStreamReader xml(&file);
+    QUrl urlBase = QUrl::fromLocalFile(m_stBaseDir.absolutePath() + "/");
+    QString strLocation;
+    QString strTitle;
+    bool bInTrack = false;
+
+    while (m_bRunning && !xml.atEnd())
+    {
+        xml.readNext();
+        if (xml.isStartElement())
+        {
+            if (xml.name() == QLatin1String("track"))
+            {
+                bInTrack = true;
+                strLocation.clear();
+                strTitle.clear();
+            }
+            else if (bInTrack && xml.name() == QLatin1String("location") && strLocation.isEmpty())
+            {
+                strLocation = xml.readElementText().trimmed();
+            }
+            else if (bInTrack && xml.name() == QLatin1String("title"))
+            {
+                strTitle = xml.readElementText().trimmed();
+            }
+        }
+        else if (xml.isEndElement() && xml.name() == QLatin1String("track"))
+        {
+            bInTrack = false;
+            if (!strLocation.isEmpty())
+            {
+                //location 是 URI，相对地址按播放列表所在目录解析
+                QUrl url = urlBase.resolved(QUrl(strLocation));
+                AddEntry(url.isLocalFile() ? url.toLocalFile() : url.toString(), strTitle);
+                ReportProgress(file);
+            }
+        }
+    }
+
+    if (xml.hasError() && m_bRunning)
+    {
+        qDebug() << "playlist import:" << m_strFile << "line" << xml.lineNumber() << xml.errorString();
+    }
+}
+
+QString PlaylistImport::ReadLine(QFile &file)
+{
+    QByteArray baLine = file.readLine(PLAYLIST_IMPORT_MAX_LINE);
+    //超长行丢弃剩余部分
+    if (baLine.size() == PLAYLIST_IMPORT_MAX_LINE - 1 && !baLine.endsWith('\n'))
+    {
+        while (!file.atEnd() && !file.readLine(PLAYLIST_IMPORT_MAX_LINE).endsWith('\n'))
+        {
+        }
+    }
+    if (baLine.startsWith("\xEF\xBB\xBF"))
+    {
+        baLine.remove(0, 3);
+    }
+    while (baLine.endsWith('\n') || baLine.endsWith('\r'))
+    {
+        baLine.chop(1);
+    }
+
+    QString strLine = QString::fromUtf8(baLine);
+    if (!m_bUtf8 && strLine.contains(QChar::ReplacementCharacter))
+    {
+        strLine = QString::fromLocal8Bit(baLine);
+    }
+    return strLine;
+}
+
+QString PlaylistImport::ResolveLocation(const QString &strLocation)
+{
+    int nScheme = strLocation.indexOf("://");
+    if (nScheme > 1)
+    {
+        QUrl url(strLocation);
+        return url.isLocalFile() ? QDir::toNativeSeparators(url.toLocalFile()) : strLocation;
+    }
+
+    return QDir::toNativeSeparators(QDir::cleanPath(m_stBaseDir.absoluteFilePath(strLocation)));
+}
+
+void PlaylistImport::AddEntry(const QString &strLocation, const QString &strTitle)
+{
+    QString strFile = ResolveLocation(strLocation);
+    QString strKey = CanonicalKey(strFile);
+
+    if (m_setKeys.contains(strKey))
+    {
+        m_nDuplicates++;
+        return;
+    }
+    m_setKeys.insert(strKey);
+
+    m_listFiles.append(strFile);
+    m_listTitles.append(strTitle);
+    if (m_listFiles.size() >= PLAYLIST_IMPORT_BATCH)
+    {
+        FlushBatch();
+    }
+}
+
+//交给界面插入，界面积压的批数达到上限时等待
+bool PlaylistImport::FlushBatch()
+{
+    if (m_listFiles.isEmpty())
+    {
+        return true;
+    }
+
+    while (!m_semPending.tryAcquire(1, 50))
+    {
+        if (!m_bRunning)
+        {
+            return false;
+        }
+    }
+
+    m_nAdded += m_listFiles.size();
+    emit SigBatch(m_listFiles, m_listTitles);
+    m_listFiles.clear();
+    m_listTitles.clear();
+    return true;
+}
+
+void PlaylistImport::ReportProgress(QFile &file)
+{
+    qint64 nSize = file.size();
+    if (nSize <= 0)
+    {
+        return;
+    }
+
+    int nPermille = (int)(file.pos() * 1000 / nSize);
+    if (nPermille != m_nPermille)
+    {
+        m_nPermille = nPermille;
+        emit SigProgress(nPermille);
+    }
+}
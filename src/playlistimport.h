@@ -0,0 +1,97 @@
+﻿/*
+ * @file 	playlistimport.h
+ * @date 	2026/10/18 19:40
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	播放列表导入
+ * @note	在工作线程上逐行（XSPF 逐个元素）解析 M3U/M3U8/PLS/XSPF，不把整个文件读入内存。
+ *			条目按规范化路径去重后分批交给界面插入，界面未取走的批数有上限，内存占用与文件大小无关。
+ */
+#ifndef PLAYLISTIMPORT_H
+#define PLAYLISTIMPORT_H
+
+#include <QDir>
+#include <QFile>
+#include <QSet>
+#include <QSemaphore>
+#include <QString>
+#include <QStringList>
+
+#include "customthread.h"
+
+#define PLAYLIST_IMPORT_BATCH 512           //每批插入的条目数
+#define PLAYLIST_IMPORT_MAX_PENDING 4       //最多等待界面插入的批数
+#define PLAYLIST_IMPORT_MAX_LINE 65536      //单行最大长度，超出部分丢弃
+
+class PlaylistImport : public CustomThread
+{
+    Q_OBJECT
+
+public:
+    PlaylistImport();
+    ~PlaylistImport();
+
+    /**
+     * @brief	开始导入
+     *
+     * @param	strFile 播放列表文件
+     * @param	listExisting 列表中已有的文件，与之重复的条目不再导入
+     * @return	true 已开始 false 正在导入或文件无法打开
+     */
+    bool Start(const QString &strFile, const QStringList &listExisting);
+
+    /**
+     * @brief	取消导入，已插入的条目保留
+     */
+    void Cancel();
+
+    /**
+     * @brief	界面插入完一批后调用
+     */
+    void BatchDone();
+
+    //按扩展名判断是否为支持的播放列表文件
+    static bool IsPlaylistFile(const QString &strFile);
+
+    //去重用的规范化路径：本地文件为绝对路径（Windows 下不区分大小写），网络地址规范化路径段
+    static QString CanonicalKey(const QString &strLocation);
+
+signals:
+    void SigBatch(QStringList listFiles, QStringList listTitles); //< 一批新条目，标题可能为空
+    void SigProgress(int nPermille);                              //< 进度（千分比）
+    void SigFinished(int nAdded, int nDuplicates, bool bCanceled);
+
+protected:
+    void run();
+
+private:
+    void ParseM3u(QFile &file);
+    void ParsePls(QFile &file);
+    void ParseXspf(QFile &file);
+
+    //读取一行，去掉换行符，UTF-8 无效时按本地编码
+    QString ReadLine(QFile &file);
+    //相对路径按播放列表所在目录解析，file:// 地址转为本地路径
+    QString ResolveLocation(const QString &strLocation);
+    void AddEntry(const QString &strLocation, const QString &strTitle);
+    bool FlushBatch();
+    void ReportProgress(QFile &file);
+
+private:
+    QString m_strFile;
+    QDir m_stBaseDir;
+    bool m_bUtf8;                   //< 按 UTF-8 解码（.m3u8、XSPF）
+
+    QSet<QString> m_setKeys;        //< 已有和已导入条目的规范化路径
+    QStringList m_listFiles;        //< 当前批
+    QStringList m_listTitles;
+    QSemaphore m_semPending;        //< 可交给界面的批数
+
+    int m_nAdded;
+    int m_nDuplicates;
+    int m_nPermille;
+};
+
+#endif // PLAYLISTIMPORT_H
@@ -0,0 +1,486 @@
+﻿/*
+ * @file 	playlistindex.cpp
+ * @date 	2026/10/18 20:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	播放列表搜索索引
+ * @note
+ */
+
+#include <algorithm>
+
+#include "playlistindex.h"
+#include "globalhelper.h"
+#include "ioscheduler.h"
+
+#pragma execution_character_set("utf-8")
+
+//一次最多处理的请求数，批量添加时查询不必等全部建完索引
+#define PLAYLIST_INDEX_OPS_PER_ROUND 1024
+//线性扫描时每隔多少条检查是否有更新的查询
+#define PLAYLIST_INDEX_CANCEL_CHECK 4096
+
+PlaylistIndex::PlaylistIndex(QObject *parent) :
+    QObject(parent),
+    m_bRunning(true),
+    m_nSearchId(0),
+    m_bQueryPending(false),
+    m_nRemoved(0)
+{
+    m_tIndexThread = std::thread(&PlaylistIndex::IndexThread, this);
+    m_tProbeThread = std::thread(&PlaylistIndex::ProbeThread, this);
+}
+
+PlaylistIndex::~PlaylistIndex()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOps);
+        m_bRunning = false;
+    }
+    m_condOps.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_mutexProbe);
+    }
+    m_condProbe.notify_all();
+
+    if (m_tIndexThread.joinable())
+    {
+        m_tIndexThread.join();
+    }
+    if (m_tProbeThread.joinable())
+    {
+        m_tProbeThread.join();
+    }
+}
+
+void PlaylistIndex::Add(const QString &strFile, const QString &strDisplay)
+{
+    if (strFile.isEmpty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOps);
+        m_dequeOps.push_back({INDEX_OP_ADD, strFile, strDisplay});
+    }
+    m_condOps.notify_one();
+
+    //网络地址不探测
+    if (strFile.indexOf("://") <= 1)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutexProbe);
+            m_dequeProbe.push_back(strFile);
+        }
+        m_condProbe.notify_one();
+    }
+}
+
+void PlaylistIndex::Remove(const QString &strFile)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOps);
+        m_dequeOps.push_back({INDEX_OP_REMOVE, strFile, QString()});
+    }
+    m_condOps.notify_one();
+}
+
+void PlaylistIndex::Clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexProbe);
+        m_dequeProbe.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOps);
+        m_dequeOps.clear();
+        m_dequeOps.push_back({INDEX_OP_CLEAR, QString(), QString()});
+    }
+    m_condOps.notify_one();
+}
+
+quint64 PlaylistIndex::Search(const QString &strQuery)
+{
+    quint64 nSearchId;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOps);
+        nSearchId = ++m_nSearchId;
+        m_strQuery = strQuery;
+        m_bQueryPending = true;
+    }
+    m_condOps.notify_one();
+
+    return nSearchId;
+}
+
+void PlaylistIndex::IndexThread()
+{
+    quint64 nActiveId = 0;
+    QString strActiveQuery;
+
+    while (m_bRunning)
+    {
+        std::deque<IndexOp> dequeOps;
+        bool bQuery = false;
+        bool bDrained = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutexOps);
+            m_condOps.wait(lock, [this] {
+                return !m_bRunning || !m_dequeOps.empty() || m_bQueryPending;
+            });
+            if (!m_bRunning)
+            {
+                break;
+            }
+
+            size_t nCount = std::min(m_dequeOps.size(), (size_t)PLAYLIST_INDEX_OPS_PER_ROUND);
+            dequeOps.insert(dequeOps.end(), std::make_move_iterator(m_dequeOps.begin()),
+                std::make_move_iterator(m_dequeOps.begin() + nCount));
+            m_dequeOps.erase(m_dequeOps.begin(), m_dequeOps.begin() + nCount);
+            bDrained = !dequeOps.empty() && m_dequeOps.empty();
+
+            if (m_bQueryPending)
+            {
+                bQuery = true;
+                nActiveId = m_nSearchId;
+                strActiveQuery = m_strQuery;
+                m_bQueryPending = false;
+            }
+        }
+
+        for (IndexOp &op : dequeOps)
+        {
+            ApplyOp(op);
+        }
+        if (m_nRemoved > PLAYLIST_INDEX_COMPACT_MIN && m_nRemoved * 2 > m_vecDocs.size())
+        {
+            Compact();
+        }
+
+        //列表变化后刷新当前查询的结果，批量添加时只在处理完后刷新一次
+        if (bQuery || (bDrained && !strActiveQuery.trimmed().isEmpty()))
+        {
+            RunQuery(nActiveId, strActiveQuery);
+        }
+    }
+}
+
+void PlaylistIndex::ProbeThread()
+{
+    while (m_bRunning)
+    {
+        QString strFile;
+        {
+            std::unique_lock<std::mutex> lock(m_mutexProbe);
+            m_condProbe.wait(lock, [this] {
+                return !m_bRunning || !m_dequeProbe.empty();
+            });
+            if (!m_bRunning)
+            {
+                break;
+            }
+            strFile = m_dequeProbe.front();
+            m_dequeProbe.pop_front();
+        }
+
+        QString strMeta = ProbeMeta(strFile);
+        if (strMeta.isEmpty())
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutexOps);
+            m_dequeOps.push_back({INDEX_OP_META, strFile, strMeta});
+        }
+        m_condOps.notify_one();
+    }
+}
+
+void PlaylistIndex::ApplyOp(IndexOp &op)
+{
+    switch (op.type)
+    {
+    case INDEX_OP_ADD:
+    {
+        auto it = m_hashFiles.constFind(op.strFile);
+        if (it != m_hashFiles.constEnd())
+        {
+            m_vecDocs[it.value()].nRefs++;
+            break;
+        }
+
+        IndexDoc doc;
+        doc.strFile = op.strFile;
+        doc.strDisplay = op.strText;
+        doc.nRefs = 1;
+        AddDoc(std::move(doc));
+        break;
+    }
+    case INDEX_OP_REMOVE:
+    {
+        auto it = m_hashFiles.constFind(op.strFile);
+        if (it != m_hashFiles.constEnd())
+        {
+            RemoveDoc(it.value());
+        }
+        break;
+    }
+    case INDEX_OP_CLEAR:
+        m_vecDocs.clear();
+        m_mapPostings.clear();
+        m_hashFiles.clear();
+        m_nRemoved = 0;
+        break;
+    case INDEX_OP_META:
+    {
+        //倒排表只追加，元数据变化时换一个新编号重新加入
+        auto it = m_hashFiles.constFind(op.strFile);
+        if (it == m_hashFiles.constEnd())
+        {
+            break;
+        }
+        IndexDoc &old = m_vecDocs[it.value()];
+        IndexDoc doc;
+        doc.strFile = old.strFile;
+        doc.strDisplay = old.strDisplay;
+        doc.strMeta = op.strText;
+        doc.nRefs = old.nRefs;
+        old.nRefs = 1;
+        RemoveDoc(it.value());
+        AddDoc(std::move(doc));
+        break;
+    }
+    }
+}
+
+void PlaylistIndex::AddDoc(IndexDoc &&doc)
+{
+    uint32_t nId = (uint32_t)m_vecDocs.size();
+
+    int nSlash = std::max(doc.strFile.lastIndexOf('/'), doc.strFile.lastIndexOf('\\'));
+    doc.strText = (doc.strDisplay + '\n' + doc.strFile.mid(nSlash + 1) + '\n' +
+        doc.strFile + '\n' + doc.strMeta).toLower();
+
+    std::vector<uint64_t> vecKeys;
+    Trigrams(doc.strText, vecKeys);
+    for (uint64_t nKey : vecKeys)
+    {
+        m_mapPostings[nKey].push_back(nId);
+    }
+
+    m_hashFiles.insert(doc.strFile, nId);
+    m_vecDocs.push_back(std::move(doc));
+}
+
+void PlaylistIndex::RemoveDoc(uint32_t nId)
+{
+    IndexDoc &doc = m_vecDocs[nId];
+    if (--doc.nRefs > 0)
+    {
+        return;
+    }
+
+    //倒排表中的编号保留，查询时跳过
+    m_hashFiles.remove(doc.strFile);
+    doc.strFile.clear();
+    doc.strDisplay.clear();
+    doc.strMeta.clear();
+    doc.strText.clear();
+    m_nRemoved++;
+}
+
+void PlaylistIndex::Compact()
+{
+    std::vector<IndexDoc> vecDocs;
+    vecDocs.swap(m_vecDocs);
+    m_mapPostings.clear();
+    m_hashFiles.clear();
+    m_nRemoved = 0;
+
+    m_vecDocs.reserve(vecDocs.size() / 2);
+    for (IndexDoc &doc : vecDocs)
+    {
+        if (doc.nRefs > 0)
+        {
+            AddDoc(std::move(doc));
+        }
+    }
+}
+
+void PlaylistIndex::RunQuery(quint64 nSearchId, const QString &strQuery)
+{
+    QStringList listFiles;
+    QStringList listDisplays;
+    int nTotal = 0;
+
+    QStringList listWords;
+    for (const QString &strWord : strQuery.toLower().simplified().split(' '))
+    {
+        if (!strWord.isEmpty())
+        {
+            listWords.append(strWord);
+        }
+    }
+    if (listWords.isEmpty())
+    {
+        emit SigResults(nSearchId, listFiles, listDisplays, 0);
+        return;
+    }
+
+    //各词所有三字符的倒排表，任一不存在则无结果
+    std::vector<const std::vector<uint32_t>*> vecLists;
+    std::vector<uint64_t> vecKeys;
+    bool bMiss = false;
+    for (const QString &strWord : listWords)
+    {
+        Trigrams(strWord, vecKeys);
+        for (uint64_t nKey : vecKeys)
+        {
+            auto it = m_mapPostings.find(nKey);
+            if (it == m_mapPostings.end())
+            {
+                bMiss = true;
+                break;
+            }
+            vecLists.push_back(&it->second);
+        }
+        if (bMiss)
+        {
+            break;
+        }
+    }
+    if (bMiss)
+    {
+        emit SigResults(nSearchId, listFiles, listDisplays, 0);
+        return;
+    }
+
+    auto match = [&](uint32_t nId) {
+        const IndexDoc &doc = m_vecDocs[nId];
+        if (doc.nRefs <= 0)
+        {
+            return;
+        }
+        for (const QString &strWord : listWords)
+        {
+            if (!doc.strText.contains(strWord))
+            {
+                return;
+            }
+        }
+        if (nTotal++ < PLAYLIST_INDEX_MAX_RESULTS)
+        {
+            listFiles.append(doc.strFile);
+            listDisplays.append(doc.strDisplay);
+        }
+    };
+
+    if (vecLists.empty())
+    {
+        //所有词都不足三个字符，逐条扫描，有新查询时放弃
+        for (size_t i = 0; i < m_vecDocs.size(); i++)
+        {
+            if (i % PLAYLIST_INDEX_CANCEL_CHECK == 0 && i > 0)
+            {
+                std::lock_guard<std::mutex> lock(m_mutexOps);
+                if (m_nSearchId != nSearchId)
+                {
+                    return;
+                }
+            }
+            match((uint32_t)i);
+        }
+    }
+    else
+    {
+        std::sort(vecLists.begin(), vecLists.end(),
+            [](const std::vector<uint32_t> *a, const std::vector<uint32_t> *b) { return a->size() < b->size(); });
+        vecLists.erase(std::unique(vecLists.begin(), vecLists.end()), vecLists.end());
+
+        std::vector<uint32_t> vecCand(*vecLists[0]);
+        std::vector<uint32_t> vecTmp;
+        for (size_t i = 1; i < vecLists.size() && !vecCand.empty(); i++)
+        {
+            vecTmp.clear();
+            std::set_intersection(vecCand.begin(), vecCand.end(),
+                vecLists[i]->begin(), vecLists[i]->end(), std::back_inserter(vecTmp));
+            vecCand.swap(vecTmp);
+        }
+
+        //三字符都包含不代表包含整个词，逐条确认
+        for (uint32_t nId : vecCand)
+        {
+            match(nId);
+        }
+    }
+
+    emit SigResults(nSearchId, listFiles, listDisplays, nTotal);
+}
+
+QString PlaylistIndex::ProbeMeta(const QString &strFile)
+{
+    //只读取文件头，不调用 avformat_find_stream_info，大部分容器的流参数已在文件头中
+    AVFormatContext *ic = avformat_alloc_context();
+    QByteArray baFile = strFile.toUtf8();
+    if (!ic)
+    {
+        return QString();
+    }
+    ic->interrupt_callback.callback = InterruptCallback;
+    ic->interrupt_callback.opaque = this;
+    if (IoScheduler::OpenInput(&ic, baFile.constData(), IO_CLASS_PROBE) < 0)
+    {
+        return QString();
+    }
+
+    QStringList listMeta;
+    static const char *const pszKeys[] = { "title", "artist", "album_artist", "album", "genre" };
+    for (const char *pszKey : pszKeys)
+    {
+        AVDictionaryEntry *t = av_dict_get(ic->metadata, pszKey, nullptr, 0);
+        if (t && t->value[0])
+        {
+            listMeta.append(QString::fromUtf8(t->value));
+        }
+    }
+
+    for (unsigned int i = 0; i < ic->nb_streams; i++)
+    {
+        AVCodecParameters *par = ic->streams[i]->codecpar;
+        if (par->codec_id != AV_CODEC_ID_NONE)
+        {
+            listMeta.append(avcodec_get_name(par->codec_id));
+        }
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO && par->width > 0 && par->height > 0)
+        {
+            listMeta.append(QString("%1x%2 %3p").arg(par->width).arg(par->height).arg(par->height));
+        }
+    }
+
+    IoScheduler::CloseInput(&ic);
+
+    listMeta.removeDuplicates();
+    return listMeta.join(' ');
+}
+
+int PlaylistIndex::InterruptCallback(void *ctx)
+{
+    PlaylistIndex *pThis = (PlaylistIndex *)ctx;
+    return !pThis->m_bRunning;
+}
+
+void PlaylistIndex::Trigrams(const QString &strText, std::vector<uint64_t> &vecKeys)
+{
+    vecKeys.clear();
+    const ushort *p = strText.utf16();
+    for (int i = 0; i + 2 < strText.size(); i++)
+    {
+        vecKeys.push_back(((uint64_t)p[i] << 32) | ((uint64_t)p[i + 1] << 16) | p[i + 2]);
+    }
+    std::sort(vecKeys.begin(), vecKeys.end());
+    vecKeys.erase(std::unique(vecKeys.begin(), vecKeys.end()), vecKeys.end());
+}
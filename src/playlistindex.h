@@ -0,0 +1,132 @@
+﻿/*
+ * @file 	playlistindex.h
+ * @date 	2026/10/18 20:30
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	播放列表搜索索引
+ * @note	文件名、路径和探测到的元数据（标题、艺术家、编码、分辨率）转为小写后建三字符（trigram）倒排索引，
+ *			条目编号递增，倒排表天然有序。查询按空白拆词，取最短的倒排表与其余求交集，再逐条确认包含所有词。
+ *			建索引和查询在索引线程，元数据探测在另一个线程，界面线程只投递请求、接收结果。
+ */
+#ifndef PLAYLISTINDEX_H
+#define PLAYLISTINDEX_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#define PLAYLIST_INDEX_MAX_RESULTS 500      //每次查询最多返回的条目数
+#define PLAYLIST_INDEX_COMPACT_MIN 4096     //已删除条目超过该数且超过一半时重建索引
+
+class PlaylistIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistIndex(QObject *parent = nullptr);
+    ~PlaylistIndex();
+
+    /**
+     * @brief	添加条目，本地文件随后在后台探测元数据
+     *
+     * @param	strFile 文件完整路径或网络地址
+     * @param	strDisplay 列表中显示的文本
+     */
+    void Add(const QString &strFile, const QString &strDisplay);
+
+    /**
+     * @brief	删除条目，同一文件添加多次时需删除同样次数
+     */
+    void Remove(const QString &strFile);
+
+    void Clear();
+
+    /**
+     * @brief	提交查询，结果通过 SigResults 返回，之前未完成的查询被丢弃
+     *
+     * @param	strQuery 查询文本，空白分隔的多个词需全部匹配，不区分大小写
+     * @return	查询序号，与 SigResults 中的序号对应
+     */
+    quint64 Search(const QString &strQuery);
+
+signals:
+    //nTotal 为匹配总数，返回的条目最多 PLAYLIST_INDEX_MAX_RESULTS 个
+    void SigResults(quint64 nSearchId, QStringList listFiles, QStringList listDisplays, int nTotal);
+
+private:
+    enum IndexOpType
+    {
+        INDEX_OP_ADD,
+        INDEX_OP_REMOVE,
+        INDEX_OP_CLEAR,
+        INDEX_OP_META,
+    };
+
+    struct IndexOp
+    {
+        IndexOpType type;
+        QString strFile;
+        QString strText;            //< 显示文本或元数据
+    };
+
+    struct IndexDoc
+    {
+        QString strFile;
+        QString strDisplay;
+        QString strMeta;
+        QString strText;            //< 小写的全部可搜索文本
+        int nRefs;                  //< 0 表示已删除
+    };
+
+    void IndexThread();
+    void ProbeThread();
+
+    void ApplyOp(IndexOp &op);
+    void AddDoc(IndexDoc &&doc);
+    void RemoveDoc(uint32_t nId);
+    void Compact();
+    void RunQuery(quint64 nSearchId, const QString &strQuery);
+
+    //探测本地文件的元数据，失败返回空；读取经过 IoScheduler，析构时中止
+    QString ProbeMeta(const QString &strFile);
+    static int InterruptCallback(void *ctx);
+    static void Trigrams(const QString &strText, std::vector<uint64_t> &vecKeys);
+
+private:
+    std::atomic<bool> m_bRunning;
+
+    //界面线程投递的请求
+    std::mutex m_mutexOps;
+    std::condition_variable m_condOps;
+    std::deque<IndexOp> m_dequeOps;
+    quint64 m_nSearchId;            //< 最新查询序号
+    QString m_strQuery;             //< 最新查询，m_bQueryPending 时有效
+    bool m_bQueryPending;
+
+    //待探测的文件
+    std::mutex m_mutexProbe;
+    std::condition_variable m_condProbe;
+    std::deque<QString> m_dequeProbe;
+
+    //以下只在索引线程访问
+    std::vector<IndexDoc> m_vecDocs;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_mapPostings;
+    QHash<QString, uint32_t> m_hashFiles;   //< 文件 -> 当前条目编号
+    size_t m_nRemoved;
+
+    std::thread m_tIndexThread;
+    std::thread m_tProbeThread;
+};
+
+#endif // PLAYLISTINDEX_H
@@ -0,0 +1,660 @@
+﻿/*
+ * @file 	proxycache.cpp
+ * @date 	2026/10/19 14:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	重文件的代理文件缓存
+ * @note
+ */
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "proxycache.h"
+#include "ioscheduler.h"
+
+#pragma execution_character_set("utf-8")
+
+#define PROXY_SKIP 1
+#define PROXY_ABORTED 2
+#define PROXY_NICE 19               //Linux 下转码线程的 nice 值
+
+//转码用到的上下文
+typedef struct ProxyTranscoder {
+    AVCodecContext *dec;
+    AVCodecContext *enc;
+    struct SwsContext *sws;
+    AVFrame *frame;
+    AVFrame *scaled;
+    AVPacket *opkt;
+    AVFormatContext *oc;
+    AVStream *ost;
+    int64_t last_pts;
+} ProxyTranscoder;
+
+//编码一帧（frame 为 NULL 时冲刷编码器）并写入
+static int transcoder_encode(ProxyTranscoder *t, AVFrame *frame)
+{
+    AVFrame *scaled = NULL;
+    int ret;
+
+    if (frame) {
+        //没有时间戳的帧无法放到原位置，时间戳不递增的帧也丢弃
+        if (frame->best_effort_timestamp == AV_NOPTS_VALUE || frame->best_effort_timestamp <= t->last_pts)
+            return 0;
+        t->last_pts = frame->best_effort_timestamp;
+
+        t->sws = sws_getCachedContext(t->sws, frame->width, frame->height, (enum AVPixelFormat)frame->format,
+            t->enc->width, t->enc->height, t->enc->pix_fmt, SWS_BILINEAR, NULL, NULL, NULL);
+        if (!t->sws)
+            return AVERROR(EINVAL);
+
+        scaled = t->scaled;
+        av_frame_unref(scaled);
+        scaled->format = t->enc->pix_fmt;
+        scaled->width = t->enc->width;
+        scaled->height = t->enc->height;
+        if ((ret = av_frame_get_buffer(scaled, 0)) < 0)
+            return ret;
+        sws_scale(t->sws, (const uint8_t * const *)frame->data, frame->linesize, 0, frame->height,
+            scaled->data, scaled->linesize);
+        scaled->pts = frame->best_effort_timestamp;
+    }
+
+    ret = avcodec_send_frame(t->enc, scaled);
+    if (ret < 0)
+        return ret;
+    for (;;) {
+        ret = avcodec_receive_packet(t->enc, t->opkt);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+            return 0;
+        if (ret < 0)
+            return ret;
+        av_packet_rescale_ts(t->opkt, t->enc->time_base, t->ost->time_base);
+        t->opkt->stream_index = t->ost->index;
+        if ((ret = av_interleaved_write_frame(t->oc, t->opkt)) < 0)
+            return ret;
+    }
+}
+
+//解码一个数据包（pkt 为 NULL 时冲刷解码器），得到的帧缩放后编码
+static int transcoder_decode(ProxyTranscoder *t, const AVPacket *pkt)
+{
+    int ret;
+
+    ret = avcodec_send_packet(t->dec, pkt);
+    //损坏的数据包跳过
+    if (ret < 0 && ret != AVERROR_EOF && ret != AVERROR_INVALIDDATA)
+        return ret;
+    for (;;) {
+        ret = avcodec_receive_frame(t->dec, t->frame);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF || ret == AVERROR_INVALIDDATA)
+            return 0;
+        if (ret < 0)
+            return ret;
+        ret = transcoder_encode(t, t->frame);
+        av_frame_unref(t->frame);
+        if (ret < 0)
+            return ret;
+    }
+}
+
+//按顺序尝试可用的编码器：帧内编码的 MJPEG，其次短关键帧间隔的 H.264
+static AVCodecContext *proxy_open_encoder(AVCodecContext *dec, int width, int height, AVRational sar,
+    AVRational time_base, AVRational frame_rate, int global_header)
+{
+    const AVCodec *codecs[2];
+    AVCodecContext *enc;
+
+    codecs[0] = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    codecs[1] = avcodec_find_encoder(AV_CODEC_ID_H264);
+    for (int i = 0; i < 2; i++) {
+        const AVCodec *codec = codecs[i];
+        if (!codec || !codec->pix_fmts)
+            continue;
+        if (!(enc = avcodec_alloc_context3(codec)))
+            return NULL;
+
+        enc->width = width;
+        enc->height = height;
+        enc->sample_aspect_ratio = sar;
+        enc->time_base = time_base;
+        enc->framerate = frame_rate;
+        enc->color_primaries = dec->color_primaries;
+        enc->color_trc = dec->color_trc;
+        enc->colorspace = dec->colorspace;
+        //只用一个线程，限速按单线程计算
+        enc->thread_count = 1;
+        if (global_header)
+            enc->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        if (codec->id == AV_CODEC_ID_MJPEG) {
+            enc->pix_fmt = codec->pix_fmts[0];
+            enc->color_range = AVCOL_RANGE_JPEG;
+            enc->flags |= AV_CODEC_FLAG_QSCALE;
+            enc->global_quality = FF_QP2LAMBDA * PROXY_MJPEG_QSCALE;
+        } else {
+            enc->pix_fmt = AV_PIX_FMT_YUV420P;
+            enc->gop_size = PROXY_GOP_SIZE;
+            enc->max_b_frames = 0;
+            av_opt_set(enc->priv_data, "preset", "veryfast", 0);
+            av_opt_set(enc->priv_data, "tune", "fastdecode", 0);
+        }
+
+        if (avcodec_open2(enc, codec, NULL) >= 0)
+            return enc;
+        av_log(NULL, AV_LOG_VERBOSE, "Proxy: could not open encoder %s\n", codec->name);
+        avcodec_free_context(&enc);
+    }
+    return NULL;
+}
+
+ProxyCache::ProxyCache(QObject *parent) :
+    QObject(parent),
+    m_bRunning(true),
+    m_bEnabled(true),
+    m_bPlaybackActive(false),
+    m_bPreempt(false),
+    m_nOrder(0),
+    m_nRunningPriority(PROXY_PRIORITY_BACKGROUND)
+{
+
+}
+
+ProxyCache::~ProxyCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bRunning = false;
+    }
+    m_cond.notify_all();
+
+    if (m_tThread.joinable())
+    {
+        m_tThread.join();
+    }
+}
+
+void ProxyCache::SetEnabled(bool bEnabled)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bEnabled = bEnabled;
+        if (!bEnabled)
+        {
+            m_vecJobs.clear();
+            m_bPreempt = true;
+        }
+    }
+    m_cond.notify_all();
+}
+
+void ProxyCache::Request(const QString &strFile, int nPriority)
+{
+    if (!m_bEnabled || strFile.isEmpty() || strFile.indexOf("://") > 1)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_setSkipped.contains(strFile))
+        {
+            return;
+        }
+
+        //正在播放的文件只有一个
+        if (nPriority == PROXY_PRIORITY_PLAYING)
+        {
+            for (ProxyJob &job : m_vecJobs)
+            {
+                job.nPriority = PROXY_PRIORITY_BACKGROUND;
+            }
+            if (m_strRunning != strFile)
+            {
+                m_nRunningPriority = PROXY_PRIORITY_BACKGROUND;
+            }
+        }
+
+        if (m_strRunning == strFile)
+        {
+            m_nRunningPriority = std::max(m_nRunningPriority, nPriority);
+            return;
+        }
+
+        auto it = std::find_if(m_vecJobs.begin(), m_vecJobs.end(), [&strFile](const ProxyJob &job) {
+            return job.strFile == strFile;
+        });
+        if (it != m_vecJobs.end())
+        {
+            it->nPriority = std::max(it->nPriority, nPriority);
+        }
+        else
+        {
+            m_vecJobs.push_back({strFile, nPriority, m_nOrder++});
+        }
+
+        if (!m_strRunning.isEmpty() && nPriority > m_nRunningPriority)
+        {
+            m_bPreempt = true;
+        }
+
+        if (!m_tThread.joinable())
+        {
+            m_tThread = std::thread(&ProxyCache::WorkerThread, this);
+        }
+    }
+    m_cond.notify_all();
+}
+
+QString ProxyCache::Lookup(const QString &strFile)
+{
+    QString strProxy;
+
+    if (!m_bEnabled)
+    {
+        return QString();
+    }
+    strProxy = ProxyPath(strFile);
+    if (strProxy.isEmpty() || !QFileInfo::exists(strProxy))
+    {
+        return QString();
+    }
+    return strProxy;
+}
+
+void ProxyCache::SetPlaybackActive(bool bActive)
+{
+    m_bPlaybackActive = bActive;
+}
+
+bool ProxyCache::IsHeavy(AVFormatContext *ic, AVStream *st)
+{
+    AVCodecParameters *par = st->codecpar;
+    int64_t nBitRate = par->bit_rate > 0 ? par->bit_rate : ic->bit_rate;
+
+    return FFMIN(par->width, par->height) > PROXY_HEAVY_SIZE || nBitRate > PROXY_HEAVY_BIT_RATE;
+}
+
+void ProxyCache::WorkerThread()
+{
+    //降低转码线程的调度优先级，不影响播放和界面
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), PROXY_NICE);
+#endif
+
+    //上次退出时未完成的文件
+    QDir dirCache(CacheDir());
+    for (const QFileInfo &fi : dirCache.entryInfoList(QStringList("*.part"), QDir::Files))
+    {
+        QFile::remove(fi.absoluteFilePath());
+    }
+
+    while (m_bRunning)
+    {
+        ProxyJob job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] {
+                return !m_bRunning || (m_bEnabled && !m_vecJobs.empty());
+            });
+            if (!m_bRunning)
+            {
+                break;
+            }
+
+            auto it = std::min_element(m_vecJobs.begin(), m_vecJobs.end(), [](const ProxyJob &a, const ProxyJob &b) {
+                return a.nPriority != b.nPriority ? a.nPriority > b.nPriority : a.nOrder < b.nOrder;
+            });
+            job = *it;
+            m_vecJobs.erase(it);
+            m_strRunning = job.strFile;
+            m_nRunningPriority = job.nPriority;
+            m_bPreempt = false;
+        }
+
+        int ret = Process(job.strFile);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            //被更高优先级的请求中止，稍后从头再转
+            if (ret == PROXY_ABORTED && m_bRunning && m_bEnabled)
+            {
+                m_vecJobs.push_back({job.strFile, m_nRunningPriority, job.nOrder});
+            }
+            else if (ret != 0 && ret != PROXY_ABORTED)
+            {
+                m_setSkipped.insert(job.strFile);
+            }
+            m_strRunning.clear();
+        }
+
+        if (ret == 0)
+        {
+            emit SigProxyReady(job.strFile);
+        }
+    }
+}
+
+int ProxyCache::Process(const QString &strFile)
+{
+    QString strOut = ProxyPath(strFile);
+    QString strPart = strOut + ".part";
+    int ret;
+
+    if (strOut.isEmpty())
+    {
+        return PROXY_SKIP;
+    }
+
+    //已有代理，更新修改时间，删除时按最久未用
+    if (QFileInfo::exists(strOut))
+    {
+        QFile file(strOut);
+        if (file.open(QIODevice::ReadWrite))
+        {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+        return 0;
+    }
+
+    if (!QDir().mkpath(CacheDir()))
+    {
+        av_log(NULL, AV_LOG_ERROR, "Proxy: could not create %s\n", CacheDir().toUtf8().constData());
+        return AVERROR(EIO);
+    }
+
+    int64_t nStart = av_gettime_relative();
+    ret = Transcode(strFile, strPart);
+    if (ret == 0 && !QFile::rename(strPart, strOut))
+    {
+        ret = AVERROR(EIO);
+    }
+    if (ret != 0)
+    {
+        QFile::remove(strPart);
+        if (ret < 0)
+        {
+            av_log(NULL, AV_LOG_WARNING, "Proxy: failed to create a proxy for %s\n", strFile.toUtf8().constData());
+        }
+        return ret;
+    }
+
+    av_log(NULL, AV_LOG_INFO, "Proxy: created %s for %s in %.1f s\n", strOut.toUtf8().constData(),
+        strFile.toUtf8().constData(), (av_gettime_relative() - nStart) / 1000000.0);
+    Evict(strOut);
+    return 0;
+}
+
+int ProxyCache::Transcode(const QString &strFile, const QString &strOut)
+{
+    AVFormatContext *ic = NULL;
+    ProxyTranscoder t = {};
+    const AVCodec *codec;
+    AVStream *ist, *ast = NULL, *oast = NULL;
+    AVPacket *pkt = NULL;
+    AVRational sar;
+    uint8_t *sd;
+    size_t sd_size;
+    int video_index, audio_index;
+    int src_w, src_h, out_w, out_h;
+    int64_t nBusyStart;
+    int ret;
+
+    t.last_pts = AV_NOPTS_VALUE;
+
+    if (!(ic = avformat_alloc_context()))
+        return AVERROR(ENOMEM);
+    ic->interrupt_callback.callback = InterruptCallback;
+    ic->interrupt_callback.opaque = this;
+    if ((ret = IoScheduler::OpenInput(&ic, strFile.toUtf8().constData(), IO_CLASS_PROXY)) < 0)
+        goto end;
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0)
+        goto end;
+
+    video_index = av_find_best_stream(ic, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+    if (video_index < 0 || (ic->streams[video_index]->disposition & AV_DISPOSITION_ATTACHED_PIC) ||
+        !IsHeavy(ic, ic->streams[video_index])) {
+        ret = PROXY_SKIP;
+        goto end;
+    }
+    ist = ic->streams[video_index];
+    audio_index = av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO, -1, video_index, NULL, 0);
+    if (audio_index >= 0)
+        ast = ic->streams[audio_index];
+    for (unsigned int i = 0; i < ic->nb_streams; i++)
+        ic->streams[i]->discard = ((int)i == video_index || (int)i == audio_index) ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+
+    //解码器
+    if (!(codec = avcodec_find_decoder(ist->codecpar->codec_id))) {
+        ret = AVERROR_DECODER_NOT_FOUND;
+        goto end;
+    }
+    if (!(t.dec = avcodec_alloc_context3(codec))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if ((ret = avcodec_parameters_to_context(t.dec, ist->codecpar)) < 0)
+        goto end;
+    t.dec->pkt_timebase = ist->time_base;
+    t.dec->thread_count = 1;
+    if ((ret = avcodec_open2(t.dec, codec, NULL)) < 0)
+        goto end;
+
+    //输出，短边缩到 PROXY_SIZE，宽高取偶数，像素宽高比随缩放调整
+    if ((ret = avformat_alloc_output_context2(&t.oc, NULL, "matroska", strOut.toUtf8().constData())) < 0)
+        goto end;
+    src_w = ist->codecpar->width;
+    src_h = ist->codecpar->height;
+    if (src_w <= 0 || src_h <= 0) {
+        ret = AVERROR_INVALIDDATA;
+        goto end;
+    }
+    if (src_w >= src_h) {
+        out_h = FFMIN(PROXY_SIZE, src_h) & ~1;
+        out_w = (int)(av_rescale(src_w, out_h, src_h) + 1) & ~1;
+    } else {
+        out_w = FFMIN(PROXY_SIZE, src_w) & ~1;
+        out_h = (int)(av_rescale(src_h, out_w, src_w) + 1) & ~1;
+    }
+    sar = av_guess_sample_aspect_ratio(ic, ist, NULL);
+    if (!sar.num)
+        sar = { 1, 1 };
+    av_reduce(&sar.num, &sar.den, (int64_t)sar.num * src_w * out_h, (int64_t)sar.den * src_h * out_w, INT_MAX);
+
+    t.enc = proxy_open_encoder(t.dec, out_w, out_h, sar, ist->time_base, av_guess_frame_rate(ic, ist, NULL),
+        t.oc->oformat->flags & AVFMT_GLOBALHEADER);
+    if (!t.enc) {
+        av_log(NULL, AV_LOG_WARNING, "Proxy: no usable MJPEG or H.264 encoder\n");
+        ret = AVERROR_ENCODER_NOT_FOUND;
+        goto end;
+    }
+
+    if (!(t.ost = avformat_new_stream(t.oc, NULL))) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    if ((ret = avcodec_parameters_from_context(t.ost->codecpar, t.enc)) < 0)
+        goto end;
+    t.ost->time_base = t.enc->time_base;
+    t.ost->sample_aspect_ratio = t.enc->sample_aspect_ratio;
+    //保留旋转
+    sd = av_stream_get_side_data(ist, AV_PKT_DATA_DISPLAYMATRIX, &sd_size);
+    if (sd) {
+        uint8_t *dst = av_stream_new_side_data(t.ost, AV_PKT_DATA_DISPLAYMATRIX, sd_size);
+        if (dst)
+            memcpy(dst, sd, sd_size);
+    }
+
+    //音频原样复制，容器放不下时不生成代理，避免切换后没有声音
+    if (ast) {
+        if (avformat_query_codec(t.oc->oformat, ast->codecpar->codec_id, FF_COMPLIANCE_NORMAL) != 1) {
+            av_log(NULL, AV_LOG_WARNING, "Proxy: audio codec %s cannot be copied\n", avcodec_get_name(ast->codecpar->codec_id));
+            ret = AVERROR_PATCHWELCOME;
+            goto end;
+        }
+        if (!(oast = avformat_new_stream(t.oc, NULL))) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        if ((ret = avcodec_parameters_copy(oast->codecpar, ast->codecpar)) < 0)
+            goto end;
+        oast->codecpar->codec_tag = 0;
+        oast->time_base = ast->time_base;
+    }
+
+    if ((ret = avio_open(&t.oc->pb, strOut.toUtf8().constData(), AVIO_FLAG_WRITE)) < 0)
+        goto end;
+    if ((ret = avformat_write_header(t.oc, NULL)) < 0)
+        goto end;
+
+    pkt = av_packet_alloc();
+    t.opkt = av_packet_alloc();
+    t.frame = av_frame_alloc();
+    t.scaled = av_frame_alloc();
+    if (!pkt || !t.opkt || !t.frame || !t.scaled) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    nBusyStart = av_gettime_relative();
+    for (;;) {
+        if (IsAborted()) {
+            ret = PROXY_ABORTED;
+            goto end;
+        }
+        ret = av_read_frame(ic, pkt);
+        if (ret == AVERROR_EOF)
+            break;
+        if (ret < 0)
+            goto end;
+
+        if (pkt->stream_index == audio_index) {
+            av_packet_rescale_ts(pkt, ast->time_base, oast->time_base);
+            pkt->stream_index = oast->index;
+            pkt->pos = -1;
+            ret = av_interleaved_write_frame(t.oc, pkt);
+        } else if (pkt->stream_index == video_index) {
+            ret = transcoder_decode(&t, pkt);
+            Throttle(nBusyStart);
+        }
+        av_packet_unref(pkt);
+        if (ret < 0)
+            goto end;
+    }
+
+    if ((ret = transcoder_decode(&t, NULL)) < 0 || (ret = transcoder_encode(&t, NULL)) < 0)
+        goto end;
+    ret = av_write_trailer(t.oc);
+
+end:
+    if (ret < 0 && ret != AVERROR_EXIT)
+        av_log(NULL, AV_LOG_WARNING, "Proxy: %s: error %d\n", strFile.toUtf8().constData(), ret);
+    //中断回调使读取返回 AVERROR_EXIT
+    if (ret == AVERROR_EXIT)
+        ret = PROXY_ABORTED;
+    av_packet_free(&pkt);
+    av_packet_free(&t.opkt);
+    av_frame_free(&t.frame);
+    av_frame_free(&t.scaled);
+    sws_freeContext(t.sws);
+    avcodec_free_context(&t.dec);
+    avcodec_free_context(&t.enc);
+    if (t.oc) {
+        avio_closep(&t.oc->pb);
+        avformat_free_context(t.oc);
+    }
+    IoScheduler::CloseInput(&ic);
+    return ret;
+}
+
+void ProxyCache::Throttle(int64_t &nBusyStart)
+{
+    double dShare = m_bPlaybackActive ? PROXY_CPU_SHARE_PLAYING : PROXY_CPU_SHARE_IDLE;
+    int64_t nBusy = av_gettime_relative() - nBusyStart;
+    int64_t nSleep = (int64_t)(nBusy * (1.0 - dShare) / dShare);
+
+    //中止、退出时立即返回
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait_for(lock, std::chrono::microseconds(nSleep), [this] {
+        return IsAborted();
+    });
+    lock.unlock();
+
+    nBusyStart = av_gettime_relative();
+}
+
+bool ProxyCache::IsAborted()
+{
+    return !m_bRunning || !m_bEnabled || m_bPreempt;
+}
+
+void ProxyCache::Evict(const QString &strKeep)
+{
+    QDir dirCache(CacheDir());
+    //按修改时间从新到旧
+    QFileInfoList listFiles = dirCache.entryInfoList(QStringList("*.mkv"), QDir::Files, QDir::Time);
+    int64_t nTotal = 0;
+
+    for (const QFileInfo &fi : listFiles)
+    {
+        nTotal += fi.size();
+        if (nTotal > PROXY_CACHE_LIMIT && fi.absoluteFilePath() != QFileInfo(strKeep).absoluteFilePath())
+        {
+            av_log(NULL, AV_LOG_INFO, "Proxy: evicting %s\n", fi.absoluteFilePath().toUtf8().constData());
+            QFile::remove(fi.absoluteFilePath());
+            nTotal -= fi.size();
+        }
+    }
+}
+
+int ProxyCache::InterruptCallback(void *ctx)
+{
+    ProxyCache *pCache = (ProxyCache *)ctx;
+    return pCache->IsAborted();
+}
+
+QString ProxyCache::CacheDir()
+{
+    QString strDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (strDir.isEmpty())
+    {
+        strDir = QDir::tempPath() + "/playerdemo";
+    }
+    return strDir + "/proxy";
+}
+
+QString ProxyCache::ProxyPath(const QString &strFile)
+{
+    QFileInfo fi(strFile);
+    QByteArray baKey;
+
+    if (strFile.indexOf("://") > 1 || !fi.isFile())
+    {
+        return QString();
+    }
+
+    //文件被替换或修改后对应新的代理
+    baKey = fi.absoluteFilePath().toUtf8();
+    baKey += '\n' + QByteArray::number(fi.size());
+    baKey += '\n' + QByteArray::number(fi.lastModified().toMSecsSinceEpoch());
+    return CacheDir() + "/" + QCryptographicHash::hash(baKey, QCryptographicHash::Sha1).toHex().left(20) + ".mkv";
+}
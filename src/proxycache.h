@@ -0,0 +1,122 @@
+﻿/*
+ * @file 	proxycache.h
+ * @date 	2026/10/19 14:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	重文件的代理文件缓存
+ * @note	8K、ProRes 等高分辨率、高码率文件在小窗口播放和拖动进度条时解码代价很高。
+ *			后台线程把这类文件转为短边 540 的帧内编码代理（优先 MJPEG，没有时用短关键帧间隔的 H.264），
+ *			音频原样复制，时间戳与原文件一致，播放时可在相同位置切换。
+ *			代理存放在缓存目录，按原文件路径、大小、修改时间命名，超过容量时删除最久未用的。
+ *			转码线程降低优先级，按占空比限制 CPU 占用，播放时占用更少；正在播放的文件优先。
+ */
+#ifndef PROXYCACHE_H
+#define PROXYCACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+#include "globalhelper.h"
+
+#define PROXY_SIZE 540                      //代理的短边（像素）
+#define PROXY_HEAVY_SIZE 1440               //视频短边超过该值视为重文件
+#define PROXY_HEAVY_BIT_RATE 60000000       //视频码率超过该值视为重文件（bit/s）
+#define PROXY_MJPEG_QSCALE 5                //MJPEG 代理的量化参数
+#define PROXY_GOP_SIZE 6                    //H.264 代理的关键帧间隔
+#define PROXY_CPU_SHARE_PLAYING 0.25        //播放时转码线程占用一个核的比例
+#define PROXY_CPU_SHARE_IDLE 0.75           //未播放时转码线程占用一个核的比例
+#define PROXY_CACHE_LIMIT (8LL << 30)       //缓存目录容量（字节）
+
+enum ProxyPriority {
+    PROXY_PRIORITY_BACKGROUND,      //之前播放过的文件
+    PROXY_PRIORITY_PLAYING          //正在播放的文件
+};
+
+class ProxyCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProxyCache(QObject *parent = nullptr);
+    ~ProxyCache();
+
+    void SetEnabled(bool bEnabled);
+
+    /**
+     * @brief	请求生成代理，后台探测是否为重文件，不是则忽略
+     *
+     * @param	strFile 本地文件完整路径，网络地址忽略
+     * @param	nPriority 优先级（ProxyPriority），正在播放的文件只有一个，之前的降为后台
+     */
+    void Request(const QString &strFile, int nPriority);
+
+    /**
+     * @brief	取已生成的代理
+     *
+     * @return	代理文件路径，没有时为空
+     */
+    QString Lookup(const QString &strFile);
+
+    //是否正在播放，决定转码线程的 CPU 占用
+    void SetPlaybackActive(bool bActive);
+
+    /**
+     * @brief	是否为重文件
+     *
+     * @param	ic 已探测流信息的文件
+     * @param	st 视频流
+     */
+    static bool IsHeavy(AVFormatContext *ic, AVStream *st);
+
+signals:
+    //代理已生成，strFile 为原文件
+    void SigProxyReady(QString strFile);
+
+private:
+    struct ProxyJob
+    {
+        QString strFile;
+        int nPriority;
+        uint64_t nOrder;            //< 请求顺序，同优先级先请求的先转
+    };
+
+    void WorkerThread();
+    //生成一个文件的代理，返回 0 成功，PROXY_SKIP 不需要代理，PROXY_ABORTED 被中止，负值错误
+    int Process(const QString &strFile);
+    int Transcode(const QString &strFile, const QString &strOut);
+    //按占空比睡眠，nBusyStart 为本次工作开始的时间，返回后更新
+    void Throttle(int64_t &nBusyStart);
+    bool IsAborted();
+    void Evict(const QString &strKeep);
+
+    static int InterruptCallback(void *ctx);
+    static QString CacheDir();
+    static QString ProxyPath(const QString &strFile);
+
+private:
+    std::atomic<bool> m_bRunning;
+    std::atomic<bool> m_bEnabled;
+    std::atomic<bool> m_bPlaybackActive;
+    std::atomic<bool> m_bPreempt;       //< 有优先级更高的请求，中止当前转码
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<ProxyJob> m_vecJobs;
+    uint64_t m_nOrder;
+    QString m_strRunning;               //< 正在转码的文件
+    int m_nRunningPriority;
+    QSet<QString> m_setSkipped;         //< 不需要代理或转码失败的文件，不再重试
+
+    std::thread m_tThread;              //< 第一次请求时启动
+};
+
+#endif // PROXYCACHE_H
@@ -0,0 +1,1030 @@
+﻿/*
+ * @file 	qtrender.cpp
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	Qt 画面输出
+ * @note
+ */
+
+#include <cmath>
+#include <utility>
+
+#include <QElapsedTimer>
+#include <QGenericMatrix>
+#include <QMetaObject>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLWidget>
+#include <QPainter>
+#include <QResizeEvent>
+
+#include "qtrender.h"
+#include "framepool.h"
+
+#pragma execution_character_set("utf-8")
+
+QtRenderScene::QtRenderScene() :
+    frame(nullptr),
+    prescaled(false),
+    video_serial(0),
+    has_video(false),
+    rotation(0),
+    flip(0),
+    subtitle_serial(0),
+    has_subtitle(false),
+    overlay_serial(0),
+    has_overlay(false)
+{
+    memset(&src, 0, sizeof(src));
+    memset(&dst, 0, sizeof(dst));
+    memset(&sub_src, 0, sizeof(sub_src));
+    memset(&sub_dst, 0, sizeof(sub_dst));
+    memset(&overlay_dst, 0, sizeof(overlay_dst));
+}
+
+QtRenderScene::~QtRenderScene()
+{
+    av_frame_free(&frame);
+}
+
+//顶点为输出上的像素坐标，绘制时换算为标准化设备坐标
+static const char *s_szVertexShader =
+    "attribute highp vec2 a_pos;\n"
+    "attribute highp vec2 a_tex;\n"
+    "uniform highp vec2 u_size;\n"
+    "varying highp vec2 v_tex;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(a_pos.x * 2.0 / u_size.x - 1.0, 1.0 - a_pos.y * 2.0 / u_size.y, 0.0, 1.0);\n"
+    "    v_tex = a_tex;\n"
+    "}\n";
+
+//纹理宽为行跨度，按各平面的有效宽度比例取样
+static const char *s_szYuvShader =
+    "uniform sampler2D u_tex_y;\n"
+    "uniform sampler2D u_tex_u;\n"
+    "uniform sampler2D u_tex_v;\n"
+    "uniform mediump vec3 u_scale;\n"
+    "uniform mediump mat3 u_matrix;\n"
+    "uniform mediump vec3 u_offset;\n"
+    "varying highp vec2 v_tex;\n"
+    "void main() {\n"
+    "    mediump vec3 yuv;\n"
+    "    yuv.x = texture2D(u_tex_y, vec2(v_tex.x * u_scale.x, v_tex.y)).r;\n"
+    "    yuv.y = texture2D(u_tex_u, vec2(v_tex.x * u_scale.y, v_tex.y)).r;\n"
+    "    yuv.z = texture2D(u_tex_v, vec2(v_tex.x * u_scale.z, v_tex.y)).r;\n"
+    "    gl_FragColor = vec4(clamp(u_matrix * (yuv - u_offset), 0.0, 1.0), 1.0);\n"
+    "}\n";
+
+//BGRA 内存按 RGBA 上传（GLES 没有 GL_BGRA），取样时交换
+static const char *s_szRgbShader =
+    "uniform sampler2D u_tex;\n"
+    "varying highp vec2 v_tex;\n"
+    "void main() {\n"
+    "    gl_FragColor = texture2D(u_tex, v_tex).bgra;\n"
+    "}\n";
+
+// OpenGL 绘制，铺满 QtRenderWidget
+class QtRenderGlView : public QOpenGLWidget, protected QOpenGLFunctions
+{
+public:
+    explicit QtRenderGlView(QtRenderWidget *pOwner) :
+        QOpenGLWidget(pOwner),
+        m_pOwner(pOwner),
+        m_nVideoSerial(0),
+        m_bVideoYuv(false),
+        m_nSubtitleSerial(0),
+        m_nOverlaySerial(0),
+        m_bStatPending(false)
+    {
+        memset(m_nTextures, 0, sizeof(m_nTextures));
+        memset(m_nTexW, 0, sizeof(m_nTexW));
+        memset(m_nTexH, 0, sizeof(m_nTexH));
+        memset(&m_stPendingStat, 0, sizeof(m_stPendingStat));
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+
+        //paintGL 只画到离屏缓冲，合成到窗口并交换后才算显示
+        connect(this, &QOpenGLWidget::frameSwapped, [this]() {
+            if (m_bStatPending)
+            {
+                m_bStatPending = false;
+                m_stPendingStat.presented_time = av_gettime_relative();
+                m_pOwner->AddPaintStat(m_stPendingStat);
+            }
+        });
+    }
+
+    ~QtRenderGlView()
+    {
+        //纹理属于本控件的上下文
+        makeCurrent();
+        if (m_nTextures[0])
+        {
+            glDeleteTextures(TEXTURE_NB, m_nTextures);
+        }
+        m_stYuvProgram.removeAllShaders();
+        m_stRgbProgram.removeAllShaders();
+        doneCurrent();
+    }
+
+protected:
+    void initializeGL()
+    {
+        GLint nMaxSize = 0;
+
+        initializeOpenGLFunctions();
+        glGenTextures(TEXTURE_NB, m_nTextures);
+        for (int i = 0; i < TEXTURE_NB; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, m_nTextures[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &nMaxSize);
+        m_pOwner->SetMaxTextureSize(nMaxSize);
+
+        if (!BuildProgram(m_stYuvProgram, s_szYuvShader) || !BuildProgram(m_stRgbProgram, s_szRgbShader))
+        {
+            av_log(NULL, AV_LOG_ERROR, "Qt render: failed to build shaders\n");
+        }
+        //上下文重建后重新上传
+        m_nVideoSerial = 0;
+        m_nSubtitleSerial = 0;
+        m_nOverlaySerial = 0;
+        memset(m_nTexW, 0, sizeof(m_nTexW));
+        memset(m_nTexH, 0, sizeof(m_nTexH));
+    }
+
+    void paintGL()
+    {
+        std::shared_ptr<QtRenderScene> pScene = m_pOwner->Scene();
+        QElapsedTimer timer;
+        timer.start();
+
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        if (pScene && pScene->has_video && m_stYuvProgram.isLinked())
+        {
+            if (pScene->video_serial != m_nVideoSerial)
+            {
+                UploadVideo(pScene.get());
+                m_nVideoSerial = pScene->video_serial;
+            }
+            DrawVideo(pScene.get());
+        }
+        if (pScene && pScene->has_subtitle && !pScene->subtitle.isNull() && m_stRgbProgram.isLinked())
+        {
+            if (pScene->subtitle_serial != m_nSubtitleSerial)
+            {
+                UploadImage(TEXTURE_SUBTITLE, pScene->subtitle);
+                m_nSubtitleSerial = pScene->subtitle_serial;
+            }
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            DrawQuad(m_stRgbProgram, TEXTURE_SUBTITLE, pScene->sub_src, pScene->sub_dst,
+                pScene->subtitle.width(), pScene->subtitle.height(), 0, 0);
+            glDisable(GL_BLEND);
+        }
+        if (pScene && pScene->has_overlay && !pScene->overlay.isNull() && m_stRgbProgram.isLinked())
+        {
+            SDL_Rect src = { 0, 0, pScene->overlay.width(), pScene->overlay.height() };
+            if (pScene->overlay_serial != m_nOverlaySerial)
+            {
+                UploadImage(TEXTURE_OVERLAY, pScene->overlay);
+                m_nOverlaySerial = pScene->overlay_serial;
+            }
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            DrawQuad(m_stRgbProgram, TEXTURE_OVERLAY, src, pScene->overlay_dst, src.w, src.h, 0, 0);
+            glDisable(GL_BLEND);
+        }
+
+        if (m_pOwner->IsCollectingStats())
+        {
+            //计入 GPU 完成绘制的时间，显示时间在 frameSwapped 时记录
+            glFinish();
+            m_stPendingStat.paint_ms = timer.nsecsElapsed() / 1e6;
+            m_stPendingStat.video_serial = pScene && pScene->has_video ? pScene->video_serial : 0;
+            m_bStatPending = true;
+        }
+    }
+
+private:
+    enum {
+        TEXTURE_Y,
+        TEXTURE_U,
+        TEXTURE_V,
+        TEXTURE_RGB,
+        TEXTURE_SUBTITLE,
+        TEXTURE_OVERLAY,
+        TEXTURE_NB
+    };
+
+    bool BuildProgram(QOpenGLShaderProgram &program, const char *szFragment)
+    {
+        program.removeAllShaders();
+        if (!program.addShaderFromSourceCode(QOpenGLShader::Vertex, s_szVertexShader) ||
+            !program.addShaderFromSourceCode(QOpenGLShader::Fragment, szFragment))
+        {
+            return false;
+        }
+        program.bindAttributeLocation("a_pos", 0);
+        program.bindAttributeLocation("a_tex", 1);
+        return program.link();
+    }
+
+    //单通道纹理，宽为行跨度
+    void UploadPlane(int nIndex, const uint8_t *pData, int nLinesize, int nHeight)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_nTextures[nIndex]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (m_nTexW[nIndex] != nLinesize || m_nTexH[nIndex] != nHeight)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, nLinesize, nHeight, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, pData);
+            m_nTexW[nIndex] = nLinesize;
+            m_nTexH[nIndex] = nHeight;
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, nLinesize, nHeight, GL_LUMINANCE, GL_UNSIGNED_BYTE, pData);
+        }
+    }
+
+    void UploadImage(int nIndex, const QImage &image)
+    {
+        glBindTexture(GL_TEXTURE_2D, m_nTextures[nIndex]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (m_nTexW[nIndex] != image.width() || m_nTexH[nIndex] != image.height())
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+            m_nTexW[nIndex] = image.width();
+            m_nTexH[nIndex] = image.height();
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width(), image.height(), GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+        }
+    }
+
+    void UploadVideo(const QtRenderScene *pScene)
+    {
+        if (pScene->frame)
+        {
+            const AVFrame *frame = pScene->frame;
+            int nChromaH = AV_CEIL_RSHIFT(frame->height, 1);
+            UploadPlane(TEXTURE_Y, frame->data[0], frame->linesize[0], frame->height);
+            UploadPlane(TEXTURE_U, frame->data[1], frame->linesize[1], nChromaH);
+            UploadPlane(TEXTURE_V, frame->data[2], frame->linesize[2], nChromaH);
+            SetYuvMatrix(frame);
+            m_bVideoYuv = true;
+        }
+        else
+        {
+            UploadImage(TEXTURE_RGB, pScene->image);
+            m_bVideoYuv = false;
+        }
+    }
+
+    //BT.709（高清）或 BT.601，有限或完整范围
+    void SetYuvMatrix(const AVFrame *frame)
+    {
+        bool b709 = frame->colorspace == AVCOL_SPC_BT709 ||
+            (frame->colorspace == AVCOL_SPC_UNSPECIFIED && frame->height > 576);
+        bool bFull = frame->color_range == AVCOL_RANGE_JPEG;
+        float kr = b709 ? 0.2126f : 0.299f;
+        float kb = b709 ? 0.0722f : 0.114f;
+        float kg = 1.0f - kr - kb;
+        float ys = bFull ? 1.0f : 255.0f / 219.0f;
+        float cs = bFull ? 1.0f : 255.0f / 224.0f;
+        float values[9] = {
+            ys, 0.0f, 2.0f * (1.0f - kr) * cs,
+            ys, -2.0f * (1.0f - kb) * kb / kg * cs, -2.0f * (1.0f - kr) * kr / kg * cs,
+            ys, 2.0f * (1.0f - kb) * cs, 0.0f
+        };
+        int chroma_w = AV_CEIL_RSHIFT(frame->width, 1);
+
+        m_stYuvProgram.bind();
+        m_stYuvProgram.setUniformValue("u_matrix", QMatrix3x3(values));
+        m_stYuvProgram.setUniformValue("u_offset", bFull ? 0.0f : 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f);
+        m_stYuvProgram.setUniformValue("u_scale",
+            (float)frame->width / frame->linesize[0],
+            (float)chroma_w / frame->linesize[1],
+            (float)chroma_w / frame->linesize[2]);
+        m_stYuvProgram.release();
+    }
+
+    void DrawVideo(const QtRenderScene *pScene)
+    {
+        if (m_bVideoYuv)
+        {
+            m_stYuvProgram.bind();
+            for (int i = 0; i < 3; i++)
+            {
+                glActiveTexture(GL_TEXTURE0 + i);
+                glBindTexture(GL_TEXTURE_2D, m_nTextures[TEXTURE_Y + i]);
+            }
+            m_stYuvProgram.setUniformValue("u_tex_y", 0);
+            m_stYuvProgram.setUniformValue("u_tex_u", 1);
+            m_stYuvProgram.setUniformValue("u_tex_v", 2);
+            glActiveTexture(GL_TEXTURE0);
+            DrawQuad(m_stYuvProgram, -1, pScene->src, pScene->dst,
+                pScene->frame->width, pScene->frame->height, pScene->rotation, pScene->flip);
+        }
+        else if (pScene->prescaled)
+        {
+            //已缩放到 dst 大小，整幅绘制
+            SDL_Rect src = { 0, 0, pScene->image.width(), pScene->image.height() };
+            DrawQuad(m_stRgbProgram, TEXTURE_RGB, src, pScene->dst,
+                pScene->image.width(), pScene->image.height(), pScene->rotation, pScene->flip);
+        }
+        else
+        {
+            DrawQuad(m_stRgbProgram, TEXTURE_RGB, pScene->src, pScene->dst,
+                pScene->image.width(), pScene->image.height(), pScene->rotation, pScene->flip);
+        }
+    }
+
+    /**
+     * @param	nTexture 绑定到 0 号纹理单元的纹理，-1 表示已绑定
+     * @param	nTexW 取样区域对应的宽（纹理坐标 0~1）
+     */
+    void DrawQuad(QOpenGLShaderProgram &program, int nTexture, const SDL_Rect &src, const SDL_Rect &dst,
+        int nTexW, int nTexH, double rotation, int flip)
+    {
+        qreal dpr = devicePixelRatioF();
+        float cx = dst.x + dst.w / 2.0f;
+        float cy = dst.y + dst.h / 2.0f;
+        float s = (float)sin(rotation * M_PI / 180);
+        float c = (float)cos(rotation * M_PI / 180);
+        float u0 = (float)src.x / nTexW, u1 = (float)(src.x + src.w) / nTexW;
+        float v0 = (float)src.y / nTexH, v1 = (float)(src.y + src.h) / nTexH;
+        //左上、右上、左下、右下
+        float corners[4][2] = {
+            { -dst.w / 2.0f, -dst.h / 2.0f }, { dst.w / 2.0f, -dst.h / 2.0f },
+            { -dst.w / 2.0f, dst.h / 2.0f }, { dst.w / 2.0f, dst.h / 2.0f }
+        };
+        GLfloat pos[8];
+        GLfloat tex[8];
+
+        if (flip & SDL_FLIP_HORIZONTAL)
+            std::swap(u0, u1);
+        if (flip & SDL_FLIP_VERTICAL)
+            std::swap(v0, v1);
+        //y 轴向下，按屏幕顺时针旋转
+        for (int i = 0; i < 4; i++)
+        {
+            pos[i * 2] = cx + corners[i][0] * c - corners[i][1] * s;
+            pos[i * 2 + 1] = cy + corners[i][0] * s + corners[i][1] * c;
+        }
+        tex[0] = u0; tex[1] = v0;
+        tex[2] = u1; tex[3] = v0;
+        tex[4] = u0; tex[5] = v1;
+        tex[6] = u1; tex[7] = v1;
+
+        program.bind();
+        if (nTexture >= 0)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, m_nTextures[nTexture]);
+            program.setUniformValue("u_tex", 0);
+        }
+        program.setUniformValue("u_size", (float)(width() * dpr), (float)(height() * dpr));
+        program.enableAttributeArray(0);
+        program.enableAttributeArray(1);
+        program.setAttributeArray(0, GL_FLOAT, pos, 2);
+        program.setAttributeArray(1, GL_FLOAT, tex, 2);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        program.disableAttributeArray(0);
+        program.disableAttributeArray(1);
+        program.release();
+    }
+
+private:
+    QtRenderWidget *m_pOwner;
+
+    QOpenGLShaderProgram m_stYuvProgram;
+    QOpenGLShaderProgram m_stRgbProgram;
+    GLuint m_nTextures[TEXTURE_NB];
+    int m_nTexW[TEXTURE_NB];
+    int m_nTexH[TEXTURE_NB];
+
+    quint64 m_nVideoSerial;             //< 已上传的画面
+    bool m_bVideoYuv;
+    quint64 m_nSubtitleSerial;
+    quint64 m_nOverlaySerial;
+
+    QtPaintStat m_stPendingStat;        //< 已绘制、等待交换的一帧
+    bool m_bStatPending;
+};
+
+QtRenderWidget::QtRenderWidget(QWidget *parent, bool bForceSoftware) :
+    QWidget(parent),
+    m_pGlView(nullptr),
+    m_nPixelW(0),
+    m_nPixelH(0),
+    m_nMaxTextureSize(0),
+    m_bCollectStats(false)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    //鼠标事件交给显示控件处理（拖动、缩放、右键菜单）
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+
+    if (!bForceSoftware)
+    {
+        //能创建 OpenGL 上下文才使用着色器绘制
+        QOpenGLContext context;
+        if (context.create())
+        {
+            m_pGlView = new QtRenderGlView(this);
+        }
+        else
+        {
+            av_log(NULL, AV_LOG_WARNING, "Qt render: OpenGL is not available, using software rendering\n");
+        }
+    }
+}
+
+QtRenderWidget::~QtRenderWidget()
+{
+}
+
+bool QtRenderWidget::IsSoftware() const
+{
+    return m_pGlView == nullptr;
+}
+
+void QtRenderWidget::SetScene(const std::shared_ptr<QtRenderScene> &pScene)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexScene);
+        m_pScene = pScene;
+    }
+
+    //界面线程上重绘，多次请求合并为一次
+    QWidget *pTarget = m_pGlView ? (QWidget *)m_pGlView : (QWidget *)this;
+    QMetaObject::invokeMethod(pTarget, "update", Qt::QueuedConnection);
+}
+
+std::shared_ptr<QtRenderScene> QtRenderWidget::Scene()
+{
+    std::lock_guard<std::mutex> lock(m_mutexScene);
+    return m_pScene;
+}
+
+void QtRenderWidget::PixelSize(int *w, int *h) const
+{
+    *w = m_nPixelW;
+    *h = m_nPixelH;
+}
+
+int QtRenderWidget::MaxTextureSize() const
+{
+    return m_nMaxTextureSize;
+}
+
+void QtRenderWidget::SetMaxTextureSize(int nSize)
+{
+    m_nMaxTextureSize = nSize;
+}
+
+void QtRenderWidget::SetCollectStats(bool bCollect)
+{
+    std::lock_guard<std::mutex> lock(m_mutexStats);
+    m_bCollectStats = bCollect;
+    m_vecPaintStats.clear();
+}
+
+bool QtRenderWidget::IsCollectingStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutexStats);
+    return m_bCollectStats;
+}
+
+void QtRenderWidget::TakePaintStats(std::vector<QtPaintStat> &vecStats)
+{
+    std::lock_guard<std::mutex> lock(m_mutexStats);
+    vecStats.swap(m_vecPaintStats);
+    m_vecPaintStats.clear();
+}
+
+void QtRenderWidget::AddPaintStat(const QtPaintStat &stat)
+{
+    std::lock_guard<std::mutex> lock(m_mutexStats);
+    if (m_bCollectStats)
+    {
+        m_vecPaintStats.push_back(stat);
+    }
+}
+
+void QtRenderWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    if (m_pGlView)
+    {
+        return;
+    }
+
+    std::shared_ptr<QtRenderScene> pScene = Scene();
+    QElapsedTimer timer;
+    QPainter painter(this);
+    qreal dpr = devicePixelRatioF();
+
+    timer.start();
+    painter.fillRect(rect(), Qt::black);
+
+    //场景中的矩形为像素坐标
+    if (pScene && pScene->has_video && !pScene->image.isNull())
+    {
+        const SDL_Rect &dst = pScene->dst;
+        QRectF rcTarget(-dst.w / 2.0 / dpr, -dst.h / 2.0 / dpr, dst.w / dpr, dst.h / dpr);
+
+        painter.save();
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.translate((dst.x + dst.w / 2.0) / dpr, (dst.y + dst.h / 2.0) / dpr);
+        painter.rotate(pScene->rotation);
+        painter.scale(pScene->flip & SDL_FLIP_HORIZONTAL ? -1 : 1, pScene->flip & SDL_FLIP_VERTICAL ? -1 : 1);
+        if (pScene->prescaled)
+        {
+            painter.drawImage(rcTarget, pScene->image);
+        }
+        else
+        {
+            const SDL_Rect &src = pScene->src;
+            painter.drawImage(rcTarget, pScene->image, QRectF(src.x, src.y, src.w, src.h));
+        }
+        painter.restore();
+    }
+    if (pScene && pScene->has_subtitle && !pScene->subtitle.isNull())
+    {
+        const SDL_Rect &src = pScene->sub_src;
+        const SDL_Rect &dst = pScene->sub_dst;
+        painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter.drawImage(QRectF(dst.x / dpr, dst.y / dpr, dst.w / dpr, dst.h / dpr),
+            pScene->subtitle, QRectF(src.x, src.y, src.w, src.h));
+    }
+    if (pScene && pScene->has_overlay && !pScene->overlay.isNull())
+    {
+        const SDL_Rect &dst = pScene->overlay_dst;
+        painter.drawImage(QRectF(dst.x / dpr, dst.y / dpr, dst.w / dpr, dst.h / dpr), pScene->overlay);
+    }
+
+    //软件绘制没有交换通知，以 paintEvent 结束为显示时间（不含之后刷新到窗口的时间）
+    if (IsCollectingStats())
+    {
+        QtPaintStat stat;
+        stat.paint_ms = timer.nsecsElapsed() / 1e6;
+        stat.video_serial = pScene && pScene->has_video ? pScene->video_serial : 0;
+        stat.presented_time = av_gettime_relative();
+        AddPaintStat(stat);
+    }
+}
+
+void QtRenderWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    if (m_pGlView)
+    {
+        m_pGlView->setGeometry(rect());
+    }
+    qreal dpr = devicePixelRatioF();
+    m_nPixelW = lrint(width() * dpr);
+    m_nPixelH = lrint(height() * dpr);
+    PostResize();
+}
+
+void QtRenderWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    PostResize();
+}
+
+void QtRenderWidget::PostResize()
+{
+    //隐藏时（使用 SDL 输出）不干扰 SDL 窗口事件
+    if (!isVisible() || !SDL_WasInit(SDL_INIT_EVENTS))
+    {
+        return;
+    }
+
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = SDL_WINDOWEVENT;
+    event.window.event = SDL_WINDOWEVENT_RESIZED;
+    event.window.data1 = m_nPixelW;
+    event.window.data2 = m_nPixelH;
+    SDL_PushEvent(&event);
+}
+
+QtRender::QtRender() :
+    m_pWidget(nullptr),
+    m_bOpen(false),
+    m_bSoftware(false),
+    m_nMaxTextureSize(0),
+    m_pFrame(nullptr),
+    m_nVideoSerial(0),
+    m_nSceneSerial(0),
+    m_nScaledSerial(0),
+    m_pConvertCtx(nullptr),
+    m_pScaleCtx(nullptr),
+    m_nSubtitleSerial(0),
+    m_nOverlaySerial(0)
+{
+    memset(&m_stScaledSrc, 0, sizeof(m_stScaledSrc));
+}
+
+QtRender::~QtRender()
+{
+    Close();
+}
+
+void QtRender::SetWidget(QtRenderWidget *pWidget)
+{
+    std::lock_guard<std::mutex> lock(m_mutexWidget);
+    m_pWidget = pWidget;
+}
+
+bool QtRender::HasWidget()
+{
+    std::lock_guard<std::mutex> lock(m_mutexWidget);
+    return m_pWidget != nullptr;
+}
+
+const char *QtRender::Name() const
+{
+    return m_bSoftware ? "qt-software" : "qt-opengl";
+}
+
+int QtRender::Open(int *w, int *h)
+{
+    std::lock_guard<std::mutex> lock(m_mutexWidget);
+    if (!m_pWidget)
+    {
+        av_log(NULL, AV_LOG_FATAL, "Qt render: no output widget\n");
+        return -1;
+    }
+
+    m_pWidget->PixelSize(w, h);
+    if (!m_bOpen)
+    {
+        m_bSoftware = m_pWidget->IsSoftware();
+        m_bOpen = true;
+        av_log(NULL, AV_LOG_VERBOSE, "Initialized %s renderer, output %dx%d.\n", Name(), *w, *h);
+    }
+    return 0;
+}
+
+void QtRender::Close()
+{
+    ReleaseTextures();
+    sws_freeContext(m_pConvertCtx);
+    m_pConvertCtx = nullptr;
+    sws_freeContext(m_pScaleCtx);
+    m_pScaleCtx = nullptr;
+    m_imgOverlay = QImage();
+    m_bOpen = false;
+
+    //不再显示已关闭文件的画面
+    std::lock_guard<std::mutex> lock(m_mutexWidget);
+    if (m_pWidget)
+    {
+        m_pWidget->SetScene(nullptr);
+    }
+}
+
+bool QtRender::IsOpen() const
+{
+    return m_bOpen;
+}
+
+void QtRender::ReleaseTextures()
+{
+    av_frame_free(&m_pFrame);
+    m_imgFrame = QImage();
+    m_imgScaled = QImage();
+    m_imgSubtitle = QImage();
+    m_pScene.reset();
+}
+
+void QtRender::MaxTextureSize(int *w, int *h)
+{
+    //软件绘制不限制；OpenGL 的字幕画布受最大纹理尺寸限制，视频帧超出时在刷新线程缩放
+    *w = m_nMaxTextureSize;
+    *h = m_nMaxTextureSize;
+}
+
+bool QtRender::BeginFrame()
+{
+    if (!m_bOpen)
+    {
+        return false;
+    }
+
+    {
+        //OpenGL 初始化后才知道最大纹理尺寸
+        std::lock_guard<std::mutex> lock(m_mutexWidget);
+        m_nMaxTextureSize = m_pWidget && !m_bSoftware ? m_pWidget->MaxTextureSize() : 0;
+    }
+
+    m_pScene = std::make_shared<QtRenderScene>();
+    return true;
+}
+
+void QtRender::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(m_mutexWidget);
+    if (m_pWidget)
+    {
+        m_pWidget->SetScene(m_pScene);
+    }
+    m_pScene.reset();
+}
+
+int QtRender::UploadVideo(AVFrame *frame, const SDL_Rect *roi)
+{
+    //转换开销与区域无关，整帧上传
+    Q_UNUSED(roi);
+
+    av_frame_free(&m_pFrame);
+    m_imgFrame = QImage();
+    m_nVideoSerial++;
+    m_nSceneSerial++;
+
+    //YUV420P 直接引用，界面线程上传平面纹理，不复制
+    if (frame->format == AV_PIX_FMT_YUV420P &&
+        frame->linesize[0] > 0 && frame->linesize[1] > 0 && frame->linesize[2] > 0)
+    {
+        m_pFrame = av_frame_alloc();
+        if (!m_pFrame || av_frame_ref(m_pFrame, frame) < 0)
+        {
+            av_frame_free(&m_pFrame);
+            return -1;
+        }
+        return 0;
+    }
+
+    return ConvertFrame(frame, m_imgFrame);
+}
+
+static void release_pool_image(void *info)
+{
+    AVBufferRef *buf = (AVBufferRef *)info;
+    av_buffer_unref(&buf);
+}
+
+//转换结果放在帧缓冲池的缓冲区中，每帧新建的 QImage 不再重新分配（4K 一帧 32MB）
+static QImage pool_image(int w, int h)
+{
+    int stride = FFALIGN(w * 4, 64);
+    AVBufferRef *buf = FramePool::GetInstance()->GetBuffer((size_t)stride * h);
+    if (!buf)
+    {
+        return QImage(w, h, QImage::Format_ARGB32);
+    }
+    return QImage(buf->data, w, h, stride, QImage::Format_ARGB32, release_pool_image, buf);
+}
+
+int QtRender::ConvertFrame(AVFrame *frame, QImage &image)
+{
+    //每次新建，已交给界面线程的画面不受影响
+    image = pool_image(frame->width, frame->height);
+    if (image.isNull())
+    {
+        return -1;
+    }
+
+    if (frame->format == AV_PIX_FMT_BGRA)
+    {
+        //与 SDL 输出一致，倒序存放时按内存顺序复制，由垂直镜像还原
+        const uint8_t *pSrc = frame->linesize[0] < 0 ? frame->data[0] + frame->linesize[0] * (frame->height - 1) : frame->data[0];
+        av_image_copy_plane(image.bits(), image.bytesPerLine(), pSrc, FFABS(frame->linesize[0]),
+            frame->width * 4, frame->height);
+        return 0;
+    }
+
+    if (frame->format == AV_PIX_FMT_YUV420P && (frame->linesize[0] < 0 || frame->linesize[1] < 0 || frame->linesize[2] < 0))
+    {
+        av_log(NULL, AV_LOG_ERROR, "Negative linesize is not supported for YUV.\n");
+        return -1;
+    }
+
+    m_pConvertCtx = sws_getCachedContext(m_pConvertCtx,
+        frame->width, frame->height, (AVPixelFormat)frame->format, frame->width, frame->height,
+        AV_PIX_FMT_BGRA, SWS_BICUBIC, NULL, NULL, NULL);
+    if (!m_pConvertCtx)
+    {
+        av_log(NULL, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
+        return -1;
+    }
+
+    uint8_t *pixels[4] = { image.bits(), NULL, NULL, NULL };
+    int pitch[4] = { (int)image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(m_pConvertCtx, (const uint8_t * const *)frame->data, frame->linesize, 0, frame->height, pixels, pitch);
+    return 0;
+}
+
+int QtRender::ScaleFrame(const SDL_Rect *src, int w, int h, QImage &image)
+{
+    const uint8_t *data[4] = { NULL, NULL, NULL, NULL };
+    int linesize[4] = { 0, 0, 0, 0 };
+    AVPixelFormat format;
+
+    //src 的 x、y 为偶数，直接偏移各平面取区域
+    if (m_pFrame)
+    {
+        format = AV_PIX_FMT_YUV420P;
+        data[0] = m_pFrame->data[0] + src->y * m_pFrame->linesize[0] + src->x;
+        data[1] = m_pFrame->data[1] + src->y / 2 * m_pFrame->linesize[1] + src->x / 2;
+        data[2] = m_pFrame->data[2] + src->y / 2 * m_pFrame->linesize[2] + src->x / 2;
+        for (int i = 0; i < 3; i++)
+        {
+            linesize[i] = m_pFrame->linesize[i];
+        }
+    }
+    else if (!m_imgFrame.isNull())
+    {
+        format = AV_PIX_FMT_BGRA;
+        data[0] = m_imgFrame.constBits() + src->y * m_imgFrame.bytesPerLine() + src->x * 4;
+        linesize[0] = m_imgFrame.bytesPerLine();
+    }
+    else
+    {
+        return -1;
+    }
+
+    image = pool_image(w, h);
+    if (image.isNull())
+    {
+        return -1;
+    }
+
+    m_pScaleCtx = sws_getCachedContext(m_pScaleCtx, src->w, src->h, format, w, h,
+        AV_PIX_FMT_BGRA, SWS_BILINEAR, NULL, NULL, NULL);
+    if (!m_pScaleCtx)
+    {
+        av_log(NULL, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
+        return -1;
+    }
+
+    uint8_t *pixels[4] = { image.bits(), NULL, NULL, NULL };
+    int pitch[4] = { (int)image.bytesPerLine(), 0, 0, 0 };
+    sws_scale(m_pScaleCtx, data, linesize, 0, src->h, pixels, pitch);
+    return 0;
+}
+
+void QtRender::RenderVideo(const SDL_Rect *src, const SDL_Rect *dst, double rotation, int flip)
+{
+    int nFrameW, nFrameH;
+
+    if (!m_pScene)
+    {
+        return;
+    }
+    if (m_pFrame)
+    {
+        nFrameW = m_pFrame->width;
+        nFrameH = m_pFrame->height;
+    }
+    else if (!m_imgFrame.isNull())
+    {
+        nFrameW = m_imgFrame.width();
+        nFrameH = m_imgFrame.height();
+    }
+    else
+    {
+        return;
+    }
+
+    QtRenderScene *pScene = m_pScene.get();
+    pScene->src = src ? *src : SDL_Rect{ 0, 0, nFrameW, nFrameH };
+    pScene->dst = *dst;
+    pScene->rotation = rotation;
+    pScene->flip = flip;
+    if (pScene->src.w <= 0 || pScene->src.h <= 0 || dst->w <= 0 || dst->h <= 0)
+    {
+        return;
+    }
+
+    bool bOversized = m_nMaxTextureSize > 0 && (nFrameW > m_nMaxTextureSize || nFrameH > m_nMaxTextureSize);
+    if (m_bSoftware || bOversized)
+    {
+        //在刷新线程缩放到输出大小，界面线程只做一次 1:1 绘制；同一帧、同一区域和大小只缩放一次
+        if (m_nScaledSerial != m_nVideoSerial || memcmp(&m_stScaledSrc, &pScene->src, sizeof(SDL_Rect)) ||
+            m_imgScaled.width() != dst->w || m_imgScaled.height() != dst->h)
+        {
+            if (ScaleFrame(&pScene->src, dst->w, dst->h, m_imgScaled) < 0)
+            {
+                return;
+            }
+            m_nScaledSerial = m_nVideoSerial;
+            m_stScaledSrc = pScene->src;
+            m_nSceneSerial++;
+        }
+        pScene->image = m_imgScaled;
+        pScene->prescaled = true;
+    }
+    else if (m_pFrame)
+    {
+        pScene->frame = av_frame_alloc();
+        if (!pScene->frame || av_frame_ref(pScene->frame, m_pFrame) < 0)
+        {
+            av_frame_free(&pScene->frame);
+            return;
+        }
+    }
+    else
+    {
+        pScene->image = m_imgFrame;
+    }
+    pScene->video_serial = m_nSceneSerial;
+    pScene->has_video = true;
+}
+
+quint64 QtRender::SceneSerial() const
+{
+    return m_nSceneSerial;
+}
+
+int QtRender::ResizeSubtitle(int w, int h)
+{
+    if (m_imgSubtitle.width() != w || m_imgSubtitle.height() != h)
+    {
+        m_imgSubtitle = QImage(w, h, QImage::Format_ARGB32);
+        if (m_imgSubtitle.isNull())
+        {
+            return -1;
+        }
+        m_imgSubtitle.fill(Qt::transparent);
+        m_nSubtitleSerial++;
+    }
+    return 0;
+}
+
+int QtRender::LockSubtitle(const SDL_Rect *rect, uint8_t **pixels, int *pitch)
+{
+    if (m_imgSubtitle.isNull() || !rect)
+    {
+        return -1;
+    }
+    if (rect->x < 0 || rect->y < 0 || rect->x + rect->w > m_imgSubtitle.width() || rect->y + rect->h > m_imgSubtitle.height())
+    {
+        return -1;
+    }
+
+    //界面线程仍持有旧画布时，bits() 先复制一份再写入
+    *pitch = m_imgSubtitle.bytesPerLine();
+    *pixels = m_imgSubtitle.bits() + rect->y * *pitch + rect->x * 4;
+    return 0;
+}
+
+void QtRender::UnlockSubtitle()
+{
+    m_nSubtitleSerial++;
+}
+
+void QtRender::RenderSubtitle(const SDL_Rect *src, const SDL_Rect *dst)
+{
+    if (!m_pScene || m_imgSubtitle.isNull())
+    {
+        return;
+    }
+
+    m_pScene->subtitle = m_imgSubtitle;
+    m_pScene->subtitle_serial = m_nSubtitleSerial;
+    m_pScene->sub_src = src ? *src : SDL_Rect{ 0, 0, m_imgSubtitle.width(), m_imgSubtitle.height() };
+    m_pScene->sub_dst = *dst;
+    m_pScene->has_subtitle = true;
+}
+
+int QtRender::UploadOverlay(const uint8_t *pixels, int pitch, int w, int h)
+{
+    //复制一份，调用方可以继续修改自己的画面
+    m_imgOverlay = QImage(w, h, QImage::Format_ARGB32);
+    if (m_imgOverlay.isNull())
+    {
+        return -1;
+    }
+    av_image_copy_plane(m_imgOverlay.bits(), m_imgOverlay.bytesPerLine(), pixels, pitch, w * 4, h);
+    m_nOverlaySerial++;
+    return 0;
+}
+
+void QtRender::RenderOverlay(const SDL_Rect *dst)
+{
+    if (!m_pScene || m_imgOverlay.isNull())
+    {
+        return;
+    }
+
+    m_pScene->overlay = m_imgOverlay;
+    m_pScene->overlay_serial = m_nOverlaySerial;
+    m_pScene->overlay_dst = *dst;
+    m_pScene->has_overlay = true;
+}
@@ -0,0 +1,185 @@
+﻿/*
+ * @file 	qtrender.h
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	Qt 画面输出
+ * @note	刷新线程把一帧要画的内容（视频帧引用或 BGRA 画面、字幕画布、位置、旋转、镜像）整理成 QtRenderScene，
+ *			交给 QtRenderWidget 后请求重绘，界面线程在 paint 时绘制最新的一份，不需要原生子窗口，也不阻塞刷新线程。
+ *			OpenGL 可用时 YUV420P 帧零拷贝交给界面线程，按平面上传纹理，着色器转 RGB；
+ *			其他格式在刷新线程转为 BGRA（颜色管理已在解码线程转为 BGRA）。OpenGL 不可用时在刷新线程缩放到目标大小，QPainter 绘制。
+ */
+#ifndef QTRENDER_H
+#define QTRENDER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QImage>
+#include <QWidget>
+
+#include "renderbackend.h"
+
+//界面线程绘制的一帧
+typedef struct QtRenderScene {
+    AVFrame *frame;             //< YUV420P 帧引用，image 有效时为空
+    QImage image;               //< BGRA 画面（整帧），prescaled 时为 src 区域缩放到 dst 大小后的画面
+    bool prescaled;
+    quint64 video_serial;       //< 画面内容变化时递增，界面线程据此重新上传纹理
+    bool has_video;
+    SDL_Rect src;               //< 帧内区域
+    SDL_Rect dst;               //< 输出上的矩形（像素），绕中心旋转
+    double rotation;
+    int flip;
+
+    QImage subtitle;            //< 字幕画布（BGRA，带透明度）
+    quint64 subtitle_serial;
+    bool has_subtitle;
+    SDL_Rect sub_src;
+    SDL_Rect sub_dst;
+
+    QImage overlay;             //< 界面叠加层（BGRA，带透明度）
+    quint64 overlay_serial;
+    bool has_overlay;
+    SDL_Rect overlay_dst;
+
+    QtRenderScene();
+    ~QtRenderScene();
+} QtRenderScene;
+
+//一次绘制的统计，基准测试用
+typedef struct QtPaintStat {
+    double paint_ms;            //< 绘制耗时（OpenGL 含 glFinish）
+    quint64 video_serial;       //< 绘制的画面（QtRenderScene::video_serial），没有画面时为 0
+    int64_t presented_time;     //< 显示的时间（av_gettime_relative），OpenGL 为 frameSwapped，软件绘制为 paintEvent 结束
+} QtPaintStat;
+
+class QtRenderGlView;
+
+// Qt 输出控件，放在显示控件中代替 SDL 的原生子窗口
+class QtRenderWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param	bForceSoftware 不使用 OpenGL
+     */
+    explicit QtRenderWidget(QWidget *parent = nullptr, bool bForceSoftware = false);
+    ~QtRenderWidget();
+
+    bool IsSoftware() const;
+
+    //任意线程调用，替换要绘制的内容并请求重绘，为空时显示黑屏
+    void SetScene(const std::shared_ptr<QtRenderScene> &pScene);
+    std::shared_ptr<QtRenderScene> Scene();
+
+    //输出大小（像素）
+    void PixelSize(int *w, int *h) const;
+
+    //OpenGL 最大纹理尺寸，未知时为 0
+    int MaxTextureSize() const;
+    void SetMaxTextureSize(int nSize);
+
+    //记录每次绘制的耗时和显示时间，基准测试用
+    void SetCollectStats(bool bCollect);
+    bool IsCollectingStats();
+    void TakePaintStats(std::vector<QtPaintStat> &vecStats);
+    void AddPaintStat(const QtPaintStat &stat);
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void showEvent(QShowEvent *event);
+
+private:
+    //通知刷新线程输出大小变化（与 SDL 窗口事件相同）
+    void PostResize();
+
+private:
+    QtRenderGlView *m_pGlView;          //< OpenGL 绘制，软件绘制时为空
+
+    std::mutex m_mutexScene;
+    std::shared_ptr<QtRenderScene> m_pScene;
+
+    std::atomic<int> m_nPixelW;
+    std::atomic<int> m_nPixelH;
+    std::atomic<int> m_nMaxTextureSize;
+
+    std::mutex m_mutexStats;
+    bool m_bCollectStats;
+    std::vector<QtPaintStat> m_vecPaintStats;
+};
+
+class QtRender : public RenderBackend
+{
+public:
+    QtRender();
+    ~QtRender();
+
+    //界面线程调用，设置输出控件，为空表示控件已销毁
+    void SetWidget(QtRenderWidget *pWidget);
+    bool HasWidget();
+
+    const char *Name() const override;
+    int Open(int *w, int *h) override;
+    void Close() override;
+    bool IsOpen() const override;
+    void ReleaseTextures() override;
+    void MaxTextureSize(int *w, int *h) override;
+
+    bool BeginFrame() override;
+    void EndFrame() override;
+
+    int UploadVideo(AVFrame *frame, const SDL_Rect *roi) override;
+    void RenderVideo(const SDL_Rect *src, const SDL_Rect *dst, double rotation, int flip) override;
+
+    int ResizeSubtitle(int w, int h) override;
+    int LockSubtitle(const SDL_Rect *rect, uint8_t **pixels, int *pitch) override;
+    void UnlockSubtitle() override;
+    void RenderSubtitle(const SDL_Rect *src, const SDL_Rect *dst) override;
+
+    int UploadOverlay(const uint8_t *pixels, int pitch, int w, int h) override;
+    void RenderOverlay(const SDL_Rect *dst) override;
+
+    //最近一次 EndFrame 交给控件的画面序号（QtRenderScene::video_serial），基准测试用
+    quint64 SceneSerial() const;
+
+private:
+    //帧转为 BGRA 整帧画面
+    int ConvertFrame(AVFrame *frame, QImage &image);
+    //已上传画面的 src 区域缩放到 w x h 的 BGRA 画面
+    int ScaleFrame(const SDL_Rect *src, int w, int h, QImage &image);
+
+private:
+    std::mutex m_mutexWidget;
+    QtRenderWidget *m_pWidget;
+
+    bool m_bOpen;
+    bool m_bSoftware;
+    int m_nMaxTextureSize;
+
+    AVFrame *m_pFrame;                  //< 最近上传的帧（YUV420P 时）
+    QImage m_imgFrame;                  //< 最近上传的帧转成的 BGRA 整帧（YUV420P 以外的格式）
+    quint64 m_nVideoSerial;             //< 每次上传递增
+    quint64 m_nSceneSerial;             //< 交给界面线程的画面内容变化时递增（上传或重新缩放）
+    QImage m_imgScaled;                 //< 缩放到目标大小的画面
+    quint64 m_nScaledSerial;            //< m_imgScaled 对应的上传
+    SDL_Rect m_stScaledSrc;
+    struct SwsContext *m_pConvertCtx;   //< 转 BGRA
+    struct SwsContext *m_pScaleCtx;     //< 缩放到目标大小
+
+    QImage m_imgSubtitle;
+    quint64 m_nSubtitleSerial;
+
+    QImage m_imgOverlay;
+    quint64 m_nOverlaySerial;
+
+    std::shared_ptr<QtRenderScene> m_pScene; //< 正在整理的一帧
+};
+
+#endif // QTRENDER_H
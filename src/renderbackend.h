@@ -0,0 +1,115 @@
+﻿/*
+ * @file 	renderbackend.h
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	画面输出接口
+ * @note	刷新线程通过该接口显示画面，不直接使用 SDL 渲染器。一帧的调用顺序为
+ *			BeginFrame、（UploadVideo）、RenderVideo、（RenderSubtitle）、（RenderOverlay）、EndFrame，都在刷新线程上。
+ *			SdlRender 在 Qt 创建的原生子窗口上使用 SDL 渲染器；QtRender 把帧交给 Qt 控件，
+ *			在界面线程上用 OpenGL 着色器（或软件 QImage）绘制，不需要原生子窗口。
+ */
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include "globalhelper.h"
+
+enum RenderBackendType {
+    RENDER_BACKEND_SDL,     //SDL 渲染器，画在原生子窗口上
+    RENDER_BACKEND_QT,      //Qt 控件，OpenGL 不可用时为软件绘制
+    RENDER_BACKEND_NB
+};
+
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+
+    virtual const char *Name() const = 0;
+
+    /**
+     * @brief	打开输出，已打开时只返回大小
+     *
+     * @param	w 输出宽（像素）
+     * @param	h 输出高（像素）
+     * @return	0 成功 负值失败
+     */
+    virtual int Open(int *w, int *h) = 0;
+
+    //关闭输出，释放全部资源
+    virtual void Close() = 0;
+
+    virtual bool IsOpen() const = 0;
+
+    //释放当前文件的视频和字幕纹理，关闭文件时调用
+    virtual void ReleaseTextures() = 0;
+
+    //单个纹理的最大宽高，0 表示不限制
+    virtual void MaxTextureSize(int *w, int *h) = 0;
+
+    /**
+     * @brief	开始一帧，清为黑色
+     *
+     * @return	false 本次不绘制（例如输出区域正在调整），不再调用 EndFrame
+     */
+    virtual bool BeginFrame() = 0;
+
+    //显示这一帧
+    virtual void EndFrame() = 0;
+
+    /**
+     * @brief	上传视频帧
+     *
+     * @param	frame 视频帧
+     * @param	roi 只需要该区域（x、y 为偶数），为空表示整帧
+     * @return	0 成功 负值失败
+     */
+    virtual int UploadVideo(AVFrame *frame, const SDL_Rect *roi) = 0;
+
+    /**
+     * @brief	绘制已上传的视频帧，语义同 SDL_RenderCopyEx
+     *
+     * @param	src 帧内要显示的区域，为空表示整帧
+     * @param	dst calculate_display_rect 得到的矩形
+     * @param	rotation 绕 dst 中心顺时针旋转的角度
+     * @param	flip SDL_RendererFlip
+     */
+    virtual void RenderVideo(const SDL_Rect *src, const SDL_Rect *dst, double rotation, int flip) = 0;
+
+    /**
+     * @brief	字幕画布（BGRA，带透明度）大小变化时重建并清空
+     *
+     * @return	0 成功 负值失败
+     */
+    virtual int ResizeSubtitle(int w, int h) = 0;
+
+    /**
+     * @brief	锁定字幕画布的一个区域用于写入
+     *
+     * @param	rect 区域
+     * @param	pixels 区域左上角
+     * @param	pitch 行字节数
+     * @return	0 成功 负值失败（不调用 UnlockSubtitle）
+     */
+    virtual int LockSubtitle(const SDL_Rect *rect, uint8_t **pixels, int *pitch) = 0;
+    virtual void UnlockSubtitle() = 0;
+
+    //把字幕画布的 src 区域叠加到 dst
+    virtual void RenderSubtitle(const SDL_Rect *src, const SDL_Rect *dst) = 0;
+
+    /**
+     * @brief	上传界面叠加层（全屏控制条），内容变化时调用，大小变化时重建
+     *
+     * @param	pixels BGRA，非预乘透明度
+     * @param	pitch 行字节数
+     * @return	0 成功 负值失败
+     */
+    virtual int UploadOverlay(const uint8_t *pixels, int pitch, int w, int h) = 0;
+
+    //把叠加层整幅绘制到 dst，输出关闭时叠加层一起释放
+    virtual void RenderOverlay(const SDL_Rect *dst) = 0;
+};
+
+#endif // RENDERBACKEND_H
@@ -0,0 +1,261 @@
+﻿/*
+ * @file 	renderbench.cpp
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	画面输出基准测试
+ * @note
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include "renderbench.h"
+#include "sdlrender.h"
+#include "qtrender.h"
+#include "videoctl.h"
+
+#pragma execution_character_set("utf-8")
+
+static double percentile(std::vector<double> vec, double p)
+{
+    if (vec.empty())
+        return 0;
+    std::sort(vec.begin(), vec.end());
+    size_t idx = (size_t)(p * (vec.size() - 1) + 0.5);
+    return vec[FFMIN(idx, vec.size() - 1)];
+}
+
+static double average(const std::vector<double> &vec)
+{
+    double sum = 0;
+    for (double d : vec)
+        sum += d;
+    return vec.empty() ? 0 : sum / vec.size();
+}
+
+//斜向移动的亮度条纹，色度随帧变化
+static void fill_frame(AVFrame *frame, int index)
+{
+    for (int y = 0; y < frame->height; y++) {
+        uint8_t *row = frame->data[0] + y * frame->linesize[0];
+        for (int x = 0; x < frame->width; x++)
+            row[x] = (uint8_t)(16 + ((x + y + index * 16) & 0xff) * 219 / 255);
+    }
+    for (int y = 0; y < AV_CEIL_RSHIFT(frame->height, 1); y++) {
+        memset(frame->data[1] + y * frame->linesize[1], 128 + index * 8, AV_CEIL_RSHIFT(frame->width, 1));
+        memset(frame->data[2] + y * frame->linesize[2], 128 - index * 8, AV_CEIL_RSHIFT(frame->width, 1));
+    }
+}
+
+int RenderBench::Run(int nFrames, int nWidth, int nHeight, FILE *fp)
+{
+    AVFrame *frames[RENDER_BENCH_SOURCE_FRAMES] = { NULL };
+    int nFailed = 0;
+
+    for (int i = 0; i < RENDER_BENCH_SOURCE_FRAMES; i++) {
+        frames[i] = av_frame_alloc();
+        if (!frames[i])
+            return -1;
+        frames[i]->format = AV_PIX_FMT_YUV420P;
+        frames[i]->width = nWidth;
+        frames[i]->height = nHeight;
+        if (av_frame_get_buffer(frames[i], 0) < 0) {
+            av_log(NULL, AV_LOG_FATAL, "render benchmark: cannot allocate %dx%d frames\n", nWidth, nHeight);
+            for (int j = 0; j <= i; j++)
+                av_frame_free(&frames[j]);
+            return -1;
+        }
+        fill_frame(frames[i], i);
+    }
+
+    fprintf(fp, "render benchmark: %d frames of %dx%d yuv420p into a %dx%d window\n",
+        nFrames, nWidth, nHeight, RENDER_BENCH_WINDOW_WIDTH, RENDER_BENCH_WINDOW_HEIGHT);
+    fprintf(fp, "latency = upload start to presented (sdl: RenderPresent returned, qt-opengl: frameSwapped, qt-software: paintEvent done)\n");
+    fprintf(fp, "%-12s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+        "backend", "fps", "avg ms", "p50 ms", "p95 ms", "max ms", "presented", "deliver", "paint ms");
+
+    if (RunBackend(RENDER_BACKEND_SDL, false, frames, nFrames, fp) < 0)
+        nFailed++;
+    if (RunBackend(RENDER_BACKEND_QT, false, frames, nFrames, fp) < 0)
+        nFailed++;
+    if (RunBackend(RENDER_BACKEND_QT, true, frames, nFrames, fp) < 0)
+        nFailed++;
+    fflush(fp);
+
+    for (int i = 0; i < RENDER_BENCH_SOURCE_FRAMES; i++)
+        av_frame_free(&frames[i]);
+    return nFailed ? 1 : 0;
+}
+
+int RenderBench::RunBackend(int nBackend, bool bSoftware, AVFrame **frames, int nFrames, FILE *fp)
+{
+    QWidget wndTop;
+    QWidget *pNative = nullptr;
+    QtRenderWidget *pQtWid = nullptr;
+    SdlRender stSdlRender;
+    QtRender stQtRender;
+    RenderBackend *pRender;
+    const char *szName;
+
+    wndTop.resize(RENDER_BENCH_WINDOW_WIDTH, RENDER_BENCH_WINDOW_HEIGHT);
+    if (nBackend == RENDER_BACKEND_SDL) {
+        //与显示控件相同，SDL 画在原生子窗口上
+        pNative = new QWidget(&wndTop);
+        pNative->setGeometry(wndTop.rect());
+        pNative->setUpdatesEnabled(false);
+        stSdlRender.SetWindow(pNative->winId());
+        pRender = &stSdlRender;
+        szName = "sdl";
+    }
+    else {
+        pQtWid = new QtRenderWidget(&wndTop, bSoftware);
+        pQtWid->setGeometry(wndTop.rect());
+        stQtRender.SetWidget(pQtWid);
+        pRender = &stQtRender;
+        szName = bSoftware ? "qt-software" : "qt-opengl";
+        if (!bSoftware && pQtWid->IsSoftware()) {
+            fprintf(fp, "%-12s OpenGL not available, skipped\n", szName);
+            return 0;
+        }
+        pQtWid->SetCollectStats(true);
+    }
+    wndTop.setWindowTitle(QString("render benchmark - %1").arg(szName));
+    wndTop.show();
+    //等待窗口显示、OpenGL 初始化
+    QElapsedTimer timerShow;
+    timerShow.start();
+    while (timerShow.elapsed() < 500)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+
+    std::vector<double> vecDeliverMs;
+    std::vector<std::pair<quint64, int64_t>> vecStarts; //Qt：画面序号和开始上传的时间
+    std::atomic<bool> bDelivered(false);
+    std::atomic<bool> bPresented(false);
+    std::atomic<bool> bDone(false);
+    int nRet = 0;
+    double dTotalMs = 0;
+
+    //刷新线程的角色：SDL 渲染器在哪个线程创建就在哪个线程使用
+    std::thread tDeliver([&]() {
+        int w, h;
+        SDL_Rect rect;
+        QElapsedTimer timer;
+
+        if (pRender->Open(&w, &h) < 0) {
+            nRet = -1;
+            bDelivered = true;
+            bDone = true;
+            return;
+        }
+        VideoCtl::calculate_display_rect(&rect, 0, 0, w, h, frames[0]->width, frames[0]->height, av_make_q(1, 1));
+
+        vecDeliverMs.reserve(nFrames);
+        vecStarts.reserve(nFrames);
+        QElapsedTimer timerTotal;
+        timerTotal.start();
+        for (int i = 0; i < nFrames; i++) {
+            int64_t nStart = av_gettime_relative();
+            timer.start();
+            if (pRender->BeginFrame()) {
+                if (pRender->UploadVideo(frames[i % RENDER_BENCH_SOURCE_FRAMES], NULL) < 0) {
+                    pRender->EndFrame();
+                    nRet = -1;
+                    break;
+                }
+                pRender->RenderVideo(NULL, &rect, 0, 0);
+                pRender->EndFrame();
+                if (pQtWid)
+                    vecStarts.push_back(std::make_pair(stQtRender.SceneSerial(), nStart));
+            }
+            vecDeliverMs.push_back(timer.nsecsElapsed() / 1e6);
+        }
+        dTotalMs = timerTotal.nsecsElapsed() / 1e6;
+        bDelivered = true;
+
+        //关闭会清空控件的画面，等最后一帧显示出来
+        while (!bPresented)
+            av_usleep(1000);
+        pRender->Close();
+        bDone = true;
+    });
+
+    while (!bDelivered)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+
+    //Qt 在界面线程绘制，等最后交付的画面显示，最多等 RENDER_BENCH_PRESENT_TIMEOUT_MS
+    std::vector<QtPaintStat> vecPaintStats;
+    if (pQtWid && nRet >= 0 && !vecStarts.empty()) {
+        QElapsedTimer timerWait;
+        bool bLastShown = false;
+        timerWait.start();
+        while (!bLastShown && timerWait.elapsed() < RENDER_BENCH_PRESENT_TIMEOUT_MS) {
+            std::vector<QtPaintStat> vecTaken;
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+            pQtWid->TakePaintStats(vecTaken);
+            for (const QtPaintStat &stat : vecTaken) {
+                bLastShown = bLastShown || stat.video_serial == vecStarts.back().first;
+                vecPaintStats.push_back(stat);
+            }
+        }
+    }
+    bPresented = true;
+    while (!bDone)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    tDeliver.join();
+    QCoreApplication::processEvents();
+    //Qt 输出控件转发的窗口事件不再需要
+    SDL_FlushEvent(SDL_WINDOWEVENT);
+
+    if (nRet < 0) {
+        fprintf(fp, "%-12s failed to open or upload\n", szName);
+        return nRet;
+    }
+
+    //从开始上传到显示的耗时：SDL 在交付时同步绘制，Present 返回即显示；
+    //Qt 按画面序号对应到显示时间，被后一帧覆盖、没有画出来的帧不计入
+    std::vector<double> vecLatencyMs;
+    std::vector<double> vecPaintMs;
+    double dFps;
+    char szDeliverAvg[16], szPaintAvg[16];
+    if (pQtWid) {
+        std::map<quint64, int64_t> mapStarts(vecStarts.begin(), vecStarts.end());
+        int64_t nLastShown = 0;
+
+        for (const QtPaintStat &stat : vecPaintStats) {
+            auto it = mapStarts.find(stat.video_serial);
+            vecPaintMs.push_back(stat.paint_ms);
+            //同一画面重绘只算第一次显示
+            if (it == mapStarts.end())
+                continue;
+            vecLatencyMs.push_back((stat.presented_time - it->second) / 1000.0);
+            nLastShown = FFMAX(nLastShown, stat.presented_time);
+            mapStarts.erase(it);
+        }
+        dFps = nLastShown > vecStarts.front().second ?
+            vecLatencyMs.size() * 1000000.0 / (nLastShown - vecStarts.front().second) : 0;
+        snprintf(szDeliverAvg, sizeof(szDeliverAvg), "%.3f", average(vecDeliverMs));
+        snprintf(szPaintAvg, sizeof(szPaintAvg), "%.3f", average(vecPaintMs));
+    }
+    else {
+        vecLatencyMs = vecDeliverMs;
+        dFps = dTotalMs > 0 ? vecDeliverMs.size() * 1000.0 / dTotalMs : 0;
+        snprintf(szDeliverAvg, sizeof(szDeliverAvg), "%.3f", average(vecDeliverMs));
+        snprintf(szPaintAvg, sizeof(szPaintAvg), "-");
+    }
+    fprintf(fp, "%-12s %9.1f %9.3f %9.3f %9.3f %9.3f %9d %9s %9s\n",
+        szName, dFps,
+        average(vecLatencyMs), percentile(vecLatencyMs, 0.5), percentile(vecLatencyMs, 0.95),
+        vecLatencyMs.empty() ? 0 : *std::max_element(vecLatencyMs.begin(), vecLatencyMs.end()),
+        (int)vecLatencyMs.size(), szDeliverAvg, szPaintAvg);
+    return 0;
+}
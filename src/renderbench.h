@@ -0,0 +1,45 @@
+﻿/*
+ * @file 	renderbench.h
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	画面输出基准测试
+ * @note	在工作线程（与刷新线程相同）上按各输出方式连续送出合成的 YUV420P 帧，
+ *			统计每帧从开始上传到显示的耗时和帧率：SDL 为 Present 返回，Qt OpenGL 为合成交换后（frameSwapped），
+ *			Qt 软件绘制为 paintEvent 结束。Qt 输出另外统计交付到界面线程的耗时和绘制耗时，
+ *			被后一帧覆盖、没有显示的帧不计入。
+ */
+#ifndef RENDERBENCH_H
+#define RENDERBENCH_H
+
+#include <cstdio>
+
+#include "renderbackend.h"
+
+#define RENDER_BENCH_WINDOW_WIDTH 1280     //输出窗口宽
+#define RENDER_BENCH_WINDOW_HEIGHT 720     //输出窗口高
+#define RENDER_BENCH_SOURCE_FRAMES 8       //预先生成的帧数，循环送出
+#define RENDER_BENCH_PRESENT_TIMEOUT_MS 1000 //交付结束后等待最后一帧显示的最长时间
+
+class RenderBench
+{
+public:
+    /**
+     * @brief	运行基准测试，需要 QApplication 和 SDL 视频子系统，在界面线程调用
+     *
+     * @param	nFrames 每种输出方式送出的帧数
+     * @param	nWidth 帧宽
+     * @param	nHeight 帧高
+     * @param	fp 结果输出
+     * @return	进程返回值，0 表示各输出方式都能打开
+     */
+    static int Run(int nFrames, int nWidth, int nHeight, FILE *fp);
+
+private:
+    //一种输出方式的结果，失败返回负值
+    static int RunBackend(int nBackend, bool bSoftware, AVFrame **frames, int nFrames, FILE *fp);
+};
+
+#endif // RENDERBENCH_H
@@ -0,0 +1,285 @@
+﻿/*
+ * @file 	resampler.cpp
+ * @date 	2026/10/18 21:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	重采样预设
+ * @note
+ */
+
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+#include "resampler.h"
+
+#pragma execution_character_set("utf-8")
+
+#define RESAMPLE_BENCH_CHUNK 1024           //每次送入的输入样本数，与常见解码帧大小相当
+
+const char *Resampler::PresetName(int nPreset)
+{
+    switch (nPreset)
+    {
+    case RESAMPLE_PRESET_FAST:
+        return "fast";
+    case RESAMPLE_PRESET_BALANCED:
+        return "balanced";
+    case RESAMPLE_PRESET_HIGH:
+        return "high";
+    default:
+        return "unknown";
+    }
+}
+
+bool Resampler::HasSoxr()
+{
+    static const bool bHasSoxr = strstr(swresample_configuration(), "--enable-libsoxr") != nullptr;
+    return bHasSoxr;
+}
+
+bool Resampler::UsesSoxr(int nPreset, bool bAllowSoxr)
+{
+    return nPreset == RESAMPLE_PRESET_HIGH && bAllowSoxr && HasSoxr();
+}
+
+int Resampler::ApplyPreset(struct SwrContext *swr, int nPreset, bool bAllowSoxr)
+{
+    int ret = 0;
+
+    switch (nPreset)
+    {
+    case RESAMPLE_PRESET_FAST:
+        //8 抽头、64 相位线性插值，截止频率放宽，阻带约 -50 dB
+        ret |= av_opt_set(swr, "resampler", "swr", 0);
+        ret |= av_opt_set_int(swr, "filter_size", 8, 0);
+        ret |= av_opt_set_int(swr, "phase_shift", 6, 0);
+        ret |= av_opt_set_int(swr, "linear_interp", 1, 0);
+        ret |= av_opt_set_int(swr, "exact_rational", 0, 0);
+        ret |= av_opt_set_double(swr, "cutoff", 0.9, 0);
+        ret |= av_opt_set(swr, "dither_method", "none", 0);
+        break;
+    case RESAMPLE_PRESET_HIGH:
+        ret |= av_opt_set(swr, "dither_method", "triangular_hp", 0);
+        if (UsesSoxr(nPreset, bAllowSoxr))
+        {
+            //28 位精度对应 soxr 的 VHQ
+            ret |= av_opt_set(swr, "resampler", "soxr", 0);
+            ret |= av_opt_set_double(swr, "precision", 28, 0);
+            break;
+        }
+        ret |= av_opt_set(swr, "resampler", "swr", 0);
+        ret |= av_opt_set_int(swr, "filter_size", 64, 0);
+        ret |= av_opt_set_int(swr, "phase_shift", 12, 0);
+        ret |= av_opt_set_int(swr, "linear_interp", 1, 0);
+        ret |= av_opt_set_int(swr, "exact_rational", 1, 0);
+        ret |= av_opt_set_double(swr, "cutoff", 0.96, 0);
+        ret |= av_opt_set_double(swr, "kaiser_beta", 12, 0);
+        break;
+    case RESAMPLE_PRESET_BALANCED:
+    default:
+        //libswresample 的默认滤波器，明确写出避免随版本变化
+        ret |= av_opt_set(swr, "resampler", "swr", 0);
+        ret |= av_opt_set_int(swr, "filter_size", 32, 0);
+        ret |= av_opt_set_int(swr, "phase_shift", 10, 0);
+        ret |= av_opt_set_int(swr, "linear_interp", 1, 0);
+        ret |= av_opt_set_int(swr, "exact_rational", 1, 0);
+        ret |= av_opt_set_double(swr, "cutoff", 0.97, 0);
+        ret |= av_opt_set(swr, "dither_method", "triangular", 0);
+        break;
+    }
+
+    if (ret < 0)
+    {
+        av_log(NULL, AV_LOG_WARNING, "Cannot apply resampler preset %s\n", PresetName(nPreset));
+        return AVERROR(EINVAL);
+    }
+    return 0;
+}
+
+double Resampler::ThdN(const float *pSamples, int nSamples, double dFreq, double dRate)
+{
+    if (nSamples < 16)
+    {
+        return NAN;
+    }
+
+    //y ≈ a·cos(wn) + b·sin(wn) + c，解 3x3 正规方程
+    double w = 2 * M_PI * dFreq / dRate;
+    double m[3][3] = { { 0 } };
+    double v[3] = { 0 };
+    for (int n = 0; n < nSamples; n++)
+    {
+        double basis[3] = { cos(w * n), sin(w * n), 1.0 };
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                m[i][j] += basis[i] * basis[j];
+            }
+            v[i] += basis[i] * pSamples[n];
+        }
+    }
+
+    //高斯消元（主元选取）
+    int order[3] = { 0, 1, 2 };
+    for (int k = 0; k < 3; k++)
+    {
+        int p = k;
+        for (int i = k + 1; i < 3; i++)
+        {
+            if (fabs(m[order[i]][k]) > fabs(m[order[p]][k]))
+                p = i;
+        }
+        std::swap(order[k], order[p]);
+        double pivot = m[order[k]][k];
+        if (fabs(pivot) < 1e-12)
+        {
+            return NAN;
+        }
+        for (int i = k + 1; i < 3; i++)
+        {
+            double f = m[order[i]][k] / pivot;
+            for (int j = k; j < 3; j++)
+            {
+                m[order[i]][j] -= f * m[order[k]][j];
+            }
+            v[order[i]] -= f * v[order[k]];
+        }
+    }
+    double coef[3];
+    for (int k = 2; k >= 0; k--)
+    {
+        double s = v[order[k]];
+        for (int j = k + 1; j < 3; j++)
+        {
+            s -= m[order[k]][j] * coef[j];
+        }
+        coef[k] = s / m[order[k]][k];
+    }
+
+    double dSignal = 0, dResidual = 0;
+    for (int n = 0; n < nSamples; n++)
+    {
+        double dTone = coef[0] * cos(w * n) + coef[1] * sin(w * n);
+        double dErr = pSamples[n] - dTone - coef[2];
+        dSignal += dTone * dTone;
+        dResidual += dErr * dErr;
+    }
+    if (dSignal <= 0)
+    {
+        return NAN;
+    }
+    if (dResidual <= 0)
+    {
+        return -INFINITY;
+    }
+    return 10 * log10(dResidual / dSignal);
+}
+
+double Resampler::BenchTone(int nPreset, int nInRate, int nOutRate, double dFreq, double dSeconds,
+    bool bFloat, double &dCpuSeconds)
+{
+    AVChannelLayout layout = AV_CHANNEL_LAYOUT_STEREO;
+    AVSampleFormat out_fmt = bFloat ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
+    struct SwrContext *swr = NULL;
+
+    //与解码器常见输出（平面 float）和播放输出（交错 s16）一致
+    swr_alloc_set_opts2(&swr, &layout, out_fmt, nOutRate, &layout, AV_SAMPLE_FMT_FLTP, nInRate, 0, NULL);
+    if (!swr || ApplyPreset(swr, nPreset) < 0 || swr_init(swr) < 0)
+    {
+        swr_free(&swr);
+        return NAN;
+    }
+
+    int64_t nInTotal = (int64_t)(dSeconds * nInRate);
+    int nOutMax = (int)av_rescale_rnd(RESAMPLE_BENCH_CHUNK, nOutRate, nInRate, AV_ROUND_UP) + 256;
+    std::vector<float> vecIn(RESAMPLE_BENCH_CHUNK);
+    std::vector<uint8_t> vecOut((size_t)nOutMax * 2 * av_get_bytes_per_sample(out_fmt));
+    std::vector<float> vecLeft;
+    vecLeft.reserve((size_t)(dSeconds * nOutRate) + nOutMax);
+
+    double w = 2 * M_PI * dFreq / nInRate;
+    double dCpu = 0;
+    for (int64_t nPos = 0; nPos < nInTotal; nPos += RESAMPLE_BENCH_CHUNK)
+    {
+        int nIn = (int)FFMIN(RESAMPLE_BENCH_CHUNK, nInTotal - nPos);
+        for (int i = 0; i < nIn; i++)
+        {
+            vecIn[i] = (float)(RESAMPLE_BENCH_TONE_AMPLITUDE * sin(w * (double)(nPos + i)));
+        }
+        const uint8_t *in[2] = { (const uint8_t *)vecIn.data(), (const uint8_t *)vecIn.data() };
+        uint8_t *out[1] = { vecOut.data() };
+
+        //只计转换本身的 CPU 时间
+        clock_t nStart = clock();
+        int nOut = swr_convert(swr, out, nOutMax, in, nIn);
+        dCpu += (double)(clock() - nStart) / CLOCKS_PER_SEC;
+        if (nOut < 0)
+        {
+            swr_free(&swr);
+            return NAN;
+        }
+
+        for (int i = 0; i < nOut; i++)
+        {
+            if (bFloat)
+                vecLeft.push_back(((const float *)vecOut.data())[2 * i]);
+            else
+                vecLeft.push_back(((const int16_t *)vecOut.data())[2 * i] / 32768.0f);
+        }
+    }
+    swr_free(&swr);
+    dCpuSeconds += dCpu;
+
+    int nSkip = (int)(RESAMPLE_BENCH_SKIP_SECONDS * nOutRate);
+    if ((int)vecLeft.size() <= nSkip)
+    {
+        return NAN;
+    }
+    return ThdN(vecLeft.data() + nSkip, (int)vecLeft.size() - nSkip, dFreq, nOutRate);
+}
+
+int Resampler::RunBench(double dSeconds, bool bFloat, FILE *fp)
+{
+    static const int nConversions[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 96000, 48000 } };
+    static const double dTones[] = { 997, 10000 };
+    int nFailed = 0;
+
+    fprintf(fp, "resampler benchmark: %.1f s per tone, stereo fltp -> %s, %.1f dBFS tones, soxr %s\n",
+        dSeconds, bFloat ? "flt" : "s16", 20 * log10(RESAMPLE_BENCH_TONE_AMPLITUDE),
+        HasSoxr() ? "available" : "not available");
+    fprintf(fp, "%-10s %-6s %-14s %12s %12s %14s %14s\n",
+        "preset", "engine", "conversion", "cpu ms/s", "x realtime", "THD+N 997 Hz", "THD+N 10 kHz");
+
+    for (int nPreset = 0; nPreset < RESAMPLE_PRESET_NB; nPreset++)
+    {
+        for (const auto &conv : nConversions)
+        {
+            double dCpuSeconds = 0;
+            double dThdN[2];
+            for (int i = 0; i < 2; i++)
+            {
+                dThdN[i] = BenchTone(nPreset, conv[0], conv[1], dTones[i], dSeconds, bFloat, dCpuSeconds);
+                if (std::isnan(dThdN[i]))
+                    nFailed++;
+            }
+
+            double dAudioSeconds = 2 * dSeconds;
+            char szConv[32];
+            snprintf(szConv, sizeof(szConv), "%g->%g kHz", conv[0] / 1000.0, conv[1] / 1000.0);
+            fprintf(fp, "%-10s %-6s %-14s %12.3f %12.0f %11.1f dB %11.1f dB\n",
+                PresetName(nPreset), UsesSoxr(nPreset) ? "soxr" : "swr", szConv,
+                dCpuSeconds * 1000 / dAudioSeconds,
+                dCpuSeconds > 0 ? dAudioSeconds / dCpuSeconds : INFINITY,
+                dThdN[0], dThdN[1]);
+        }
+    }
+    fflush(fp);
+
+    return nFailed ? 1 : 0;
+}
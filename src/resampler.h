@@ -0,0 +1,83 @@
+﻿/*
+ * @file 	resampler.h
+ * @date 	2026/10/18 21:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	重采样预设
+ * @note	在 swr_init 之前设置 SwrContext 的引擎、滤波器长度、精度和抖动，替代默认参数。
+ *			soxr 不一定支持 swr_set_compensation，需要变速补偿（非音频主时钟）时调用方改用 swr 引擎。
+ *			基准测试按预设和常见采样率转换输出每秒音频的 CPU 时间和 THD+N。
+ */
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstdio>
+
+#include "globalhelper.h"
+
+enum ResamplePreset {
+    RESAMPLE_PRESET_FAST,       //低 CPU：短滤波器，不抖动，适合性能较弱的设备
+    RESAMPLE_PRESET_BALANCED,   //swr 默认滤波器，输出整数样本时三角抖动
+    RESAMPLE_PRESET_HIGH,       //soxr 非常高质量，未编译 soxr 时为长滤波器的 swr
+    RESAMPLE_PRESET_NB
+};
+
+#define RESAMPLE_BENCH_TONE_AMPLITUDE 0.5   //测试正弦波幅度（-6 dBFS）
+#define RESAMPLE_BENCH_SKIP_SECONDS 0.25    //计算 THD+N 时跳过开头（滤波器建立）的时长
+
+class Resampler
+{
+public:
+    static const char *PresetName(int nPreset);
+
+    //libswresample 是否编译了 soxr
+    static bool HasSoxr();
+
+    //该预设在 bAllowSoxr 时是否使用 soxr 引擎
+    static bool UsesSoxr(int nPreset, bool bAllowSoxr = true);
+
+    /**
+     * @brief	设置重采样参数，在 swr_alloc_set_opts2 之后、swr_init 之前调用
+     *
+     * @param	swr 重采样上下文
+     * @param	nPreset ResamplePreset
+     * @param	bAllowSoxr false 时高质量预设也使用 swr 引擎
+     * @return	0 成功 负值失败
+     */
+    static int ApplyPreset(struct SwrContext *swr, int nPreset, bool bAllowSoxr = true);
+
+    /**
+     * @brief	基准测试：各预设在 44.1↔48 kHz、96→48 kHz 下的 CPU 占用和 THD+N
+     *
+     * @param	dSeconds 每项测试的音频时长（秒）
+     * @param	bFloat true 输出 float，只衡量重采样本身；false 输出 s16，与播放时相同（含抖动和量化）
+     * @param	fp 输出
+     * @return	进程返回值，0 成功
+     */
+    static int RunBench(double dSeconds, bool bFloat, FILE *fp);
+
+    /**
+     * @brief	对单声道样本按已知频率最小二乘拟合正弦（含直流），残差能量与正弦能量之比
+     *
+     * @param	pSamples 样本
+     * @param	nSamples 样本数
+     * @param	dFreq 正弦频率（Hz）
+     * @param	dRate 采样率（Hz）
+     * @return	THD+N（dB），无法计算时返回 NAN
+     */
+    static double ThdN(const float *pSamples, int nSamples, double dFreq, double dRate);
+
+private:
+    /**
+     * @brief	一项测试：生成正弦波，重采样，统计 CPU 时间，计算 THD+N
+     *
+     * @param	dCpuSeconds 累加 CPU 时间
+     * @return	THD+N（dB），失败返回 NAN
+     */
+    static double BenchTone(int nPreset, int nInRate, int nOutRate, double dFreq, double dSeconds,
+        bool bFloat, double &dCpuSeconds);
+};
+
+#endif // RESAMPLER_H
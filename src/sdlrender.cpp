@@ -0,0 +1,199 @@
+﻿/*
+ * @file 	sdlrender.cpp
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	SDL 画面输出
+ * @note
+ */
+
+#include <QMutex>
+
+#include "sdlrender.h"
+#include "videoctl.h"
+
+#pragma execution_character_set("utf-8")
+
+#define HIDDEN_WINDOW_WIDTH 1280     //没有输出窗口时自建隐藏窗口的默认宽高
+#define HIDDEN_WINDOW_HEIGHT 720
+
+extern QMutex g_show_rect_mutex;
+
+SdlRender::SdlRender(bool bMirror) :
+    m_wid(0),
+    m_bMirror(bMirror),
+    m_pWindow(nullptr),
+    m_pRenderer(nullptr),
+    m_pSubTexture(nullptr),
+    m_pOverlayTexture(nullptr)
+{
+    memset(&m_stRendererInfo, 0, sizeof(m_stRendererInfo));
+    memset(&m_stVidTiles, 0, sizeof(m_stVidTiles));
+}
+
+SdlRender::~SdlRender()
+{
+    Close();
+}
+
+void SdlRender::SetWindow(WId wid)
+{
+    m_wid = wid;
+}
+
+Uint32 SdlRender::WindowID() const
+{
+    return m_pWindow ? SDL_GetWindowID(m_pWindow) : 0;
+}
+
+const char *SdlRender::Name() const
+{
+    return "sdl";
+}
+
+int SdlRender::Open(int *w, int *h)
+{
+    if (!m_pWindow) {
+        //没有设置输出窗口（无界面测试）时画在隐藏窗口上，不等待垂直同步
+        if (m_wid)
+            m_pWindow = SDL_CreateWindowFrom((void *)m_wid);
+        else
+            m_pWindow = SDL_CreateWindow("playerdemo", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+                *w > 0 ? *w : HIDDEN_WINDOW_WIDTH, *h > 0 ? *h : HIDDEN_WINDOW_HEIGHT, SDL_WINDOW_HIDDEN);
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+        if (m_pWindow) {
+            if (!m_pRenderer)
+                m_pRenderer = SDL_CreateRenderer(m_pWindow, -1, SDL_RENDERER_ACCELERATED | (m_bMirror || !m_wid ? 0 : SDL_RENDERER_PRESENTVSYNC));
+            if (!m_pRenderer) {
+                av_log(NULL, AV_LOG_WARNING, "Failed to initialize a hardware accelerated renderer: %s\n", SDL_GetError());
+                m_pRenderer = SDL_CreateRenderer(m_pWindow, -1, 0);
+            }
+            if (m_pRenderer) {
+                if (!SDL_GetRendererInfo(m_pRenderer, &m_stRendererInfo))
+                    av_log(NULL, AV_LOG_VERBOSE, "Initialized %s renderer, max texture size %dx%d.\n",
+                        m_stRendererInfo.name, m_stRendererInfo.max_texture_width, m_stRendererInfo.max_texture_height);
+            }
+        }
+    }
+
+    if (!m_pWindow || !m_pRenderer) {
+        av_log(NULL, AV_LOG_FATAL, "SDL: could not set video mode - %s\n", SDL_GetError());
+        return -1;
+    }
+
+    //初始宽高为显示控件宽高，之后按窗口事件更新
+    SDL_GetWindowSize(m_pWindow, w, h);
+    return 0;
+}
+
+void SdlRender::Close()
+{
+    ReleaseTextures();
+    if (m_pOverlayTexture) {
+        SDL_DestroyTexture(m_pOverlayTexture);
+        m_pOverlayTexture = nullptr;
+    }
+    if (m_pRenderer) {
+        SDL_DestroyRenderer(m_pRenderer);
+        m_pRenderer = nullptr;
+    }
+    if (m_pWindow) {
+        //窗口由 Qt 创建时，SDL_DestroyWindow 只释放 SDL 自己的窗口数据，不销毁原生窗口
+        SDL_DestroyWindow(m_pWindow);
+        m_pWindow = nullptr;
+    }
+    memset(&m_stRendererInfo, 0, sizeof(m_stRendererInfo));
+}
+
+bool SdlRender::IsOpen() const
+{
+    return m_pRenderer != nullptr;
+}
+
+void SdlRender::ReleaseTextures()
+{
+    VideoCtl::free_tiles(&m_stVidTiles);
+    if (m_pSubTexture) {
+        SDL_DestroyTexture(m_pSubTexture);
+        m_pSubTexture = nullptr;
+    }
+}
+
+void SdlRender::MaxTextureSize(int *w, int *h)
+{
+    *w = m_stRendererInfo.max_texture_width;
+    *h = m_stRendererInfo.max_texture_height;
+}
+
+bool SdlRender::BeginFrame()
+{
+    if (!m_pRenderer)
+        return false;
+    //恰好显示控件大小在变化，则不刷新显示
+    if (!m_bMirror && !g_show_rect_mutex.tryLock())
+        return false;
+
+    SDL_SetRenderDrawColor(m_pRenderer, 0, 0, 0, 255);
+    SDL_RenderClear(m_pRenderer);
+    return true;
+}
+
+void SdlRender::EndFrame()
+{
+    SDL_RenderPresent(m_pRenderer);
+    if (!m_bMirror)
+        g_show_rect_mutex.unlock();
+}
+
+int SdlRender::UploadVideo(AVFrame *frame, const SDL_Rect *roi)
+{
+    Uint32 sdl_pix_fmt = frame->format == AV_PIX_FMT_YUV420P ? SDL_PIXELFORMAT_YV12 : SDL_PIXELFORMAT_ARGB8888;
+
+    if (VideoCtl::realloc_tiles(m_pRenderer, &m_stRendererInfo, &m_stVidTiles, sdl_pix_fmt, frame->width, frame->height) < 0)
+        return -1;
+    return VideoCtl::upload_tiles(&m_stVidTiles, frame, roi);
+}
+
+void SdlRender::RenderVideo(const SDL_Rect *src, const SDL_Rect *dst, double rotation, int flip)
+{
+    if (m_stVidTiles.nb_tiles > 0)
+        VideoCtl::render_tiles(m_pRenderer, &m_stVidTiles, src, dst, rotation, (SDL_RendererFlip)flip);
+}
+
+int SdlRender::ResizeSubtitle(int w, int h)
+{
+    return VideoCtl::realloc_texture(m_pRenderer, &m_pSubTexture, SDL_PIXELFORMAT_ARGB8888, w, h, SDL_BLENDMODE_BLEND, 1);
+}
+
+int SdlRender::LockSubtitle(const SDL_Rect *rect, uint8_t **pixels, int *pitch)
+{
+    if (!m_pSubTexture)
+        return -1;
+    return SDL_LockTexture(m_pSubTexture, rect, (void **)pixels, pitch);
+}
+
+void SdlRender::UnlockSubtitle()
+{
+    SDL_UnlockTexture(m_pSubTexture);
+}
+
+void SdlRender::RenderSubtitle(const SDL_Rect *src, const SDL_Rect *dst)
+{
+    if (m_pSubTexture)
+        SDL_RenderCopy(m_pRenderer, m_pSubTexture, src, dst);
+}
+
+int SdlRender::UploadOverlay(const uint8_t *pixels, int pitch, int w, int h)
+{
+    if (VideoCtl::realloc_texture(m_pRenderer, &m_pOverlayTexture, SDL_PIXELFORMAT_ARGB8888, w, h, SDL_BLENDMODE_BLEND, 0) < 0)
+        return -1;
+    return SDL_UpdateTexture(m_pOverlayTexture, NULL, pixels, pitch);
+}
+
+void SdlRender::RenderOverlay(const SDL_Rect *dst)
+{
+    if (m_pOverlayTexture)
+        SDL_RenderCopy(m_pRenderer, m_pOverlayTexture, NULL, dst);
+}
@@ -0,0 +1,67 @@
+﻿/*
+ * @file 	sdlrender.h
+ * @date 	2026/10/18 21:50
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	SDL 画面输出
+ * @note	SDL_CreateWindowFrom 接管 Qt 创建的原生子窗口，渲染器、视频纹理（超出最大纹理尺寸时分块）
+ *			和字幕纹理都只在刷新线程上使用。显示控件调整子窗口位置时不绘制（g_show_rect_mutex）。
+ */
+#ifndef SDLRENDER_H
+#define SDLRENDER_H
+
+#include "renderbackend.h"
+#include "datactl.h"
+
+class SdlRender : public RenderBackend
+{
+public:
+    /**
+     * @param	bMirror 镜像输出：不等待垂直同步（与主画面在同一线程显示），不与主显示控件的大小调整互斥
+     */
+    explicit SdlRender(bool bMirror = false);
+    ~SdlRender();
+
+    //设置输出窗口，下次 Open 时生效；未设置时 Open 创建隐藏窗口
+    void SetWindow(WId wid);
+
+    //SDL 窗口 ID，未打开时为 0
+    Uint32 WindowID() const;
+
+    const char *Name() const override;
+    int Open(int *w, int *h) override;
+    void Close() override;
+    bool IsOpen() const override;
+    void ReleaseTextures() override;
+    void MaxTextureSize(int *w, int *h) override;
+
+    bool BeginFrame() override;
+    void EndFrame() override;
+
+    int UploadVideo(AVFrame *frame, const SDL_Rect *roi) override;
+    void RenderVideo(const SDL_Rect *src, const SDL_Rect *dst, double rotation, int flip) override;
+
+    int ResizeSubtitle(int w, int h) override;
+    int LockSubtitle(const SDL_Rect *rect, uint8_t **pixels, int *pitch) override;
+    void UnlockSubtitle() override;
+    void RenderSubtitle(const SDL_Rect *src, const SDL_Rect *dst) override;
+
+    int UploadOverlay(const uint8_t *pixels, int pitch, int w, int h) override;
+    void RenderOverlay(const SDL_Rect *dst) override;
+
+private:
+    WId m_wid;
+    bool m_bMirror;
+
+    SDL_Window *m_pWindow;
+    SDL_Renderer *m_pRenderer;
+    SDL_RendererInfo m_stRendererInfo;
+
+    VideoTiles m_stVidTiles;            //< 视频纹理
+    SDL_Texture *m_pSubTexture;         //< 字幕纹理
+    SDL_Texture *m_pOverlayTexture;     //< 叠加层纹理
+};
+
+#endif // SDLRENDER_H
@@ -0,0 +1,212 @@
+﻿/*
+ * @file 	seekstress.cpp
+ * @date 	2026/10/18 16:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	seek 压力测试统计
+ * @note
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "seekstress.h"
+
+SeekStress::SeekStress() :
+    m_bPending(false),
+    m_bLanded(false),
+    m_eType(SEEK_STRESS_ABSOLUTE),
+    m_dTarget(NAN),
+    m_nSerial(0),
+    m_nRequestTime(0),
+    m_bHasLanded(false),
+    m_nLandedSerial(0),
+    m_eLandedType(SEEK_STRESS_ABSOLUTE)
+{
+}
+
+void SeekStress::BeginFile(const QString &strFormat)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_strFormat = strFormat;
+    m_mapFiles[strFormat]++;
+    m_mapStats[strFormat];
+    m_bPending = false;
+    //新打开的流序号重新开始
+    m_bHasLanded = false;
+}
+
+void SeekStress::BeginSeek(SeekStressType eType, double dTarget, int nSerial)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_eType = eType;
+    m_dTarget = dTarget;
+    m_nSerial = nSerial;
+    m_bPending = true;
+    m_bLanded = false;
+    m_nRequestTime = av_gettime_relative();
+}
+
+void SeekStress::OnPresent(double dPts, int nSerial)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_strFormat.isEmpty())
+        {
+            return;
+        }
+
+        //已经显示了新位置的帧，又显示 seek 之前的帧：清空队列有遗漏。
+        //只与显示出来的帧比较，读取线程随时可能更新队列序号，不能用队列当前序号判断
+        if (m_bHasLanded && nSerial < m_nLandedSerial)
+        {
+            m_mapStats[m_strFormat][m_eLandedType].nStale++;
+        }
+
+        if (!m_bPending || m_bLanded || nSerial <= m_nSerial)
+        {
+            return;
+        }
+
+        SeekStats &stStats = m_mapStats[m_strFormat][m_eType];
+        m_bLanded = true;
+        m_bHasLanded = true;
+        m_nLandedSerial = nSerial;
+        m_eLandedType = m_eType;
+        stStats.vecLatency.push_back((av_gettime_relative() - m_nRequestTime) / 1000.0);
+        if (!std::isnan(m_dTarget) && !std::isnan(dPts))
+        {
+            stStats.vecError.push_back(fabs(dPts - m_dTarget) * 1000.0);
+        }
+    }
+    m_cond.notify_one();
+}
+
+bool SeekStress::WaitLanded(int nTimeoutMs)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_cond.wait_for(lock, std::chrono::milliseconds(nTimeoutMs), [this] { return m_bLanded; });
+}
+
+void SeekStress::EndSeek()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bPending && !m_bLanded)
+    {
+        m_mapStats[m_strFormat][m_eType].nFailed++;
+    }
+    m_bPending = false;
+}
+
+double SeekStress::Percentile(std::vector<double> &vecValues, double dPercent)
+{
+    size_t nIndex;
+
+    if (vecValues.empty())
+    {
+        return NAN;
+    }
+    //最近秩
+    nIndex = (size_t)ceil(dPercent / 100.0 * vecValues.size());
+    nIndex = std::min(std::max(nIndex, (size_t)1), vecValues.size()) - 1;
+    std::nth_element(vecValues.begin(), vecValues.begin() + nIndex, vecValues.end());
+    return vecValues[nIndex];
+}
+
+void SeekStress::Report(FILE *fp)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    fprintf(fp, "latency: seek request to the first frame of the new position drawn (hidden window)\n"
+        "stale: frames from before the last landed seek drawn after it\n");
+    for (auto &format : m_mapStats)
+    {
+        fprintf(fp, "\n== %s (%d file%s) ==\n", format.first.toUtf8().constData(),
+            m_mapFiles[format.first], m_mapFiles[format.first] > 1 ? "s" : "");
+        fprintf(fp, "%-9s %6s %5s %5s | %-12s%7s%7s%7s%7s | %-12s%7s%7s%7s\n", "type", "seeks", "fail", "stale",
+            "latency ms", "p50", "p90", "p99", "max", "|error| ms", "p50", "p90", "p99");
+
+        for (int i = 0; i < SEEK_STRESS_TYPE_NB; i++)
+        {
+            SeekStats &stStats = format.second[i];
+            int nSeeks = (int)stStats.vecLatency.size() + stStats.nFailed;
+            if (nSeeks == 0 && stStats.nStale == 0)
+            {
+                continue;
+            }
+            double dMax = stStats.vecLatency.empty() ? NAN : *std::max_element(stStats.vecLatency.begin(), stStats.vecLatency.end());
+            fprintf(fp, "%-9s %6d %5d %5d | %-12s%7.1f%7.1f%7.1f%7.1f | %-12s%7.1f%7.1f%7.1f\n",
+                TypeName((SeekStressType)i), nSeeks, stStats.nFailed, stStats.nStale, "",
+                Percentile(stStats.vecLatency, 50), Percentile(stStats.vecLatency, 90),
+                Percentile(stStats.vecLatency, 99), dMax, "",
+                Percentile(stStats.vecError, 50), Percentile(stStats.vecError, 90),
+                Percentile(stStats.vecError, 99));
+        }
+
+        //延迟直方图，各类型合并
+        int nHist[SEEK_STRESS_HIST_BUCKETS] = { 0 };
+        int nPeak = 0;
+        for (int i = 0; i < SEEK_STRESS_TYPE_NB; i++)
+        {
+            for (double dLatency : format.second[i].vecLatency)
+            {
+                int nBucket = dLatency < 1.0 ? 0 : (int)log2(dLatency) + 1;
+                nBucket = std::min(nBucket, SEEK_STRESS_HIST_BUCKETS - 1);
+                nPeak = std::max(nPeak, ++nHist[nBucket]);
+            }
+        }
+        fprintf(fp, "latency histogram:\n");
+        for (int i = 0; i < SEEK_STRESS_HIST_BUCKETS; i++)
+        {
+            if (nHist[i] == 0)
+            {
+                continue;
+            }
+            if (i == SEEK_STRESS_HIST_BUCKETS - 1)
+                fprintf(fp, "  >=%5d ms ", 1 << (i - 1));
+            else
+                fprintf(fp, "  < %5d ms ", 1 << i);
+            fprintf(fp, "%-40s %d\n", std::string(nHist[i] * 40 / std::max(nPeak, 1), '#').c_str(), nHist[i]);
+        }
+    }
+    fflush(fp);
+}
+
+bool SeekStress::HasErrors()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &format : m_mapStats)
+    {
+        for (auto &stStats : format.second)
+        {
+            if (stStats.nFailed || stStats.nStale)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const char *SeekStress::TypeName(SeekStressType eType)
+{
+    switch (eType)
+    {
+    case SEEK_STRESS_ABSOLUTE:
+        return "absolute";
+    case SEEK_STRESS_FORWARD:
+        return "+5s";
+    case SEEK_STRESS_BACKWARD:
+        return "-5s";
+    case SEEK_STRESS_CHAPTER:
+        return "chapter";
+    case SEEK_STRESS_BYTE:
+        return "byte";
+    default:
+        return "?";
+    }
+}
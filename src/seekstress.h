@@ -0,0 +1,124 @@
+﻿/*
+ * @file 	seekstress.h
+ * @date 	2026/10/18 16:20
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	seek 压力测试统计
+ * @note	无界面打开文件（画面输出到隐藏窗口）后连续发起随机 seek，记录从发起到新位置第一帧显示的延迟、
+ *			落点与目标的偏差，以及落点之后是否还显示了 seek 之前序号（serial）的帧，按封装格式输出分位数和直方图。
+ */
+#ifndef SEEKSTRESS_H
+#define SEEKSTRESS_H
+
+#include <map>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+#include <QString>
+
+#include "globalhelper.h"
+
+#define SEEK_STRESS_TIMEOUT_MS 5000 //单次 seek 等待落点的超时
+#define SEEK_STRESS_HIST_BUCKETS 14 //延迟直方图桶数，按 2 的幂划分（毫秒）
+
+enum SeekStressType {
+    SEEK_STRESS_ABSOLUTE,   //按进度条跳转
+    SEEK_STRESS_FORWARD,    //快进 5s
+    SEEK_STRESS_BACKWARD,   //快退 5s
+    SEEK_STRESS_CHAPTER,    //跳到章节
+    SEEK_STRESS_BYTE,       //按字节位置跳转
+    SEEK_STRESS_TYPE_NB
+};
+
+class SeekStress
+{
+public:
+    SeekStress();
+
+    /**
+     * @brief	开始统计一个文件，结果按封装格式归类
+     *
+     * @param	strFormat 封装格式名
+     */
+    void BeginFile(const QString &strFormat);
+
+    /**
+     * @brief	发起 seek 前调用
+     *
+     * @param	eType seek 类型
+     * @param	dTarget 目标时间（秒），按字节跳转时为 NAN
+     * @param	nSerial 发起时视频包队列的序号
+     */
+    void BeginSeek(SeekStressType eType, double dTarget, int nSerial);
+
+    /**
+     * @brief	渲染线程显示一帧时调用
+     *
+     * @param	dPts 帧时间戳（秒）
+     * @param	nSerial 帧序号
+     */
+    void OnPresent(double dPts, int nSerial);
+
+    /**
+     * @brief	等待新位置的第一帧显示
+     *
+     * @param	nTimeoutMs 超时（毫秒）
+     * @return	true 已显示 false 超时
+     */
+    bool WaitLanded(int nTimeoutMs);
+
+    /**
+     * @brief	结束当前 seek，没有落点的记为失败
+     */
+    void EndSeek();
+
+    /**
+     * @brief	输出统计结果
+     */
+    void Report(FILE *fp);
+
+    /**
+     * @brief	是否有失败的 seek 或在落点之后显示了旧序号的帧
+     */
+    bool HasErrors();
+
+    static const char *TypeName(SeekStressType eType);
+
+private:
+    typedef struct SeekStats {
+        std::vector<double> vecLatency;     //< 毫秒
+        std::vector<double> vecError;       //< 落点偏差绝对值，毫秒
+        int nFailed;
+        int nStale;
+    } SeekStats;
+
+    static double Percentile(std::vector<double> &vecValues, double dPercent);
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    std::map<QString, std::array<SeekStats, SEEK_STRESS_TYPE_NB>> m_mapStats; //< 按封装格式
+    std::map<QString, int> m_mapFiles;
+    QString m_strFormat;
+
+    //当前 seek
+    bool m_bPending;
+    bool m_bLanded;
+    SeekStressType m_eType;
+    double m_dTarget;
+    int m_nSerial;
+    int64_t m_nRequestTime;
+
+    //上一次完成的 seek：落点帧的序号，之后显示的帧不应更旧
+    bool m_bHasLanded;
+    int m_nLandedSerial;
+    SeekStressType m_eLandedType;
+};
+
+#endif // SEEKSTRESS_H
@@ -12,6 +12,7 @@
 
 #include <QDebug>
 #include <QMutex>
+#include <QCursor>
 
 #include "show.h"
 #include "ui_show.h"
@@ -42,12 +43,19 @@ Show::Show(QWidget *parent) :
     ui->label->setUpdatesEnabled(false);
 
     this->setMouseTracking(true);
+    //原生子窗口不处理鼠标移动，开启跟踪后未按键的移动事件也会传到本控件（全屏控制条）
+    ui->label->setMouseTracking(true);
     
 
 
     m_nLastFrameWidth = 0; ///< 记录视频宽高
     m_nLastFrameHeight = 0;
 
+    m_bDragging = false;
+
+    m_pQtRenderWid = new QtRenderWidget(this);
+    m_pQtRenderWid->hide();
+
     m_stActionGroup.addAction("全屏");
     m_stActionGroup.addAction("暂停");
     m_stActionGroup.addAction("停止");
@@ -59,6 +67,8 @@ Show::Show(QWidget *parent) :
 
 Show::~Show()
 {
+    //刷新线程不再使用即将销毁的控件
+    VideoCtl::GetInstance()->SetQtRenderWidget(nullptr);
     delete ui;
 }
 
@@ -71,7 +81,7 @@ bool Show::Init()
 
 	//ui->label->setUpdatesEnabled(false);
 
-
+    VideoCtl::GetInstance()->SetQtRenderWidget(m_pQtRenderWid);
 
 
 	return true;
@@ -93,6 +103,7 @@ void Show::ChangeShow()
     if (m_nLastFrameWidth == 0 && m_nLastFrameHeight == 0)
     {
         ui->label->setGeometry(0, 0, width(), height());
+        m_pQtRenderWid->setGeometry(0, 0, width(), height());
     }
     else
     {
@@ -115,9 +126,17 @@ void Show::ChangeShow()
 
 
         ui->label->setGeometry(x, y, width, height);
+        m_pQtRenderWid->setGeometry(x, y, width, height);
     }
 
     g_show_rect_mutex.unlock();
+
+    //控制条与画面同宽，画在画面底部
+    m_stOsd.SetOutputSize(ui->label->width(), ui->label->height(), devicePixelRatioF());
+
+    //小窗口播放重文件时改用代理
+    VideoCtl::GetInstance()->SetViewState(lrint(ui->label->width() * devicePixelRatioF()),
+        lrint(ui->label->height() * devicePixelRatioF()), m_stOsd.IsEnabled());
 }
 
 void Show::dragEnterEvent(QDragEnterEvent *event)
@@ -139,6 +158,28 @@ void Show::resizeEvent(QResizeEvent *event)
 void Show::keyReleaseEvent(QKeyEvent *event)
 {
     qDebug() << "Show::keyPressEvent:" << event->key();
+    //Ctrl + 方向键平移放大后的画面
+    if (event->modifiers() & Qt::ControlModifier)
+    {
+        switch (event->key())
+        {
+        case Qt::Key_Left:
+            emit SigPan(0.1, 0);
+            return;
+        case Qt::Key_Right:
+            emit SigPan(-0.1, 0);
+            return;
+        case Qt::Key_Up:
+            emit SigPan(0, 0.1);
+            return;
+        case Qt::Key_Down:
+            emit SigPan(0, -0.1);
+            return;
+        default:
+            break;
+        }
+    }
+
     switch (event->key())
     {
     case Qt::Key_Return://全屏
@@ -160,6 +201,16 @@ void Show::keyReleaseEvent(QKeyEvent *event)
     case Qt::Key_Space://减少10音量
         emit SigPlayOrPause();
         break;
+    case Qt::Key_Plus://放大
+    case Qt::Key_Equal:
+        emit SigZoom(1, 0.5, 0.5);
+        break;
+    case Qt::Key_Minus://缩小
+        emit SigZoom(-1, 0.5, 0.5);
+        break;
+    case Qt::Key_0://恢复原始大小
+        emit SigZoomReset();
+        break;
 
     default:
         QWidget::keyPressEvent(event);
@@ -174,14 +225,76 @@ void Show::keyReleaseEvent(QKeyEvent *event)
 // }
 void Show::mousePressEvent(QMouseEvent *event)
 {
+    if (event->button() == Qt::LeftButton && m_stOsd.OnMousePress(event->pos() - ui->label->geometry().topLeft()))
+    {
+        event->accept();
+        return;
+    }
+
     if (event->buttons() & Qt::RightButton)
     {
         emit SigShowMenu();
     }
+    else if (event->button() == Qt::LeftButton)
+    {
+        m_bDragging = true;
+        m_stLastDragPos = event->pos();
+    }
 
     QWidget::mousePressEvent(event);
 }
 
+void Show::mouseMoveEvent(QMouseEvent *event)
+{
+    m_stOsd.OnMouseMove(event->pos() - ui->label->geometry().topLeft());
+
+    if (m_bDragging && (event->buttons() & Qt::LeftButton))
+    {
+        QRect rect = ui->label->geometry();
+        QPoint delta = event->pos() - m_stLastDragPos;
+        m_stLastDragPos = event->pos();
+        if (rect.width() > 0 && rect.height() > 0 && !delta.isNull())
+        {
+            emit SigPan((double)delta.x() / rect.width(), (double)delta.y() / rect.height());
+        }
+    }
+
+    QWidget::mouseMoveEvent(event);
+}
+
+void Show::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_bDragging = false;
+    }
+
+    QWidget::mouseReleaseEvent(event);
+}
+
+void Show::leaveEvent(QEvent *event)
+{
+    m_stOsd.OnMouseLeave();
+
+    QWidget::leaveEvent(event);
+}
+
+void Show::wheelEvent(QWheelEvent *event)
+{
+    QRect rect = ui->label->geometry();
+    int nSteps = event->angleDelta().y() / 120;
+    if (nSteps == 0 || rect.width() <= 0 || rect.height() <= 0)
+    {
+        QWidget::wheelEvent(event);
+        return;
+    }
+
+    //鼠标所指的点在画面中的相对位置
+    QPoint pos = mapFromGlobal(QCursor::pos()) - rect.topLeft();
+    emit SigZoom(nSteps, (double)pos.x() / rect.width(), (double)pos.y() / rect.height());
+    event->accept();
+}
+
 void Show::OnDisplayMsg(QString strMsg)
 {
 	qDebug() << "Show::OnDisplayMsg " << strMsg;
@@ -189,9 +302,23 @@ void Show::OnDisplayMsg(QString strMsg)
 
 void Show::OnPlay(QString strFile)
 {
+    //Qt 输出画在普通控件上，隐藏原生子窗口
+    bool bQtRender = VideoCtl::GetInstance()->GetRenderBackend() == RENDER_BACKEND_QT;
+    ui->label->setVisible(!bQtRender);
+    m_pQtRenderWid->setVisible(bQtRender);
+
     VideoCtl::GetInstance()->StartPlay(strFile, ui->label->winId());
 }
 
+void Show::OnSchedulePlay(QString strFile, QDateTime dtStart)
+{
+    bool bQtRender = VideoCtl::GetInstance()->GetRenderBackend() == RENDER_BACKEND_QT;
+    ui->label->setVisible(!bQtRender);
+    m_pQtRenderWid->setVisible(bQtRender);
+
+    VideoCtl::GetInstance()->SchedulePlay(strFile, ui->label->winId(), dtStart);
+}
+
 void Show::OnStopFinished()
 {
     update();
@@ -204,6 +331,29 @@ void Show::OnTimerShowCursorUpdate()
     //setCursor(Qt::BlankCursor);
 }
 
+void Show::SetFullScreen(bool bFullScreen)
+{
+    m_stOsd.SetEnabled(bFullScreen);
+    VideoCtl::GetInstance()->SetViewState(lrint(ui->label->width() * devicePixelRatioF()),
+        lrint(ui->label->height() * devicePixelRatioF()), bFullScreen);
+    if (!bFullScreen)
+    {
+        unsetCursor();
+    }
+}
+
+void Show::OnOsdShownChanged(bool bShown)
+{
+    if (bShown || !m_stOsd.IsEnabled())
+    {
+        unsetCursor();
+    }
+    else
+    {
+        setCursor(Qt::BlankCursor);
+    }
+}
+
 void Show::OnActionsTriggered(QAction *action)
 {
     QString strAction = action->text();
@@ -235,6 +385,18 @@ bool Show::ConnectSignalSlots()
 
     connect(&m_stActionGroup, &QActionGroup::triggered, this, &Show::OnActionsTriggered);
 
+    //全屏控制条
+    VideoCtl *pVideoCtl = VideoCtl::GetInstance();
+    connect(&m_stOsd, &Osd::SigPlaySeek, this, &Show::SigPlaySeek);
+    connect(&m_stOsd, &Osd::SigPlayOrPause, this, &Show::SigPlayOrPause);
+    connect(&m_stOsd, &Osd::SigStop, this, &Show::SigStop);
+    connect(&m_stOsd, &Osd::SigExitFullScreen, this, &Show::SigFullScreen);
+    connect(&m_stOsd, &Osd::SigShownChanged, this, &Show::OnOsdShownChanged);
+    connect(pVideoCtl, &VideoCtl::SigVideoTotalSeconds, &m_stOsd, &Osd::OnVideoTotalSeconds);
+    connect(pVideoCtl, &VideoCtl::SigVideoPlaySeconds, &m_stOsd, &Osd::OnVideoPlaySeconds);
+    connect(pVideoCtl, &VideoCtl::SigPauseStat, &m_stOsd, &Osd::OnPauseStat, Qt::QueuedConnection);
+    connect(pVideoCtl, &VideoCtl::SigStopFinished, &m_stOsd, &Osd::OnStopFinished, Qt::QueuedConnection);
+
 	for (bool bReturn : listRet)
 	{
 		if (bReturn == false)
@@ -17,11 +17,14 @@
 #include <QTimer>
 #include <QDragEnterEvent>
 #include <QKeyEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
 #include <QMenu>
 #include <QActionGroup>
 #include <QAction>
 
 #include "videoctl.h"
+#include "osd.h"
 
 namespace Ui {
 class Show;
@@ -73,6 +76,13 @@ protected:
 
 
     void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void leaveEvent(QEvent *event);
+    /**
+     * @brief	滚轮缩放画面
+     */
+    void wheelEvent(QWheelEvent *event);
     //void contextMenuEvent(QContextMenuEvent* event);
 public:
     /**
@@ -82,6 +92,13 @@ public:
     * @note
     */
     void OnPlay(QString strFile);
+    /**
+    * @brief	在指定时间开始播放
+    *
+    * @param	strFile 文件名
+    * @param	dtStart 开始时间
+    */
+    void OnSchedulePlay(QString strFile, QDateTime dtStart);
     void OnStopFinished();
 
     /**
@@ -93,6 +110,11 @@ public:
      * @note
      */
     void OnFrameDimensionsChanged(int nFrameWidth, int nFrameHeight);
+
+    /**
+     * @brief	进入、退出全屏，全屏时在画面上显示控制条
+     */
+    void SetFullScreen(bool bFullScreen);
 private:
 	/**
 	 * @brief	显示信息
@@ -106,6 +128,9 @@ private:
     void OnTimerShowCursorUpdate();
 
     void OnActionsTriggered(QAction *action);
+
+    //全屏控制条显示时显示光标，隐藏时隐藏光标
+    void OnOsdShownChanged(bool bShown);
 private:
 	/**
 	 * @brief	连接信号槽	
@@ -122,11 +147,16 @@ signals:
     void SigPlayOrPause();
     void SigStop();
     void SigShowMenu();
+    void SigPlaySeek(double dPercent);
 
     void SigSeekForward();
     void SigSeekBack();
     void SigAddVolume();
     void SigSubVolume();
+
+    void SigZoom(int nSteps, double dX, double dY); ///< 以画面上的点(相对位置)为中心缩放
+    void SigPan(double dDx, double dDy);            ///< 平移，相对画面宽高的比例
+    void SigZoomReset();
 private:
     Ui::Show *ui;
 
@@ -137,6 +167,13 @@ private:
 
     QMenu m_stMenu;
     QActionGroup m_stActionGroup;
+
+    bool m_bDragging; ///< 左键拖动平移
+    QPoint m_stLastDragPos;
+
+    QtRenderWidget *m_pQtRenderWid; ///< Qt 画面输出，与 label 位置相同，按输出方式二选一显示
+
+    Osd m_stOsd; ///< 全屏控制条
 };
 
 #endif // DISPLAY_H
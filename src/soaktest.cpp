@@ -0,0 +1,298 @@
+﻿/*
+ * @file 	soaktest.cpp
+ * @date 	2026/10/18 17:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	长时间运行（浸泡）测试统计
+ * @note
+ */
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(Q_OS_WIN)
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#elif defined(Q_OS_MAC)
+#include <dirent.h>
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#elif defined(Q_OS_LINUX)
+#include <dirent.h>
+#include <unistd.h>
+#include <malloc.h>
+#endif
+
+#include "soaktest.h"
+
+#if defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+//目录下的条目数（不含 . 和 ..）
+static int count_dir_entries(const char *path)
+{
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    int count = 0;
+
+    if (!dir)
+        return -1;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+            count++;
+    }
+    closedir(dir);
+    //减去 opendir 自己占用的句柄
+    return count - 1;
+}
+#endif
+
+SoakTest::SoakTest() :
+    m_nCycles(0),
+    m_nDecoded(0),
+    m_dExpected(0),
+    m_nDropped(0),
+    m_dDriftSum(0),
+    m_nDriftCount(0)
+{
+}
+
+bool SoakTest::ReadProcessStats(double *pRssMB, double *pHeapMB, int *pFds, int *pThreads)
+{
+    *pRssMB = -1;
+    *pHeapMB = -1;
+    *pFds = -1;
+    *pThreads = -1;
+
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        *pRssMB = pmc.WorkingSetSize / (1024.0 * 1024.0);
+
+    DWORD dwHandles = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &dwHandles))
+        *pFds = (int)dwHandles;
+
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (hSnapshot != INVALID_HANDLE_VALUE) {
+        THREADENTRY32 te;
+        DWORD dwPid = GetCurrentProcessId();
+        int nThreads = 0;
+        te.dwSize = sizeof(te);
+        if (Thread32First(hSnapshot, &te)) {
+            do {
+                if (te.th32OwnerProcessID == dwPid)
+                    nThreads++;
+            } while (Thread32Next(hSnapshot, &te));
+        }
+        CloseHandle(hSnapshot);
+        *pThreads = nThreads;
+    }
+    return true;
+#elif defined(Q_OS_MAC)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+        *pRssMB = info.resident_size / (1024.0 * 1024.0);
+
+    malloc_statistics_t stats;
+    malloc_zone_statistics(NULL, &stats);
+    *pHeapMB = stats.size_in_use / (1024.0 * 1024.0);
+
+    *pFds = count_dir_entries("/dev/fd");
+
+    thread_act_array_t threads;
+    mach_msg_type_number_t thread_count;
+    if (task_threads(mach_task_self(), &threads, &thread_count) == KERN_SUCCESS) {
+        for (mach_msg_type_number_t i = 0; i < thread_count; i++)
+            mach_port_deallocate(mach_task_self(), threads[i]);
+        vm_deallocate(mach_task_self(), (vm_address_t)threads, thread_count * sizeof(thread_act_t));
+        *pThreads = (int)thread_count;
+    }
+    return true;
+#elif defined(Q_OS_LINUX)
+    FILE *fp;
+    long pages;
+
+    if ((fp = fopen("/proc/self/statm", "r"))) {
+        if (fscanf(fp, "%*s %ld", &pages) == 1)
+            *pRssMB = pages * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+        fclose(fp);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+    *pHeapMB = (mi.uordblks + mi.hblkhd) / (1024.0 * 1024.0);
+#elif defined(__GLIBC__)
+    struct mallinfo mi = mallinfo();
+    *pHeapMB = ((unsigned int)mi.uordblks + (unsigned int)mi.hblkhd) / (1024.0 * 1024.0);
+#endif
+
+    *pFds = count_dir_entries("/proc/self/fd");
+
+    if ((fp = fopen("/proc/self/status", "r"))) {
+        char line[256];
+        while (fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "Threads: %d", pThreads) == 1)
+                break;
+        }
+        fclose(fp);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SoakTest::AddPlayback(int64_t nDecoded, double dExpected, int64_t nDropped)
+{
+    m_nDecoded += nDecoded;
+    m_dExpected += dExpected;
+    m_nDropped += nDropped;
+}
+
+void SoakTest::AddDrift(double dDiff)
+{
+    if (std::isnan(dDiff))
+    {
+        return;
+    }
+    m_dDriftSum += fabs(dDiff) * 1000.0;
+    m_nDriftCount++;
+}
+
+void SoakTest::AddCycle()
+{
+    m_nCycles++;
+}
+
+void SoakTest::TakeSample(double dMinutes, FILE *fp)
+{
+    SoakSample stSample;
+
+    stSample.dMinutes = dMinutes;
+    ReadProcessStats(&stSample.dRssMB, &stSample.dHeapMB, &stSample.nFds, &stSample.nThreads);
+    stSample.dDecodeRatio = m_dExpected > 0 ? m_nDecoded / m_dExpected : NAN;
+    stSample.dDropRate = m_nDecoded > 0 ? (double)m_nDropped / m_nDecoded : NAN;
+    stSample.dDriftMs = m_nDriftCount > 0 ? m_dDriftSum / m_nDriftCount : NAN;
+    m_vecSamples.push_back(stSample);
+
+    if (m_vecSamples.size() == 1)
+    {
+        fprintf(fp, "%8s %7s %9s %9s %5s %7s %7s %7s %8s\n",
+            "minutes", "cycles", "rss MB", "heap MB", "fds", "threads", "decode", "drops", "drift ms");
+    }
+    fprintf(fp, "%8.1f %7d %9.1f %9.1f %5d %7d %7.3f %7.4f %8.1f\n",
+        stSample.dMinutes, m_nCycles, stSample.dRssMB, stSample.dHeapMB, stSample.nFds, stSample.nThreads,
+        stSample.dDecodeRatio, stSample.dDropRate, stSample.dDriftMs);
+    fflush(fp);
+
+    m_nDecoded = 0;
+    m_dExpected = 0;
+    m_nDropped = 0;
+    m_dDriftSum = 0;
+    m_nDriftCount = 0;
+}
+
+double SoakTest::FitSlope(const std::vector<double> &vecX, const std::vector<double> &vecY, double *pIntercept)
+{
+    double dMeanX = 0, dMeanY = 0, dSxx = 0, dSxy = 0;
+    size_t n = vecX.size();
+
+    for (size_t i = 0; i < n; i++)
+    {
+        dMeanX += vecX[i];
+        dMeanY += vecY[i];
+    }
+    dMeanX /= n;
+    dMeanY /= n;
+    for (size_t i = 0; i < n; i++)
+    {
+        dSxx += (vecX[i] - dMeanX) * (vecX[i] - dMeanX);
+        dSxy += (vecX[i] - dMeanX) * (vecY[i] - dMeanY);
+    }
+
+    double dSlope = dSxx > 0 ? dSxy / dSxx : 0;
+    *pIntercept = dMeanY - dSlope * (dMeanX - vecX[0]);
+    return dSlope;
+}
+
+bool SoakTest::StepUp(const std::vector<double> &vecY)
+{
+    size_t nQuarter = std::max(vecY.size() / 4, (size_t)1);
+    double dFirstMax = *std::max_element(vecY.begin(), vecY.begin() + nQuarter);
+    double dLastMin = *std::min_element(vecY.end() - nQuarter, vecY.end());
+    return dLastMin > dFirstMax;
+}
+
+bool SoakTest::Analyze(FILE *fp)
+{
+    //预热阶段（缓存、解码器池、字体等）的增长不计
+    size_t nWarmup = std::max(m_vecSamples.size() / 10, (size_t)2);
+    bool bPassed = true;
+
+    fprintf(fp, "\n%d play cycles, %d samples\n", m_nCycles, (int)m_vecSamples.size());
+    if (m_vecSamples.size() < nWarmup + SOAK_MIN_SAMPLES)
+    {
+        fprintf(fp, "run too short to judge trends (need %d samples after warm-up)\n", SOAK_MIN_SAMPLES);
+        return true;
+    }
+
+    //逐项拟合，跳过无法获取的值
+    auto check = [&](const char *pName, double (*pfnValue)(const SoakSample &), bool bStepRule,
+        double dMaxRise, double dMinRise, double dMaxFall) {
+        std::vector<double> vecX, vecY;
+        for (size_t i = nWarmup; i < m_vecSamples.size(); i++)
+        {
+            double dValue = pfnValue(m_vecSamples[i]);
+            if (dValue >= 0 && !std::isnan(dValue))
+            {
+                vecX.push_back(m_vecSamples[i].dMinutes);
+                vecY.push_back(dValue);
+            }
+        }
+        if (vecY.size() < SOAK_MIN_SAMPLES)
+        {
+            fprintf(fp, "%-10s n/a\n", pName);
+            return;
+        }
+
+        double dStart;
+        double dSlope = FitSlope(vecX, vecY, &dStart);
+        double dChange = dSlope * (vecX.back() - vecX.front());
+        bool bFailed;
+        if (bStepRule)
+            bFailed = StepUp(vecY);
+        else
+            bFailed = (dChange > dMinRise && dSlope * 60 > dMaxRise) || dChange < -dMaxFall;
+
+        fprintf(fp, "%-10s %10.3f -> %10.3f  (%+.3f/hour)  %s\n", pName, dStart, dStart + dChange, dSlope * 60,
+            bFailed ? "FAIL" : "ok");
+        if (bFailed)
+        {
+            bPassed = false;
+        }
+    };
+
+    check("rss MB", [](const SoakSample &s) { return s.dRssMB; }, false,
+        SOAK_MEM_SLOPE_MB_PER_HOUR, SOAK_MEM_MIN_GROWTH_MB, INFINITY);
+    check("heap MB", [](const SoakSample &s) { return s.dHeapMB; }, false,
+        SOAK_MEM_SLOPE_MB_PER_HOUR, SOAK_MEM_MIN_GROWTH_MB, INFINITY);
+    check("fds", [](const SoakSample &s) { return (double)s.nFds; }, true, 0, 0, 0);
+    check("threads", [](const SoakSample &s) { return (double)s.nThreads; }, true, 0, 0, 0);
+    check("decode", [](const SoakSample &s) { return s.dDecodeRatio; }, false,
+        INFINITY, INFINITY, SOAK_DECODE_RATIO_DROP);
+    check("drops", [](const SoakSample &s) { return s.dDropRate; }, false,
+        0, SOAK_DROP_RATE_RISE, INFINITY);
+    check("drift ms", [](const SoakSample &s) { return s.dDriftMs; }, false,
+        0, SOAK_DRIFT_RISE_MS, INFINITY);
+
+    fprintf(fp, "%s\n", bPassed ? "PASSED" : "FAILED");
+    fflush(fp);
+    return bPassed;
+}
@@ -0,0 +1,103 @@
+﻿/*
+ * @file 	soaktest.h
+ * @date 	2026/10/18 17:10
+ *
+ * @author 	itisyang
+ * @Contact	itisyang@gmail.com
+ *
+ * @brief 	长时间运行（浸泡）测试统计
+ * @note	按固定周期采样进程内存、堆、文件句柄、线程数，以及解码速度、丢帧率、音画偏差，
+ *			去掉预热阶段后做线性拟合，有持续上升（或解码速度持续下降）的趋势即判为失败。
+ */
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <vector>
+#include <cstdio>
+
+#include "globalhelper.h"
+
+#define SOAK_MIN_SAMPLES 6              //去掉预热后至少需要的采样数，不足时不做判断
+#define SOAK_MEM_SLOPE_MB_PER_HOUR 2.0  //内存增长速度上限
+#define SOAK_MEM_MIN_GROWTH_MB 8.0      //内存拟合增长量低于该值视为噪声
+#define SOAK_DECODE_RATIO_DROP 0.05     //解码速度（相对标称帧率）允许的下降
+#define SOAK_DROP_RATE_RISE 0.02        //丢帧率允许的上升
+#define SOAK_DRIFT_RISE_MS 20.0         //音画偏差允许的上升
+
+typedef struct SoakSample {
+    double dMinutes;        //距开始的分钟数
+    double dRssMB;          //常驻内存，-1 表示无法获取
+    double dHeapMB;         //堆已分配，-1 表示无法获取
+    int nFds;               //打开的文件句柄，-1 表示无法获取
+    int nThreads;           //线程数，-1 表示无法获取
+    double dDecodeRatio;    //解码帧数 / 按标称帧率应解码的帧数
+    double dDropRate;       //丢帧 / 解码帧数
+    double dDriftMs;        //音画偏差绝对值的平均
+} SoakSample;
+
+class SoakTest
+{
+public:
+    SoakTest();
+
+    /**
+     * @brief	读取进程资源占用
+     *
+     * @return	true 成功 false 当前平台不支持
+     */
+    static bool ReadProcessStats(double *pRssMB, double *pHeapMB, int *pFds, int *pThreads);
+
+    /**
+     * @brief	累加一段播放的统计，在两次采样之间反复调用
+     *
+     * @param	nDecoded 解码帧数
+     * @param	dExpected 按标称帧率应解码的帧数
+     * @param	nDropped 丢帧数
+     */
+    void AddPlayback(int64_t nDecoded, double dExpected, int64_t nDropped);
+
+    /**
+     * @brief	累加一次音画偏差
+     *
+     * @param	dDiff 视频时钟 - 音频时钟（秒）
+     */
+    void AddDrift(double dDiff);
+
+    /**
+     * @brief	完成一次打开/播放/关闭
+     */
+    void AddCycle();
+
+    /**
+     * @brief	采样一次并输出一行，清空播放统计
+     *
+     * @param	dMinutes 距开始的分钟数
+     */
+    void TakeSample(double dMinutes, FILE *fp);
+
+    /**
+     * @brief	分析趋势并输出结论
+     *
+     * @return	true 通过 false 有持续增长
+     */
+    bool Analyze(FILE *fp);
+
+private:
+    //最小二乘拟合，返回斜率（每分钟），pIntercept 为 x = x0 处的值
+    static double FitSlope(const std::vector<double> &vecX, const std::vector<double> &vecY, double *pIntercept);
+    //后四分之一的最小值超过前四分之一的最大值
+    static bool StepUp(const std::vector<double> &vecY);
+
+private:
+    std::vector<SoakSample> m_vecSamples;
+    int m_nCycles;
+
+    //当前采样周期内的播放统计
+    int64_t m_nDecoded;
+    double m_dExpected;
+    int64_t m_nDropped;
+    double m_dDriftSum;
+    int m_nDriftCount;
+};
+
+#endif // SOAKTEST_H
@@ -11,21 +11,81 @@
 
 
 #include <QDebug>
-#include <QMutex>
+#include <QTimer>
 #include <thread>
+#include <new>
+#include <algorithm>
 #include "videoctl.h"
 
 #pragma execution_character_set("utf-8")
 
-extern QMutex g_show_rect_mutex;
-
 static int framedrop = -1;
 static int infinite_buffer = -1;
+static int decoder_pool = 1;
+static int frame_pool = FRAME_POOL_HUGE_PAGES;
+static int fast_first_frame = 1;
+static int color_manage = 1;
+static int proxy_enable = 1;
+static int display_disable = 0;
+static int audio_disable = 0;
 static int64_t audio_callback_time;
 
 #define FF_QUIT_EVENT    (SDL_USEREVENT + 2)
 
-int VideoCtl::realloc_texture(SDL_Texture **texture, Uint32 new_format, int new_width, int new_height, SDL_BlendMode blendmode, int init_texture)
+#define ZOOM_MAX         16.0
+#define ZOOM_STEP        1.25
+
+#define OUTPUT_TRANSITION_SETTLE  0.3   //最后一次按新大小显示后没有新的大小变化，视为切换完成（秒）
+#define OUTPUT_TRANSITION_TIMEOUT 5.0   //超时不再统计（秒）
+#define SCHEDULE_PREROLL_LEAD 2.0       //定时播放提前打开文件预加载的时间（秒），之前继续当前播放
+#define SCHEDULE_SPIN_TIME 0.002        //开始时间前最后一段改为忙等，避免睡眠精度带来的误差（秒）
+#define PROXY_SWITCH_DELAY_MS 300       //状态变化后延迟切换代理的时间，连续变化只切换一次
+#define PROXY_SMALL_VIEW_SCALE 1.5      //画面显示短边不超过代理短边的该倍数视为小窗口
+
+//从显示矩阵得到顺时针旋转角度和是否水平镜像，帧上的优先于流上的
+static void get_display_orientation(AVStream *st, AVFrame *frame, double *rotation, int *flip_h)
+{
+    AVFrameSideData *sd = av_frame_get_side_data(frame, AV_FRAME_DATA_DISPLAYMATRIX);
+    const int32_t *displaymatrix = NULL;
+    int32_t matrix[9];
+    double theta;
+
+    *rotation = 0;
+    *flip_h = 0;
+
+    if (sd && sd->size >= sizeof(matrix))
+        displaymatrix = (const int32_t *)sd->data;
+    else if (st)
+        displaymatrix = (const int32_t *)av_stream_get_side_data(st, AV_PKT_DATA_DISPLAYMATRIX, NULL);
+    if (!displaymatrix)
+        return;
+
+    /* 行列式为负说明带镜像，去掉镜像后再取旋转角 */
+    memcpy(matrix, displaymatrix, sizeof(matrix));
+    if ((int64_t)matrix[0] * matrix[4] - (int64_t)matrix[1] * matrix[3] < 0) {
+        av_display_matrix_flip(matrix, 1, 0);
+        *flip_h = 1;
+    }
+
+    theta = -round(av_display_rotation_get(matrix));
+    if (isnan(theta)) {
+        *flip_h = 0;
+        return;
+    }
+    /* 显示矩阵先旋转后镜像，SDL 先镜像后旋转，镜像时角度取反 */
+    if (*flip_h)
+        theta = -theta;
+    theta -= 360 * floor(theta / 360 + 0.9 / 360);
+    *rotation = theta;
+}
+
+//是否旋转了 90 或 270 度（宽高互换）
+static int is_transposed(double rotation)
+{
+    return fabs(fmod(rotation, 180.0) - 90.0) < 1.0;
+}
+
+int VideoCtl::realloc_texture(SDL_Renderer *renderer, SDL_Texture **texture, Uint32 new_format, int new_width, int new_height, SDL_BlendMode blendmode, int init_texture)
 {
     Uint32 format;
     int access, w, h;
@@ -49,10 +109,11 @@ int VideoCtl::realloc_texture(SDL_Texture **texture, Uint32 new_format, int new_
 
 void VideoCtl::calculate_display_rect(SDL_Rect *rect,
     int scr_xleft, int scr_ytop, int scr_width, int scr_height,
-    int pic_width, int pic_height, AVRational pic_sar)
+    int pic_width, int pic_height, AVRational pic_sar, double rotation)
 {
     float aspect_ratio;
     int width, height, x, y;
+    int transposed = is_transposed(rotation);
 
     if (pic_sar.num == 0)
         aspect_ratio = 0;
@@ -62,6 +123,8 @@ void VideoCtl::calculate_display_rect(SDL_Rect *rect,
     if (aspect_ratio <= 0.0)
         aspect_ratio = 1.0;
     aspect_ratio *= (float)pic_width / (float)pic_height;
+    if (transposed)
+        aspect_ratio = 1.0f / aspect_ratio;
 
     /* XXX: we suppose the screen has a 1.0 pixel ratio */
     height = scr_height;
@@ -76,9 +139,27 @@ void VideoCtl::calculate_display_rect(SDL_Rect *rect,
     rect->y = scr_ytop + y;
     rect->w = FFMAX(width, 1);
     rect->h = FFMAX(height, 1);
+
+    /* SDL 绕矩形中心旋转，旋转前的矩形宽高互换、中心不变 */
+    if (transposed) {
+        *rect = rotated_display_rect(*rect, 90);
+    }
+}
+
+SDL_Rect VideoCtl::rotated_display_rect(const SDL_Rect &rect, double rotation)
+{
+    SDL_Rect rotated = rect;
+
+    if (is_transposed(rotation)) {
+        rotated.x = rect.x + (rect.w - rect.h) / 2;
+        rotated.y = rect.y + (rect.h - rect.w) / 2;
+        rotated.w = rect.h;
+        rotated.h = rect.w;
+    }
+    return rotated;
 }
 
-int VideoCtl::upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext **img_convert_ctx) {
+int VideoCtl::upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext **img_convert_ctx, const SDL_Rect *roi) {
     int ret = 0;
     switch (frame->format) {
     case AV_PIX_FMT_YUV420P:
@@ -86,29 +167,55 @@ int VideoCtl::upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext
             av_log(NULL, AV_LOG_ERROR, "Negative linesize is not supported for YUV.\n");
             return -1;
         }
+        if (roi) {
+            //只上传缩放区域
+            ret = SDL_UpdateYUVTexture(tex, roi,
+                frame->data[0] + roi->y * frame->linesize[0] + roi->x, frame->linesize[0],
+                frame->data[1] + roi->y / 2 * frame->linesize[1] + roi->x / 2, frame->linesize[1],
+                frame->data[2] + roi->y / 2 * frame->linesize[2] + roi->x / 2, frame->linesize[2]);
+            break;
+        }
         ret = SDL_UpdateYUVTexture(tex, NULL, frame->data[0], frame->linesize[0],
             frame->data[1], frame->linesize[1],
             frame->data[2], frame->linesize[2]);
         break;
     case AV_PIX_FMT_BGRA:
         if (frame->linesize[0] < 0) {
+            //倒序存放时纹理行序与缩放区域不一致，整帧上传
             ret = SDL_UpdateTexture(tex, NULL, frame->data[0] + frame->linesize[0] * (frame->height - 1), -frame->linesize[0]);
         }
+        else if (roi) {
+            ret = SDL_UpdateTexture(tex, roi, frame->data[0] + roi->y * frame->linesize[0] + roi->x * 4, frame->linesize[0]);
+        }
         else {
             ret = SDL_UpdateTexture(tex, NULL, frame->data[0], frame->linesize[0]);
         }
         break;
-    default:
+    default: {
         /* This should only happen if we are not using avfilter... */
+        AVFrame *src = frame;
+        AVFrame *view = NULL;
+
+        //缩放时只转换可见区域：按 roi 裁剪出帧引用，只锁定纹理的对应区域。
+        //倒序存放时纹理行序与缩放区域不一致，整帧转换
+        if (roi && frame->linesize[0] > 0 && (view = av_frame_alloc()) && av_frame_ref(view, frame) >= 0) {
+            view->crop_left = roi->x;
+            view->crop_top = roi->y;
+            view->crop_right = frame->width - roi->x - roi->w;
+            view->crop_bottom = frame->height - roi->y - roi->h;
+            if (av_frame_apply_cropping(view, AV_FRAME_CROP_UNALIGNED) >= 0)
+                src = view;
+        }
+
         *img_convert_ctx = sws_getCachedContext(*img_convert_ctx,
-            frame->width, frame->height, (AVPixelFormat)frame->format, frame->width, frame->height,
+            src->width, src->height, (AVPixelFormat)src->format, src->width, src->height,
             AV_PIX_FMT_BGRA, SWS_BICUBIC, NULL, NULL, NULL);
         if (*img_convert_ctx != NULL) {
             uint8_t *pixels[4];
             int pitch[4];
-            if (!SDL_LockTexture(tex, NULL, (void **)pixels, pitch)) {
-                sws_scale(*img_convert_ctx, (const uint8_t * const *)frame->data, frame->linesize,
-                    0, frame->height, pixels, pitch);
+            if (!SDL_LockTexture(tex, src == view ? roi : NULL, (void **)pixels, pitch)) {
+                sws_scale(*img_convert_ctx, (const uint8_t * const *)src->data, src->linesize,
+                    0, src->height, pixels, pitch);
                 SDL_UnlockTexture(tex);
             }
         }
@@ -116,18 +223,304 @@ int VideoCtl::upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext
             av_log(NULL, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
             ret = -1;
         }
+        av_frame_free(&view);
         break;
     }
+    }
+    return ret;
+}
+
+void VideoCtl::fit_texture_size(const SDL_RendererInfo *info, int width, int height, int *tex_width, int *tex_height)
+{
+    double scale = 1.0;
+
+    if (info && info->max_texture_width > 0 && width > info->max_texture_width)
+        scale = FFMIN(scale, (double)info->max_texture_width / width);
+    if (info && info->max_texture_height > 0 && height > info->max_texture_height)
+        scale = FFMIN(scale, (double)info->max_texture_height / height);
+    *tex_width = FFMAX((int)(width * scale), 1);
+    *tex_height = FFMAX((int)(height * scale), 1);
+}
+
+//不超出时为一整块；超出时各块尽量等大，起点按 16 对齐，保证各种色度抽样下平面偏移都是整数
+static int tile_size(int size, int max_size)
+{
+    int count;
+
+    if (size <= max_size)
+        return size;
+    count = (size + max_size - 1) / max_size;
+    return FFMIN(FFALIGN((size + count - 1) / count, 16), max_size & ~15);
+}
+
+int VideoCtl::realloc_tiles(SDL_Renderer *renderer, const SDL_RendererInfo *info, VideoTiles *tiles, Uint32 format, int width, int height)
+{
+    int max_w = info && info->max_texture_width > 0 ? info->max_texture_width : width;
+    int max_h = info && info->max_texture_height > 0 ? info->max_texture_height : height;
+    int tile_w, tile_h, cols, rows;
+
+    tile_w = tile_size(width, max_w);
+    tile_h = tile_size(height, max_h);
+    if (tile_w <= 0 || tile_h <= 0)
+        return -1;
+    cols = (width + tile_w - 1) / tile_w;
+    rows = (height + tile_h - 1) / tile_h;
+
+    if (tiles->cols != cols || tiles->rows != rows) {
+        VideoTile *new_tiles;
+        free_tiles(tiles);
+        if (!(new_tiles = (VideoTile *)av_calloc(cols * rows, sizeof(VideoTile))))
+            return AVERROR(ENOMEM);
+        tiles->tiles = new_tiles;
+        tiles->nb_tiles = cols * rows;
+        tiles->cols = cols;
+        tiles->rows = rows;
+        if (tiles->nb_tiles > 1)
+            av_log(NULL, AV_LOG_VERBOSE, "Frame %dx%d exceeds the maximum texture size %dx%d, split into %dx%d tiles.\n",
+                width, height, max_w, max_h, cols, rows);
+    }
+    tiles->width = width;
+    tiles->height = height;
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            VideoTile *tile = &tiles->tiles[r * cols + c];
+            tile->rect.x = c * tile_w;
+            tile->rect.y = r * tile_h;
+            tile->rect.w = FFMIN(tile_w, width - tile->rect.x);
+            tile->rect.h = FFMIN(tile_h, height - tile->rect.y);
+            if (realloc_texture(renderer, &tile->texture, format, tile->rect.w, tile->rect.h, SDL_BLENDMODE_NONE, 0) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+int VideoCtl::upload_tiles(VideoTiles *tiles, AVFrame *frame, const SDL_Rect *roi)
+{
+    int ret = 0;
+
+    if (tiles->nb_tiles == 1)
+        return upload_texture(tiles->tiles[0].texture, frame, &tiles->tiles[0].convert_ctx, roi);
+
+    if (!tiles->view && !(tiles->view = av_frame_alloc()))
+        return AVERROR(ENOMEM);
+
+    //看不见的块不上传
+    for (int i = 0; i < tiles->nb_tiles && ret >= 0; i++) {
+        VideoTile *tile = &tiles->tiles[i];
+        SDL_Rect part, tile_roi;
+
+        if (roi) {
+            if (!SDL_IntersectRect(roi, &tile->rect, &part))
+                continue;
+        }
+        else {
+            part = tile->rect;
+        }
+        tile_roi.x = part.x - tile->rect.x;
+        tile_roi.y = part.y - tile->rect.y;
+        tile_roi.w = part.w;
+        tile_roi.h = part.h;
+
+        //按块裁剪出的帧引用，只调整数据指针，不拷贝
+        if ((ret = av_frame_ref(tiles->view, frame)) < 0)
+            break;
+        tiles->view->crop_left = tile->rect.x;
+        tiles->view->crop_top = tile->rect.y;
+        tiles->view->crop_right = frame->width - tile->rect.x - tile->rect.w;
+        tiles->view->crop_bottom = frame->height - tile->rect.y - tile->rect.h;
+        if ((ret = av_frame_apply_cropping(tiles->view, AV_FRAME_CROP_UNALIGNED)) >= 0) {
+            bool bWholeTile = tile_roi.w == tile->rect.w && tile_roi.h == tile->rect.h;
+            ret = upload_texture(tile->texture, tiles->view, &tile->convert_ctx, bWholeTile ? NULL : &tile_roi);
+        }
+        av_frame_unref(tiles->view);
+    }
     return ret;
 }
 
+void VideoCtl::render_tiles(SDL_Renderer *renderer, VideoTiles *tiles, const SDL_Rect *src, const SDL_Rect *dst, double rotation, SDL_RendererFlip flip)
+{
+    SDL_Rect full = { 0, 0, tiles->width, tiles->height };
+
+    if (tiles->nb_tiles == 1) {
+        SDL_RenderCopyEx(renderer, tiles->tiles[0].texture, src, dst, rotation, NULL, flip);
+        return;
+    }
+    if (!src)
+        src = &full;
+    if (src->w <= 0 || src->h <= 0)
+        return;
+
+    for (int i = 0; i < tiles->nb_tiles; i++) {
+        VideoTile *tile = &tiles->tiles[i];
+        SDL_Rect part, tile_src, tile_dst;
+        SDL_Point center;
+        int x0, x1, y0, y1;
+
+        if (!SDL_IntersectRect(src, &tile->rect, &part))
+            continue;
+        tile_src.x = part.x - tile->rect.x;
+        tile_src.y = part.y - tile->rect.y;
+        tile_src.w = part.w;
+        tile_src.h = part.h;
+
+        //按边缘换算目标位置，相邻块之间不留缝；镜像时块的位置也要镜像
+        x0 = part.x - src->x;
+        x1 = x0 + part.w;
+        if (flip & SDL_FLIP_HORIZONTAL) {
+            x0 = src->w - x1;
+            x1 = x0 + part.w;
+        }
+        y0 = part.y - src->y;
+        y1 = y0 + part.h;
+        if (flip & SDL_FLIP_VERTICAL) {
+            y0 = src->h - y1;
+            y1 = y0 + part.h;
+        }
+        tile_dst.x = dst->x + (int)((int64_t)x0 * dst->w / src->w);
+        tile_dst.y = dst->y + (int)((int64_t)y0 * dst->h / src->h);
+        tile_dst.w = dst->x + (int)((int64_t)x1 * dst->w / src->w) - tile_dst.x;
+        tile_dst.h = dst->y + (int)((int64_t)y1 * dst->h / src->h) - tile_dst.y;
+        if (tile_dst.w <= 0 || tile_dst.h <= 0)
+            continue;
+
+        //绕整个画面的中心旋转
+        center.x = dst->x + dst->w / 2 - tile_dst.x;
+        center.y = dst->y + dst->h / 2 - tile_dst.y;
+        SDL_RenderCopyEx(renderer, tile->texture, &tile_src, &tile_dst, rotation, &center, flip);
+    }
+}
+
+void VideoCtl::free_tiles(VideoTiles *tiles)
+{
+    for (int i = 0; i < tiles->nb_tiles; i++) {
+        if (tiles->tiles[i].texture)
+            SDL_DestroyTexture(tiles->tiles[i].texture);
+        sws_freeContext(tiles->tiles[i].convert_ctx);
+    }
+    av_freep(&tiles->tiles);
+    tiles->nb_tiles = 0;
+    tiles->cols = 0;
+    tiles->rows = 0;
+    av_frame_free(&tiles->view);
+}
+
+//缩放区域对应的帧内矩形
+bool VideoCtl::zoom_source_rect(Frame *vp, SDL_Rect *roi)
+{
+    double half, u[2], v[2];
+    double fx_min = 1.0, fx_max = 0.0, fy_min = 1.0, fy_max = 0.0;
+    int quarter;
+
+    memset(roi, 0, sizeof(*roi));
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        if (m_dZoom <= 1.0)
+            return false;
+        half = 0.5 / m_dZoom;
+        u[0] = m_dZoomCenterX - half;
+        u[1] = m_dZoomCenterX + half;
+        v[0] = m_dZoomCenterY - half;
+        v[1] = m_dZoomCenterY + half;
+    }
+
+    //缩放区域是按显示方向给出的，先逆旋转，再按 SDL 的顺序去掉镜像，得到纹理坐标
+    quarter = lrint(vp->rotation / 90) & 3;
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 2; j++) {
+            double fx, fy;
+            switch (quarter) {
+            case 1:  fx = v[j];       fy = 1 - u[i]; break;
+            case 2:  fx = 1 - u[i];   fy = 1 - v[j]; break;
+            case 3:  fx = 1 - v[j];   fy = u[i];     break;
+            default: fx = u[i];       fy = v[j];     break;
+            }
+            if (vp->flip_h)
+                fx = 1 - fx;
+            if (vp->flip_v)
+                fy = 1 - fy;
+            fx_min = FFMIN(fx_min, fx);
+            fx_max = FFMAX(fx_max, fx);
+            fy_min = FFMIN(fy_min, fy);
+            fy_max = FFMAX(fy_max, fy);
+        }
+    }
+
+    //按偶数对齐，YUV420 的色度与亮度对应
+    roi->x = av_clip((int)floor(fx_min * vp->width) & ~1, 0, FFMAX(vp->width - 2, 0));
+    roi->y = av_clip((int)floor(fy_min * vp->height) & ~1, 0, FFMAX(vp->height - 2, 0));
+    roi->w = FFMIN(FFALIGN((int)ceil(fx_max * vp->width) - roi->x, 2), vp->width - roi->x);
+    roi->h = FFMIN(FFALIGN((int)ceil(fy_max * vp->height) - roi->y, 2), vp->height - roi->y);
+    if (roi->w <= 0 || roi->h <= 0) {
+        memset(roi, 0, sizeof(*roi));
+        return false;
+    }
+    return true;
+}
+
+int VideoCtl::upload_subtitle(RenderBackend *render, const SDL_RendererInfo *info, Frame *sp, Frame *vp, struct SwsContext **convert_ctx)
+{
+    uint8_t* pixels[4];
+    int pitch[4];
+    int i;
+    int sub_w, sub_h;
+    if (!sp->width || !sp->height) {
+        sp->width = vp->width;
+        sp->height = vp->height;
+    }
+    //字幕纹理超出最大纹理尺寸时按比例缩小
+    fit_texture_size(info, sp->width, sp->height, &sub_w, &sub_h);
+    if (render->ResizeSubtitle(sub_w, sub_h) < 0)
+        return -1;
+
+    for (i = 0; i < sp->sub.num_rects; i++) {
+        AVSubtitleRect *sub_rect = sp->sub.rects[i];
+        SDL_Rect tex_rect;
+
+        sub_rect->x = av_clip(sub_rect->x, 0, sp->width);
+        sub_rect->y = av_clip(sub_rect->y, 0, sp->height);
+        sub_rect->w = av_clip(sub_rect->w, 0, sp->width - sub_rect->x);
+        sub_rect->h = av_clip(sub_rect->h, 0, sp->height - sub_rect->y);
+
+        tex_rect.x = sub_rect->x * sub_w / sp->width;
+        tex_rect.y = sub_rect->y * sub_h / sp->height;
+        tex_rect.w = (sub_rect->x + sub_rect->w) * sub_w / sp->width - tex_rect.x;
+        tex_rect.h = (sub_rect->y + sub_rect->h) * sub_h / sp->height - tex_rect.y;
+        if (tex_rect.w <= 0 || tex_rect.h <= 0)
+            continue;
+
+        *convert_ctx = sws_getCachedContext(*convert_ctx,
+            sub_rect->w, sub_rect->h, AV_PIX_FMT_PAL8,
+            tex_rect.w, tex_rect.h, AV_PIX_FMT_BGRA,
+            0, NULL, NULL, NULL);
+        if (!*convert_ctx) {
+            av_log(NULL, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
+            return -1;
+        }
+        if (!render->LockSubtitle(&tex_rect, pixels, pitch)) {
+            sws_scale(*convert_ctx, (const uint8_t * const *)sub_rect->data, sub_rect->linesize,
+                0, sub_rect->h, pixels, pitch);
+            render->UnlockSubtitle();
+        }
+    }
+    return 0;
+}
+
 //显示视频画面
 void VideoCtl::video_image_display(VideoState *is)
 {
     Frame *vp;
     Frame *sp = NULL;
     SDL_Rect rect;
+    SDL_Rect roi;
+    bool bNewFrame;
+    bool bZoomed;
+    SDL_RendererInfo renderer_info = { 0 };
 
+    //纹理尺寸上限（SDL 渲染器或 OpenGL）
+    m_pRender->MaxTextureSize(&renderer_info.max_texture_width, &renderer_info.max_texture_height);
     vp = frame_queue_peek_last(&is->pictq);
     if (is->subtitle_st) {
         if (frame_queue_nb_remaining(&is->subpq) > 0) {
@@ -135,38 +528,8 @@ void VideoCtl::video_image_display(VideoState *is)
 
             if (vp->pts >= sp->pts + ((float)sp->sub.start_display_time / 1000)) {
                 if (!sp->uploaded) {
-                    uint8_t* pixels[4];
-                    int pitch[4];
-                    int i;
-                    if (!sp->width || !sp->height) {
-                        sp->width = vp->width;
-                        sp->height = vp->height;
-                    }
-                    if (realloc_texture(&is->sub_texture, SDL_PIXELFORMAT_ARGB8888, sp->width, sp->height, SDL_BLENDMODE_BLEND, 1) < 0)
+                    if (upload_subtitle(m_pRender, &renderer_info, sp, vp, &is->sub_convert_ctx) < 0)
                         return;
-
-                    for (i = 0; i < sp->sub.num_rects; i++) {
-                        AVSubtitleRect *sub_rect = sp->sub.rects[i];
-
-                        sub_rect->x = av_clip(sub_rect->x, 0, sp->width);
-                        sub_rect->y = av_clip(sub_rect->y, 0, sp->height);
-                        sub_rect->w = av_clip(sub_rect->w, 0, sp->width - sub_rect->x);
-                        sub_rect->h = av_clip(sub_rect->h, 0, sp->height - sub_rect->y);
-
-                        is->sub_convert_ctx = sws_getCachedContext(is->sub_convert_ctx,
-                            sub_rect->w, sub_rect->h, AV_PIX_FMT_PAL8,
-                            sub_rect->w, sub_rect->h, AV_PIX_FMT_BGRA,
-                            0, NULL, NULL, NULL);
-                        if (!is->sub_convert_ctx) {
-                            av_log(NULL, AV_LOG_FATAL, "Cannot initialize the conversion context\n");
-                            return;
-                        }
-                        if (!SDL_LockTexture(is->sub_texture, (SDL_Rect *)sub_rect, (void **)pixels, pitch)) {
-                            sws_scale(is->sub_convert_ctx, (const uint8_t * const *)sub_rect->data, sub_rect->linesize,
-                                0, sub_rect->h, pixels, pitch);
-                            SDL_UnlockTexture(is->sub_texture);
-                        }
-                    }
                     sp->uploaded = 1;
                 }
             }
@@ -175,39 +538,111 @@ void VideoCtl::video_image_display(VideoState *is)
         }
     }
 
-    calculate_display_rect(&rect, is->xleft, is->ytop, is->width, is->height, vp->width, vp->height, vp->sar);
+    bZoomed = zoom_source_rect(vp, &roi);
+    if (bZoomed)
+        calculate_display_rect(&rect, is->xleft, is->ytop, is->width, is->height, roi.w, roi.h, vp->sar, vp->rotation);
+    else
+        calculate_display_rect(&rect, is->xleft, is->ytop, is->width, is->height, vp->width, vp->height, vp->sar, vp->rotation);
 
-    if (!vp->uploaded) {
-        int sdl_pix_fmt = vp->frame->format == AV_PIX_FMT_YUV420P ? SDL_PIXELFORMAT_YV12 : SDL_PIXELFORMAT_ARGB8888;
-        if (realloc_texture(&is->vid_texture, sdl_pix_fmt, vp->frame->width, vp->frame->height, SDL_BLENDMODE_NONE, 0) < 0)
-            return;
-        if (upload_texture(is->vid_texture, vp->frame, &is->img_convert_ctx) < 0)
+    bNewFrame = !vp->uploaded;
+    //新帧或缩放区域变化时上传，缩放时只上传可见区域
+    if (!vp->uploaded || memcmp(&roi, &is->vid_roi, sizeof(roi))) {
+        if (m_pRender->UploadVideo(vp->frame, bZoomed ? &roi : NULL) < 0)
             return;
+        is->vid_roi = roi;
         vp->uploaded = 1;
         vp->flip_v = vp->frame->linesize[0] < 0;
 
-        //通知宽高变化
-        if (m_nFrameW != vp->frame->width || m_nFrameH != vp->frame->height)
+        //通知宽高变化（旋转 90/270 度时为旋转后的宽高）
+        int nFrameW = is_transposed(vp->rotation) ? vp->frame->height : vp->frame->width;
+        int nFrameH = is_transposed(vp->rotation) ? vp->frame->width : vp->frame->height;
+        if (m_nFrameW != nFrameW || m_nFrameH != nFrameH)
         {
-            m_nFrameW = vp->frame->width;
-            m_nFrameH = vp->frame->height;
+            m_nFrameW = nFrameW;
+            m_nFrameH = nFrameH;
             emit SigFrameDimensionsChanged(m_nFrameW, m_nFrameH);
         }
     }
 
-    SDL_RenderCopyEx(renderer, is->vid_texture, NULL, &rect, 0, NULL, (SDL_RendererFlip)(vp->flip_v ? SDL_FLIP_VERTICAL : 0));
+    //旋转和镜像交给渲染器完成
+    m_pRender->RenderVideo(bZoomed ? &roi : NULL, &rect, vp->rotation,
+        (vp->flip_v ? SDL_FLIP_VERTICAL : 0) | (vp->flip_h ? SDL_FLIP_HORIZONTAL : 0));
     if (sp) {
-        SDL_RenderCopy(renderer, is->sub_texture, NULL, &rect);
+        //字幕保持正向，铺在旋转后的画面区域上，缩放时按比例取对应区域
+        SDL_Rect sub_rect = rotated_display_rect(rect, vp->rotation);
+        SDL_Rect sub_src = { 0, 0, 0, 0 };
+        fit_texture_size(&renderer_info, sp->width, sp->height, &sub_src.w, &sub_src.h);
+        if (bZoomed && vp->width > 0 && vp->height > 0) {
+            sub_src.x = roi.x * sub_src.w / vp->width;
+            sub_src.y = roi.y * sub_src.h / vp->height;
+            sub_src.w = roi.w * sub_src.w / vp->width;
+            sub_src.h = roi.h * sub_src.h / vp->height;
+        }
+        m_pRender->RenderSubtitle(&sub_src, &sub_rect);
+    }
+
+    //同一帧交给镜像输出，在本线程上传和显示
+    mirror_display(vp, sp, bNewFrame);
+}
+
+void VideoCtl::mirror_display(Frame *vp, Frame *sp, bool bNewFrame)
+{
+    std::lock_guard<std::mutex> lock(m_mutexMirrors);
+
+    //先关闭已移除的输出，同一窗口重新加入时不会同时存在两个 SDL 窗口
+    for (MirrorOutput *pMirror : m_vecMirrorsClosing)
+    {
+        delete pMirror;
+    }
+    m_vecMirrorsClosing.clear();
+
+    for (MirrorOutput *pMirror : m_vecMirrors)
+    {
+        //新打开的输出在 Display 中上传整帧
+        if (!pMirror->IsOpen() && pMirror->Open() < 0)
+            continue;
+        pMirror->Display(vp, sp, bNewFrame);
+    }
+}
+
+void VideoCtl::mirror_close()
+{
+    std::lock_guard<std::mutex> lock(m_mutexMirrors);
+
+    for (MirrorOutput *pMirror : m_vecMirrorsClosing)
+    {
+        delete pMirror;
+    }
+    m_vecMirrorsClosing.clear();
+    for (MirrorOutput *pMirror : m_vecMirrors)
+    {
+        pMirror->Close();
+    }
+}
+
+bool VideoCtl::is_mirror_window(Uint32 window_id)
+{
+    std::lock_guard<std::mutex> lock(m_mutexMirrors);
+
+    if (!window_id)
+        return false;
+    for (MirrorOutput *pMirror : m_vecMirrors)
+    {
+        if (pMirror->WindowID() == window_id)
+            return true;
     }
+    return false;
 }
 
 
 //关闭流对应的解码器等
-void VideoCtl::stream_component_close(VideoState *is, int stream_index)
+void VideoCtl::stream_component_close(VideoState *is, int stream_index, AVFormatContext *ic)
 {
-    AVFormatContext *ic = is->ic;
     AVCodecParameters *codecpar;
 
+    if (!ic)
+        ic = is->ic;
+
     if (stream_index < 0 || stream_index >= ic->nb_streams)
         return;
     codecpar = ic->streams[stream_index]->codecpar;
@@ -215,23 +650,41 @@ void VideoCtl::stream_component_close(VideoState *is, int stream_index)
     switch (codecpar->codec_type) {
     case AVMEDIA_TYPE_AUDIO:
         decoder_abort(&is->auddec, &is->sampq);
+        //混入的音轨跟随主音轨关闭
+        m_stAudioMixer.Close();
+        for (unsigned int i = 0; i < is->ic->nb_streams; i++) {
+            if (!(ic == is->ic && (int)i == stream_index) && is->ic->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+                is->ic->streams[i]->discard = AVDISCARD_ALL;
+        }
         SDL_CloseAudio();
+        m_stDecoderPool.Release(is->auddec.avctx, codecpar);
+        is->auddec.avctx = NULL;
         decoder_destroy(&is->auddec);
         swr_free(&is->swr_ctx);
         av_freep(&is->audio_buf1);
         is->audio_buf1_size = 0;
         is->audio_buf = NULL;
 
-        if (is->rdft) {
-            av_rdft_end(is->rdft);
-            av_freep(&is->rdft_data);
-            is->rdft = NULL;
-            is->rdft_bits = 0;
+        if (is->vis && is->vis->rdft) {
+            av_rdft_end(is->vis->rdft);
+            av_freep(&is->vis->rdft_data);
+            is->vis->rdft = NULL;
+            is->vis->rdft_bits = 0;
         }
         break;
     case AVMEDIA_TYPE_VIDEO:
         decoder_abort(&is->viddec, &is->pictq);
+        m_stDecoderPool.Release(is->viddec.avctx, codecpar);
+        is->viddec.avctx = NULL;
         decoder_destroy(&is->viddec);
+        {
+            FramePoolStats stats;
+            FramePool::GetStats(&stats);
+            av_log(NULL, AV_LOG_VERBOSE, "frame pool: %" PRId64 " of %" PRId64 " buffer requests allocated, %.1f MB held (%.1f MB huge pages)\n",
+                stats.allocations, stats.requests, stats.bytes / (1024.0 * 1024.0), stats.huge_bytes / (1024.0 * 1024.0));
+        }
+        //下一个文件的分辨率可能不同，空闲的缓冲区归还系统
+        FramePool::GetInstance()->Trim();
         break;
     case AVMEDIA_TYPE_SUBTITLE:
         decoder_abort(&is->subdec, &is->subpq);
@@ -259,6 +712,23 @@ void VideoCtl::stream_component_close(VideoState *is, int stream_index)
         break;
     }
 }
+//释放外部音频（读取线程已退出或未启动）
+static void ext_audio_free(ExtAudio *ea)
+{
+    avformat_close_input(&ea->ic);
+    if (ea->cond)
+        SDL_DestroyCond(ea->cond);
+    if (ea->mutex)
+        SDL_DestroyMutex(ea->mutex);
+    delete ea;
+}
+
+static int ext_audio_interrupt_cb(void *ctx)
+{
+    ExtAudio *ea = (ExtAudio *)ctx;
+    return ea->abort_request;
+}
+
 //关闭流
 void VideoCtl::stream_close(VideoState *is)
 {
@@ -266,6 +736,18 @@ void VideoCtl::stream_close(VideoState *is)
     is->abort_request = 1;
     is->read_tid.join();
 
+    //外部音频及尚未载入的请求
+    ext_audio_close(is);
+    ext_audio_open_cancel();
+    {
+        std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+        if (m_pExtAudioReq)
+        {
+            ext_audio_free(m_pExtAudioReq);
+            m_pExtAudioReq = nullptr;
+        }
+    }
+
     /* close each stream */
     if (is->audio_stream >= 0)
         stream_component_close(is, is->audio_stream);
@@ -285,15 +767,16 @@ void VideoCtl::stream_close(VideoState *is)
     frame_queue_destory(&is->sampq);
     frame_queue_destory(&is->subpq);
     SDL_DestroyCond(is->continue_read_thread);
-    sws_freeContext(is->img_convert_ctx);
     sws_freeContext(is->sub_convert_ctx);
     av_free(is->filename);
 
-    if (is->vid_texture)
-        SDL_DestroyTexture(is->vid_texture);
-    if (is->sub_texture)
-        SDL_DestroyTexture(is->sub_texture);
-    av_free(is);
+    m_pRender->ReleaseTextures();
+    if (is->vis) {
+        if (is->vis->vis_texture)
+            SDL_DestroyTexture(is->vis->vis_texture);
+        av_freep(&is->vis);
+    }
+    delete is;
 }
 
 double VideoCtl::get_clock(Clock *c)
@@ -382,6 +865,60 @@ double VideoCtl::get_master_clock(VideoState *is)
     return val;
 }
 
+void VideoCtl::update_sync_clock(VideoState *is)
+{
+    ClockSync *sync = ClockSync::GetInstance();
+    int64_t now = av_gettime_relative();
+    Clock *c = is->video_st ? &is->vidclk : &is->audclk;
+    double pts, speed, diff;
+    int serial;
+    bool paused;
+
+    //有视频时以显示的画面为准
+    if (sync->GetRole() == SYNC_ROLE_MASTER) {
+        if (!is->video_st && get_master_sync_type(is) == AV_SYNC_EXTERNAL_CLOCK)
+            c = &is->extclk;
+        sync->SetMasterClock(get_clock(c), c->speed, c->serial, is->paused);
+        return;
+    }
+
+    if (!sync->GetMasterClock(now, &pts, &speed, &serial, &paused) || std::isnan(pts))
+        return;
+    if (paused != !!is->paused) {
+        toggle_pause(is);
+        emit SigPauseStat(is->paused);
+    }
+    if (is->paused)
+        return;
+
+    diff = get_clock(&is->extclk) - pts;
+    if (std::isnan(diff) || fabs(diff) > SYNC_SEEK_THRESHOLD) {
+        //seek 后外部时钟从目标位置开始走，剩下的偏差下次再调整
+        if (now - is->sync_jump_time > SYNC_SEEK_HOLDOFF * 1000000 && !is->seek_req) {
+            av_log(NULL, AV_LOG_INFO, "Sync: %.3f s off the master, seeking to %.3f\n", std::isnan(diff) ? 0.0 : diff, pts);
+            stream_seek(is, (int64_t)(pts * AV_TIME_BASE), 0);
+            is->sync_jump_time = now;
+        }
+        return;
+    }
+    if (fabs(diff) > SYNC_STEP_THRESHOLD) {
+        //视频丢帧或重复帧追上，音频按采样数调整
+        set_clock(&is->extclk, pts, is->extclk.serial);
+        set_clock_speed(&is->extclk, speed);
+        is->sync_jump_time = now;
+    }
+    else {
+        //小偏差按比例调整速度，范围与 check_external_clock_speed 相同
+        set_clock_speed(&is->extclk, speed * av_clipd(1.0 - diff * SYNC_SPEED_GAIN, EXTERNAL_CLOCK_SPEED_MIN, EXTERNAL_CLOCK_SPEED_MAX));
+    }
+
+    if (now - is->sync_jump_time > SYNC_SEEK_HOLDOFF * 1000000) {
+        diff = get_clock(c) - pts;
+        if (!std::isnan(diff))
+            sync->AddSkew(diff);
+    }
+}
+
 void VideoCtl::check_external_clock_speed(VideoState *is) {
     if (is->video_stream >= 0 && is->videoq.nb_packets <= EXTERNAL_CLOCK_MIN_FRAMES ||
         is->audio_stream >= 0 && is->audioq.nb_packets <= EXTERNAL_CLOCK_MIN_FRAMES) {
@@ -399,12 +936,16 @@ void VideoCtl::check_external_clock_speed(VideoState *is) {
 }
 
 /* seek in the stream */
-void VideoCtl::stream_seek(VideoState *is, int64_t pos, int64_t rel)
+void VideoCtl::stream_seek(VideoState *is, int64_t pos, int64_t rel, int seek_by_bytes)
 {
+    //用户 seek 后不再丢弃切换位置之前的帧
+    is->start_pos = NAN;
     if (!is->seek_req) {
         is->seek_pos = pos;
         is->seek_rel = rel;
         is->seek_flags &= ~AVSEEK_FLAG_BYTE;
+        if (seek_by_bytes)
+            is->seek_flags |= AVSEEK_FLAG_BYTE;
         is->seek_req = 1;
         SDL_CondSignal(is->continue_read_thread);
     }
@@ -501,7 +1042,9 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
 
     double rdftspeed = 0.02;
 
-    if (!is->paused && get_master_sync_type(is) == AV_SYNC_EXTERNAL_CLOCK && is->realtime)
+    //跟随其他播放器时外部时钟由 update_sync_clock 调整
+    if (!is->paused && get_master_sync_type(is) == AV_SYNC_EXTERNAL_CLOCK && is->realtime &&
+        ClockSync::GetInstance()->GetRole() != SYNC_ROLE_FOLLOWER)
         check_external_clock_speed(is);
 
     if (is->video_st) {
@@ -528,6 +1071,13 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
             if (is->paused)
                 goto display;
 
+            //首帧解码出来后立即显示，不等待音频时钟
+            if (fast_first_frame && !is->first_frame_shown) {
+                time = av_gettime_relative() / 1000000.0;
+                is->frame_timer = time;
+                goto present;
+            }
+
             /* compute nominal last_duration */
             last_duration = vp_duration(is, lastvp, vp);
             delay = compute_target_delay(last_duration, is);
@@ -542,6 +1092,7 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
             if (delay > 0 && time - is->frame_timer > AV_SYNC_THRESHOLD_MAX)
                 is->frame_timer = time;
 
+        present:
             SDL_LockMutex(is->pictq.mutex);
             if (!std::isnan(vp->pts))
                 update_video_pts(is, vp->pts, vp->pos, vp->serial);
@@ -577,10 +1128,10 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
                                 uint8_t *pixels;
                                 int pitch, j;
 
-                                if (!SDL_LockTexture(is->sub_texture, (SDL_Rect *)sub_rect, (void **)&pixels, &pitch)) {
+                                if (!m_pRender->LockSubtitle((SDL_Rect *)sub_rect, &pixels, &pitch)) {
                                     for (j = 0; j < sub_rect->h; j++, pixels += pitch)
                                         memset(pixels, 0, sub_rect->w << 2);
-                                    SDL_UnlockTexture(is->sub_texture);
+                                    m_pRender->UnlockSubtitle();
                                 }
                             }
                         }
@@ -592,6 +1143,9 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
                 }
             }
 
+            if (m_pSeekStress)
+                m_pSeekStress->OnPresent(vp->pts, vp->serial);
+
             frame_queue_next(&is->pictq);
             is->force_refresh = 1;
 
@@ -600,8 +1154,19 @@ void VideoCtl::video_refresh(void *opaque, double *remaining_time)
         }
     display:
         /* display picture */
-        if (is->force_refresh && is->pictq.rindex_shown)
+        if (is->force_refresh && is->pictq.rindex_shown) {
             video_display(is);
+            if (!is->first_frame_shown) {
+                //先记录耗时，headless_open 看到 first_frame_shown 时已可读取
+                m_nFirstFrameUs = av_gettime_relative() - is->open_time;
+                is->first_frame_shown = 1;
+                av_log(NULL, AV_LOG_INFO, "Time to first frame: %.1f ms\n", m_nFirstFrameUs / 1000.0);
+                //垂直同步时 Present 等到消隐期才返回，即实际显示的时间
+                if (is->schedule_start)
+                    av_log(NULL, AV_LOG_INFO, "Scheduled start: first frame presented %+.1f ms from the scheduled time\n",
+                        (av_gettime() - is->schedule_start) / 1000.0);
+            }
+        }
     }
     is->force_refresh = 0;
 
@@ -627,6 +1192,8 @@ int VideoCtl::queue_picture(VideoState *is, AVFrame *src_frame, double pts, doub
     vp->pos = pos;
     vp->serial = serial;
 
+    get_display_orientation(is->video_st, src_frame, &vp->rotation, &vp->flip_h);
+
     av_frame_move_ref(vp->frame, src_frame);
     frame_queue_push(&is->pictq);
     return 0;
@@ -643,11 +1210,18 @@ int VideoCtl::get_video_frame(VideoState *is, AVFrame *frame)
     if (got_picture) {
         double dpts = NAN;
 
+        is->frames_decoded++;
         if (frame->pts != AV_NOPTS_VALUE)
             dpts = av_q2d(is->video_st->time_base) * frame->pts;
 
         frame->sample_aspect_ratio = av_guess_sample_aspect_ratio(is->ic, is->video_st, frame);
 
+        //切换原文件与代理后从切换位置开始，关键帧到该位置之间的帧丢弃
+        if (!isnan(is->start_pos) && !isnan(dpts) && dpts < is->start_pos) {
+            av_frame_unref(frame);
+            return 0;
+        }
+
         if (framedrop > 0 || (framedrop && get_master_sync_type(is) != AV_SYNC_VIDEO_MASTER)) {
             if (frame->pts != AV_NOPTS_VALUE) {
                 double diff = dpts - get_master_clock(is);
@@ -687,6 +1261,12 @@ int VideoCtl::audio_thread(void *arg)
         if (got_frame) {
             tb = { 1, frame->sample_rate };
 
+                if (!isnan(is->start_pos) && frame->pts != AV_NOPTS_VALUE &&
+                    (frame->pts + frame->nb_samples) * av_q2d(tb) <= is->start_pos) {
+                    av_frame_unref(frame);
+                    continue;
+                }
+
                 if (!(af = frame_queue_peek_writable(&is->sampq)))
                     goto the_end;
 
@@ -695,9 +1275,28 @@ int VideoCtl::audio_thread(void *arg)
                 af->serial = is->auddec.pkt_serial;
                 af->duration = av_q2d({ frame->nb_samples, frame->sample_rate });
 
+                //混入其他音轨，旧序号的帧会被丢弃，不需要混音
+                if (af->serial == is->audioq.serial)
+                    m_stAudioMixer.Mix(frame, af->pts);
+
                 av_frame_move_ref(af->frame, frame);
                 frame_queue_push(&is->sampq);
 
+                //先缓冲够一个硬件缓冲区的数据再启动音频设备，避免开头输出静音。
+                //定时播放由刷新线程在开始时间启动设备
+                if (!is->audio_started) {
+                    is->audio_primed += af->duration;
+                    if (!is->schedule_pending && (is->audio_primed >= (double)is->audio_hw_buf_size / is->audio_tgt.bytes_per_sec ||
+                        frame_queue_nb_remaining(&is->sampq) >= is->sampq.max_size - 1)) {
+                        is->audio_started = 1;
+                        SDL_PauseAudioDevice(audio_dev, 0);
+                    }
+                }
+        }
+        else if (!is->audio_started && is->auddec.finished && !is->schedule_pending) {
+            //音频过短，解码结束也不够缓冲量，直接开始播放
+            is->audio_started = 1;
+            SDL_PauseAudioDevice(audio_dev, 0);
         }
     } while (ret >= 0 || ret == AVERROR(EAGAIN) || ret == AVERROR_EOF);
 the_end:
@@ -716,6 +1315,8 @@ int VideoCtl::video_thread(void *arg)
     int ret;
     AVRational tb = is->video_st->time_base;
     AVRational frame_rate = av_guess_frame_rate(is->ic, is->video_st, NULL);
+    int64_t lut_frames = 0;
+    int64_t lut_time = 0;
 
     if (!frame)
     {
@@ -732,6 +1333,16 @@ int VideoCtl::video_thread(void *arg)
 
         duration = (frame_rate.num && frame_rate.den ? av_q2d({ frame_rate.den, frame_rate.num }) : 0);
         pts = (frame->pts == AV_NOPTS_VALUE) ? NAN : frame->pts * av_q2d(tb);
+
+        //颜色管理在解码线程完成，不占用刷新线程；失败时按原格式显示
+        if (m_stColorLut.IsNeeded(frame)) {
+            int64_t start = av_gettime_relative();
+            if (color_manage_frame(frame) >= 0) {
+                lut_time += av_gettime_relative() - start;
+                lut_frames++;
+            }
+        }
+
         ret = queue_picture(is, frame, pts, duration, frame->pkt_pos, is->viddec.pkt_serial);
         av_frame_unref(frame);
 
@@ -740,10 +1351,38 @@ int VideoCtl::video_thread(void *arg)
     }
 the_end:
 
+    if (lut_frames > 0)
+        av_log(NULL, AV_LOG_INFO, "Color management: %" PRId64 " frames, %.2f ms/frame on the decoder thread\n",
+            lut_frames, lut_time / 1000.0 / lut_frames);
+
     av_frame_free(&frame);
     return 0;
 }
 
+int VideoCtl::color_manage_frame(AVFrame *frame)
+{
+    AVFrame *rgb = av_frame_alloc();
+    int ret;
+
+    if (!rgb)
+        return AVERROR(ENOMEM);
+
+    rgb->format = AV_PIX_FMT_BGRA;
+    rgb->width = frame->width;
+    rgb->height = frame->height;
+    if ((ret = FramePool::GetInstance()->GetFrameBuffer(rgb)) < 0 ||
+        (ret = av_frame_copy_props(rgb, frame)) < 0 ||
+        (ret = m_stColorLut.Apply(frame, rgb->data[0], rgb->linesize[0])) < 0) {
+        av_frame_free(&rgb);
+        return ret;
+    }
+
+    av_frame_unref(frame);
+    av_frame_move_ref(frame, rgb);
+    av_frame_free(&rgb);
+    return 0;
+}
+
 int VideoCtl::subtitle_thread(void *arg)
 {
     VideoState *is = (VideoState *)arg;
@@ -779,25 +1418,6 @@ int VideoCtl::subtitle_thread(void *arg)
     return 0;
 }
 
-/* copy samples for viewing in editor window */
-void VideoCtl::update_sample_display(VideoState *is, short *samples, int samples_size)
-{
-    int size, len;
-
-    size = samples_size / sizeof(short);
-    while (size > 0) {
-        len = SAMPLE_ARRAY_SIZE - is->sample_array_index;
-        if (len > size)
-            len = size;
-        memcpy(is->sample_array + is->sample_array_index, samples, len * sizeof(short));
-        samples += len;
-        is->sample_array_index += len;
-        if (is->sample_array_index >= SAMPLE_ARRAY_SIZE)
-            is->sample_array_index = 0;
-        size -= len;
-    }
-}
-
 /* return the wanted number of samples to get better sync if sync_type is video
 * or external master clock */
 int VideoCtl::synchronize_audio(VideoState *is, int nb_samples)
@@ -850,11 +1470,28 @@ int VideoCtl::synchronize_audio(VideoState *is, int nb_samples)
 * stored in is->audio_buf, with size in bytes given by the return
 * value.
 */
+/* 按预设创建重采样上下文并初始化，失败返回 NULL */
+static struct SwrContext *audio_resampler_alloc(VideoState *is, AVFrame *frame, int preset, int allow_soxr)
+{
+    struct SwrContext *swr = NULL;
+
+    swr_alloc_set_opts2(&swr,
+        &is->audio_tgt.ch_layout, is->audio_tgt.fmt, is->audio_tgt.freq,
+        &frame->ch_layout, (AVSampleFormat)frame->format, frame->sample_rate,
+        0, NULL);
+    if (swr)
+        Resampler::ApplyPreset(swr, preset, allow_soxr);
+    if (!swr || swr_init(swr) < 0)
+        swr_free(&swr);
+    return swr;
+}
+
 int VideoCtl::audio_decode_frame(VideoState *is)
 {
     int data_size, resampled_data_size;
     av_unused double audio_clock0;
     int wanted_nb_samples;
+    int preset = m_nResamplePreset;
     Frame* af;
 
     if (is->paused)
@@ -882,20 +1519,18 @@ int VideoCtl::audio_decode_frame(VideoState *is)
     if (af->frame->format != is->audio_src.fmt ||
         av_channel_layout_compare(&af->frame->ch_layout, &is->audio_src.ch_layout) ||
         af->frame->sample_rate != is->audio_src.freq ||
-        (wanted_nb_samples != af->frame->nb_samples && !is->swr_ctx)) {
+        (wanted_nb_samples != af->frame->nb_samples && !is->swr_ctx) ||
+        (is->swr_ctx && is->swr_preset != preset)) {
         swr_free(&is->swr_ctx);
-        swr_alloc_set_opts2(&is->swr_ctx,
-            &is->audio_tgt.ch_layout, is->audio_tgt.fmt, is->audio_tgt.freq,
-            &af->frame->ch_layout, (AVSampleFormat)af->frame->format, af->frame->sample_rate,
-            0, NULL);
-        if (!is->swr_ctx || swr_init(is->swr_ctx) < 0) {
+        is->swr_ctx = audio_resampler_alloc(is, af->frame, preset, !is->swr_no_soxr);
+        if (!is->swr_ctx) {
             av_log(NULL, AV_LOG_ERROR,
                 "Cannot create sample rate converter for conversion of %d Hz %s %d channels to %d Hz %s %d channels!\n",
                 af->frame->sample_rate, av_get_sample_fmt_name((AVSampleFormat)af->frame->format), af->frame->ch_layout.nb_channels,
                 is->audio_tgt.freq, av_get_sample_fmt_name(is->audio_tgt.fmt), is->audio_tgt.ch_layout.nb_channels);
-            swr_free(&is->swr_ctx);
             return -1;
         }
+        is->swr_preset = preset;
         if (av_channel_layout_copy(&is->audio_src.ch_layout, &af->frame->ch_layout) < 0)
             return -1;
         is->audio_src.freq = af->frame->sample_rate;
@@ -913,10 +1548,23 @@ int VideoCtl::audio_decode_frame(VideoState *is)
             return -1;
         }
         if (wanted_nb_samples != af->frame->nb_samples) {
-            if (swr_set_compensation(is->swr_ctx, (wanted_nb_samples - af->frame->nb_samples) * is->audio_tgt.freq / af->frame->sample_rate,
-                wanted_nb_samples * is->audio_tgt.freq / af->frame->sample_rate) < 0) {
-                av_log(NULL, AV_LOG_ERROR, "swr_set_compensation() failed\n");
-                return -1;
+            int sample_delta = (wanted_nb_samples - af->frame->nb_samples) * is->audio_tgt.freq / af->frame->sample_rate;
+            int compensation_distance = wanted_nb_samples * is->audio_tgt.freq / af->frame->sample_rate;
+            if (swr_set_compensation(is->swr_ctx, sample_delta, compensation_distance) < 0) {
+                /* soxr 不一定支持变速补偿，改用 swr 引擎重建后重试 */
+                struct SwrContext *swr = NULL;
+                if (!is->swr_no_soxr && Resampler::UsesSoxr(is->swr_preset)) {
+                    av_log(NULL, AV_LOG_WARNING, "soxr resampler cannot compensate, falling back to swr\n");
+                    is->swr_no_soxr = 1;
+                    swr = audio_resampler_alloc(is, af->frame, is->swr_preset, 0);
+                }
+                if (!swr || swr_set_compensation(swr, sample_delta, compensation_distance) < 0) {
+                    swr_free(&swr);
+                    av_log(NULL, AV_LOG_ERROR, "swr_set_compensation() failed\n");
+                    return -1;
+                }
+                swr_free(&is->swr_ctx);
+                is->swr_ctx = swr;
             }
         }
         av_fast_malloc(&is->audio_buf1, &is->audio_buf1_size, out_size);
@@ -979,6 +1627,15 @@ void sdl_audio_callback(void *opaque, Uint8 *stream, int len)
             }
             else {
                 is->audio_buf_size = audio_size;
+                if (!is->first_audio_played) {
+                    is->first_audio_played = 1;
+                    av_log(NULL, AV_LOG_INFO, "Time to first audio: %.1f ms\n",
+                        (audio_callback_time - is->open_time) / 1000.0);
+                    //按两个硬件缓冲区估计设备输出延迟
+                    if (is->schedule_start)
+                        av_log(NULL, AV_LOG_INFO, "Scheduled start: first audio expected %+.1f ms from the scheduled time\n",
+                            (av_gettime() - is->schedule_start) / 1000.0 + 2000.0 * is->audio_hw_buf_size / is->audio_tgt.bytes_per_sec);
+                }
             }
             is->audio_buf_index = 0;
         }
@@ -1082,9 +1739,8 @@ int VideoCtl::audio_open(void* opaque, AVChannelLayout* wanted_channel_layout, i
 
 /* open a given stream. Return 0 if OK */
 //打开流
-int VideoCtl::stream_component_open(VideoState *is, int stream_index)
+int VideoCtl::stream_component_open(VideoState *is, int stream_index, AVFormatContext *ic)
 {
-    AVFormatContext* ic = is->ic;
     AVCodecContext* avctx;
     const AVCodec* codec;
     const char* forced_codec_name = NULL;
@@ -1095,10 +1751,30 @@ int VideoCtl::stream_component_open(VideoState *is, int stream_index)
     memset(&ch_layout, 0, sizeof(AVChannelLayout));
     int ret = 0;
     int stream_lowres = 0;
+    int64_t open_start_time = av_gettime_relative();
+    int warm = 0;
 
+    if (!ic)
+        ic = is->ic;
     if (stream_index < 0 || stream_index >= ic->nb_streams)
         return -1;
 
+    //外部文件的流不记入主文件的切换位置
+    if (ic == is->ic) {
+        switch (ic->streams[stream_index]->codecpar->codec_type) {
+        case AVMEDIA_TYPE_AUDIO: is->last_audio_stream = stream_index; break;
+        case AVMEDIA_TYPE_SUBTITLE: is->last_subtitle_stream = stream_index;break;
+        case AVMEDIA_TYPE_VIDEO: is->last_video_stream = stream_index; break;
+        }
+    }
+
+    //编码参数与之前打开过的流一致时，直接复用已打开的解码器
+    if ((avctx = m_stDecoderPool.Acquire(ic->streams[stream_index]->codecpar))) {
+        avctx->pkt_timebase = ic->streams[stream_index]->time_base;
+        warm = 1;
+        goto opened;
+    }
+
     avctx = avcodec_alloc_context3(NULL);
     if (!avctx)
         return AVERROR(ENOMEM);
@@ -1110,11 +1786,6 @@ int VideoCtl::stream_component_open(VideoState *is, int stream_index)
 
     codec = avcodec_find_decoder(avctx->codec_id);
 
-    switch (avctx->codec_type) {
-    case AVMEDIA_TYPE_AUDIO: is->last_audio_stream = stream_index; break;
-    case AVMEDIA_TYPE_SUBTITLE: is->last_subtitle_stream = stream_index;break;
-    case AVMEDIA_TYPE_VIDEO: is->last_video_stream = stream_index; break;
-    }
     if (forced_codec_name)
         codec = avcodec_find_decoder_by_name(forced_codec_name);
     if (!codec) {
@@ -1134,6 +1805,9 @@ int VideoCtl::stream_component_open(VideoState *is, int stream_index)
     }
     avctx->lowres = stream_lowres;
 
+    //视频帧从缓冲池分配，seek 后复用已预先写入的大页缓冲区
+    FramePool::GetInstance()->Attach(avctx);
+
     //if (fast)
     //    avctx->flags2 |= AV_CODEC_FLAG2_FAST;
 
@@ -1151,6 +1825,11 @@ int VideoCtl::stream_component_open(VideoState *is, int stream_index)
         goto fail;
     }
 
+opened:
+    av_log(NULL, AV_LOG_INFO, "%s decoder %s opened in %.2f ms (%s)\n",
+        av_get_media_type_string(avctx->codec_type), avctx->codec->name,
+        (av_gettime_relative() - open_start_time) / 1000.0, warm ? "reused" : "new");
+
     is->eof = 0;
     ic->streams[stream_index]->discard = AVDISCARD_DEFAULT;
     switch (avctx->codec_type) {
@@ -1197,17 +1876,27 @@ int VideoCtl::stream_component_open(VideoState *is, int stream_index)
         is->audio_stream = stream_index;
         is->audio_st = ic->streams[stream_index];
 
+        //混入的音轨转为主音轨的采样率和输出声道布局
+        m_stAudioMixer.Open(&is->audio_tgt.ch_layout, sample_rate, m_nResamplePreset);
+
         if ((ret = decoder_init(&is->auddec, avctx, &is->audioq, is->continue_read_thread)) < 0)
             goto fail;
-        if ((is->ic->iformat->flags & (AVFMT_NOBINSEARCH | AVFMT_NOGENSEARCH | AVFMT_NO_BYTE_SEEK)) && !is->ic->iformat->read_seek) {
+        if ((ic->iformat->flags & (AVFMT_NOBINSEARCH | AVFMT_NOGENSEARCH | AVFMT_NO_BYTE_SEEK)) && !ic->iformat->read_seek) {
             is->auddec.start_pts = is->audio_st->start_time;
             is->auddec.start_pts_tb = is->audio_st->time_base;
         }
 
+        is->audio_primed = 0;
+        is->audio_started = !fast_first_frame && !is->schedule_pending;
+
         packet_queue_start(is->auddec.queue);
         is->auddec.decode_thread = std::thread(&VideoCtl::audio_thread, this, is);
 
-        SDL_PauseAudioDevice(audio_dev, 0);
+        update_audio_mix(is);
+
+        //快速起播时由音频解码线程在缓冲足够后启动设备
+        if (is->audio_started)
+            SDL_PauseAudioDevice(audio_dev, 0);
         break;
     case AVMEDIA_TYPE_VIDEO:
         is->video_stream = stream_index;
@@ -1255,6 +1944,19 @@ int VideoCtl::stream_has_enough_packets(AVStream* st, int stream_id, PacketQueue
         queue->nb_packets > MIN_FRAMES && (!queue->duration || av_q2d(st->time_base) * queue->duration > 1.0);
 }
 
+static double queue_seconds(AVStream* st, int stream_id, PacketQueue* queue)
+{
+    if (stream_id < 0 || !st || (st->disposition & AV_DISPOSITION_ATTACHED_PIC))
+        return INFINITY;
+    return queue->duration * av_q2d(st->time_base);
+}
+
+double VideoCtl::buffered_seconds(VideoState *is)
+{
+    return FFMIN(queue_seconds(is->audio_st, is->audio_stream, &is->audioq),
+                 queue_seconds(is->video_st, is->video_stream, &is->videoq));
+}
+
 int VideoCtl::is_realtime(AVFormatContext* s)
 {
     if (!strcmp(s->iformat->name, "rtp")
@@ -1291,6 +1993,9 @@ void VideoCtl::ReadThread(VideoState *is)
 
     const char* wanted_stream_spec[AVMEDIA_TYPE_NB] = { 0 };
 
+    //播放期间后台读取让出
+    IoScheduler::GetInstance()->PlaybackStart();
+
     if (!wait_mutex) {
         av_log(NULL, AV_LOG_FATAL, "SDL_CreateMutex(): %s\n", SDL_GetError());
         ret = AVERROR(ENOMEM);
@@ -1402,7 +2107,7 @@ void VideoCtl::ReadThread(VideoState *is)
 
     /* open the streams */
     //打开音频流
-    if (st_index[AVMEDIA_TYPE_AUDIO] >= 0) {
+    if (!audio_disable && st_index[AVMEDIA_TYPE_AUDIO] >= 0) {
         stream_component_open(is, st_index[AVMEDIA_TYPE_AUDIO]);
     }
 
@@ -1427,6 +2132,17 @@ void VideoCtl::ReadThread(VideoState *is)
     if (infinite_buffer < 0 && is->realtime)
         infinite_buffer = 1;
 
+    //从指定位置开始，按普通 seek 处理
+    if (!isnan(is->start_pos) && !is->seek_req) {
+        int64_t start = (int64_t)(is->start_pos * AV_TIME_BASE);
+        if (ic->start_time != AV_NOPTS_VALUE && start < ic->start_time)
+            start = ic->start_time;
+        is->seek_pos = start;
+        is->seek_rel = 0;
+        is->seek_flags &= ~AVSEEK_FLAG_BYTE;
+        is->seek_req = 1;
+    }
+
     //读取视频数据
     for (;;) {
         if (is->abort_request)
@@ -1438,7 +2154,18 @@ void VideoCtl::ReadThread(VideoState *is)
             else
                 av_read_play(ic);
         }
-
+        //载入外部音频
+        {
+            ExtAudio *ea;
+            {
+                std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+                ea = m_pExtAudioReq;
+                m_pExtAudioReq = nullptr;
+            }
+            if (ea)
+                ext_audio_attach(is, ea);
+        }
+
         if (is->seek_req) {
             int64_t seek_target = is->seek_pos;
             int64_t seek_min = is->seek_rel > 0 ? seek_target - is->seek_rel + 2 : INT64_MIN;
@@ -1446,12 +2173,20 @@ void VideoCtl::ReadThread(VideoState *is)
             // FIXME the +-2 is due to rounding being not done in the correct direction in generation
             //      of the seek_pos/seek_rel variables
 
+            //外部音频同时 seek，两个文件并行，总耗时取较慢的一个
+            if (is->ext_audio)
+                ext_audio_seek_start(is, seek_min, seek_target, seek_max, is->seek_flags);
             ret = avformat_seek_file(is->ic, -1, seek_min, seek_target, seek_max, is->seek_flags);
+            if (is->ext_audio && ext_audio_seek_wait(is) < 0) {
+                av_log(NULL, AV_LOG_ERROR,
+                    "%s: error while seeking\n", is->ext_audio->ic->url);
+            }
             if (ret < 0) {
                 av_log(NULL, AV_LOG_ERROR,
                     "%s: error while seeking\n", is->ic->url);
             }
             else {
+                m_stAudioMixer.Flush();
                 if (is->audio_stream >= 0)
                     packet_queue_flush(&is->audioq);
                 if (is->subtitle_stream >= 0)
@@ -1465,6 +2200,8 @@ void VideoCtl::ReadThread(VideoState *is)
                     set_clock(&is->extclk, seek_target / (double)AV_TIME_BASE, 0);
                 }
             }
+            if (is->ext_audio)
+                ext_audio_seek_end(is);
             is->seek_req = 0;
             is->queue_attachments_req = 1;
             is->eof = 0;
@@ -1487,6 +2224,7 @@ void VideoCtl::ReadThread(VideoState *is)
                 || (stream_has_enough_packets(is->audio_st, is->audio_stream, &is->audioq) &&
                     stream_has_enough_packets(is->video_st, is->video_stream, &is->videoq) &&
                     stream_has_enough_packets(is->subtitle_st, is->subtitle_stream, &is->subtitleq)))) {
+            IoScheduler::GetInstance()->SetPlaybackBuffer(buffered_seconds(is), true);
             /* wait 10 ms */
             SDL_LockMutex(wait_mutex);
             SDL_CondWaitTimeout(is->continue_read_thread, wait_mutex, 10);
@@ -1501,14 +2239,18 @@ void VideoCtl::ReadThread(VideoState *is)
             emit SigStop();
             continue;
         }
+        IoScheduler::GetInstance()->SetPlaybackBuffer(buffered_seconds(is), is->eof);
         //按帧读取
+        IoScheduler::GetInstance()->PlaybackReadBegin();
         ret = av_read_frame(ic, pkt);
+        IoScheduler::GetInstance()->PlaybackReadEnd(ret >= 0 ? pkt->size : 0);
         if (ret < 0) {
             if ((ret == AVERROR_EOF || avio_feof(ic->pb)) && !is->eof) {
                 if (is->video_stream >= 0)
                     packet_queue_put_nullpacket(&is->videoq, pkt, is->video_stream);
-                if (is->audio_stream >= 0)
+                if (is->audio_stream >= 0 && !is->ext_audio)
                     packet_queue_put_nullpacket(&is->audioq, pkt, is->audio_stream);
+                m_stAudioMixer.PutNullPackets(pkt);
                 if (is->subtitle_stream >= 0)
                     packet_queue_put_nullpacket(&is->subtitleq, pkt, is->subtitle_stream);
                 is->eof = 1;
@@ -1532,7 +2274,7 @@ void VideoCtl::ReadThread(VideoState *is)
             (double)(0 != AV_NOPTS_VALUE ? 0 : 0) / 1000000
             <= ((double)AV_NOPTS_VALUE / 1000000);
         //按数据帧的类型存放至对应队列
-        if (pkt->stream_index == is->audio_stream && pkt_in_play_range) {
+        if (pkt->stream_index == is->audio_stream && pkt_in_play_range && !is->ext_audio) {
             packet_queue_put(&is->audioq, pkt);
         }
         else if (pkt->stream_index == is->video_stream && pkt_in_play_range
@@ -1542,6 +2284,9 @@ void VideoCtl::ReadThread(VideoState *is)
         else if (pkt->stream_index == is->subtitle_stream && pkt_in_play_range) {
             packet_queue_put(&is->subtitleq, pkt);
         }
+        else if (pkt_in_play_range && m_stAudioMixer.PutPacket(pkt)) {
+            //混入的音轨，不计入队列上限，由主音轨的消耗速度控制读取
+        }
         else {
             av_packet_unref(pkt);
         }
@@ -1559,17 +2304,22 @@ fail:
         event.user.data1 = is;
         SDL_PushEvent(&event);
     }
+    IoScheduler::GetInstance()->PlaybackStop();
     SDL_DestroyMutex(wait_mutex);
     return ;
 }
 
-VideoState* VideoCtl::stream_open(const char *filename)
+VideoState* VideoCtl::stream_open(const char *filename, int64_t schedule_start, double start_pos, int start_paused)
 {
     VideoState *is;
-    //构造视频状态类
-    is = (VideoState *)av_mallocz(sizeof(VideoState));
+    //构造视频状态类（按缓存行对齐，值初始化保证各字段清零）
+    is = new (std::nothrow) VideoState();
     if (!is)
         return NULL;
+    //读取线程打开解码器之前设置，音频设备不自动启动
+    is->schedule_start = schedule_start;
+    is->schedule_pending = schedule_start != 0;
+    is->start_pos = start_pos;
     //视频文件名
     is->last_video_stream = is->video_stream = -1;
     is->last_audio_stream = is->audio_stream = -1;
@@ -1606,6 +2356,7 @@ VideoState* VideoCtl::stream_open(const char *filename)
     init_clock(&is->audclk, &is->audioq.serial);
     init_clock(&is->extclk, &is->extclk.serial);
     is->audio_clock_serial = -1;
+    is->open_time = av_gettime_relative();
     //音量
     if (startup_volume < 0)
         av_log(NULL, AV_LOG_WARNING, "-volume=%d < 0, setting to 0\n", startup_volume);
@@ -1614,11 +2365,17 @@ VideoState* VideoCtl::stream_open(const char *filename)
     startup_volume = av_clip(startup_volume, 0, 100);
     startup_volume = av_clip(SDL_MIX_MAXVOLUME * startup_volume / 100, 0, SDL_MIX_MAXVOLUME);
     is->audio_volume = startup_volume;
+    //保持暂停，读取线程 seek 到开始位置后显示一帧
+    if (start_paused)
+        is->paused = is->audclk.paused = is->vidclk.paused = is->extclk.paused = 1;
 
     emit SigVideoVolume(startup_volume * 1.0 / SDL_MIX_MAXVOLUME);
     emit SigPauseStat(is->paused);
 
     is->av_sync_type = AV_SYNC_AUDIO_MASTER;
+    //跟随其他播放器时，音频、视频都同步到跟随主机的外部时钟
+    if (ClockSync::GetInstance()->GetRole() == SYNC_ROLE_FOLLOWER)
+        is->av_sync_type = AV_SYNC_EXTERNAL_CLOCK;
     //构建读取线程
     is->read_tid = std::thread(&VideoCtl::ReadThread, this, is);
 
@@ -1638,6 +2395,11 @@ void VideoCtl::stream_cycle_channel(VideoState *is, int codec_type)
     AVProgram *p = NULL;
     int nb_streams = is->ic->nb_streams;
 
+    if (codec_type == AVMEDIA_TYPE_AUDIO && is->ext_audio) {
+        av_log(NULL, AV_LOG_INFO, "Audio comes from the external file, not switching\n");
+        return;
+    }
+
     if (codec_type == AVMEDIA_TYPE_VIDEO) {
         start_index = is->last_video_stream;
         old_index = is->video_stream;
@@ -1709,6 +2471,229 @@ the_end:
     stream_component_open(is, stream_index);
 }
 
+void VideoCtl::update_audio_mix(VideoState *is)
+{
+    AVFormatContext *ic = is->ic;
+
+    for (unsigned int i = 0; i < ic->nb_streams; i++) {
+        AVStream *st = ic->streams[i];
+
+        if (((int)i == is->audio_stream && !is->ext_audio) || st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+            continue;
+        if (m_bMixAudio && is->audio_stream >= 0) {
+            if (st->codecpar->sample_rate == 0 || st->codecpar->ch_layout.nb_channels == 0)
+                continue;
+            if (m_stAudioMixer.AddTrack(ic, i, is->continue_read_thread) == 0)
+                st->discard = AVDISCARD_DEFAULT;
+        }
+        else if (m_stAudioMixer.HasTrack(i)) {
+            m_stAudioMixer.RemoveTrack(i);
+            st->discard = AVDISCARD_ALL;
+        }
+    }
+}
+
+//在读取线程中换用外部音频作为主音轨
+void VideoCtl::ext_audio_attach(VideoState *is, ExtAudio *ea)
+{
+    double pos = get_master_clock(is);
+
+    //两个文件的起始时间不同时（如 TS 与单独的配音），按起始时间对齐
+    if (is->ic->start_time != AV_NOPTS_VALUE && ea->ic->start_time != AV_NOPTS_VALUE)
+        ea->ts_offset = is->ic->start_time - ea->ic->start_time;
+
+    ext_audio_close(is);
+    if (is->audio_stream >= 0)
+        stream_component_close(is, is->audio_stream);
+
+    //从当前播放位置开始
+    if (!isnan(pos)) {
+        int64_t ts = (int64_t)(pos * AV_TIME_BASE) - ea->ts_offset;
+        if (avformat_seek_file(ea->ic, -1, INT64_MIN, ts, INT64_MAX, 0) < 0)
+            av_log(NULL, AV_LOG_WARNING, "%s: could not seek to position %0.3f\n", ea->ic->url, pos);
+    }
+
+    is->ext_audio = ea;
+    if (stream_component_open(is, ea->stream_index, ea->ic) < 0) {
+        av_log(NULL, AV_LOG_ERROR, "%s: could not open the audio stream\n", ea->ic->url);
+        is->ext_audio = NULL;
+        ext_audio_free(ea);
+        //恢复主文件的音轨
+        if (is->last_audio_stream >= 0)
+            stream_component_open(is, is->last_audio_stream);
+        return;
+    }
+    ea->read_tid = std::thread(&VideoCtl::ExtAudioReadThread, this, is);
+
+    av_log(NULL, AV_LOG_INFO, "Audio from %s stream #%d, offset %0.3f s\n",
+        ea->ic->url, ea->stream_index, ea->ts_offset / (double)AV_TIME_BASE);
+}
+
+//停止外部音频的读取线程，关闭其音轨
+void VideoCtl::ext_audio_close(VideoState *is)
+{
+    ExtAudio *ea = is->ext_audio;
+
+    if (!ea)
+        return;
+
+    SDL_LockMutex(ea->mutex);
+    ea->abort_request = 1;
+    SDL_CondBroadcast(ea->cond);
+    SDL_UnlockMutex(ea->mutex);
+    if (ea->read_tid.joinable())
+        ea->read_tid.join();
+
+    if (is->audio_stream >= 0)
+        stream_component_close(is, is->audio_stream, ea->ic);
+    is->ext_audio = NULL;
+    ext_audio_free(ea);
+}
+
+//通知外部音频的读取线程 seek，与主文件的 seek 同时进行
+void VideoCtl::ext_audio_seek_start(VideoState *is, int64_t seek_min, int64_t seek_target, int64_t seek_max, int seek_flags)
+{
+    ExtAudio *ea = is->ext_audio;
+
+    if (seek_flags & AVSEEK_FLAG_BYTE) {
+        //按字节 seek 时按主文件的大小和时长换算为时间
+        int64_t size = is->ic->pb ? avio_size(is->ic->pb) : -1;
+        if (size > 0 && is->ic->duration > 0) {
+            seek_target = av_rescale(seek_target, is->ic->duration, size);
+            if (is->ic->start_time != AV_NOPTS_VALUE)
+                seek_target += is->ic->start_time;
+        }
+        else {
+            double pos = get_master_clock(is);
+            seek_target = isnan(pos) ? 0 : (int64_t)(pos * AV_TIME_BASE);
+        }
+        seek_min = INT64_MIN;
+        seek_max = INT64_MAX;
+    }
+
+    SDL_LockMutex(ea->mutex);
+    ea->seek_min = seek_min == INT64_MIN ? INT64_MIN : seek_min - ea->ts_offset;
+    ea->seek_target = seek_target - ea->ts_offset;
+    ea->seek_max = seek_max == INT64_MAX ? INT64_MAX : seek_max - ea->ts_offset;
+    ea->seek_req = 1;
+    SDL_CondBroadcast(ea->cond);
+    SDL_UnlockMutex(ea->mutex);
+}
+
+//等外部音频 seek 完成，返回其结果
+int VideoCtl::ext_audio_seek_wait(VideoState *is)
+{
+    ExtAudio *ea = is->ext_audio;
+    int ret;
+
+    SDL_LockMutex(ea->mutex);
+    while (ea->seek_req == 1 && !ea->finished && !is->abort_request)
+        SDL_CondWaitTimeout(ea->cond, ea->mutex, 10);
+    ret = ea->seek_req == 2 ? ea->seek_ret : AVERROR_EXIT;
+    SDL_UnlockMutex(ea->mutex);
+    return ret;
+}
+
+//队列已清空，外部音频继续读取
+void VideoCtl::ext_audio_seek_end(VideoState *is)
+{
+    ExtAudio *ea = is->ext_audio;
+
+    SDL_LockMutex(ea->mutex);
+    ea->seek_req = 0;
+    SDL_CondBroadcast(ea->cond);
+    SDL_UnlockMutex(ea->mutex);
+}
+
+//外部音频读取线程
+void VideoCtl::ExtAudioReadThread(VideoState *is)
+{
+    ExtAudio *ea = is->ext_audio;
+    AVStream *st = ea->ic->streams[ea->stream_index];
+    int64_t pkt_offset = av_rescale_q(ea->ts_offset, AV_TIME_BASE_Q, st->time_base);
+    AVPacket *pkt = av_packet_alloc();
+    SDL_mutex *wait_mutex = SDL_CreateMutex();
+    int ret;
+
+    if (!pkt || !wait_mutex) {
+        av_log(NULL, AV_LOG_FATAL, "Could not allocate the external audio reader\n");
+        goto the_end;
+    }
+
+    for (;;) {
+        SDL_LockMutex(ea->mutex);
+        if (ea->seek_req == 1) {
+            int64_t seek_min = ea->seek_min, seek_target = ea->seek_target, seek_max = ea->seek_max;
+            SDL_UnlockMutex(ea->mutex);
+            ret = avformat_seek_file(ea->ic, -1, seek_min, seek_target, seek_max, 0);
+            SDL_LockMutex(ea->mutex);
+            ea->seek_ret = ret;
+            ea->seek_req = 2;
+            ea->eof = 0;
+            SDL_CondBroadcast(ea->cond);
+        }
+        //主读取线程清空队列前不能放入数据包
+        while (ea->seek_req == 2 && !ea->abort_request && !is->abort_request)
+            SDL_CondWaitTimeout(ea->cond, ea->mutex, 10);
+        if (ea->abort_request || is->abort_request) {
+            SDL_UnlockMutex(ea->mutex);
+            break;
+        }
+        if (ea->seek_req) {
+            SDL_UnlockMutex(ea->mutex);
+            continue;
+        }
+        SDL_UnlockMutex(ea->mutex);
+
+        /* if the queue are full, no need to read more */
+        if (infinite_buffer < 1 &&
+            (is->audioq.size > MAX_QUEUE_SIZE || stream_has_enough_packets(st, ea->stream_index, &is->audioq))) {
+            SDL_LockMutex(wait_mutex);
+            SDL_CondWaitTimeout(is->continue_read_thread, wait_mutex, 10);
+            SDL_UnlockMutex(wait_mutex);
+            continue;
+        }
+
+        IoScheduler::GetInstance()->PlaybackReadBegin();
+        ret = av_read_frame(ea->ic, pkt);
+        IoScheduler::GetInstance()->PlaybackReadEnd(ret >= 0 ? pkt->size : 0);
+        if (ret < 0) {
+            if ((ret == AVERROR_EOF || avio_feof(ea->ic->pb)) && !ea->eof) {
+                packet_queue_put_nullpacket(&is->audioq, pkt, ea->stream_index);
+                ea->eof = 1;
+            }
+            if (ea->ic->pb && ea->ic->pb->error)
+                break;
+            SDL_LockMutex(wait_mutex);
+            SDL_CondWaitTimeout(is->continue_read_thread, wait_mutex, 10);
+            SDL_UnlockMutex(wait_mutex);
+            continue;
+        }
+        ea->eof = 0;
+
+        if (pkt->stream_index == ea->stream_index) {
+            if (pkt->pts != AV_NOPTS_VALUE)
+                pkt->pts += pkt_offset;
+            if (pkt->dts != AV_NOPTS_VALUE)
+                pkt->dts += pkt_offset;
+            packet_queue_put(&is->audioq, pkt);
+        }
+        else {
+            av_packet_unref(pkt);
+        }
+    }
+
+the_end:
+    SDL_LockMutex(ea->mutex);
+    ea->finished = 1;
+    SDL_CondBroadcast(ea->cond);
+    SDL_UnlockMutex(ea->mutex);
+
+    av_packet_free(&pkt);
+    if (wait_mutex)
+        SDL_DestroyMutex(wait_mutex);
+}
+
 
 void VideoCtl::refresh_loop_wait_event(VideoState *is, SDL_Event *event) {
     double remaining_time = 0.0;
@@ -1718,12 +2703,76 @@ void VideoCtl::refresh_loop_wait_event(VideoState *is, SDL_Event *event) {
         if (remaining_time > 0.0)
             av_usleep((int64_t)(remaining_time * 1000000.0));
         remaining_time = REFRESH_RATE;
+        //定时播放在开始时间之前只预加载
+        if (is->schedule_pending && scheduled_start_wait(is, &remaining_time)) {
+            check_output_transition();
+            SDL_PumpEvents();
+            continue;
+        }
+        //首帧显示前缩短轮询间隔，解码出来就能尽快显示
+        if (fast_first_frame && is->video_st && !is->first_frame_shown)
+            remaining_time = 0.001;
+        if (ClockSync::GetInstance()->GetRole() != SYNC_ROLE_OFF)
+            update_sync_clock(is);
         if (!is->paused || is->force_refresh)
             video_refresh(is, &remaining_time);
+        check_output_transition();
         SDL_PumpEvents();
     }
 }
 
+int VideoCtl::scheduled_start_wait(VideoState *is, double *remaining_time)
+{
+    //按系统时间计算，等待期间系统时间被校准也以新时间为准
+    int64_t until = is->schedule_start - av_gettime();
+    int video_ready = !is->video_st || frame_queue_nb_remaining(&is->pictq) > 0;
+    int audio_ready = !is->audio_st || is->auddec.finished ||
+        is->audio_primed >= (double)is->audio_hw_buf_size / is->audio_tgt.bytes_per_sec ||
+        frame_queue_nb_remaining(&is->sampq) >= is->sampq.max_size - 1;
+    double audio_lead;
+    double now, pts;
+
+    //预加载未完成时到了开始时间也只能推迟
+    if (!video_ready || !audio_ready) {
+        *remaining_time = FFMIN(*remaining_time, 0.001);
+        return 1;
+    }
+    if (!is->preroll_time) {
+        is->preroll_time = av_gettime_relative();
+        av_log(NULL, until > 0 ? AV_LOG_INFO : AV_LOG_WARNING, "Scheduled start: pre-rolled in %.1f ms, %.1f ms %s the scheduled time\n",
+            (is->preroll_time - is->open_time) / 1000.0, FFABS(until) / 1000.0, until > 0 ? "before" : "after");
+    }
+
+    //声音经过设备缓冲（按两个硬件缓冲区估计）才输出，提前启动设备
+    audio_lead = is->audio_st ? 2.0 * is->audio_hw_buf_size / is->audio_tgt.bytes_per_sec : 0;
+    if (is->audio_st && !is->audio_started && until <= audio_lead * 1000000) {
+        is->audio_started = 1;
+        SDL_PauseAudioDevice(audio_dev, 0);
+    }
+
+    if (until > SCHEDULE_SPIN_TIME * 1000000) {
+        double wait = until / 1000000.0 - SCHEDULE_SPIN_TIME;
+        if (is->audio_st && !is->audio_started)
+            wait = FFMIN(wait, until / 1000000.0 - audio_lead);
+        *remaining_time = FFMIN(*remaining_time, FFMAX(wait, 0.0));
+        return 1;
+    }
+    while (av_gettime() < is->schedule_start)
+        std::this_thread::yield();
+
+    //外部时钟（没有音频时的主时钟）从开始时间起走，视频立即显示第一帧
+    now = av_gettime_relative() / 1000000.0;
+    pts = NAN;
+    if (is->video_st)
+        pts = frame_queue_peek(&is->pictq)->pts;
+    else if (is->audio_st && frame_queue_nb_remaining(&is->sampq) > 0)
+        pts = frame_queue_peek(&is->sampq)->pts;
+    set_clock_at(&is->extclk, pts, is->extclk.serial, now - (av_gettime() - is->schedule_start) / 1000000.0);
+    is->frame_timer = now;
+    is->schedule_pending = 0;
+    return 0;
+}
+
 void VideoCtl::seek_chapter(VideoState *is, int incr)
 {
     int64_t pos = get_master_clock(is) * AV_TIME_BASE;
@@ -1789,11 +2838,21 @@ void VideoCtl::LoopThread(VideoState *cur_stream)
             }
             break;
         case SDL_WINDOWEVENT:
+            //镜像输出窗口变化时只需重绘
+            if (is_mirror_window(event.window.windowID)) {
+                cur_stream->force_refresh = 1;
+                break;
+            }
             //窗口大小改变事件
             switch (event.window.event) {
             case SDL_WINDOWEVENT_RESIZED:
                 screen_width = cur_stream->width = event.window.data1;
                 screen_height = cur_stream->height = event.window.data2;
+                if (m_bTransitionPending) {
+                    std::lock_guard<std::mutex> lock(m_mutexTransition);
+                    m_bTransitionResized = true;
+                    m_nTransitionResizes++;
+                }
             case SDL_WINDOWEVENT_EXPOSED:
                 cur_stream->force_refresh = 1;
             }
@@ -1836,6 +2895,17 @@ void VideoCtl::OnPlayVolume(double dPercent)
     m_CurStream->audio_volume = startup_volume;
 }
 
+double VideoCtl::relative_seek_target(VideoState *is, double incr)
+{
+    double pos = get_master_clock(is);
+    if (std::isnan(pos))
+        pos = (double)is->seek_pos / AV_TIME_BASE;
+    pos += incr;
+    if (is->ic->start_time != AV_NOPTS_VALUE && pos < is->ic->start_time / (double)AV_TIME_BASE)
+        pos = is->ic->start_time / (double)AV_TIME_BASE;
+    return pos;
+}
+
 void VideoCtl::OnSeekForward()
 {
     if (m_CurStream == nullptr)
@@ -1843,12 +2913,7 @@ void VideoCtl::OnSeekForward()
         return;
     }
     double incr = 5.0;
-    double pos = get_master_clock(m_CurStream);
-    if (std::isnan(pos))
-        pos = (double)m_CurStream->seek_pos / AV_TIME_BASE;
-    pos += incr;
-    if (m_CurStream->ic->start_time != AV_NOPTS_VALUE && pos < m_CurStream->ic->start_time / (double)AV_TIME_BASE)
-        pos = m_CurStream->ic->start_time / (double)AV_TIME_BASE;
+    double pos = relative_seek_target(m_CurStream, incr);
     stream_seek(m_CurStream, (int64_t)(pos * AV_TIME_BASE), (int64_t)(incr * AV_TIME_BASE));
 }
 
@@ -1859,12 +2924,7 @@ void VideoCtl::OnSeekBack()
         return;
     }
     double incr = -5.0;
-    double pos = get_master_clock(m_CurStream);
-    if (std::isnan(pos))
-        pos = (double)m_CurStream->seek_pos / AV_TIME_BASE;
-    pos += incr;
-    if (m_CurStream->ic->start_time != AV_NOPTS_VALUE && pos < m_CurStream->ic->start_time / (double)AV_TIME_BASE)
-        pos = m_CurStream->ic->start_time / (double)AV_TIME_BASE;
+    double pos = relative_seek_target(m_CurStream, incr);
     stream_seek(m_CurStream, (int64_t)(pos * AV_TIME_BASE), (int64_t)(incr * AV_TIME_BASE));
 }
 
@@ -1884,22 +2944,80 @@ void VideoCtl::UpdateVolume(int sign, double step)
 /* display the current picture, if any */
 void VideoCtl::video_display(VideoState *is)
 {
-    if (!window)
+    if (display_disable)
+        return;
+    if (!m_pRender->IsOpen())
         video_open(is);
-    if (renderer)
+    if (m_pRender->IsOpen() && m_pRender->BeginFrame())
     {
-        //恰好显示控件大小在变化，则不刷新显示
-        if (g_show_rect_mutex.tryLock())
-        {
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            SDL_RenderClear(renderer);
-            video_image_display(is);
-            SDL_RenderPresent(renderer);
+        video_image_display(is);
+        overlay_display(is);
+        m_pRender->EndFrame();
 
-            g_show_rect_mutex.unlock();
+        if (m_bTransitionPending)
+        {
+            std::lock_guard<std::mutex> lock(m_mutexTransition);
+            if (m_bTransitionResized)
+            {
+                m_bTransitionResized = false;
+                m_nTransitionPresent = av_gettime_relative();
+            }
         }
     }
+    else if (m_bTransitionPending)
+    {
+        std::lock_guard<std::mutex> lock(m_mutexTransition);
+        m_nTransitionSkipped++;
+    }
+
+}
+
+void VideoCtl::check_output_transition()
+{
+    if (!m_bTransitionPending)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutexTransition);
+    int64_t now = av_gettime_relative();
+    if (m_nTransitionPresent > 0 && !m_bTransitionResized &&
+        now - m_nTransitionPresent > OUTPUT_TRANSITION_SETTLE * 1000000) {
+        av_log(NULL, AV_LOG_INFO, "Output transition (%s): %.1f ms to first stable frame, %d resizes, %d frames not presented\n",
+            m_szTransition, (m_nTransitionPresent - m_nTransitionStart) / 1000.0, m_nTransitionResizes, m_nTransitionSkipped);
+        m_bTransitionPending = false;
+    }
+    else if (now - m_nTransitionStart > OUTPUT_TRANSITION_TIMEOUT * 1000000) {
+        av_log(NULL, AV_LOG_WARNING, "Output transition (%s): no stable frame within %.0f s, %d resizes, %d frames not presented\n",
+            m_szTransition, OUTPUT_TRANSITION_TIMEOUT, m_nTransitionResizes, m_nTransitionSkipped);
+        m_bTransitionPending = false;
+    }
+}
+
+void VideoCtl::overlay_display(VideoState *is)
+{
+    QImage image;
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOverlay);
+        image = m_imgOverlay;
+        serial = m_nOverlaySerial;
+    }
+    if (image.isNull())
+        return;
+
+    //图像没变时复用已上传的纹理
+    if (serial != m_nOverlayUploaded) {
+        if (m_pRender->UploadOverlay(image.constBits(), image.bytesPerLine(), image.width(), image.height()) < 0)
+            return;
+        m_nOverlayUploaded = serial;
+    }
 
+    //图像按界面设备像素比绘制，输出区域可能与控件大小不同（未及时调整时按宽度缩放）
+    SDL_Rect rect;
+    rect.w = is->width;
+    rect.h = FFMAX(1, (int)av_rescale(image.height(), is->width, FFMAX(image.width(), 1)));
+    rect.x = 0;
+    rect.y = is->height - rect.h;
+    m_pRender->RenderOverlay(&rect);
 }
 
 int VideoCtl::video_open(VideoState *is)
@@ -1909,38 +3027,17 @@ int VideoCtl::video_open(VideoState *is)
     w = screen_width;
     h = screen_height;
 
-    if (!window) {
-        int flags = SDL_WINDOW_SHOWN;
-        flags |= SDL_WINDOW_RESIZABLE;
-
-        window = SDL_CreateWindowFrom((void *)play_wid);
-        SDL_GetWindowSize(window, &w, &h);//初始宽高设置为显示控件宽高
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-        if (window) {
-            SDL_RendererInfo info;
-            if (!renderer)
-                renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-            if (!renderer) {
-                av_log(NULL, AV_LOG_WARNING, "Failed to initialize a hardware accelerated renderer: %s\n", SDL_GetError());
-                renderer = SDL_CreateRenderer(window, -1, 0);
-            }
-            if (renderer) {
-                if (!SDL_GetRendererInfo(renderer, &info))
-                    av_log(NULL, AV_LOG_VERBOSE, "Initialized %s renderer.\n", info.name);
-            }
-        }
-    }
-    else {
-        SDL_SetWindowSize(window, w, h);
-    }
-
-    if (!window || !renderer) {
-        av_log(NULL, AV_LOG_FATAL, "SDL: could not set video mode - exiting\n");
+    //初始宽高为输出控件宽高
+    if (m_pRender->Open(&w, &h) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "%s: could not set video mode - exiting\n", m_pRender->Name());
         do_exit(is);
+        return -1;
     }
 
     is->width = w;
     is->height = h;
+    //新打开的输出没有叠加纹理
+    m_nOverlayUploaded = 0;
 
     return 0;
 }
@@ -1952,19 +3049,13 @@ void VideoCtl::do_exit(VideoState* &is)
         stream_close(is);
         is = nullptr;
     }
-    if (renderer)
-    {
-        SDL_DestroyRenderer(renderer);
-        renderer = nullptr;
-    }
+    m_pRender->Close();
+    mirror_close();
+    m_stProxyCache.SetPlaybackActive(false);
 
-    if (window)
-    {
-        //SDL_DestroyWindow(window);
-        window = nullptr;
-    }
-
-    emit SigStopFinished();
+    //切换原文件与代理时马上重新打开，界面不视为停止
+    if (!m_bSourceSwitch)
+        emit SigStopFinished();
 }
 
 void VideoCtl::OnAddVolume()
@@ -1993,13 +3084,144 @@ void VideoCtl::OnPause()
     }
     toggle_pause(m_CurStream);
     emit SigPauseStat(m_CurStream->paused);
+    m_stProxyCache.SetPlaybackActive(!m_CurStream->paused);
+    schedule_proxy_update();
 }
 
 void VideoCtl::OnStop()
 {
+    m_nScheduleId++;
     m_bPlayLoop = false;
 }
 
+void VideoCtl::OnZoom(int nSteps, double dX, double dY)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        double dOldZoom = m_dZoom;
+        double dPointX, dPointY;
+
+        m_dZoom = av_clipd(m_dZoom * pow(ZOOM_STEP, nSteps), 1.0, ZOOM_MAX);
+
+        //保持鼠标所指的点不动
+        dX = av_clipd(dX, 0.0, 1.0);
+        dY = av_clipd(dY, 0.0, 1.0);
+        dPointX = m_dZoomCenterX - 0.5 / dOldZoom + dX / dOldZoom;
+        dPointY = m_dZoomCenterY - 0.5 / dOldZoom + dY / dOldZoom;
+        m_dZoomCenterX = av_clipd(dPointX - (dX - 0.5) / m_dZoom, 0.5 / m_dZoom, 1.0 - 0.5 / m_dZoom);
+        m_dZoomCenterY = av_clipd(dPointY - (dY - 0.5) / m_dZoom, 0.5 / m_dZoom, 1.0 - 0.5 / m_dZoom);
+    }
+
+    if (m_CurStream)
+    {
+        m_CurStream->force_refresh = 1;
+    }
+}
+
+void VideoCtl::OnPan(double dDx, double dDy)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        if (m_dZoom <= 1.0)
+        {
+            return;
+        }
+        m_dZoomCenterX = av_clipd(m_dZoomCenterX - dDx / m_dZoom, 0.5 / m_dZoom, 1.0 - 0.5 / m_dZoom);
+        m_dZoomCenterY = av_clipd(m_dZoomCenterY - dDy / m_dZoom, 0.5 / m_dZoom, 1.0 - 0.5 / m_dZoom);
+    }
+
+    if (m_CurStream)
+    {
+        m_CurStream->force_refresh = 1;
+    }
+}
+
+void VideoCtl::OnZoomReset()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        m_dZoom = 1.0;
+        m_dZoomCenterX = 0.5;
+        m_dZoomCenterY = 0.5;
+    }
+
+    if (m_CurStream)
+    {
+        m_CurStream->force_refresh = 1;
+    }
+}
+
+void VideoCtl::OnToggleAudioMix()
+{
+    m_bMixAudio = !m_bMixAudio;
+
+    if (m_CurStream)
+    {
+        update_audio_mix(m_CurStream);
+    }
+}
+
+void VideoCtl::OnSetAudioTrackMix(int nStreamIndex, double dGain, double dPan)
+{
+    m_stAudioMixer.SetTrackMix(nStreamIndex, dGain, dPan);
+}
+
+void VideoCtl::SetResamplePreset(int nPreset)
+{
+    m_nResamplePreset = av_clip(nPreset, 0, RESAMPLE_PRESET_NB - 1);
+}
+
+int VideoCtl::GetResamplePreset()
+{
+    return m_nResamplePreset;
+}
+
+void VideoCtl::SetRenderBackend(int nBackend)
+{
+    if (nBackend < 0 || nBackend >= RENDER_BACKEND_NB)
+    {
+        return;
+    }
+    m_nRenderBackend = nBackend;
+}
+
+int VideoCtl::GetRenderBackend()
+{
+    return m_nRenderBackend;
+}
+
+void VideoCtl::SetQtRenderWidget(QtRenderWidget *pWidget)
+{
+    m_stQtRender.SetWidget(pWidget);
+}
+
+void VideoCtl::SetOverlay(const QImage &image)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutexOverlay);
+        if (image.isNull() && m_imgOverlay.isNull())
+            return;
+        m_imgOverlay = image;
+        m_nOverlaySerial++;
+    }
+
+    //暂停时也要显示控制条的变化
+    if (m_CurStream)
+        m_CurStream->force_refresh = 1;
+}
+
+void VideoCtl::MarkOutputTransition(const char *szName)
+{
+    std::lock_guard<std::mutex> lock(m_mutexTransition);
+    m_szTransition = szName;
+    m_nTransitionStart = av_gettime_relative();
+    m_bTransitionResized = false;
+    m_nTransitionPresent = 0;
+    m_nTransitionResizes = 0;
+    m_nTransitionSkipped = 0;
+    m_bTransitionPending = true;
+}
+
 VideoCtl::VideoCtl(QObject *parent) :
 QObject(parent),
 m_bInited(false),
@@ -2008,14 +3230,42 @@ m_bPlayLoop(false),
 screen_width(0),
 screen_height(0),
 startup_volume(30),
-renderer(nullptr),
-window(nullptr),
+m_pRender(&m_stSdlRender),
+m_nRenderBackend(RENDER_BACKEND_SDL),
+m_bTransitionPending(false),
+m_szTransition(""),
+m_nTransitionStart(0),
+m_bTransitionResized(false),
+m_nTransitionPresent(0),
+m_nTransitionResizes(0),
+m_nTransitionSkipped(0),
+m_nScheduleId(0),
+m_nOverlaySerial(0),
+m_nOverlayUploaded(0),
 m_nFrameW(0),
-m_nFrameH(0)
+m_nFrameH(0),
+m_dZoom(1.0),
+m_dZoomCenterX(0.5),
+m_dZoomCenterY(0.5),
+m_pSeekStress(nullptr),
+m_nFirstFrameUs(0),
+m_bMixAudio(false),
+m_nResamplePreset(RESAMPLE_PRESET_BALANCED),
+m_pExtAudioReq(nullptr),
+m_pExtAudioOpening(nullptr),
+m_bProxyActive(false),
+m_bSourceSwitch(false),
+m_bScrubbing(false),
+m_nViewW(0),
+m_nViewH(0),
+m_bFullScreen(false),
+m_nProxyUpdateId(0)
 {
     avdevice_register_all();
     //网络格式初始化
     avformat_network_init();
+
+    m_stProxyCache.SetEnabled(proxy_enable);
 }
 
 bool VideoCtl::Init()
@@ -2030,7 +3280,12 @@ bool VideoCtl::Init()
         return false;
     }
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER))
+    int flags = SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_TIMER;
+    if (audio_disable)
+        flags &= ~SDL_INIT_AUDIO;
+    if (display_disable)
+        flags = (flags & ~SDL_INIT_VIDEO) | SDL_INIT_EVENTS; //刷新循环仍要用事件队列
+    if (SDL_Init(flags))
     {
         av_log(NULL, AV_LOG_FATAL, "Could not initialize SDL - %s\n", SDL_GetError());
         av_log(NULL, AV_LOG_FATAL, "(Did you set the DISPLAY variable?)\n");
@@ -2039,6 +3294,29 @@ bool VideoCtl::Init()
     SDL_EventState(SDL_SYSWMEVENT, SDL_IGNORE);
     SDL_EventState(SDL_USEREVENT, SDL_IGNORE);
 
+    //不在构造函数中设置，FramePool 单例可能还没有初始化
+    FramePool::GetInstance()->SetMode(frame_pool);
+
+    //颜色管理配置
+    QString strDisplayProfile, strLutFile;
+    GlobalHelper::GetColorConfig(strDisplayProfile, strLutFile);
+    m_stColorLut.SetEnabled(color_manage);
+    m_stColorLut.SetDisplayProfile(strDisplayProfile);
+    m_stColorLut.SetLutFile(strLutFile);
+
+    int nResamplePreset = RESAMPLE_PRESET_BALANCED;
+    GlobalHelper::GetResamplePreset(nResamplePreset);
+    SetResamplePreset(nResamplePreset);
+
+    int nRenderBackend = RENDER_BACKEND_SDL;
+    GlobalHelper::GetRenderBackend(nRenderBackend);
+    SetRenderBackend(nRenderBackend);
+
+    //解码器复用，配置文件 video/decoder_pool=false 可关闭，不必重新编译
+    bool bDecoderPool = decoder_pool;
+    GlobalHelper::GetDecoderPool(bDecoderPool);
+    m_stDecoderPool.SetEnabled(bDecoderPool);
+
     m_bInited = true;
 
     return true;
@@ -2047,6 +3325,7 @@ bool VideoCtl::Init()
 bool VideoCtl::ConnectSignalSlots()
 {
     connect(this, &VideoCtl::SigStop, &VideoCtl::OnStop);
+    connect(&m_stProxyCache, &ProxyCache::SigProxyReady, this, &VideoCtl::OnProxyReady, Qt::QueuedConnection);
 
     return true;
 }
@@ -2065,30 +3344,265 @@ VideoCtl *VideoCtl::GetInstance()
 
 VideoCtl::~VideoCtl()
 {
+    ext_audio_open_cancel();
+    {
+        std::lock_guard<std::mutex> lock(m_mutexMirrors);
+        for (MirrorOutput *pMirror : m_vecMirrors)
+        {
+            delete pMirror;
+        }
+        m_vecMirrors.clear();
+        for (MirrorOutput *pMirror : m_vecMirrorsClosing)
+        {
+            delete pMirror;
+        }
+        m_vecMirrorsClosing.clear();
+    }
+
     avformat_network_deinit();
 
     SDL_Quit();
 
 }
 
-bool VideoCtl::StartPlay(QString strFileName, WId widPlayWid)
+bool VideoCtl::LoadAudio(QString strFileName)
 {
-    m_bPlayLoop = false;
-    if (m_tPlayLoopThread.joinable())
+    ExtAudio *ea;
+
+    if (m_CurStream == nullptr || audio_disable || strFileName.isEmpty())
     {
-        m_tPlayLoopThread.join();
+        return false;
     }
-    emit SigStartPlay(strFileName);//正式播放，发送给标题栏
-
-    play_wid = widPlayWid;
 
-    VideoState *is;
+    //新的请求代替还没打开完的请求
+    ext_audio_open_cancel();
 
-    char file_name[1024];
-    memset(file_name, 0, 1024);
+    ea = new (std::nothrow) ExtAudio();
+    if (!ea)
+    {
+        return false;
+    }
+    ea->mutex = SDL_CreateMutex();
+    ea->cond = SDL_CreateCond();
+    if (!ea->mutex || !ea->cond)
+    {
+        av_log(NULL, AV_LOG_FATAL, "SDL_CreateMutex(): %s\n", SDL_GetError());
+        ext_audio_free(ea);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+        m_pExtAudioOpening = ea;
+    }
+    m_tExtAudioOpen = std::thread(&VideoCtl::ExtAudioOpenThread, this, ea, strFileName);
+
+    return true;
+}
+
+void VideoCtl::ExtAudioOpenThread(ExtAudio *ea, QString strFileName)
+{
+    AVFormatContext *ic = NULL;
+    int stream_index = -1;
+    int ret;
+
+    ic = avformat_alloc_context();
+    if (!ic)
+    {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    ic->interrupt_callback.callback = ext_audio_interrupt_cb;
+    ic->interrupt_callback.opaque = ea;
+    if ((ret = avformat_open_input(&ic, strFileName.toUtf8().constData(), NULL, NULL)) < 0)
+    {
+        av_log(NULL, AV_LOG_ERROR, "%s: could not open the audio file (%d)\n", strFileName.toUtf8().constData(), ret);
+        goto fail;
+    }
+    ea->ic = ic;
+
+    if ((ret = avformat_find_stream_info(ic, NULL)) < 0 ||
+        (stream_index = av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0)) < 0)
+    {
+        if (!ea->abort_request)
+            av_log(NULL, AV_LOG_ERROR, "%s: no audio stream found\n", strFileName.toUtf8().constData());
+        goto fail;
+    }
+    for (unsigned int i = 0; i < ic->nb_streams; i++)
+    {
+        ic->streams[i]->discard = (int)i == stream_index ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+    ea->stream_index = stream_index;
+
+    {
+        //由读取线程换入，避免与其 seek 同时修改
+        std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+        m_pExtAudioOpening = nullptr;
+        if (!ea->abort_request)
+        {
+            if (m_pExtAudioReq)
+            {
+                ext_audio_free(m_pExtAudioReq);
+            }
+            m_pExtAudioReq = ea;
+            return;
+        }
+    }
+    ext_audio_free(ea);
+    return;
+
+fail:
+    {
+        std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+        m_pExtAudioOpening = nullptr;
+    }
+    ext_audio_free(ea);
+}
+
+void VideoCtl::ext_audio_open_cancel()
+{
+    {
+        //打开线程清空 m_pExtAudioOpening 之前不会释放 ea
+        std::lock_guard<std::mutex> lock(m_mutexExtAudio);
+        if (m_pExtAudioOpening)
+        {
+            m_pExtAudioOpening->abort_request = 1;
+        }
+    }
+    if (m_tExtAudioOpen.joinable())
+    {
+        m_tExtAudioOpen.join();
+    }
+}
+
+bool VideoCtl::AddMirror(WId wid)
+{
+    MirrorOutput *pMirror;
+
+    std::lock_guard<std::mutex> lock(m_mutexMirrors);
+    for (MirrorOutput *pExist : m_vecMirrors)
+    {
+        if (pExist->GetWId() == wid)
+        {
+            return true;
+        }
+    }
+
+    //由刷新线程打开和绘制
+    pMirror = new (std::nothrow) MirrorOutput(wid);
+    if (!pMirror)
+    {
+        return false;
+    }
+    m_vecMirrors.push_back(pMirror);
+
+    //暂停时也让新加入的输出立即拿到当前画面
+    if (m_CurStream)
+    {
+        m_CurStream->force_refresh = 1;
+    }
+
+    return true;
+}
+
+void VideoCtl::RemoveMirror(WId wid)
+{
+    std::lock_guard<std::mutex> lock(m_mutexMirrors);
+
+    for (auto it = m_vecMirrors.begin(); it != m_vecMirrors.end(); ++it)
+    {
+        if ((*it)->GetWId() == wid)
+        {
+            MirrorOutput *pMirror = *it;
+            m_vecMirrors.erase(it);
+            //已打开的渲染器只能在刷新线程上释放，未打开（没有播放）时直接删除
+            if (pMirror->IsOpen())
+            {
+                m_vecMirrorsClosing.push_back(pMirror);
+                if (m_CurStream)
+                    m_CurStream->force_refresh = 1;
+            }
+            else
+            {
+                delete pMirror;
+            }
+            break;
+        }
+    }
+}
+
+bool VideoCtl::StartPlay(QString strFileName, WId widPlayWid)
+{
+    //取消尚未打开的定时播放
+    m_nScheduleId++;
+    return start_play(strFileName, widPlayWid, 0);
+}
+
+bool VideoCtl::SchedulePlay(QString strFileName, WId widPlayWid, QDateTime dtStart)
+{
+    //QDateTime 与 av_gettime 都是 UNIX 时间
+    int64_t schedule_start = dtStart.toMSecsSinceEpoch() * 1000;
+    int64_t until = schedule_start - av_gettime();
+    int nScheduleId = ++m_nScheduleId;
+
+    if (until <= 0)
+    {
+        av_log(NULL, AV_LOG_WARNING, "Scheduled start time %s has passed\n", dtStart.toString("yyyy-MM-dd HH:mm:ss.zzz").toUtf8().constData());
+        return false;
+    }
+    av_log(NULL, AV_LOG_INFO, "Scheduled start of %s at %s\n", strFileName.toUtf8().constData(),
+        dtStart.toString("yyyy-MM-dd HH:mm:ss.zzz").toUtf8().constData());
+
+    if (until <= SCHEDULE_PREROLL_LEAD * 1000000)
+    {
+        return start_play(strFileName, widPlayWid, schedule_start);
+    }
+
+    //离开始时间较远时继续当前播放，提前一段时间再打开文件预加载
+    QTimer::singleShot((int)((until - SCHEDULE_PREROLL_LEAD * 1000000) / 1000), Qt::PreciseTimer, this, [=]()
+    {
+        if (nScheduleId == m_nScheduleId)
+        {
+            start_play(strFileName, widPlayWid, schedule_start);
+        }
+    });
+    return true;
+}
+
+bool VideoCtl::start_play(QString strFileName, WId widPlayWid, int64_t schedule_start)
+{
+    m_bPlayLoop = false;
+    if (m_tPlayLoopThread.joinable())
+    {
+        m_tPlayLoopThread.join();
+    }
+    emit SigStartPlay(strFileName);//正式播放，发送给标题栏
+
+    play_wid = widPlayWid;
+    m_stSdlRender.SetWindow(widPlayWid);
+    //未播放时的切换不统计
+    m_bTransitionPending = false;
+    //Qt 输出控件不可用时仍用 SDL
+    if (m_nRenderBackend == RENDER_BACKEND_QT && m_stQtRender.HasWidget())
+        m_pRender = &m_stQtRender;
+    else
+        m_pRender = &m_stSdlRender;
+
+    {
+        //新文件从原始大小开始
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        m_dZoom = 1.0;
+        m_dZoomCenterX = 0.5;
+        m_dZoomCenterY = 0.5;
+    }
+
+    VideoState *is;
+
+    char file_name[1024];
+    memset(file_name, 0, 1024);
     sprintf(file_name, "%s", /*strFileName.toLocal8Bit().data()*/strFileName.toStdString().c_str());
     //打开流
-    is = stream_open(file_name);
+    is = stream_open(file_name, schedule_start);
     if (!is) {
         av_log(NULL, AV_LOG_FATAL, "Failed to initialize VideoState!\n");
         do_exit(m_CurStream);
@@ -2099,6 +3613,534 @@ bool VideoCtl::StartPlay(QString strFileName, WId widPlayWid)
     //事件循环
     m_tPlayLoopThread = std::thread(&VideoCtl::LoopThread, this, is);
 
+    //重文件在后台生成代理，已有代理时按窗口大小决定是否切换
+    m_strSourceFile = strFileName;
+    m_bProxyActive = false;
+    m_stProxyCache.SetPlaybackActive(true);
+    m_stProxyCache.Request(strFileName, PROXY_PRIORITY_PLAYING);
+    schedule_proxy_update();
 
     return true;
 }
+
+bool VideoCtl::want_proxy(VideoState *is)
+{
+    int nViewSize;
+
+    //定时播放、跟随其他播放器、载入外部音频时重新打开会打乱同步或丢失外部音频，不切换
+    if (is->schedule_pending || is->ext_audio || ClockSync::GetInstance()->GetRole() != SYNC_ROLE_OFF)
+        return m_bProxyActive;
+
+    //放大画面、镜像输出（可能在其他屏幕全屏）时需要原文件的细节
+    {
+        std::lock_guard<std::mutex> lock(m_mutexZoom);
+        if (m_dZoom > 1.0)
+            return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutexMirrors);
+        if (!m_vecMirrors.empty())
+            return false;
+    }
+
+    if (m_bScrubbing)
+        return true;
+    if (is->paused || m_bFullScreen)
+        return false;
+    nViewSize = FFMIN(m_nViewW, m_nViewH);
+    return nViewSize > 0 && nViewSize <= PROXY_SIZE * PROXY_SMALL_VIEW_SCALE;
+}
+
+void VideoCtl::schedule_proxy_update()
+{
+    int nUpdateId = ++m_nProxyUpdateId;
+
+    QTimer::singleShot(PROXY_SWITCH_DELAY_MS, this, [=]()
+    {
+        if (nUpdateId == m_nProxyUpdateId)
+        {
+            update_proxy();
+        }
+    });
+}
+
+void VideoCtl::update_proxy()
+{
+    VideoState *is = m_CurStream;
+    bool bProxy;
+
+    if (is == nullptr || !m_bPlayLoop || m_strSourceFile.isEmpty())
+    {
+        return;
+    }
+
+    bProxy = want_proxy(is);
+    if (bProxy == m_bProxyActive)
+    {
+        return;
+    }
+    if (bProxy && m_stProxyCache.Lookup(m_strSourceFile).isEmpty())
+    {
+        return;
+    }
+    switch_source(bProxy);
+}
+
+void VideoCtl::switch_source(bool bProxy)
+{
+    VideoState *is = m_CurStream;
+    QString strFile = bProxy ? m_stProxyCache.Lookup(m_strSourceFile) : m_strSourceFile;
+    double pos;
+    int paused, volume;
+
+    if (is == nullptr || strFile.isEmpty())
+    {
+        return;
+    }
+    //代理与原文件时间戳一致，在当前位置切换
+    pos = get_master_clock(is);
+    if (isnan(pos))
+    {
+        return;
+    }
+    paused = is->paused;
+    volume = is->audio_volume;
+
+    av_log(NULL, AV_LOG_INFO, "Switching to the %s at %.3f s\n", bProxy ? "proxy" : "original file", pos);
+
+    m_bSourceSwitch = true;
+    m_bPlayLoop = false;
+    if (m_tPlayLoopThread.joinable())
+    {
+        m_tPlayLoopThread.join();
+    }
+    m_bSourceSwitch = false;
+
+    m_bProxyActive = bProxy;
+    is = stream_open(strFile.toUtf8().constData(), 0, pos, paused);
+    if (!is) {
+        av_log(NULL, AV_LOG_FATAL, "Failed to initialize VideoState!\n");
+        do_exit(m_CurStream);
+        return;
+    }
+    //音量沿用切换前的
+    is->audio_volume = volume;
+    emit SigVideoVolume(volume * 1.0 / SDL_MIX_MAXVOLUME);
+    m_CurStream = is;
+    m_stProxyCache.SetPlaybackActive(!paused);
+
+    m_tPlayLoopThread = std::thread(&VideoCtl::LoopThread, this, is);
+}
+
+void VideoCtl::SetViewState(int nWidth, int nHeight, bool bFullScreen)
+{
+    if (m_nViewW == nWidth && m_nViewH == nHeight && m_bFullScreen == bFullScreen)
+    {
+        return;
+    }
+    m_nViewW = nWidth;
+    m_nViewH = nHeight;
+    m_bFullScreen = bFullScreen;
+    schedule_proxy_update();
+}
+
+void VideoCtl::OnScrubbing(bool bScrubbing)
+{
+    m_bScrubbing = bScrubbing;
+    schedule_proxy_update();
+}
+
+void VideoCtl::OnProxyReady(QString strFile)
+{
+    if (strFile == m_strSourceFile)
+    {
+        av_log(NULL, AV_LOG_INFO, "Proxy ready for %s\n", strFile.toUtf8().constData());
+        schedule_proxy_update();
+    }
+}
+
+int VideoCtl::RunSeekStress(const QStringList &listFiles, int nSeeks, unsigned int nSeed)
+{
+    //画面输出到隐藏的 SDL 窗口（与 --soak 相同），不输出声音，SDL 初始化之前设置
+    audio_disable = 1;
+
+    VideoCtl *pVideoCtl = GetInstance();
+    if (pVideoCtl == nullptr)
+    {
+        return -1;
+    }
+
+    SeekStress stress;
+    std::mt19937 rng(nSeed);
+    int nRet = 0;
+
+    fprintf(stdout, "seek stress: %d file(s), %d seeks each, seed %u\n", (int)listFiles.size(), nSeeks, nSeed);
+    pVideoCtl->m_pSeekStress = &stress;
+    for (const QString &strFile : listFiles)
+    {
+        if (!pVideoCtl->seek_stress_file(strFile, nSeeks, rng, stress))
+        {
+            fprintf(stdout, "%s: could not be played\n", strFile.toUtf8().constData());
+            nRet = 1;
+        }
+    }
+    pVideoCtl->m_pSeekStress = nullptr;
+
+    stress.Report(stdout);
+    if (stress.HasErrors())
+    {
+        nRet = 1;
+    }
+    return nRet;
+}
+
+bool VideoCtl::seek_stress_file(const QString &strFile, int nSeeks, std::mt19937 &rng, SeekStress &stress)
+{
+    VideoState *is;
+    int64_t start_time, duration, file_size;
+    int64_t t;
+    bool bRet = false;
+
+    is = headless_open(strFile);
+    if (!is)
+    {
+        return false;
+    }
+
+    start_time = is->ic->start_time != AV_NOPTS_VALUE ? is->ic->start_time : 0;
+    duration = is->ic->duration;
+    file_size = is->ic->pb ? avio_size(is->ic->pb) : -1;
+    if (duration <= 0)
+        goto the_end;
+
+    stress.BeginFile(is->ic->iformat->name);
+    for (int i = 0; i < nSeeks && m_bPlayLoop; i++)
+    {
+        std::vector<SeekStressType> vecTypes = { SEEK_STRESS_ABSOLUTE };
+        double pos = get_master_clock(is);
+        double end = (start_time + duration) / (double)AV_TIME_BASE;
+        double target = NAN;
+        int serial = is->videoq.serial;
+
+        //只挑当前位置和文件能做的跳转方式
+        if (!std::isnan(pos) && pos + 5.0 < end - 1.0)
+            vecTypes.push_back(SEEK_STRESS_FORWARD);
+        if (!std::isnan(pos) && pos - 5.0 > start_time / (double)AV_TIME_BASE)
+            vecTypes.push_back(SEEK_STRESS_BACKWARD);
+        if (is->ic->nb_chapters > 0)
+            vecTypes.push_back(SEEK_STRESS_CHAPTER);
+        if (file_size > 0 && !(is->ic->iformat->flags & AVFMT_NO_BYTE_SEEK))
+            vecTypes.push_back(SEEK_STRESS_BYTE);
+
+        SeekStressType eType = vecTypes[std::uniform_int_distribution<size_t>(0, vecTypes.size() - 1)(rng)];
+        switch (eType)
+        {
+        case SEEK_STRESS_ABSOLUTE:
+        {
+            //避开结尾，保证落点之后还有帧
+            int64_t ts = start_time + (int64_t)(std::uniform_real_distribution<double>(0.0, 0.98)(rng) * duration);
+            target = ts / (double)AV_TIME_BASE;
+            stress.BeginSeek(eType, target, serial);
+            stream_seek(is, ts, 0);
+            break;
+        }
+        case SEEK_STRESS_FORWARD:
+        case SEEK_STRESS_BACKWARD:
+        {
+            //与 OnSeekForward、OnSeekBack 相同
+            double incr = eType == SEEK_STRESS_FORWARD ? 5.0 : -5.0;
+            target = relative_seek_target(is, incr);
+            stress.BeginSeek(eType, target, serial);
+            stream_seek(is, (int64_t)(target * AV_TIME_BASE), (int64_t)(incr * AV_TIME_BASE));
+            break;
+        }
+        case SEEK_STRESS_CHAPTER:
+        {
+            AVChapter *ch = is->ic->chapters[std::uniform_int_distribution<int>(0, is->ic->nb_chapters - 1)(rng)];
+            int64_t ts = av_rescale_q(ch->start, ch->time_base, /*AV_TIME_BASE_Q*/{ 1, AV_TIME_BASE });
+            target = ts / (double)AV_TIME_BASE;
+            stress.BeginSeek(eType, target, serial);
+            stream_seek(is, ts, 0);
+            break;
+        }
+        case SEEK_STRESS_BYTE:
+        {
+            //字节位置没有对应的目标时间，只统计延迟
+            int64_t byte_pos = (int64_t)(std::uniform_real_distribution<double>(0.0, 0.98)(rng) * file_size);
+            stress.BeginSeek(eType, NAN, serial);
+            stream_seek(is, byte_pos, 0, 1);
+            break;
+        }
+        default:
+            break;
+        }
+
+        //读取线程处理完 seek 但队列序号没变，说明 seek 出错，不必等到超时
+        t = av_gettime_relative();
+        while (!stress.WaitLanded(5))
+        {
+            if (!is->seek_req && is->videoq.serial == serial)
+                break;
+            if (av_gettime_relative() - t > SEEK_STRESS_TIMEOUT_MS * 1000LL || !m_bPlayLoop)
+                break;
+        }
+        stress.EndSeek();
+    }
+    bRet = true;
+
+the_end:
+    headless_close();
+    return bRet;
+}
+
+VideoState *VideoCtl::headless_open(const QString &strFile)
+{
+    VideoState *is;
+    int64_t t;
+
+    headless_close();
+
+    is = stream_open(strFile.toUtf8().constData());
+    if (!is)
+    {
+        return nullptr;
+    }
+    m_CurStream = is;
+    m_bPlayLoop = true;
+    m_tPlayLoopThread = std::thread(&VideoCtl::LoopThread, this, is);
+
+    //等第一帧显示出来，读取线程已完成打开
+    t = av_gettime_relative();
+    while (!is->first_frame_shown && m_bPlayLoop && av_gettime_relative() - t < SEEK_STRESS_TIMEOUT_MS * 1000LL)
+        av_usleep(10000);
+    if (!is->first_frame_shown || !is->video_st)
+    {
+        headless_close();
+        return nullptr;
+    }
+    return is;
+}
+
+void VideoCtl::headless_close()
+{
+    //刷新循环退出时关闭流
+    m_bPlayLoop = false;
+    if (m_tPlayLoopThread.joinable())
+    {
+        m_tPlayLoopThread.join();
+    }
+}
+
+int VideoCtl::RunSoak(const QStringList &listFiles, double dHours, int nIntervalSec, unsigned int nSeed)
+{
+    //画面输出到隐藏的 SDL 窗口，上传、绘制、字幕和 OSD 与正常播放相同；
+    //没有显示器时用 SDL_VIDEODRIVER=offscreen。声音照常输出（可用 SDL_AUDIODRIVER=dummy 静音运行）
+
+    VideoCtl *pVideoCtl = GetInstance();
+    if (pVideoCtl == nullptr)
+    {
+        return -1;
+    }
+
+    SoakTest soak;
+    std::mt19937 rng(nSeed);
+    int64_t nStartTime = av_gettime_relative();
+    int64_t nEndTime = nStartTime + (int64_t)(dHours * 3600 * 1000000);
+    int64_t nIntervalUs = nIntervalSec * 1000000LL;
+    int64_t nNextSample = nStartTime + nIntervalUs;
+    int nFailedInRow = 0;
+
+    fprintf(stdout, "soak: %d file(s), %.2f hours, sample every %d s, seed %u\n",
+        (int)listFiles.size(), dHours, nIntervalSec, nSeed);
+    for (int i = 0; av_gettime_relative() < nEndTime; i++)
+    {
+        const QString &strFile = listFiles[i % listFiles.size()];
+        VideoState *is = pVideoCtl->headless_open(strFile);
+        if (!is)
+        {
+            fprintf(stdout, "%s: could not be played\n", strFile.toUtf8().constData());
+            //整个列表都放不了
+            if (++nFailedInRow >= listFiles.size())
+            {
+                return 1;
+            }
+            continue;
+        }
+        nFailedInRow = 0;
+
+        //每个文件播放 30s~3min，模拟播放列表切换
+        int64_t nPlayUs = std::uniform_int_distribution<int64_t>(30, 180)(rng) * 1000000;
+        nPlayUs = FFMIN(nPlayUs, nEndTime - av_gettime_relative());
+        pVideoCtl->soak_play_file(is, nPlayUs, rng, soak, nStartTime, nNextSample, nIntervalUs);
+        pVideoCtl->headless_close();
+        soak.AddCycle();
+    }
+
+    return soak.Analyze(stdout) ? 0 : 1;
+}
+
+int VideoCtl::RunSyncPlay(const QString &strFile, double dSeconds)
+{
+    //不显示画面，只比较时钟
+    display_disable = 1;
+
+    VideoCtl *pVideoCtl = GetInstance();
+    if (pVideoCtl == nullptr)
+    {
+        return -1;
+    }
+
+    VideoState *is = pVideoCtl->headless_open(strFile);
+    if (!is)
+    {
+        fprintf(stdout, "%s: could not be played\n", strFile.toUtf8().constData());
+        return 1;
+    }
+
+    int64_t nEndTime = av_gettime_relative() + (int64_t)(dSeconds * 1000000);
+    while (av_gettime_relative() < nEndTime && pVideoCtl->m_bPlayLoop)
+    {
+        av_usleep(100000);
+        if (is->eof && frame_queue_nb_remaining(&is->pictq) == 0)
+        {
+            break;
+        }
+    }
+    pVideoCtl->headless_close();
+
+    return ClockSync::GetInstance()->Summary(stdout) ? 0 : 1;
+}
+
+int VideoCtl::RunDecoderPoolBench(const QStringList &listFiles, int nRounds)
+{
+    //画面输出到隐藏的 SDL 窗口（与 --soak 相同），不输出声音，SDL 初始化之前设置
+    audio_disable = 1;
+
+    VideoCtl *pVideoCtl = GetInstance();
+    if (pVideoCtl == nullptr)
+    {
+        return -1;
+    }
+
+    int nRet = 0;
+
+    fprintf(stdout, "decoder pool bench: %d file(s), %d round(s), first round is warm-up\n",
+        (int)listFiles.size(), nRounds);
+    fprintf(stdout, "%-6s %6s %9s %9s %9s %9s  (time to first frame, ms)\n", "pool", "opens", "mean", "p50", "p95", "max");
+    for (int nPool = 0; nPool <= 1; nPool++)
+    {
+        std::vector<double> vecMs;
+
+        //关闭时清空池，两种情况互不影响
+        pVideoCtl->m_stDecoderPool.SetEnabled(false);
+        pVideoCtl->m_stDecoderPool.SetEnabled(nPool != 0);
+        for (int nRound = 0; nRound < nRounds; nRound++)
+        {
+            for (const QString &strFile : listFiles)
+            {
+                pVideoCtl->m_nFirstFrameUs = -1;
+                VideoState *is = pVideoCtl->headless_open(strFile);
+                if (!is)
+                {
+                    fprintf(stdout, "%s: could not be played\n", strFile.toUtf8().constData());
+                    nRet = 1;
+                    continue;
+                }
+                int64_t nFirstFrameUs = pVideoCtl->m_nFirstFrameUs;
+                pVideoCtl->headless_close();
+                //第一轮池还是空的，打开方式与关闭复用相同
+                if (nRound > 0 && nFirstFrameUs >= 0)
+                    vecMs.push_back(nFirstFrameUs / 1000.0);
+            }
+        }
+
+        if (vecMs.empty())
+        {
+            fprintf(stdout, "%-6s %6d\n", nPool ? "on" : "off", 0);
+            continue;
+        }
+        std::sort(vecMs.begin(), vecMs.end());
+        double dSum = 0;
+        for (double d : vecMs)
+            dSum += d;
+        fprintf(stdout, "%-6s %6d %9.1f %9.1f %9.1f %9.1f\n", nPool ? "on" : "off", (int)vecMs.size(),
+            dSum / vecMs.size(), vecMs[vecMs.size() / 2], vecMs[(vecMs.size() - 1) * 95 / 100], vecMs.back());
+    }
+
+    //恢复配置中的设置
+    bool bDecoderPool = decoder_pool;
+    GlobalHelper::GetDecoderPool(bDecoderPool);
+    pVideoCtl->m_stDecoderPool.SetEnabled(false);
+    pVideoCtl->m_stDecoderPool.SetEnabled(bDecoderPool);
+    return nRet;
+}
+
+void VideoCtl::soak_play_file(VideoState *is, int64_t nPlayUs, std::mt19937 &rng, SoakTest &soak,
+    int64_t nStartTime, int64_t &nNextSample, int64_t nIntervalUs)
+{
+    double frame_rate = av_q2d(av_guess_frame_rate(is->ic, is->video_st, NULL));
+    int64_t now = av_gettime_relative();
+    int64_t end = now + nPlayUs;
+    int64_t next_action = now + std::uniform_int_distribution<int64_t>(5, 15)(rng) * 1000000;
+    int64_t last = now;
+    int64_t decoded = is->frames_decoded;
+    int64_t dropped = is->frame_drops_early + is->frame_drops_late;
+
+    while (now < end && m_bPlayLoop)
+    {
+        av_usleep(100000);
+        now = av_gettime_relative();
+
+        //播放统计，seek 后的追赶也算在内
+        soak.AddPlayback(is->frames_decoded - decoded,
+            is->paused || std::isnan(frame_rate) ? 0 : (now - last) / 1000000.0 * frame_rate,
+            is->frame_drops_early + is->frame_drops_late - dropped);
+        decoded = is->frames_decoded;
+        dropped = is->frame_drops_early + is->frame_drops_late;
+        last = now;
+        if (is->audio_st)
+            soak.AddDrift(get_clock(&is->vidclk) - get_clock(&is->audclk));
+
+        //播放结束
+        if (is->eof && frame_queue_nb_remaining(&is->pictq) == 0)
+            break;
+
+        if (now >= next_action)
+        {
+            SDL_Event event;
+            switch (std::uniform_int_distribution<int>(0, 3)(rng))
+            {
+            case 0:
+            {
+                double incr = std::uniform_int_distribution<int>(0, 1)(rng) ? 5.0 : -5.0;
+                double pos = relative_seek_target(is, incr);
+                stream_seek(is, (int64_t)(pos * AV_TIME_BASE), (int64_t)(incr * AV_TIME_BASE));
+                break;
+            }
+            case 1:
+                if (is->ic->duration > 0)
+                {
+                    int64_t ts = (int64_t)(std::uniform_real_distribution<double>(0.0, 0.9)(rng) * is->ic->duration);
+                    if (is->ic->start_time != AV_NOPTS_VALUE)
+                        ts += is->ic->start_time;
+                    stream_seek(is, ts, 0);
+                }
+                break;
+            default:
+                //切换音轨、字幕交给刷新循环线程处理，与按键相同
+                memset(&event, 0, sizeof(event));
+                event.type = SDL_KEYDOWN;
+                event.key.keysym.sym = std::uniform_int_distribution<int>(0, 1)(rng) ? SDLK_a : SDLK_t;
+                SDL_PushEvent(&event);
+                break;
+            }
+            next_action = now + std::uniform_int_distribution<int64_t>(5, 15)(rng) * 1000000;
+        }
+
+        if (now >= nNextSample)
+        {
+            soak.TakeSample((now - nStartTime) / 60000000.0, stdout);
+            nNextSample += nIntervalUs;
+        }
+    }
+}
@@ -14,9 +14,30 @@
 #include <QObject>
 #include <QThread>
 #include <QString>
+#include <QStringList>
+#include <QImage>
+#include <QDateTime>
+
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <random>
 
 #include "globalhelper.h"
 #include "datactl.h"
+#include "decoderpool.h"
+#include "mirrorout.h"
+#include "colorlut.h"
+#include "audiomixer.h"
+#include "resampler.h"
+#include "seekstress.h"
+#include "soaktest.h"
+#include "sdlrender.h"
+#include "qtrender.h"
+#include "framepool.h"
+#include "clocksync.h"
+#include "proxycache.h"
+#include "ioscheduler.h"
 
 // 视频控制类，负责视频的播放、暂停、停止、音量控制等基本操作
 // 采用单例模式，确保全局只有一个实例
@@ -39,21 +60,135 @@ public:
     bool StartPlay(QString strFileName, WId widPlayWid);
 
     /**
-     * @brief 音频解码函数，用于解码音频帧
+     * @brief 定时播放，第一帧在预定时间显示。提前打开文件，解码出第一帧、缓冲好声音后保持不动，
+     *        到预定时间再按系统时间启动时钟，日志输出与预定时间的偏差
      *
-     * @param is 视频状态结构体
-     * @return 解码后的音频样本数量
+     * @param strFileName 文件完整路径
+     * @param widPlayWid 播放窗口ID
+     * @param dtStart 开始时间
+     * @return true 成功，false 开始时间已过
      */
-    int audio_decode_frame(VideoState *is);
+    bool SchedulePlay(QString strFileName, WId widPlayWid, QDateTime dtStart);
 
     /**
-     * @brief 更新样本显示，用于音频波形显示
+     * @brief 无界面 seek 压力测试：依次打开文件，发起随机 seek，输出延迟和落点统计
+     *
+     * @param listFiles 文件列表
+     * @param nSeeks 每个文件的 seek 次数
+     * @param nSeed 随机数种子
+     * @return 进程返回值，0 表示没有失败的 seek 且没有显示旧序号的帧
+     */
+    static int RunSeekStress(const QStringList &listFiles, int nSeeks, unsigned int nSeed);
+
+    /**
+     * @brief 无界面长时间运行测试：循环播放列表，反复打开、seek、切换音轨字幕、关闭，
+     *        定期采样资源占用和播放指标，有持续增长的趋势则失败
+     *
+     * @param listFiles 播放列表
+     * @param dHours 运行时长（小时）
+     * @param nIntervalSec 采样周期（秒）
+     * @param nSeed 随机数种子
+     * @return 进程返回值，0 表示通过
+     */
+    static int RunSoak(const QStringList &listFiles, double dHours, int nIntervalSec, unsigned int nSeed);
+
+    /**
+     * @brief 无界面同步播放：按 ClockSync 已设置的角色发布或跟随时钟，结束时输出偏差统计
+     *
+     * @param strFile 文件
+     * @param dSeconds 运行时长（秒）
+     * @return 进程返回值，0 表示通过
+     */
+    static int RunSyncPlay(const QString &strFile, double dSeconds);
+
+    /**
+     * @brief 解码器复用基准测试：关闭和打开解码器复用各把文件列表循环打开若干轮，
+     *        输出两种情况下的首帧耗时分布
+     *
+     * @param listFiles 文件列表
+     * @param nRounds 轮数，第一轮只用于预热，不计入统计
+     * @return 进程返回值，0 表示所有文件都能打开
+     */
+    static int RunDecoderPoolBench(const QStringList &listFiles, int nRounds);
+
+    /**
+     * @brief 载入外部音频文件，代替当前文件的音轨，与画面同步播放。
+     *        在单独的线程上打开和探测，完成后由读取线程换入，不阻塞界面线程
+     *
+     * @param strFileName 音频文件完整路径
+     * @return true 已开始打开，false 失败
+     */
+    bool LoadAudio(QString strFileName);
+
+    /**
+     * @brief 设置重采样预设，正在播放时从下一帧开始生效
+     *
+     * @param nPreset ResamplePreset
+     */
+    void SetResamplePreset(int nPreset);
+    int GetResamplePreset();
+
+    /**
+     * @brief 设置画面输出方式，下一个文件开始生效
+     *
+     * @param nBackend RenderBackendType
+     */
+    void SetRenderBackend(int nBackend);
+    int GetRenderBackend();
+
+    /**
+     * @brief 设置 Qt 输出使用的控件，界面线程调用，控件销毁前设为空
+     *
+     * @param pWidget 输出控件
+     */
+    void SetQtRenderWidget(QtRenderWidget *pWidget);
+
+    /**
+     * @brief 标记输出区域开始切换（全屏、退出全屏），界面线程在改变窗口之前调用，
+     *        刷新线程统计到新大小的画面稳定显示为止的耗时和未显示的帧数
+     *
+     * @param szName 切换名称（静态字符串），用于日志
+     */
+    void MarkOutputTransition(const char *szName);
+
+    /**
+     * @brief 设置叠加在画面底部的图像（全屏控制条），界面线程调用，内容变化时才需要调用
+     *
+     * @param image 非预乘 ARGB32 图像，宽为输出宽度，空图像移除叠加层
+     */
+    void SetOverlay(const QImage &image);
+
+    /**
+     * @brief 画面显示区域变化，界面线程调用。重文件有代理时，小窗口播放改用代理，全屏、暂停时用原文件
+     *
+     * @param nWidth 画面显示宽度（像素）
+     * @param nHeight 画面显示高度（像素）
+     * @param bFullScreen 是否全屏
+     */
+    void SetViewState(int nWidth, int nHeight, bool bFullScreen);
+
+    /**
+     * @brief 增加镜像输出窗口，主窗口显示的画面同步显示到该窗口，不重复解码
+     *
+     * @param wid 输出窗口ID
+     * @return true 成功，false 失败
+     */
+    bool AddMirror(WId wid);
+
+    /**
+     * @brief 移除镜像输出窗口，返回后不再使用该窗口
+     *
+     * @param wid 输出窗口ID
+     */
+    void RemoveMirror(WId wid);
+
+    /**
+     * @brief 音频解码函数，用于解码音频帧
      *
      * @param is 视频状态结构体
-     * @param samples 音频样本数据
-     * @param samples_size 样本数据大小
+     * @return 解码后的音频样本数量
      */
-    void update_sample_display(VideoState *is, short *samples, int samples_size);
+    int audio_decode_frame(VideoState *is);
 
     /**
      * @brief 设置时钟，用于同步音频和视频
@@ -73,6 +208,120 @@ public:
      */
     void sync_clock_to_slave(Clock *c, Clock *slave);
 
+    /**
+     * @brief 重新分配纹理
+     *
+     * @param renderer 纹理所属的渲染器
+     * @param texture 纹理
+     * @param new_format 新格式
+     * @param new_width 新宽度
+     * @param new_height 新高度
+     * @param blendmode 混合模式
+     * @param init_texture 是否初始化纹理
+     * @return 0 表示成功，负值表示错误
+     */
+    static int realloc_texture(SDL_Renderer *renderer, SDL_Texture **texture, Uint32 new_format, int new_width, int new_height, SDL_BlendMode blendmode, int init_texture);
+
+    /**
+     * @brief 计算显示矩形
+     *
+     * @param rect 矩形
+     * @param scr_xleft 屏幕左上角X坐标
+     * @param scr_ytop 屏幕左上角Y坐标
+     * @param scr_width 屏幕宽度
+     * @param scr_height 屏幕高度
+     * @param pic_width 图片宽度
+     * @param pic_height 图片高度
+     * @param pic_sar 图片宽高比
+     * @param rotation 顺时针旋转角度，90/270 度时按旋转后的宽高比计算，返回的是旋转前的矩形（与 SDL_RenderCopyEx 配合使用）
+     */
+    static void calculate_display_rect(SDL_Rect *rect, int scr_xleft, int scr_ytop, int scr_width, int scr_height, int pic_width, int pic_height, AVRational pic_sar, double rotation = 0);
+
+    /**
+     * @brief 旋转后画面在屏幕上占据的矩形
+     *
+     * @param rect calculate_display_rect 得到的矩形
+     * @param rotation 顺时针旋转角度
+     * @return 屏幕上的矩形
+     */
+    static SDL_Rect rotated_display_rect(const SDL_Rect &rect, double rotation);
+
+    /**
+     * @brief 上传纹理
+     *
+     * @param tex 纹理
+     * @param frame 视频帧
+     * @param img_convert_ctx 图像转换上下文
+     * @param roi 只上传该区域（x、y 为偶数），为空表示整帧；倒序存放（linesize 为负）时仍上传整帧
+     * @return 0 表示成功，负值表示错误
+     */
+    static int upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext **img_convert_ctx, const SDL_Rect *roi = nullptr);
+
+    /**
+     * @brief 按渲染器的最大纹理尺寸缩小宽高（保持比例）
+     *
+     * @param info 渲染器信息，最大宽高为 0 表示不限制
+     * @param width 宽
+     * @param height 高
+     * @param tex_width 纹理宽
+     * @param tex_height 纹理高
+     */
+    static void fit_texture_size(const SDL_RendererInfo *info, int width, int height, int *tex_width, int *tex_height);
+
+    /**
+     * @brief 重新分配视频纹理，帧超出渲染器最大纹理尺寸时拆成多块
+     *
+     * @param renderer 纹理所属的渲染器
+     * @param info 渲染器信息，最大宽高为 0 表示不限制
+     * @param tiles 视频纹理
+     * @param format 纹理格式
+     * @param width 帧宽度
+     * @param height 帧高度
+     * @return 0 表示成功，负值表示错误
+     */
+    static int realloc_tiles(SDL_Renderer *renderer, const SDL_RendererInfo *info, VideoTiles *tiles, Uint32 format, int width, int height);
+
+    /**
+     * @brief 上传视频纹理，只上传与 roi 相交的块
+     *
+     * @param tiles 视频纹理
+     * @param frame 视频帧
+     * @param roi 只上传该区域（x、y 为偶数），为空表示整帧
+     * @return 0 表示成功，负值表示错误
+     */
+    static int upload_tiles(VideoTiles *tiles, AVFrame *frame, const SDL_Rect *roi = nullptr);
+
+    /**
+     * @brief 绘制视频纹理，各块绕整个画面的中心旋转
+     *
+     * @param renderer 渲染器
+     * @param tiles 视频纹理
+     * @param src 帧内要显示的区域，为空表示整帧
+     * @param dst calculate_display_rect 得到的矩形
+     * @param rotation 顺时针旋转角度
+     * @param flip 镜像
+     */
+    static void render_tiles(SDL_Renderer *renderer, VideoTiles *tiles, const SDL_Rect *src, const SDL_Rect *dst, double rotation, SDL_RendererFlip flip);
+
+    /**
+     * @brief 释放视频纹理
+     *
+     * @param tiles 视频纹理
+     */
+    static void free_tiles(VideoTiles *tiles);
+
+    /**
+     * @brief 把字幕的各区域转换为 BGRA 写入输出的字幕画布
+     *
+     * @param render 输出
+     * @param info 最大纹理尺寸
+     * @param sp 字幕，宽高为 0 时取视频帧的宽高
+     * @param vp 视频帧
+     * @param convert_ctx 转换上下文，按需重建
+     * @return 0 表示成功，负值表示错误
+     */
+    static int upload_subtitle(RenderBackend *render, const SDL_RendererInfo *info, Frame *sp, Frame *vp, struct SwsContext **convert_ctx);
+
 signals:
     // 发送错误信息
     void SigPlayMsg(QString strMsg);
@@ -126,6 +375,28 @@ public slots:
     // 停止播放
     void OnStop();
 
+    // 以画面上的点为中心缩放，nSteps 为正放大、为负缩小，dX dY 为该点在画面中的相对位置(0~1)
+    void OnZoom(int nSteps, double dX, double dY);
+
+    // 平移缩放区域，dDx dDy 为拖动距离相对画面宽高的比例
+    void OnPan(double dDx, double dDy);
+
+    // 恢复原始大小
+    void OnZoomReset();
+
+    // 开启、关闭混音：把文件中主音轨以外的音轨一起解码混入输出
+    void OnToggleAudioMix();
+
+    // 设置混入音轨的增益（线性，1 为原始音量）和声像（-1 左 ~ 1 右）
+    void OnSetAudioTrackMix(int nStreamIndex, double dGain, double dPan);
+
+    // 开始、结束拖动进度条，拖动时有代理则改用代理
+    void OnScrubbing(bool bScrubbing);
+
+private slots:
+    // 后台生成的代理可用
+    void OnProxyReady(QString strFile);
+
 private:
     // 构造函数，私有化防止外部直接构造
     explicit VideoCtl(QObject *parent = nullptr);
@@ -169,6 +440,14 @@ private:
      */
     int video_thread(void *arg);
 
+    /**
+     * @brief 颜色管理：在解码线程上把帧转换为 BGRA，刷新线程只上传
+     *
+     * @param frame 视频帧，成功时替换为转换后的 BGRA 帧
+     * @return 0 表示成功，负值表示错误
+     */
+    int color_manage_frame(AVFrame *frame);
+
     /**
      * @brief 字幕解码线程
      *
@@ -202,9 +481,10 @@ private:
      *
      * @param is 视频状态结构体
      * @param stream_index 流索引
+     * @param ic 流所在的文件，为空表示 is->ic（外部音频时为外部文件）
      * @return 0 表示成功，负值表示错误
      */
-    int stream_component_open(VideoState *is, int stream_index);
+    int stream_component_open(VideoState *is, int stream_index, AVFormatContext *ic = nullptr);
 
     /**
      * @brief 检查流是否有足够的数据包
@@ -216,6 +496,14 @@ private:
      */
     int stream_has_enough_packets(AVStream *st, int stream_id, PacketQueue *queue);
 
+    /**
+     * @brief 音视频数据包队列中较短的缓冲时长，用于后台读取调度
+     *
+     * @param is 视频状态
+     * @return 秒，没有音视频流或只有封面时为 INFINITY
+     */
+    double buffered_seconds(VideoState *is);
+
     /**
      * @brief 检查是否是实时流
      *
@@ -242,9 +530,12 @@ private:
      * @brief 打开流
      *
      * @param filename 文件名
+     * @param schedule_start 定时播放的开始时间，0 表示立即开始
+     * @param start_pos 从该位置开始播放（秒），NAN 表示从头开始
+     * @param start_paused 打开后保持暂停，显示 start_pos 处的一帧
      * @return 视频状态结构体
      */
-    VideoState *stream_open(const char *filename);
+    VideoState *stream_open(const char *filename, int64_t schedule_start = 0, double start_pos = NAN, int start_paused = 0);
 
     /**
      * @brief 切换流通道
@@ -254,6 +545,53 @@ private:
      */
     void stream_cycle_channel(VideoState *is, int codec_type);
 
+    /**
+     * @brief 按混音开关打开或关闭主音轨以外的音轨
+     *
+     * @param is 视频状态结构体
+     */
+    void update_audio_mix(VideoState *is);
+
+    /**
+     * @brief 换用外部音频作为主音轨，在读取线程中调用
+     *
+     * @param is 视频状态结构体
+     * @param ea 已打开的外部音频
+     */
+    void ext_audio_attach(VideoState *is, ExtAudio *ea);
+
+    /**
+     * @brief 停止外部音频的读取线程，关闭其音轨
+     *
+     * @param is 视频状态结构体
+     */
+    void ext_audio_close(VideoState *is);
+
+    /**
+     * @brief 外部音频与主文件同时 seek：通知、等待完成、清空队列后继续读取
+     */
+    void ext_audio_seek_start(VideoState *is, int64_t seek_min, int64_t seek_target, int64_t seek_max, int seek_flags);
+    int ext_audio_seek_wait(VideoState *is);
+    void ext_audio_seek_end(VideoState *is);
+
+    /**
+     * @brief 外部音频读取线程，数据包放入主音轨的队列
+     *
+     * @param is 视频状态结构体
+     */
+    void ExtAudioReadThread(VideoState *is);
+
+    /**
+     * @brief 打开外部音频文件的线程，成功后交给读取线程换入
+     *
+     * @param ea 外部音频
+     * @param strFileName 音频文件完整路径
+     */
+    void ExtAudioOpenThread(ExtAudio *ea, QString strFileName);
+
+    //中止正在打开的外部音频并等待打开线程退出
+    void ext_audio_open_cancel();
+
     /**
      * @brief 刷新循环等待事件
      *
@@ -306,6 +644,54 @@ private:
      */
     void video_display(VideoState *is);
 
+    /**
+     * @brief 输出区域切换后画面稳定时输出统计
+     */
+    void check_output_transition();
+
+    /**
+     * @brief 定时播放在开始时间之前的等待，预加载完成后临近开始时间时忙等，到时间设置时钟
+     *
+     * @param is 视频状态结构体
+     * @param remaining_time 下次刷新的等待时间
+     * @return 1 仍在等待，0 已开始
+     */
+    int scheduled_start_wait(VideoState *is, double *remaining_time);
+
+    /**
+     * @brief 打开文件开始播放
+     *
+     * @param schedule_start 定时播放的开始时间（av_gettime，微秒），0 表示立即开始
+     */
+    bool start_play(QString strFileName, WId widPlayWid, int64_t schedule_start);
+
+    /**
+     * @brief 按当前状态判断是否应播放代理：拖动进度条时，或小窗口正常播放时
+     */
+    bool want_proxy(VideoState *is);
+
+    /**
+     * @brief 延迟一段时间后判断是否切换代理，连续的状态变化只切换一次
+     */
+    void schedule_proxy_update();
+
+    /**
+     * @brief 需要时在原文件与代理之间切换
+     */
+    void update_proxy();
+
+    /**
+     * @brief 在当前位置重新打开原文件或代理，保持暂停状态和缩放，界面不视为停止
+     *
+     * @param bProxy true 打开代理，false 打开原文件
+     */
+    void switch_source(bool bProxy);
+
+    /**
+     * @brief 在画面上叠加界面设置的图像，图像变化时才重新上传纹理
+     */
+    void overlay_display(VideoState *is);
+
     /**
      * @brief 打开视频窗口
      *
@@ -376,6 +762,10 @@ private:
      * @param is 视频状态结构体
      */
     void check_external_clock_speed(VideoState *is);
+    /**
+     * @brief 多个播放器同步：主机发布时钟；从机让外部时钟跟随主机，统计偏差
+     */
+    void update_sync_clock(VideoState *is);
 
     /**
      * @brief 流跳转
@@ -383,8 +773,56 @@ private:
      * @param is 视频状态结构体
      * @param pos 位置
      * @param rel 相对位置
+     * @param seek_by_bytes pos、rel 是否为字节位置
+     */
+    void stream_seek(VideoState *is, int64_t pos, int64_t rel, int seek_by_bytes = 0);
+
+    /**
+     * @brief 从当前位置前后跳转的目标时间
+     *
+     * @param is 视频状态结构体
+     * @param incr 跳转秒数，负值向后
+     * @return 目标时间（秒）
+     */
+    double relative_seek_target(VideoState *is, double incr);
+
+    /**
+     * @brief 无界面打开文件并启动刷新循环，等到第一帧显示
+     *
+     * @param strFile 文件
+     * @return 视频状态，没有视频或超时返回 nullptr（已关闭）
+     */
+    VideoState *headless_open(const QString &strFile);
+
+    /**
+     * @brief 停止刷新循环并关闭当前文件
+     */
+    void headless_close();
+
+    /**
+     * @brief 长时间运行测试中播放一个文件
+     *
+     * @param is 视频状态结构体
+     * @param nPlayUs 播放时长（微秒）
+     * @param rng 随机数发生器
+     * @param soak 统计
+     * @param nStartTime 测试开始时间
+     * @param nNextSample 下次采样时间，采样后后移
+     * @param nIntervalUs 采样周期（微秒）
+     */
+    void soak_play_file(VideoState *is, int64_t nPlayUs, std::mt19937 &rng, SoakTest &soak,
+        int64_t nStartTime, int64_t &nNextSample, int64_t nIntervalUs);
+
+    /**
+     * @brief seek 压力测试主循环，在调用线程上运行
+     *
+     * @param strFile 文件
+     * @param nSeeks seek 次数
+     * @param rng 随机数发生器
+     * @param stress 统计
+     * @return true 成功 false 文件无法播放
      */
-    void stream_seek(VideoState *is, int64_t pos, int64_t rel);
+    bool seek_stress_file(const QString &strFile, int nSeeks, std::mt19937 &rng, SeekStress &stress);
 
     /**
      * @brief 切换暂停状态
@@ -437,56 +875,44 @@ private:
     void update_video_pts(VideoState *is, double pts, int64_t pos, int serial);
 
     /**
-     * @brief 重新分配纹理
+     * @brief 缩放区域对应的帧内矩形（纹理坐标）
      *
-     * @param texture 纹理
-     * @param new_format 新格式
-     * @param new_width 新宽度
-     * @param new_height 新高度
-     * @param blendmode 混合模式
-     * @param init_texture 是否初始化纹理
-     * @return 0 表示成功，负值表示错误
+     * @param vp 当前视频帧
+     * @param roi 帧内矩形，x、y、宽、高均为偶数
+     * @return true 已缩放，false 未缩放
      */
-    int realloc_texture(SDL_Texture **texture, Uint32 new_format, int new_width, int new_height, SDL_BlendMode blendmode, int init_texture);
+    bool zoom_source_rect(Frame *vp, SDL_Rect *roi);
 
     /**
-     * @brief 计算显示矩形
+     * @brief 显示视频画面
      *
-     * @param rect 矩形
-     * @param scr_xleft 屏幕左上角X坐标
-     * @param scr_ytop 屏幕左上角Y坐标
-     * @param scr_width 屏幕宽度
-     * @param scr_height 屏幕高度
-     * @param pic_width 图片宽度
-     * @param pic_height 图片高度
-     * @param pic_sar 图片宽高比
+     * @param is 视频状态结构体
      */
-    void calculate_display_rect(SDL_Rect *rect, int scr_xleft, int scr_ytop, int scr_width, int scr_height, int pic_width, int pic_height, AVRational pic_sar);
+    void video_image_display(VideoState *is);
 
     /**
-     * @brief 上传纹理
+     * @brief 在刷新线程上显示镜像输出，先释放已移除的输出，未打开的输出在这里打开
      *
-     * @param tex 纹理
-     * @param frame 视频帧
-     * @param img_convert_ctx 图像转换上下文
-     * @return 0 表示成功，负值表示错误
+     * @param vp 主画面当前帧（已上传）
+     * @param sp 正在显示的字幕，没有时为空
+     * @param bNewFrame 是否为新帧
      */
-    int upload_texture(SDL_Texture *tex, AVFrame *frame, struct SwsContext **img_convert_ctx);
+    void mirror_display(Frame *vp, Frame *sp, bool bNewFrame);
 
-    /**
-     * @brief 显示视频画面
-     *
-     * @param is 视频状态结构体
-     */
-    void video_image_display(VideoState *is);
+    //关闭全部镜像输出的渲染器，停止播放时在刷新线程调用，下次播放重新打开
+    void mirror_close();
+
+    //SDL 窗口事件是否来自镜像输出窗口
+    bool is_mirror_window(Uint32 window_id);
 
     /**
      * @brief 关闭流对应的解码器等
      *
      * @param is 视频状态结构体
      * @param stream_index 流索引
+     * @param ic 流所在的文件，为空表示 is->ic
      */
-    void stream_component_close(VideoState *is, int stream_index);
+    void stream_component_close(VideoState *is, int stream_index, AVFormatContext *ic = nullptr);
 
     /**
      * @brief 关闭流
@@ -503,9 +929,24 @@ private:
 
     VideoState* m_CurStream; //< 当前播放流状态
 
-    SDL_Window *window; //< SDL窗口
-    SDL_Renderer *renderer; //< SDL渲染器
-    SDL_RendererInfo renderer_info = { 0 }; //< 渲染器信息
+    SdlRender m_stSdlRender; //< SDL 输出
+    QtRender m_stQtRender; //< Qt 输出
+    RenderBackend *m_pRender; //< 当前文件使用的输出，只在刷新线程使用
+    std::atomic<int> m_nRenderBackend; //< 画面输出方式（RenderBackendType）
+
+    std::mutex m_mutexTransition;
+    std::atomic<bool> m_bTransitionPending; //< 输出区域正在切换
+    const char *m_szTransition; //< 切换名称
+    int64_t m_nTransitionStart; //< 开始时间（微秒）
+    bool m_bTransitionResized; //< 开始后刷新线程收到了大小变化，下一次显示为新大小
+    int64_t m_nTransitionPresent; //< 最后一次按新大小显示的时间
+    int m_nTransitionResizes; //< 切换期间的大小变化次数
+    int m_nTransitionSkipped; //< 切换期间因输出区域调整未显示的次数
+
+    std::mutex m_mutexOverlay;
+    QImage m_imgOverlay; //< 叠加图像，界面线程设置
+    uint64_t m_nOverlaySerial; //< 叠加图像序号，每次设置加一
+    uint64_t m_nOverlayUploaded; //< 已上传到输出的序号，只在刷新线程使用
     SDL_AudioDeviceID audio_dev; //< 音频设备ID
     WId play_wid; //< 播放窗口ID
 
@@ -516,8 +957,43 @@ private:
     // 播放刷新循环线程
     std::thread m_tPlayLoopThread;
 
+    int m_nScheduleId; //< 定时播放序号，开始其他播放或停止时加一，取消尚未打开的定时播放
+
     int m_nFrameW; //< 当前视频帧宽度
     int m_nFrameH; //< 当前视频帧高度
+
+    DecoderPool m_stDecoderPool; //< 解码器复用池
+    ColorLut m_stColorLut; //< 颜色管理
+    AudioMixer m_stAudioMixer; //< 多音轨混音
+    bool m_bMixAudio; //< 是否混入主音轨以外的音轨
+    std::atomic<int> m_nResamplePreset; //< 重采样预设（ResamplePreset）
+
+    std::mutex m_mutexExtAudio;
+    ExtAudio *m_pExtAudioReq; //< 待读取线程换入的外部音频
+    ExtAudio *m_pExtAudioOpening; //< 正在打开的外部音频，由 m_mutexExtAudio 保护
+    std::thread m_tExtAudioOpen; //< 打开外部音频的线程
+
+    std::mutex m_mutexZoom;
+    double m_dZoom; //< 缩放倍数，1 为原始大小
+    double m_dZoomCenterX; //< 缩放区域中心在画面中的相对位置(0~1)
+    double m_dZoomCenterY;
+
+    std::mutex m_mutexMirrors;
+    std::vector<MirrorOutput*> m_vecMirrors; //< 镜像输出
+    std::vector<MirrorOutput*> m_vecMirrorsClosing; //< 已移除、等刷新线程释放渲染器的镜像输出
+
+    SeekStress *m_pSeekStress; //< seek 压力测试统计，只在压力测试时设置
+    std::atomic<int64_t> m_nFirstFrameUs; //< 最近一次打开文件的首帧耗时（微秒）
+
+    ProxyCache m_stProxyCache; //< 重文件的代理
+    QString m_strSourceFile; //< 当前播放的原文件
+    bool m_bProxyActive; //< 当前打开的是代理
+    std::atomic<bool> m_bSourceSwitch; //< 正在切换原文件与代理，停止时不通知界面
+    bool m_bScrubbing; //< 正在拖动进度条
+    int m_nViewW; //< 画面显示宽度（像素）
+    int m_nViewH; //< 画面显示高度（像素）
+    bool m_bFullScreen; //< 是否全屏
+    int m_nProxyUpdateId; //< 延迟切换序号，只执行最后一次
 };
 
 #endif // VIDEOCTL_H